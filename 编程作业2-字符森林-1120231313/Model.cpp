@@ -26,8 +26,8 @@ void Model::Draw(ComPtr<ID3D11DeviceContext> context, ConstantBuffer pCBuffer, C
 	context->DrawIndexed(m_IndexCount, 0, 0); // 根据模型的索引计数绘制
 }
 std::unique_ptr<Model> Model::LoadModel(ComPtr<ID3D11Device> pDevice, const std::string& filePath) {
-	std::ifstream file(filePath);
-	if (!file.is_open()) {
+	MappedFile file;
+	if (!file.Open(filePath)) {
 		throw std::runtime_error("Failed to open OBJ file.");
 	}
 
@@ -35,70 +35,62 @@ std::unique_ptr<Model> Model::LoadModel(ComPtr<ID3D11Device> pDevice, const std:
 	std::mt19937 gen(rd());
 	std::uniform_real_distribution<float> dis(0.0f, 1.0f);
 
-	std::string line;
-	std::vector<std::string> s_vertices, s_indices;
+	// 先统计各类记录的数目，一次性分配好顶点和索引数组
+	ObjReader::RecordCounts counts = ObjReader::CountRecords(file.Begin(), file.End());
+	size_t vertexCount = counts.positionCount;
+	size_t indexCount = 3 * counts.faceCount;
+	VertexPosColor* vertices = new VertexPosColor[vertexCount];
+	WORD* indices = new WORD[indexCount];
 
-	// 存储每行的内容
-	while (std::getline(file, line)) {
-		if (!line.empty()) {
-			if (line.size() > 1 && line[0] == 'v' && line[1] != 'n')
-				s_vertices.push_back(line.substr(2));
-			else if (line[0] == 'f')
-				s_indices.push_back(line.substr(2));
+	// 在映射区域上原地解析，直接写入顶点和索引数组
+	size_t vIndex = 0, iIndex = 0;
+	const char* content = nullptr;
+	for (const char* p = file.Begin(); p < file.End(); ) {
+		const char* lineEnd = ObjReader::LineEnd(p, file.End());
+		ObjReader::RecordType type = ObjReader::ReadRecordType(p, lineEnd, content);
+		if (type == ObjReader::RecordType::Position) {
+			XMFLOAT3& pos = vertices[vIndex++].pos;
+			content = ObjReader::ParseFloat(content, lineEnd, pos.x);
+			content = ObjReader::ParseFloat(content, lineEnd, pos.y);
+			content = ObjReader::ParseFloat(content, lineEnd, pos.z);
+			pos.x *= 20; // 线性变换坐标
+			pos.y *= 20;
+			pos.z *= 20;
 		}
+		else if (type == ObjReader::RecordType::Face) {
+			int a, b, c;
+			content = ObjReader::ParseIndex(content, lineEnd, a);
+			content = ObjReader::ParseIndex(content, lineEnd, b);
+			content = ObjReader::ParseIndex(content, lineEnd, c);
+			indices[iIndex++] = c - 1;
+			indices[iIndex++] = b - 1;
+			indices[iIndex++] = a - 1;
+		}
+		p = lineEnd + 1;
 	}
-	file.close();
-
-	size_t vertexCount = s_vertices.size();
-	size_t indexCount = 3 * s_indices.size();
-	VertexPosColor* vertices = new VertexPosColor[vertexCount];
-	WORD* indices = new WORD[indexCount];
+	file.Close();
 
 	float centerX = 0.0f;
 	float centerY = 0.0f;
 	float centerZ = 0.0f;
 
-	std::vector<XMFLOAT3> tempVertices(vertexCount); // 临时存储顶点
-
-	// 读取顶点并计算质心
-	for (size_t i = 0; i < s_vertices.size(); ++i) {
-		std::istringstream data(s_vertices[i]);
-		float x, y, z;
-		data >> x >> y >> z;
-		x *= 20; // 线性变换坐标
-		y *= 20;
-		z *= 20;
-
-		tempVertices[i] = XMFLOAT3(x, y, z); // 存储原始顶点
-
-		centerX += x;
-		centerY += y;
-		centerZ += z;
-	}
-
 	// 计算质心
+	for (size_t i = 0; i < vertexCount; ++i) {
+		centerX += vertices[i].pos.x;
+		centerY += vertices[i].pos.y;
+		centerZ += vertices[i].pos.z;
+	}
 	centerX /= vertexCount;
 	centerY /= vertexCount;
 	centerZ /= vertexCount;
 
-	// 重新赋值顶点并移动到中心
+	// 移动到中心
 	for (size_t i = 0; i < vertexCount; ++i) {
-		vertices[i].pos = XMFLOAT3(tempVertices[i].x - centerX, tempVertices[i].y - centerY, tempVertices[i].z - centerZ);
+		vertices[i].pos.x -= centerX;
+		vertices[i].pos.y -= centerY;
+		vertices[i].pos.z -= centerZ;
 		vertices[i].color = XMFLOAT4(dis(gen), dis(gen), dis(gen), dis(gen)); // 随机颜色
 	}
-	for (size_t i = 0; i < s_indices.size(); ++i) {
-		std::istringstream data(s_indices[i]);
-		std::string s_a, s_b, s_c;
-		data >> s_a >> s_b >> s_c;
-		int a, b, c;
-		std::istringstream ss_a(s_a), ss_b(s_b), ss_c(s_c);
-		ss_a >> a;
-		ss_b >> b;
-		ss_c >> c;
-		indices[3 * i] = c - 1;
-		indices[3 * i + 1] = b - 1;
-		indices[3 * i + 2] = a - 1;
-	}
 
 	// 创建顶点缓冲区
 	ComPtr<ID3D11Buffer> vertexBuffer = nullptr;
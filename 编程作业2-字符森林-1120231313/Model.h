@@ -3,6 +3,7 @@
 
 #include "d3dUtil.h"
 #include "DXTrace.h"
+#include "ObjReader.h"
 #include <wrl/client.h>
 using namespace DirectX;
 
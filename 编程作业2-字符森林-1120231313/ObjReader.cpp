@@ -0,0 +1,78 @@
+#include "ObjReader.h"
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	m_hFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_hFile, &fileSize))
+	{
+		Close();
+		return false;
+	}
+
+	// 空文件无法创建映射，视为打开成功的空区域
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+	if (m_Size == 0)
+		return true;
+
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_hMapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const char*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+	m_pData = nullptr;
+	m_Size = 0;
+}
+
+ObjReader::RecordCounts ObjReader::CountRecords(const char* begin, const char* end)
+{
+	RecordCounts counts = {};
+	const char* content = nullptr;
+	for (const char* p = begin; p < end; )
+	{
+		const char* lineEnd = LineEnd(p, end);
+		switch (ReadRecordType(p, lineEnd, content))
+		{
+		case RecordType::Position: ++counts.positionCount; break;
+		case RecordType::Normal: ++counts.normalCount; break;
+		case RecordType::Face: ++counts.faceCount; break;
+		default: break;
+		}
+		p = lineEnd + 1;
+	}
+	return counts;
+}
@@ -0,0 +1,139 @@
+//***************************************************************************************
+// ObjReader.h
+//
+// 基于内存映射的OBJ模型文件读取
+// Memory-mapped OBJ model file reader.
+//***************************************************************************************
+
+#ifndef OBJREADER_H
+#define OBJREADER_H
+
+#include <Windows.h>
+#include <charconv>
+#include <cstring>
+#include <string>
+
+// 只读的内存映射文件
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// 打开并映射整个文件，失败返回false
+	bool Open(const std::string& filePath);
+	// 解除映射并关闭文件
+	void Close();
+
+	// 获取映射区域
+	const char* Begin() const { return m_pData; }
+	const char* End() const { return m_pData + m_Size; }
+	size_t Size() const { return m_Size; }
+
+private:
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;	// 文件句柄
+	HANDLE m_hMapping = nullptr;			// 文件映射句柄
+	const char* m_pData = nullptr;			// 映射视图首地址
+	size_t m_Size = 0;						// 文件字节数
+};
+
+namespace ObjReader
+{
+	// 文件中各类记录的数目
+	struct RecordCounts
+	{
+		size_t positionCount;	// v
+		size_t normalCount;		// vn
+		size_t faceCount;		// f
+	};
+
+	// 记录类型
+	enum class RecordType { Other, Position, Normal, Face };
+
+	// 是否为行内空白
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// 跳过行内空白
+	inline const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	// 跳过当前词
+	inline const char* SkipToken(const char* p, const char* end)
+	{
+		while (p < end && !IsSpace(*p) && *p != '\n')
+			++p;
+		return p;
+	}
+
+	// 返回当前行的行尾(指向'\n'或end)
+	inline const char* LineEnd(const char* p, const char* end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+		return lineEnd ? lineEnd : end;
+	}
+
+	// 判断一行的记录类型，并返回记录内容的起始位置
+	inline RecordType ReadRecordType(const char* p, const char* lineEnd, const char*& content)
+	{
+		p = SkipSpaces(p, lineEnd);
+		if (lineEnd - p < 2)
+			return RecordType::Other;
+
+		if (p[0] == 'v' && IsSpace(p[1]))
+		{
+			content = p + 2;
+			return RecordType::Position;
+		}
+		if (p[0] == 'v' && p[1] == 'n' && lineEnd - p > 2 && IsSpace(p[2]))
+		{
+			content = p + 3;
+			return RecordType::Normal;
+		}
+		if (p[0] == 'f' && IsSpace(p[1]))
+		{
+			content = p + 2;
+			return RecordType::Face;
+		}
+		return RecordType::Other;
+	}
+
+	// 原地解析一个浮点数，失败时置0并跳过该词
+	inline const char* ParseFloat(const char* p, const char* end, float& value)
+	{
+		p = SkipSpaces(p, end);
+		if (p < end && *p == '+')
+			++p;
+		auto result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+		{
+			value = 0.0f;
+			return SkipToken(p, end);
+		}
+		return result.ptr;
+	}
+
+	// 原地解析面记录中一个顶点的位置索引(即"a/b/c"中的a)，并跳过该词的剩余部分
+	inline const char* ParseIndex(const char* p, const char* end, int& value)
+	{
+		p = SkipSpaces(p, end);
+		auto result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+			value = 0;
+		return SkipToken(result.ptr, end);
+	}
+
+	// 统计[begin, end)内各类记录的数目
+	RecordCounts CountRecords(const char* begin, const char* end);
+}
+
+#endif
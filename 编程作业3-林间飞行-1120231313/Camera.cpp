@@ -54,6 +54,26 @@ DirectX::XMFLOAT3 Camera::GetLook() const
 	return m_Look;
 }
 
+float Camera::GetNearZ() const
+{
+	return m_NearZ;
+}
+
+float Camera::GetFarZ() const
+{
+	return m_FarZ;
+}
+
+float Camera::GetFovY() const
+{
+	return m_FovY;
+}
+
+float Camera::GetAspectRatio() const
+{
+	return m_Aspect;
+}
+
 float Camera::GetNearWindowWidth() const
 {
 	return m_Aspect * m_NearWindowHeight;
@@ -31,6 +31,10 @@ public:
 	DirectX::XMFLOAT3 GetLook() const;
 
 	// 获取视锥体信息
+	float GetNearZ() const;
+	float GetFarZ() const;
+	float GetFovY() const;
+	float GetAspectRatio() const;
 	float GetNearWindowWidth() const;
 	float GetNearWindowHeight() const;
 	float GetFarWindowWidth() const;
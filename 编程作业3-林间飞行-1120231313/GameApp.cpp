@@ -87,6 +87,9 @@ void GameApp::UpdateScene(float dt)
 	XMStoreFloat4(&m_CBFrame.eyePos, m_pCamera->GetPositionXM());
 	m_CBFrame.view = XMMatrixTranspose(m_pCamera->GetViewXM());
 
+	// 按摄像机位置选择地形各块的层级，屏幕空间误差不超过2像素
+	m_pTerrain->SelectLod(Terrain::MakeView(*m_pCamera, 2.0f), m_TerrainLods);
+
 	// 重置滚轮值
 	m_pMouse->ResetScrollWheelValue();
 
@@ -149,6 +152,11 @@ void GameApp::DrawScene()
 	m_pd3dImmediateContext->ClearRenderTargetView(m_pRenderTargetView.Get(), reinterpret_cast<const float*>(&Colors::Black));
 	m_pd3dImmediateContext->ClearDepthStencilView(m_pDepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
+	//
+	// 绘制地形
+	//
+	DrawTerrain();
+
 	//
 	// 绘制几何模型
 	//
@@ -164,6 +172,29 @@ void GameApp::DrawScene()
 	HR(m_pSwapChain->Present(0, 0));
 }
 
+void GameApp::DrawTerrain()
+{
+	// 地形顶点已位于世界坐标系
+	CBChangesEveryDrawing cbDrawing;
+	cbDrawing.world = XMMatrixIdentity();
+	cbDrawing.worldInvTranspose = XMMatrixIdentity();
+	D3D11_MAPPED_SUBRESOURCE mappedData;
+	HR(m_pd3dImmediateContext->Map(m_pConstantBuffers[0].Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+	memcpy_s(mappedData.pData, sizeof(CBChangesEveryDrawing), &cbDrawing, sizeof(CBChangesEveryDrawing));
+	m_pd3dImmediateContext->Unmap(m_pConstantBuffers[0].Get(), 0);
+
+	// 各块共用一个索引缓冲区，按层级与接缝组合选取其中一段
+	UINT strides = sizeof(VertexPosNormalColor);
+	UINT offsets = 0;
+	m_pd3dImmediateContext->IASetIndexBuffer(m_pTerrainIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+	for (const Terrain::ChunkLod& chunkLod : m_TerrainLods)
+	{
+		Terrain::DrawRange range = m_pTerrain->GetDrawRange(chunkLod.level, chunkLod.edgeFlags);
+		m_pd3dImmediateContext->IASetVertexBuffers(0, 1, m_pTerrainVertexBuffers[chunkLod.chunk].GetAddressOf(), &strides, &offsets);
+		m_pd3dImmediateContext->DrawIndexed(range.indexCount, range.startIndex, 0);
+	}
+}
+
 
 bool GameApp::InitEffect()
 {
@@ -217,6 +248,9 @@ bool GameApp::InitResource()
 		m_Models.push_back(model);
 	}
 
+	if (!InitTerrain())
+		return false;
+
 	// 初始化模型的世界矩阵
 	m_Worlds.resize(m_Models.size());
 	for (auto& world : m_Worlds)
@@ -325,6 +359,47 @@ bool GameApp::InitResource()
 	return true;
 }
 
+bool GameApp::InitTerrain()
+{
+	// 方阵下方较为平坦，越往外山丘越高
+	auto heightFunc = [](float x, float z) {
+		float r = sqrtf(x * x + z * z);
+		float t = (std::min)((std::max)((r - 60.0f) / 120.0f, 0.0f), 1.0f);
+		return -10.0f + 1.5f * sinf(0.21f * x) * sinf(0.17f * z)
+			+ t * t * (25.0f * sinf(0.023f * x) * cosf(0.019f * z) + 12.0f * sinf(0.051f * x + 0.037f * z) + 15.0f);
+	};
+	m_pTerrain = std::make_unique<Terrain>(Terrain::Create(XMFLOAT2(512.0f, 512.0f), XMUINT2(16, 16), 32, heightFunc));
+
+	// 每块一个顶点缓冲区
+	D3D11_BUFFER_DESC vbd;
+	ZeroMemory(&vbd, sizeof(vbd));
+	vbd.Usage = D3D11_USAGE_IMMUTABLE;
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	D3D11_SUBRESOURCE_DATA InitData;
+	ZeroMemory(&InitData, sizeof(InitData));
+	m_pTerrainVertexBuffers.resize(m_pTerrain->GetChunkCount());
+	for (UINT i = 0; i < m_pTerrain->GetChunkCount(); ++i)
+	{
+		auto meshData = m_pTerrain->CreateChunkMesh<VertexPosNormalColor>(i);
+		vbd.ByteWidth = (UINT)meshData.vertexVec.size() * sizeof(VertexPosNormalColor);
+		InitData.pSysMem = meshData.vertexVec.data();
+		HR(m_pd3dDevice->CreateBuffer(&vbd, &InitData, m_pTerrainVertexBuffers[i].GetAddressOf()));
+	}
+
+	// 所有层级与接缝组合的索引
+	const std::vector<WORD>& indices = m_pTerrain->GetIndices();
+	D3D11_BUFFER_DESC ibd;
+	ZeroMemory(&ibd, sizeof(ibd));
+	ibd.Usage = D3D11_USAGE_IMMUTABLE;
+	ibd.ByteWidth = (UINT)indices.size() * sizeof(WORD);
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	InitData.pSysMem = indices.data();
+	HR(m_pd3dDevice->CreateBuffer(&ibd, &InitData, m_pTerrainIndexBuffer.GetAddressOf()));
+
+	D3D11SetDebugObjectName(m_pTerrainIndexBuffer.Get(), "TerrainIndexBuffer");
+	return true;
+}
+
 GameApp::GameObject::GameObject()
 	: m_IndexCount(), m_VertexStride()
 {
@@ -5,6 +5,7 @@
 #include "Geometry.h"
 #include "LightHelper.h"
 #include "Camera.h"
+#include "Terrain.h"
 
 class GameApp : public D3DApp
 {
@@ -85,6 +86,8 @@ public:
 private:
 	bool InitEffect();
 	bool InitResource();
+	bool InitTerrain();
+	void DrawTerrain();
 
 private:
 	// 定义了方阵的大小
@@ -97,6 +100,11 @@ private:
 	std::vector<GameObject> m_Models;							// 所有模型
 	std::vector<std::vector<DirectX::XMMATRIX>> m_Worlds;		// 所有模型的世界矩阵
 
+	std::unique_ptr<Terrain> m_pTerrain;						// 地形
+	std::vector<ComPtr<ID3D11Buffer>> m_pTerrainVertexBuffers;	// 地形各块的顶点缓冲区
+	ComPtr<ID3D11Buffer> m_pTerrainIndexBuffer;					// 地形各块共用的索引缓冲区
+	std::vector<Terrain::ChunkLod> m_TerrainLods;				// 本帧需要绘制的地形块及其层级
+
 	ComPtr<ID3D11VertexShader> m_pVertexShader3D;				// 用于3D的顶点着色器
 	ComPtr<ID3D11PixelShader> m_pPixelShader3D;				    // 用于3D的像素着色器
 
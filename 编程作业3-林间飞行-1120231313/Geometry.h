@@ -15,6 +15,7 @@
 #include "Vertex.h"
 #include <wrl/client.h>
 #include "d3dUtil.h"
+#include "MeshNormals.h"
 
 namespace Geometry
 {
@@ -171,6 +172,9 @@ namespace Geometry
 			meshData.indexVec[iIndex++] = c - 1;
 		}
 
+		// 文件中的法线未被读取，由位置生成平滑法线，折痕处的顶点会被拆分
+		MeshNormals::GenerateNormals(meshData.vertexVec, meshData.indexVec);
+
 		delete[] vertices;		// 释放临时顶点数据
 		delete[] indices;		// 释放临时索引数据
 		return meshData;
@@ -0,0 +1,230 @@
+#include "Terrain.h"
+#include <algorithm>
+#include <stdexcept>
+using namespace DirectX;
+
+Terrain::Terrain(const DirectX::XMFLOAT2& terrainSize, const DirectX::XMUINT2& chunkCounts, UINT chunkCells,
+	std::vector<float> heights)
+	: m_TerrainSize(terrainSize), m_ChunkCounts(chunkCounts), m_ChunkCells(chunkCells), m_LevelCount(),
+	m_ColumnCount(chunkCounts.x * chunkCells + 1), m_Heights(std::move(heights)), m_MinHeight(), m_MaxHeight()
+{
+	// 块内顶点数需能用WORD索引，且每一层级都能把边长对半划分
+	if (chunkCells < 2 || chunkCells > 128 || (chunkCells & (chunkCells - 1)) != 0)
+	{
+		throw std::runtime_error("Terrain chunk cells must be a power of two in [2, 128].");
+	}
+	if (chunkCounts.x == 0 || chunkCounts.y == 0 ||
+		m_Heights.size() != static_cast<size_t>(m_ColumnCount) * (chunkCounts.y * chunkCells + 1))
+	{
+		throw std::runtime_error("Terrain height count does not match the chunk layout.");
+	}
+
+	// 最粗一级每块只有两个三角形
+	for (UINT step = 1; step <= chunkCells; step *= 2)
+		++m_LevelCount;
+
+	BuildIndices();
+	BuildChunks();
+}
+
+Terrain::View Terrain::MakeView(const Camera& camera, float maxPixelError)
+{
+	View view;
+	view.eyePos = camera.GetPosition();
+	view.pixelsPerUnit = camera.GetViewPort().Height / (2.0f * tanf(0.5f * camera.GetFovY()));
+	view.farZ = camera.GetFarZ();
+	view.maxPixelError = maxPixelError;
+	return view;
+}
+
+float Terrain::GetHeight(UINT row, UINT column) const
+{
+	return m_Heights[static_cast<size_t>(row) * m_ColumnCount + column];
+}
+
+float Terrain::GetGeometricError(UINT chunk, UINT level) const
+{
+	return m_Chunks[chunk].errors[level];
+}
+
+Terrain::DrawRange Terrain::GetDrawRange(UINT level, UINT edgeFlags) const
+{
+	return m_DrawRanges[level * EdgeVariantCount + (edgeFlags & (EdgeVariantCount - 1))];
+}
+
+void Terrain::SelectLod(const View& view, std::vector<ChunkLod>& chunkLods) const
+{
+	chunkLods.clear();
+	UINT chunkCount = GetChunkCount();
+	std::vector<UINT> levels(chunkCount);
+	std::vector<float> distances(chunkCount);
+
+	// 屏幕空间误差 = 几何误差 * pixelsPerUnit / 距离，取满足误差要求的最粗层级
+	XMVECTOR eyePos = XMLoadFloat3(&view.eyePos);
+	for (UINT i = 0; i < chunkCount; ++i)
+	{
+		const Chunk& chunk = m_Chunks[i];
+		XMVECTOR closest = XMVectorClamp(eyePos, XMLoadFloat3(&chunk.boundsMin), XMLoadFloat3(&chunk.boundsMax));
+		distances[i] = XMVectorGetX(XMVector3Length(eyePos - closest));
+
+		UINT level = m_LevelCount - 1;
+		while (level > 0 && chunk.errors[level] * view.pixelsPerUnit > view.maxPixelError * distances[i])
+			--level;
+		levels[i] = level;
+	}
+
+	// 相邻块的层级最多相差一级，否则接缝索引无法消除裂缝；只会把层级调细，不会增大误差
+	auto relax = [&levels](UINT i, UINT neighbor) {
+		if (levels[i] > levels[neighbor] + 1)
+		{
+			levels[i] = levels[neighbor] + 1;
+			return true;
+		}
+		return false;
+	};
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (UINT z = 0; z < m_ChunkCounts.y; ++z)
+		{
+			for (UINT x = 0; x < m_ChunkCounts.x; ++x)
+			{
+				UINT i = z * m_ChunkCounts.x + x;
+				if (z > 0) changed |= relax(i, i - m_ChunkCounts.x);
+				if (x + 1 < m_ChunkCounts.x) changed |= relax(i, i + 1);
+				if (z + 1 < m_ChunkCounts.y) changed |= relax(i, i + m_ChunkCounts.x);
+				if (x > 0) changed |= relax(i, i - 1);
+			}
+		}
+	}
+
+	// 标记层级更粗的相邻边，视距外的块不绘制
+	for (UINT z = 0; z < m_ChunkCounts.y; ++z)
+	{
+		for (UINT x = 0; x < m_ChunkCounts.x; ++x)
+		{
+			UINT i = z * m_ChunkCounts.x + x;
+			if (distances[i] > view.farZ)
+				continue;
+
+			UINT level = levels[i], edgeFlags = 0;
+			if (z > 0 && levels[i - m_ChunkCounts.x] > level) edgeFlags |= EdgeNorth;
+			if (x + 1 < m_ChunkCounts.x && levels[i + 1] > level) edgeFlags |= EdgeEast;
+			if (z + 1 < m_ChunkCounts.y && levels[i + m_ChunkCounts.x] > level) edgeFlags |= EdgeSouth;
+			if (x > 0 && levels[i - 1] > level) edgeFlags |= EdgeWest;
+			chunkLods.push_back({ i, level, edgeFlags });
+		}
+	}
+}
+
+void Terrain::BuildIndices()
+{
+	// 块内顶点按行从+Z到-Z(北到南)、每行从-X到+X(西到东)排列
+	// 层级level使用间隔为step = 2^level的顶点；某条边的相邻块粗一级时，
+	// 将该边上不属于2 * step网格的顶点并到相邻的顶点上，该边只剩粗一级的顶点，从而与相邻块完全重合，
+	// 合并后面积为0的三角形直接丢弃
+	// 格子的对角线连接西南角与东北角，块的西北角、东南角所在格子中有一个三角形的两个顶点分别位于两条边上，
+	// 因此北、西边的顶点并向西北角，南、东边的顶点并向东南角，否则这个三角形会翻转
+	UINT n = m_ChunkCells;
+	m_DrawRanges.resize(m_LevelCount * EdgeVariantCount);
+	for (UINT level = 0; level < m_LevelCount; ++level)
+	{
+		UINT step = 1u << level;
+		for (UINT edgeFlags = 0; edgeFlags < EdgeVariantCount; ++edgeFlags)
+		{
+			// 最粗一级不存在更粗的相邻块
+			UINT flags = level + 1 < m_LevelCount ? edgeFlags : 0;
+			auto vertexAt = [n, step, flags](UINT row, UINT column) {
+				if ((flags & EdgeNorth) && row == 0)
+					column -= column % (2 * step);
+				else if ((flags & EdgeSouth) && row == n)
+					column += column % (2 * step);
+				if ((flags & EdgeWest) && column == 0)
+					row -= row % (2 * step);
+				else if ((flags & EdgeEast) && column == n)
+					row += row % (2 * step);
+				return static_cast<WORD>(row * (n + 1) + column);
+			};
+
+			DrawRange& range = m_DrawRanges[level * EdgeVariantCount + edgeFlags];
+			range.startIndex = static_cast<UINT>(m_Indices.size());
+			auto addTriangle = [this](WORD v0, WORD v1, WORD v2) {
+				if (v0 != v1 && v1 != v2 && v2 != v0)
+				{
+					m_Indices.push_back(v0);
+					m_Indices.push_back(v1);
+					m_Indices.push_back(v2);
+				}
+			};
+			for (UINT row = 0; row < n; row += step)
+			{
+				for (UINT column = 0; column < n; column += step)
+				{
+					// 与CreatePlane的绕序一致
+					WORD farLeft = vertexAt(row, column), farRight = vertexAt(row, column + step);
+					WORD nearLeft = vertexAt(row + step, column), nearRight = vertexAt(row + step, column + step);
+					addTriangle(nearLeft, farLeft, farRight);
+					addTriangle(farRight, nearRight, nearLeft);
+				}
+			}
+			range.indexCount = static_cast<UINT>(m_Indices.size()) - range.startIndex;
+		}
+	}
+}
+
+void Terrain::BuildChunks()
+{
+	UINT n = m_ChunkCells;
+	UINT rowCount = m_ChunkCounts.y * n + 1;
+	float dx = m_TerrainSize.x / (m_ColumnCount - 1), dz = m_TerrainSize.y / (rowCount - 1);
+	auto minmax = std::minmax_element(m_Heights.begin(), m_Heights.end());
+	m_MinHeight = *minmax.first;
+	m_MaxHeight = *minmax.second;
+
+	m_Chunks.resize(GetChunkCount());
+	ThreadPool::Get().ParallelFor(m_Chunks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			Chunk& chunk = m_Chunks[i];
+			UINT firstRow = static_cast<UINT>(i) / m_ChunkCounts.x * n;
+			UINT firstColumn = static_cast<UINT>(i) % m_ChunkCounts.x * n;
+			auto height = [&](UINT row, UINT column) { return GetHeight(firstRow + row, firstColumn + column); };
+
+			float minY = height(0, 0), maxY = minY;
+			for (UINT row = 0; row <= n; ++row)
+				for (UINT column = 0; column <= n; ++column)
+				{
+					minY = (std::min)(minY, height(row, column));
+					maxY = (std::max)(maxY, height(row, column));
+				}
+			chunk.boundsMin = XMFLOAT3(-m_TerrainSize.x / 2 + firstColumn * dx, minY, m_TerrainSize.y / 2 - (firstRow + n) * dz);
+			chunk.boundsMax = XMFLOAT3(-m_TerrainSize.x / 2 + (firstColumn + n) * dx, maxY, m_TerrainSize.y / 2 - firstRow * dz);
+
+			// 几何误差：最精细网格的顶点与该层级三角形在同一位置的高度差的最大值
+			// 格子的对角线连接左下与右上，与BuildIndices的三角形划分一致
+			chunk.errors.assign(m_LevelCount, 0.0f);
+			for (UINT level = 1; level < m_LevelCount; ++level)
+			{
+				UINT step = 1u << level;
+				float error = chunk.errors[level - 1];
+				for (UINT row = 0; row <= n; ++row)
+				{
+					for (UINT column = 0; column <= n; ++column)
+					{
+						UINT r0 = (std::min)(row / step * step, n - step);
+						UINT c0 = (std::min)(column / step * step, n - step);
+						float a = static_cast<float>(column - c0) / step, b = static_cast<float>(row - r0) / step;
+						float farLeft = height(r0, c0), farRight = height(r0, c0 + step);
+						float nearLeft = height(r0 + step, c0), nearRight = height(r0 + step, c0 + step);
+						float approx = a + b <= 1.0f ?
+							farLeft + a * (farRight - farLeft) + b * (nearLeft - farLeft) :
+							nearRight + (1.0f - a) * (nearLeft - nearRight) + (1.0f - b) * (farRight - nearRight);
+						error = (std::max)(error, fabsf(height(row, column) - approx));
+					}
+				}
+				chunk.errors[level] = error;
+			}
+		}
+	});
+}
@@ -0,0 +1,177 @@
+//***************************************************************************************
+// Terrain.h
+//
+// 分块高度场地形，每块按摄像机距离与屏幕空间误差选择几何MIP层级(geomipmapping)，
+// 与较粗的相邻块之间用预先生成的接缝索引消除裂缝
+// Chunked heightfield terrain with geomipmapping LOD and precomputed crack-free stitching.
+//***************************************************************************************
+
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <vector>
+#include "Geometry.h"
+#include "Camera.h"
+#include "ThreadPool.h"
+
+class Terrain
+{
+public:
+	// 相邻块的层级比本块粗一级的边，按位组合
+	// 北为+Z方向，东为+X方向
+	enum EdgeFlag : UINT
+	{
+		EdgeNorth = 1,
+		EdgeEast = 2,
+		EdgeSouth = 4,
+		EdgeWest = 8,
+		EdgeVariantCount = 16
+	};
+
+	// 共享索引数组中的一段
+	struct DrawRange
+	{
+		UINT indexCount;
+		UINT startIndex;
+	};
+
+	// 选择LOD所需的观察参数，可由Camera生成，也可直接填写以便脱离渲染环境测试
+	struct View
+	{
+		DirectX::XMFLOAT3 eyePos;		// 观察点位置
+		float pixelsPerUnit;			// 距离为1处单位长度在屏幕上对应的像素数
+		float farZ;						// 超出该距离的块不绘制
+		float maxPixelError;			// 允许的最大屏幕空间误差(像素)
+	};
+
+	// 一个待绘制的块
+	struct ChunkLod
+	{
+		UINT chunk;						// 块序号，按行从+Z到-Z、每行从-X到+X
+		UINT level;						// 层级，0为最精细
+		UINT edgeFlags;					// 层级更粗的相邻边
+	};
+
+	// heights为(chunkCounts.x * chunkCells + 1) * (chunkCounts.y * chunkCells + 1)个顶点的高度，
+	// 顶点排列与Geometry的网格相同：按行从+Z到-Z、每行从-X到+X，地形中心在原点
+	// chunkCells为每块每边的格子数，需为2的幂且不超过128；参数不合法时抛出std::runtime_error
+	Terrain(const DirectX::XMFLOAT2& terrainSize, const DirectX::XMUINT2& chunkCounts, UINT chunkCells,
+		std::vector<float> heights);
+
+	// 以heightFunc(x, z)采样高度并创建地形，heightFunc会在多个线程上并行调用
+	template<class HeightFunc>
+	static Terrain Create(const DirectX::XMFLOAT2& terrainSize, const DirectX::XMUINT2& chunkCounts, UINT chunkCells,
+		const HeightFunc& heightFunc);
+
+	// 由摄像机的位置、视锥体与视口生成观察参数
+	static View MakeView(const Camera& camera, float maxPixelError);
+
+	UINT GetChunkCount() const { return m_ChunkCounts.x * m_ChunkCounts.y; }
+	UINT GetChunkCells() const { return m_ChunkCells; }
+	UINT GetLevelCount() const { return m_LevelCount; }
+	// 获取顶点处的高度，row/column为整个地形的顶点行列号
+	float GetHeight(UINT row, UINT column) const;
+	// 获取块在某一层级下相对最精细网格的最大高度误差
+	float GetGeometricError(UINT chunk, UINT level) const;
+
+	// 所有块共用的索引数组(块内顶点序号)，包含每个层级的16种接缝组合
+	const std::vector<WORD>& GetIndices() const { return m_Indices; }
+	// 获取某一层级与接缝组合在共享索引数组中的范围
+	DrawRange GetDrawRange(UINT level, UINT edgeFlags) const;
+
+	// 生成块的顶点，法线由整个高度场的差分得到，因此块与块之间光照连续
+	template<class VertexType>
+	Geometry::MeshData<VertexType, WORD> CreateChunkMesh(UINT chunk) const;
+
+	// 为视距内的块选择层级：取屏幕空间误差不超过view.maxPixelError的最粗层级，
+	// 再限制相邻块相差不超过一级，并标记需要接缝的边
+	// 不修改地形，可以在多个线程上以不同的观察参数同时调用
+	// 平滑的地形上几何误差约与顶点间距的平方成正比，每块的三角形数约与距离成反比，
+	// 因此三角形总数随视距大致线性增长，而绘制的块数随视距的平方增长，远处的块最终只剩最粗层级的2个三角形
+	// (64x64块的地形上视距从250增大到1000时，块数从220增加到3195，三角形从41k增加到135k，见单元测试)
+	void SelectLod(const View& view, std::vector<ChunkLod>& chunkLods) const;
+
+private:
+	// 块的包围盒与各层级的几何误差
+	struct Chunk
+	{
+		DirectX::XMFLOAT3 boundsMin;
+		DirectX::XMFLOAT3 boundsMax;
+		std::vector<float> errors;
+	};
+
+	void BuildIndices();
+	void BuildChunks();
+
+private:
+	DirectX::XMFLOAT2 m_TerrainSize;		// 地形在X、Z方向上的尺寸
+	DirectX::XMUINT2 m_ChunkCounts;			// X、Z方向上的块数
+	UINT m_ChunkCells;						// 每块每边的格子数
+	UINT m_LevelCount;						// 层级数目
+	UINT m_ColumnCount;						// 每行的顶点数
+	std::vector<float> m_Heights;			// 顶点高度
+	float m_MinHeight;						// 最低高度
+	float m_MaxHeight;						// 最高高度
+	std::vector<Chunk> m_Chunks;			// 所有块
+	std::vector<WORD> m_Indices;			// 共享索引
+	std::vector<DrawRange> m_DrawRanges;	// 按level * EdgeVariantCount + edgeFlags存放
+};
+
+template<class HeightFunc>
+inline Terrain Terrain::Create(const DirectX::XMFLOAT2& terrainSize, const DirectX::XMUINT2& chunkCounts, UINT chunkCells,
+	const HeightFunc& heightFunc)
+{
+	UINT columnCount = chunkCounts.x * chunkCells + 1, rowCount = chunkCounts.y * chunkCells + 1;
+	std::vector<float> heights(static_cast<size_t>(columnCount) * rowCount);
+	float dx = terrainSize.x / (columnCount - 1), dz = terrainSize.y / (rowCount - 1);
+	ThreadPool::Get().ParallelFor(rowCount, 16, [&](size_t begin, size_t end) {
+		for (UINT i = static_cast<UINT>(begin); i < end; ++i)
+		{
+			float z = terrainSize.y / 2 - i * dz;
+			for (UINT j = 0; j < columnCount; ++j)
+				heights[static_cast<size_t>(i) * columnCount + j] = heightFunc(-terrainSize.x / 2 + j * dx, z);
+		}
+	});
+	return Terrain(terrainSize, chunkCounts, chunkCells, std::move(heights));
+}
+
+template<class VertexType>
+inline Geometry::MeshData<VertexType, WORD> Terrain::CreateChunkMesh(UINT chunk) const
+{
+	using namespace DirectX;
+
+	UINT rowCount = m_ChunkCounts.y * m_ChunkCells + 1;
+	UINT firstRow = chunk / m_ChunkCounts.x * m_ChunkCells;
+	UINT firstColumn = chunk % m_ChunkCounts.x * m_ChunkCells;
+	float dx = m_TerrainSize.x / (m_ColumnCount - 1), dz = m_TerrainSize.y / (rowCount - 1);
+
+	Geometry::MeshData<VertexType, WORD> meshData;
+	meshData.vertexVec.resize((m_ChunkCells + 1) * (m_ChunkCells + 1));
+	Geometry::Internal::VertexData vertexData;
+	vertexData.tangent = XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f);
+	size_t vIndex = 0;
+	for (UINT i = firstRow; i <= firstRow + m_ChunkCells; ++i)
+	{
+		for (UINT j = firstColumn; j <= firstColumn + m_ChunkCells; ++j)
+		{
+			// 中心差分，地形边界处使用单侧差分
+			UINT j0 = j > 0 ? j - 1 : j, j1 = j + 1 < m_ColumnCount ? j + 1 : j;
+			UINT i0 = i > 0 ? i - 1 : i, i1 = i + 1 < rowCount ? i + 1 : i;
+			float dydx = (GetHeight(i, j1) - GetHeight(i, j0)) / ((j1 - j0) * dx);
+			float dydz = (GetHeight(i0, j) - GetHeight(i1, j)) / ((i1 - i0) * dz);
+			float y = GetHeight(i, j);
+
+			vertexData.pos = XMFLOAT3(-m_TerrainSize.x / 2 + j * dx, y, m_TerrainSize.y / 2 - i * dz);
+			XMStoreFloat3(&vertexData.normal, XMVector3Normalize(XMVectorSet(-dydx, 1.0f, -dydz, 0.0f)));
+			// 低处偏绿、高处偏褐
+			float t = m_MaxHeight > m_MinHeight ? (y - m_MinHeight) / (m_MaxHeight - m_MinHeight) : 0.0f;
+			vertexData.color = XMFLOAT4(0.25f + 0.25f * t, 0.45f - 0.1f * t, 0.2f, 1.0f);
+			vertexData.tex = XMFLOAT2(static_cast<float>(j - firstColumn) / m_ChunkCells,
+				static_cast<float>(i - firstRow) / m_ChunkCells);
+			Geometry::Internal::InsertVertexElement(meshData.vertexVec[vIndex++], vertexData);
+		}
+	}
+	return meshData;
+}
+
+#endif
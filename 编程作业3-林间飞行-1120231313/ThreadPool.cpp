@@ -0,0 +1,52 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount)
+	: m_Stop(false)
+{
+	m_Threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Condition.notify_all();
+	for (std::thread& thread : m_Threads)
+		thread.join();
+}
+
+ThreadPool& ThreadPool::Get()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+	return pool;
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Tasks.push_back(std::move(task));
+	}
+	m_Condition.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return m_Stop || !m_Tasks.empty(); });
+			if (m_Stop && m_Tasks.empty())
+				return;
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+		task();
+	}
+}
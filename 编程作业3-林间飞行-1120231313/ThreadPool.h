@@ -0,0 +1,123 @@
+//***************************************************************************************
+// ThreadPool.h
+//
+// 固定数目工作线程的线程池，提供按区间划分的并行循环
+// Fixed-size worker thread pool with a range-partitioned parallel loop.
+//***************************************************************************************
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// threadCount为工作线程数目，调用ParallelFor的线程也会参与计算
+	explicit ThreadPool(size_t threadCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// 获取全局共享的线程池，工作线程数目为硬件线程数减一
+	static ThreadPool& Get();
+
+	// 获取工作线程数目
+	size_t GetThreadCount() const { return m_Threads.size(); }
+
+	// 将[0, count)划分为长度为grainSize的区间，由工作线程与当前线程并行执行func(begin, end)，全部完成后返回
+	// 当前线程会领取尚未开始的区间，因此在工作线程中嵌套调用也不会死锁
+	// func抛出异常时不再开始新的区间，等待已开始的区间结束后在当前线程重新抛出第一个异常
+	template<class Func>
+	void ParallelFor(size_t count, size_t grainSize, const Func& func);
+
+	// 提交一个任务，由某个工作线程执行，任务不能抛出异常
+	void Submit(std::function<void()> task);
+
+private:
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> m_Threads;				// 工作线程
+	std::deque<std::function<void()>> m_Tasks;		// 待执行的任务
+	std::mutex m_Mutex;								// 保护任务队列
+	std::condition_variable m_Condition;			// 通知工作线程有新任务或需要退出
+	bool m_Stop;									// 是否正在析构
+};
+
+template<class Func>
+inline void ThreadPool::ParallelFor(size_t count, size_t grainSize, const Func& func)
+{
+	if (grainSize == 0)
+		grainSize = 1;
+	size_t rangeCount = (count + grainSize - 1) / grainSize;
+	if (rangeCount <= 1 || m_Threads.empty())
+	{
+		if (count > 0)
+			func(size_t(0), count);
+		return;
+	}
+
+	// 各区间由最先空闲的线程领取，共享状态由参与的任务共同持有，保证提前返回后不被访问
+	struct State
+	{
+		std::atomic<size_t> nextRange{ 0 };
+		std::atomic<size_t> doneRanges{ 0 };
+		std::atomic<bool> failed{ false };
+		std::exception_ptr error;		// 第一个异常，由mutex保护
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	auto state = std::make_shared<State>();
+	auto run = [state, count, grainSize, rangeCount, &func]()
+	{
+		size_t range;
+		while ((range = state->nextRange.fetch_add(1)) < rangeCount)
+		{
+			size_t begin = range * grainSize;
+			size_t end = begin + grainSize < count ? begin + grainSize : count;
+			// 异常不能离开任务：工作线程上会直接终止进程，当前线程上会在其余线程仍在使用func时提前返回
+			// 出错后剩余的区间不再执行，但仍计为完成，保证等待能够结束
+			if (!state->failed.load())
+			{
+				try
+				{
+					func(begin, end);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					if (!state->error)
+						state->error = std::current_exception();
+					state->failed = true;
+				}
+			}
+			if (state->doneRanges.fetch_add(1) + 1 == rangeCount)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->done.notify_all();
+			}
+		}
+	};
+
+	size_t helperCount = rangeCount - 1 < m_Threads.size() ? rangeCount - 1 : m_Threads.size();
+	for (size_t i = 0; i < helperCount; ++i)
+		Submit(run);
+	run();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [&state, rangeCount]() { return state->doneRanges.load() == rangeCount; });
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+#endif
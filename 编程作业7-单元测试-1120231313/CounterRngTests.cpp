@@ -0,0 +1,83 @@
+#include "TestFramework.h"
+#include <cstring>
+#include <vector>
+#include "CounterRng.h"
+using namespace DirectX;
+
+namespace
+{
+	// Random123发布的Philox4x32-10已知答案向量(kat_vectors)
+	struct PhiloxVector
+	{
+		XMUINT4 counter;
+		uint32_t key0, key1;
+		XMUINT4 expected;
+	};
+
+	const PhiloxVector philoxVectors[] = {
+		{ XMUINT4(0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u), 0x00000000u, 0x00000000u,
+		  XMUINT4(0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u) },
+		{ XMUINT4(0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu), 0xffffffffu, 0xffffffffu,
+		  XMUINT4(0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu) },
+		{ XMUINT4(0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u), 0xa4093822u, 0x299f31d0u,
+		  XMUINT4(0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u) },
+	};
+
+	bool Equal(const XMUINT4& a, const XMUINT4& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+	}
+
+	bool BitwiseEqual(const XMFLOAT4& a, const XMFLOAT4& b)
+	{
+		return memcmp(&a, &b, sizeof(XMFLOAT4)) == 0;
+	}
+}
+
+TEST_CASE(CounterRng_PhiloxKnownAnswers)
+{
+	for (const PhiloxVector& v : philoxVectors)
+		CHECK(Equal(CounterRng::Philox4x32(v.counter, v.key0, v.key1), v.expected));
+
+	// (seed, stream)为密钥，(id低32位, id高32位, draw, 0)为计数器
+	CHECK(Equal(CounterRng::Random4(0, 0, 0), philoxVectors[0].expected));
+	XMUINT4 counter(0x9abcdef0u, 0x12345678u, 5, 0);
+	CHECK(Equal(CounterRng::Random4(0xa4093822u, 0x299f31d0u, 0x123456789abcdef0ull, 5),
+		CounterRng::Philox4x32(counter, 0xa4093822u, 0x299f31d0u)));
+
+	// 浮点映射取高24位
+	CHECK(CounterRng::ToUnitFloat(0) == 0.0f);
+	CHECK(CounterRng::ToUnitFloat(0x000000ffu) == 0.0f);
+	CHECK(CounterRng::ToUnitFloat(0x80000000u) == 0.5f);
+	CHECK(CounterRng::ToUnitFloat(0xffffffffu) == 1.0f - 1.0f / 16777216.0f);
+	XMFLOAT4 zero = CounterRng::Uniform4(0, 0, 0);
+	CHECK(zero.x == CounterRng::ToUnitFloat(0x6627e8d5u) && zero.w == CounterRng::ToUnitFloat(0x9b00dbd8u));
+}
+
+TEST_CASE(CounterRng_BatchMatchesScalar)
+{
+	// 批量生成每次处理4个实例，检查不满4个的尾部，以及编号低32位跨越进位的区间
+	const uint64_t firstIds[] = { 0, 1, 0xfffffffdull, 0xffffffffull, 0x1fffffffeull };
+	bool same = true;
+	std::vector<XMFLOAT4> out;
+	for (uint64_t firstId : firstIds)
+	{
+		for (size_t count : { 0, 1, 3, 4, 5, 8, 17 })
+		{
+			for (uint32_t draw : { 0u, 3u })
+			{
+				out.assign(count, XMFLOAT4(-1.0f, -1.0f, -1.0f, -1.0f));
+				CounterRng::GenerateUniform4(1120231313u, 7, firstId, count, out.data(), draw);
+				for (size_t i = 0; i < count; ++i)
+					same &= BitwiseEqual(out[i], CounterRng::Uniform4(1120231313u, 7, firstId + i, draw));
+			}
+		}
+	}
+	CHECK(same);
+
+	// 批量路径同样满足已知答案
+	XMFLOAT4 batch[4];
+	CounterRng::GenerateUniform4(0, 0, 0, 4, batch);
+	CHECK(BitwiseEqual(batch[0], CounterRng::Uniform4(0, 0, 0)));
+	CHECK(batch[0].y == CounterRng::ToUnitFloat(0xe169c58du) && batch[0].z == CounterRng::ToUnitFloat(0xbc57ac4cu));
+}
@@ -0,0 +1,137 @@
+#include "TestFramework.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "CounterRng.h"
+#include "ForestAnimation.h"
+using namespace DirectX;
+
+namespace
+{
+	constexpr uint32_t TestSeed = 1120231313;
+	constexpr uint32_t TestStream = 7;
+
+	// 原UpdateScene逐格子组合矩阵的写法，rand()换成与ForestAnimation相同的CounterRng随机数
+	void ReferenceUpdate(int size, float angle, std::vector<XMMATRIX>& parents, std::vector<XMMATRIX>& children)
+	{
+		parents.clear();
+		children.clear();
+		size_t child = 0;
+		for (int i = -size; i <= size; i++)
+		{
+			for (int j = -size; j <= size; j++)
+			{
+				float length = static_cast<float>(abs(i) + abs(j));
+				float scale = (sinf(0.05f * angle * 3.0f + i + j) + 1) * 0.25f;
+				auto mScale = XMMatrixScaling(scale, scale, scale);
+
+				auto mRotateSelf = XMMatrixRotationX(angle + i + j);
+				auto mRotateCommon = XMMatrixRotationY(angle * length * 0.05f);
+				auto mTranslateXY = XMMatrixTranslation(i * 2.0f, 0.0f, j * 2.0f);
+				auto mTranslateZ = XMMatrixTranslation(0, powf(11.5f - length, 2) * cosf(angle * 0.6f) * 0.015f, 0);
+
+				auto mTranslate = mTranslateXY * mRotateCommon * mTranslateZ;
+				parents.push_back(mScale * mRotateSelf * mTranslate);
+
+				scale *= 0.6f;
+				auto mTranslateChild = XMMatrixTranslation(3, 3, 0);
+				for (int k = 0; k < 6; ++k, ++child)
+				{
+					XMFLOAT4 r = CounterRng::Uniform4(TestSeed, TestStream, child);
+					auto mScaleChild = XMMatrixScaling(scale, scale, scale);
+					auto mRotateChild = XMMatrixRotationX(r.x * XM_2PI) * XMMatrixRotationY(r.y * XM_2PI) *
+						XMMatrixRotationZ(r.z * XM_2PI + angle);
+					children.push_back(mTranslateChild * mRotateSelf * mScaleChild * mRotateChild * mTranslate);
+				}
+			}
+		}
+	}
+
+	// 分别统计线性部分与平移的最大绝对误差
+	void MaxDifference(const InstanceTransforms& transforms, const std::vector<XMMATRIX>& expected,
+		float& linear, float& translation)
+	{
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			XMFLOAT4X4 a, b;
+			XMStoreFloat4x4(&a, transforms.Load(i));
+			XMStoreFloat4x4(&b, expected[i]);
+			for (int row = 0; row < 4; ++row)
+			{
+				for (int column = 0; column < 4; ++column)
+				{
+					float diff = fabsf(a.m[row][column] - b.m[row][column]);
+					float& maxDiff = row < 3 ? linear : translation;
+					maxDiff = (std::max)(maxDiff, diff);
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE(ForestAnimation_MatchesPerFrameMath)
+{
+	// 误差来源只有三角函数的实现与矩阵乘法的结合顺序：线性部分各元素不超过1，
+	// 平移最大约为2 * size * sqrt(2) + 3，允许的误差按float精度留出余量
+	const float LinearTolerance = 2e-5f;
+	const float TranslationTolerance = 2e-4f;
+	for (int size : { 0, 1, 12 })
+	{
+		ForestAnimation animation;
+		animation.Init(size, TestSeed, TestStream);
+		InstanceTransforms parentWorlds, childWorlds;
+		parentWorlds.Resize(animation.GetParentCount());
+		childWorlds.Resize(animation.GetChildCount());
+		CHECK(animation.GetParentCount() == static_cast<size_t>((2 * size + 1) * (2 * size + 1)));
+		CHECK(animation.GetChildCount() == animation.GetParentCount() * ForestAnimation::ChildCount);
+
+		std::vector<XMMATRIX> parents, children;
+		for (float angle : { 0.0f, 1.7f, 12.3f, 250.0f })
+		{
+			animation.Update(angle, parentWorlds, childWorlds);
+			ReferenceUpdate(size, angle, parents, children);
+			CHECK(parents.size() == parentWorlds.GetCount());
+			CHECK(children.size() == childWorlds.GetCount());
+
+			float parentLinear = 0.0f, parentTranslation = 0.0f, childLinear = 0.0f, childTranslation = 0.0f;
+			MaxDifference(parentWorlds, parents, parentLinear, parentTranslation);
+			MaxDifference(childWorlds, children, childLinear, childTranslation);
+			if (size == 12)
+			{
+				printf("  size %d, angle %6.1f: parent %.2e / %.2e, child %.2e / %.2e\n", size, angle,
+					parentLinear, parentTranslation, childLinear, childTranslation);
+			}
+			CHECK(parentLinear <= LinearTolerance);
+			CHECK(parentTranslation <= TranslationTolerance);
+			CHECK(childLinear <= LinearTolerance);
+			CHECK(childTranslation <= TranslationTolerance);
+		}
+	}
+}
+
+BENCHMARK_CASE(ForestAnimationUpdate)
+{
+	for (int size : { 12, 50, 200 })
+	{
+		ForestAnimation animation;
+		animation.Init(size, TestSeed, TestStream);
+		InstanceTransforms parentWorlds, childWorlds;
+		parentWorlds.Resize(animation.GetParentCount());
+		childWorlds.Resize(animation.GetChildCount());
+
+		float angle = 0.0f;
+		int repeat = size > 50 ? 5 : 50;
+		double updateMs = TestFramework::MeasureMilliseconds(repeat, [&]() {
+			animation.Update(angle += 0.016f, parentWorlds, childWorlds);
+		});
+		std::vector<XMMATRIX> parents, children;
+		parents.reserve(parentWorlds.GetCount());
+		children.reserve(childWorlds.GetCount());
+		double referenceMs = TestFramework::MeasureMilliseconds(repeat, [&]() {
+			ReferenceUpdate(size, angle += 0.016f, parents, children);
+		});
+		size_t matrixCount = parentWorlds.GetCount() + childWorlds.GetCount();
+		printf("  size %3d (%zu matrices): per-frame math %.2f ms, ForestAnimation %.2f ms (%.1f ns/matrix)\n",
+			size, matrixCount, referenceMs, updateMs, updateMs * 1e6 / matrixCount);
+	}
+}
@@ -0,0 +1,45 @@
+#include "TestFramework.h"
+#include <cmath>
+#include <cstring>
+#include "Geometry.h"
+using namespace DirectX;
+
+namespace
+{
+	template<class VertexType, class IndexType>
+	bool SameMeshBytes(const Geometry::MeshData<VertexType, IndexType>& a, const Geometry::MeshData<VertexType, IndexType>& b)
+	{
+		return a.vertexVec.size() == b.vertexVec.size() && a.indexVec.size() == b.indexVec.size() &&
+			memcmp(a.vertexVec.data(), b.vertexVec.data(), a.vertexVec.size() * sizeof(VertexType)) == 0 &&
+			memcmp(a.indexVec.data(), b.indexVec.data(), a.indexVec.size() * sizeof(IndexType)) == 0;
+	}
+
+	// 每种形状分别串行与并行生成一次，逐字节比较；细分数使顶点数远多于每个并行任务的粒度(16384个顶点)
+	template<class VertexType, class IndexType>
+	void CheckGeneratorsDeterministic(UINT scale)
+	{
+		const XMFLOAT4 color(0.2f, 0.4f, 0.6f, 1.0f);
+		auto heightFunc = [](float x, float z) { return 0.3f * (z * sinf(0.1f * x) + x * cosf(0.1f * z)); };
+
+		CHECK(SameMeshBytes(
+			Geometry::CreateGrid<VertexType, IndexType>(XMFLOAT2(160.0f, 90.0f), XMUINT2(scale, scale / 2), XMFLOAT2(8.0f, 4.0f), color, false),
+			Geometry::CreateGrid<VertexType, IndexType>(XMFLOAT2(160.0f, 90.0f), XMUINT2(scale, scale / 2), XMFLOAT2(8.0f, 4.0f), color, true)));
+		CHECK(SameMeshBytes(
+			Geometry::CreateHeightfield<VertexType, IndexType>(XMFLOAT2(160.0f, 90.0f), XMUINT2(scale / 2, scale), XMFLOAT2(8.0f, 4.0f), heightFunc, color, false),
+			Geometry::CreateHeightfield<VertexType, IndexType>(XMFLOAT2(160.0f, 90.0f), XMUINT2(scale / 2, scale), XMFLOAT2(8.0f, 4.0f), heightFunc, color, true)));
+		CHECK(SameMeshBytes(
+			Geometry::CreateSphere<VertexType, IndexType>(3.0f, scale, scale / 2, color, false),
+			Geometry::CreateSphere<VertexType, IndexType>(3.0f, scale, scale / 2, color, true)));
+		CHECK(SameMeshBytes(
+			Geometry::CreateCylinder<VertexType, IndexType>(1.5f, 4.0f, scale / 2, scale, 2.0f, 3.0f, color, false),
+			Geometry::CreateCylinder<VertexType, IndexType>(1.5f, 4.0f, scale / 2, scale, 2.0f, 3.0f, color, true)));
+	}
+}
+
+TEST_CASE(Geometry_ParallelMatchesSerial)
+{
+	// 立方体只有24个顶点，总是在当前线程上生成，不在比较之列
+	CheckGeneratorsDeterministic<VertexPosNormalTangentTex, DWORD>(600);
+	CheckGeneratorsDeterministic<VertexPosNormalColor, DWORD>(601);
+	CheckGeneratorsDeterministic<VertexPosTex, WORD>(300);
+}
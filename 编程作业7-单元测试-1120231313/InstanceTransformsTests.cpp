@@ -0,0 +1,228 @@
+#include "TestFramework.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "CounterRng.h"
+#include "InstanceTransforms.h"
+using namespace DirectX;
+
+namespace
+{
+	// 随机的仿射矩阵：第4列为(0, 0, 0, 1)，其余分量在[-4, 4)内
+	std::vector<XMMATRIX> RandomAffine(size_t count, uint32_t stream)
+	{
+		std::vector<XMMATRIX> worlds(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMFLOAT4X4 m;
+			for (uint32_t row = 0; row < 4; ++row)
+			{
+				XMFLOAT4 r = CounterRng::Uniform4(1120231313u, stream, i, row);
+				m.m[row][0] = r.x * 8.0f - 4.0f;
+				m.m[row][1] = r.y * 8.0f - 4.0f;
+				m.m[row][2] = r.z * 8.0f - 4.0f;
+				m.m[row][3] = row == 3 ? 1.0f : 0.0f;
+			}
+			worlds[i] = XMLoadFloat4x4(&m);
+		}
+		return worlds;
+	}
+
+	bool BitwiseEqual(const XMMATRIX& a, const XMMATRIX& b)
+	{
+		XMFLOAT4X4 fa, fb;
+		XMStoreFloat4x4(&fa, a);
+		XMStoreFloat4x4(&fb, b);
+		return memcmp(&fa, &fb, sizeof(XMFLOAT4X4)) == 0;
+	}
+}
+
+TEST_CASE(InstanceTransforms_RoundTrip)
+{
+	// 实例数目不是4的整数倍，批量保存从不同的位置开始
+	const size_t count = 37;
+	std::vector<XMMATRIX> worlds = RandomAffine(count, 1);
+	XMMATRIX identity = XMMatrixIdentity();
+
+	InstanceTransforms transforms;
+	transforms.Resize(count);
+	CHECK(transforms.GetCount() == count);
+	bool allIdentity = true;
+	for (size_t i = 0; i < count; ++i)
+		allIdentity &= BitwiseEqual(transforms.Load(i), identity);
+	CHECK(allIdentity);
+
+	for (size_t batch : { 1, 3, 4, 6, 9, 37 })
+	{
+		// 先用单个保存写入前几个实例，其余按batch个一组批量保存
+		transforms.Resize(count);
+		size_t head = batch % 3;
+		for (size_t i = 0; i < head; ++i)
+			transforms.Store(i, worlds[i]);
+		for (size_t first = head; first < count; first += batch)
+			transforms.StoreBatch(first, (std::min)(batch, count - first), &worlds[first]);
+
+		bool loaded = true;
+		for (size_t i = 0; i < count; ++i)
+			loaded &= BitwiseEqual(transforms.Load(i), worlds[i]);
+		CHECK(loaded);
+	}
+
+	// 第4列总是置为(0, 0, 0, 1)
+	XMMATRIX projective = worlds[0];
+	projective.r[0] = XMVectorSetW(projective.r[0], 2.0f);
+	projective.r[3] = XMVectorSetW(projective.r[3], 5.0f);
+	transforms.Store(0, projective);
+	CHECK(BitwiseEqual(transforms.Load(0), worlds[0]));
+
+	// 移动后内容不变，原对象为空
+	transforms.Store(0, worlds[0]);
+	InstanceTransforms moved(std::move(transforms));
+	CHECK(transforms.GetCount() == 0);
+	CHECK(moved.GetCount() == count);
+	CHECK(BitwiseEqual(moved.Load(count - 1), worlds[count - 1]));
+}
+
+namespace
+{
+	// 随机的仿射矩阵：旋转、缩放与平移，nonUniform为false时三个轴等比缩放，
+	// 否则各轴缩放在[0.5, 2)内并带有切变，条件数有界，逆矩阵的相对误差只取决于float精度
+	std::vector<XMMATRIX> RandomTransforms(size_t count, uint32_t stream, bool nonUniform)
+	{
+		std::vector<XMMATRIX> worlds(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMFLOAT4 a = CounterRng::Uniform4(1120231313u, stream, i, 0);
+			XMFLOAT4 b = CounterRng::Uniform4(1120231313u, stream, i, 1);
+			XMMATRIX rotation = XMMatrixRotationX(a.x * XM_2PI) * XMMatrixRotationY(a.y * XM_2PI) * XMMatrixRotationZ(a.z * XM_2PI);
+			XMMATRIX scale = nonUniform ? XMMatrixScaling(0.5f + 1.5f * b.x, 0.5f + 1.5f * b.y, 0.5f + 1.5f * b.z) :
+				XMMatrixScaling(0.5f + 1.5f * b.x, 0.5f + 1.5f * b.x, 0.5f + 1.5f * b.x);
+			XMMATRIX shear = XMMatrixIdentity();
+			if (nonUniform)
+				shear.r[1] = XMVectorSet(0.5f * b.w - 0.25f, 1.0f, 0.0f, 0.0f);
+			worlds[i] = shear * scale * rotation * XMMatrixTranslation(a.w * 100.0f - 50.0f, b.w * 10.0f, 3.0f);
+		}
+		return worlds;
+	}
+
+	// 左上3x3部分的最大误差除以参考矩阵左上3x3部分的最大元素；其余元素必须与单位矩阵完全相同
+	float RelativeInverseError(const XMMATRIX& inverse, const XMMATRIX& world, bool& affine)
+	{
+		XMFLOAT4X4 actual, expected;
+		XMStoreFloat4x4(&actual, inverse);
+		XMStoreFloat4x4(&expected, XMMatrixInverse(nullptr, world));
+		float maxError = 0.0f, maxElement = 0.0f;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				if (row < 3 && column < 3)
+				{
+					maxError = (std::max)(maxError, fabsf(actual.m[row][column] - expected.m[row][column]));
+					maxElement = (std::max)(maxElement, fabsf(expected.m[row][column]));
+				}
+				else
+				{
+					affine &= actual.m[row][column] == (row == column ? 1.0f : 0.0f);
+				}
+			}
+		}
+		return maxError / maxElement;
+	}
+
+	// 逐个实例与XMMatrixInverse比较，返回最大相对误差
+	float MaxInverseError(const std::vector<XMMATRIX>& worlds, bool& affine)
+	{
+		InstanceTransforms transforms, inverses;
+		transforms.Resize(worlds.size());
+		transforms.StoreBatch(0, worlds.size(), worlds.data());
+		transforms.ComputeInverses(inverses);
+		float maxError = 0.0f;
+		for (size_t i = 0; i < worlds.size(); ++i)
+			maxError = (std::max)(maxError, RelativeInverseError(inverses.Load(i), worlds[i], affine));
+		return maxError;
+	}
+}
+
+TEST_CASE(InstanceTransforms_InversesMatchXMMatrixInverse)
+{
+	// 均匀缩放的实例走转置除以缩放平方的路径，带切变的实例走伴随矩阵的路径，
+	// 两者交替时整组都按伴随矩阵计算；float求逆的相对误差为1e-6量级，留出一个数量级的余量
+	const float Tolerance = 1e-5f;
+	const size_t count = 4099;
+	std::vector<XMMATRIX> uniform = RandomTransforms(count, 3, false);
+	std::vector<XMMATRIX> general = RandomTransforms(count, 4, true);
+	std::vector<XMMATRIX> mixed(count);
+	for (size_t i = 0; i < count; ++i)
+		mixed[i] = i % 3 ? uniform[i] : general[i];
+
+	bool affine = true;
+	float uniformError = MaxInverseError(uniform, affine);
+	float generalError = MaxInverseError(general, affine);
+	float mixedError = MaxInverseError(mixed, affine);
+	printf("  max relative error: uniform %.2e, general %.2e, mixed %.2e\n", uniformError, generalError, mixedError);
+	CHECK(uniformError <= Tolerance);
+	CHECK(generalError <= Tolerance);
+	CHECK(mixedError <= Tolerance);
+	// 逆矩阵的平移为0，第4列为(0, 0, 0, 1)
+	CHECK(affine);
+}
+
+TEST_CASE(InstanceTransforms_PaddingStaysIdentity)
+{
+	// 实例数目不是4的整数倍时，最后一组的补齐实例与真实实例一起计算逆矩阵，两边的补齐都应保持单位矩阵
+	XMMATRIX identity = XMMatrixIdentity();
+	std::vector<XMMATRIX> general = RandomTransforms(11, 5, true);
+	bool padding = true, affine = true;
+	float maxError = 0.0f;
+	for (size_t count = 1; count <= general.size(); ++count)
+	{
+		InstanceTransforms transforms, inverses;
+		transforms.Resize(count);
+		transforms.StoreBatch(0, count, general.data());
+		// 先计算一次更大的数目，检查重新分配后补齐部分不保留旧的内容
+		inverses.Resize(general.size());
+		inverses.Store(general.size() - 1, general.back());
+		transforms.ComputeInverses(inverses);
+		transforms.ComputeInverses(inverses);
+
+		padding &= transforms.GetPaddedCount() == ((count + 3) & ~size_t(3));
+		padding &= inverses.GetCount() == count && inverses.GetPaddedCount() == transforms.GetPaddedCount();
+		for (size_t i = count; i < transforms.GetPaddedCount(); ++i)
+		{
+			padding &= BitwiseEqual(transforms.Load(i), identity);
+			padding &= BitwiseEqual(inverses.Load(i), identity);
+		}
+		for (size_t i = 0; i < count; ++i)
+			maxError = (std::max)(maxError, RelativeInverseError(inverses.Load(i), general[i], affine));
+	}
+	CHECK(padding);
+	CHECK(affine);
+	CHECK(maxError <= 1e-5f);
+}
+
+BENCHMARK_CASE(InstanceTransformsInverses)
+{
+	// 字符森林size为200时的子字符数目；逐个实例求逆对应原先每次绘制调用XMMatrixInverse(每帧两个绘制阶段各一次)
+	const size_t count = 964806;
+	for (bool nonUniform : { false, true })
+	{
+		std::vector<XMMATRIX> worlds = RandomTransforms(count, 6, nonUniform);
+		InstanceTransforms transforms, inverses;
+		transforms.Resize(count);
+		transforms.StoreBatch(0, count, worlds.data());
+		std::vector<XMMATRIX> perDraw(count);
+
+		double perDrawMs = TestFramework::MeasureMilliseconds(3, [&]() {
+			for (size_t i = 0; i < count; ++i)
+				perDraw[i] = XMMatrixInverse(nullptr, transforms.Load(i));
+		});
+		double batchedMs = TestFramework::MeasureMilliseconds(5, [&]() {
+			transforms.ComputeInverses(inverses);
+		});
+		printf("  %zu %s instances: XMMatrixInverse per draw %.2f ms per pass (%.2f ms for both passes), ComputeInverses %.2f ms\n",
+			count, nonUniform ? "sheared" : "uniform", perDrawMs, 2.0 * perDrawMs, batchedMs);
+	}
+}
@@ -0,0 +1,10 @@
+#include "TestFramework.h"
+#include <cstring>
+
+// 测试读取的模型文件以编程作业7的项目目录为工作目录
+// 带--benchmark参数时运行基准测试(应使用Release配置)，否则运行单元测试
+int main(int argc, char* argv[])
+{
+	bool benchmark = argc > 1 && strcmp(argv[1], "--benchmark") == 0;
+	return TestFramework::RunAll(benchmark) == 0 ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "CounterRng.h"
+#include "Geometry.h"
+#include "MeshCodec.h"
+#include "MeshOptimizer.h"
+using namespace DirectX;
+
+namespace
+{
+	// 随机数据的种子
+	constexpr uint32_t CodecSeed = 20240705;
+
+	bool IndicesRoundTrip(const std::vector<uint32_t>& indices)
+	{
+		std::vector<uint8_t> blob = MeshCodec::EncodeIndices(indices.data(), indices.size());
+		std::vector<uint32_t> decoded(indices.size());
+		bool ok = MeshCodec::DecodeIndices(decoded.data(), decoded.size(), blob.data(), blob.size()) && decoded == indices;
+		// 截断的数据须解码失败
+		if (!blob.empty())
+			ok &= !MeshCodec::DecodeIndices(decoded.data(), decoded.size(), blob.data(), blob.size() - 1);
+		return ok;
+	}
+
+	bool VerticesRoundTrip(const std::vector<uint8_t>& vertices, size_t vertexStride)
+	{
+		size_t vertexCount = vertices.size() / vertexStride;
+		std::vector<uint8_t> blob = MeshCodec::EncodeVertices(vertices.data(), vertexCount, vertexStride);
+		std::vector<uint8_t> decoded(vertices.size());
+		bool ok = MeshCodec::DecodeVertices(decoded.data(), vertexCount, vertexStride, blob.data(), blob.size()) && decoded == vertices;
+		if (!blob.empty())
+			ok &= !MeshCodec::DecodeVertices(decoded.data(), vertexCount, vertexStride, blob.data(), blob.size() - 1);
+		return ok;
+	}
+
+	// 生成各字节平面差值宽度不同的顶点数据：常量字节(0位)、缓慢变化(2/4位)与随机字节(8位)
+	std::vector<uint8_t> MakeVertexBytes(size_t vertexCount, size_t vertexStride, uint32_t stream)
+	{
+		std::vector<uint8_t> bytes(vertexCount * vertexStride);
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			for (size_t k = 0; k < vertexStride; ++k)
+			{
+				uint8_t value;
+				switch (k % 4)
+				{
+				case 0: value = static_cast<uint8_t>(k); break;
+				case 1: value = static_cast<uint8_t>(i / 3); break;
+				case 2: value = static_cast<uint8_t>(i * 5 + (i >> 4)); break;
+				default: value = static_cast<uint8_t>(CounterRng::Random4(CodecSeed, stream, i * vertexStride + k).x); break;
+				}
+				bytes[i * vertexStride + k] = value;
+			}
+		}
+		return bytes;
+	}
+
+	template<class VertexType>
+	std::vector<uint8_t> ToBytes(const std::vector<VertexType>& vertices)
+	{
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(vertices.data());
+		return std::vector<uint8_t>(p, p + vertices.size() * sizeof(VertexType));
+	}
+
+	// 压缩率与解码吞吐量，网格先经过与加载时相同的优化
+	template<class VertexType>
+	void BenchmarkCodec(const char* name, Geometry::MeshData<VertexType, DWORD> meshData)
+	{
+		MeshOptimizer::Optimize(meshData);
+		const auto& vertices = meshData.vertexVec;
+		const auto& indices = meshData.indexVec;
+		std::vector<uint8_t> vertexBlob = MeshCodec::EncodeVertexBuffer(vertices);
+		std::vector<uint8_t> indexBlob = MeshCodec::EncodeIndexBuffer(indices);
+
+		std::vector<VertexType> decodedVertices;
+		std::vector<DWORD> decodedIndices;
+		double vertexTime = TestFramework::MeasureMilliseconds(10, [&]() {
+			MeshCodec::DecodeVertexBuffer(decodedVertices, vertices.size(), vertexBlob.data(), vertexBlob.size());
+		});
+		double indexTime = TestFramework::MeasureMilliseconds(10, [&]() {
+			MeshCodec::DecodeIndexBuffer(decodedIndices, indices.size(), indexBlob.data(), indexBlob.size());
+		});
+		CHECK(memcmp(decodedVertices.data(), vertices.data(), vertices.size() * sizeof(VertexType)) == 0);
+		CHECK(decodedIndices == indices);
+
+		double vertexBytes = static_cast<double>(vertices.size() * sizeof(VertexType));
+		double indexBytes = static_cast<double>(indices.size() * sizeof(DWORD));
+		printf("  %-10s %7zu vertices: %5.1f%% of raw, %7.1f MB/s | %7zu indices: %5.1f%% of raw (%.2f bytes/tri), %7.1f MB/s\n",
+			name, vertices.size(), 100.0 * vertexBlob.size() / vertexBytes, vertexBytes / 1.0e3 / vertexTime,
+			indices.size(), 100.0 * indexBlob.size() / indexBytes, indexBlob.size() * 3.0 / indices.size(), indexBytes / 1.0e3 / indexTime);
+	}
+}
+
+TEST_CASE(MeshCodec_IndexRoundTrip)
+{
+	// 空输入与只有尾部索引的输入
+	CHECK(MeshCodec::EncodeIndices(nullptr, 0).empty());
+	CHECK(MeshCodec::DecodeIndices(nullptr, 0, nullptr, 0));
+	CHECK(IndicesRoundTrip({ 7 }));
+	CHECK(IndicesRoundTrip({ 7, 0xFFFFFFFEu }));
+
+	// 编码结果可以逐字节推算：三个三角形都未命中边FIFO，第一二个全是新顶点，第三个的0、3命中顶点FIFO，
+	// 第四个以边(1, 2)的反向命中边FIFO，第三个顶点是新顶点；最后两个索引作为尾部保存
+	std::vector<uint32_t> indices = { 0, 1, 2, 3, 4, 5, 0, 3, 6, 2, 1, 7, 1, 300 };
+	std::vector<uint8_t> blob = MeshCodec::EncodeIndices(indices.data(), indices.size());
+	const std::vector<uint8_t> expected = {
+		15, 0x00,			// 0 1 2：未命中，三个KindNext
+		15, 0x00,			// 3 4 5
+		15, 0x05, 5, 2,		// 0 3 6：KindFifo(位置5)、KindFifo(位置2)、KindNext
+		7,					// 2 1 7：命中第7新的边，旋转0，KindNext
+		1, 0xAC, 0x02		// 尾部的变长整数1与300
+	};
+	CHECK(blob == expected);
+	CHECK(IndicesRoundTrip(indices));
+
+	// 显式差值：向前与向后跳跃的索引，以及各种旋转下命中的边
+	CHECK(IndicesRoundTrip({ 100, 5, 70000, 70000, 5, 2, 5, 2, 100000, 1, 0, 2 }));
+
+	// 随机三角形多数走显式差值，模型网格主要走边FIFO
+	std::vector<uint32_t> randomIndices(3001);
+	for (size_t i = 0; i < randomIndices.size(); ++i)
+		randomIndices[i] = CounterRng::Random4(CodecSeed, 0, i).x % 5000;
+	CHECK(IndicesRoundTrip(randomIndices));
+	for (const char* filePath : { "Ning.obj", "Jie.obj" })
+	{
+		auto meshData = Geometry::CreateModel<VertexPosNormalColor>(filePath, false, false);
+		CHECK(IndicesRoundTrip(std::vector<uint32_t>(meshData.indexVec.begin(), meshData.indexVec.end())));
+	}
+
+	// WORD索引超出范围时解码失败
+	std::vector<uint32_t> wide = { 0, 1, 70000 };
+	blob = MeshCodec::EncodeIndices(wide.data(), wide.size());
+	std::vector<WORD> narrow;
+	CHECK(!MeshCodec::DecodeIndexBuffer(narrow, wide.size(), blob.data(), blob.size()));
+}
+
+TEST_CASE(MeshCodec_VertexRoundTrip)
+{
+	// 空输入
+	CHECK(MeshCodec::EncodeVertices(nullptr, 0, 32).empty());
+	CHECK(MeshCodec::DecodeVertices(nullptr, 0, 32, nullptr, 0));
+
+	// 顶点数不是16(一组)或256(一块)的倍数、步长为奇数，覆盖解码时组内与数据末尾不足16字节的情况
+	const size_t strides[] = { 1, 3, 7, 12, 28, 40 };
+	const size_t counts[] = { 1, 2, 15, 16, 17, 255, 256, 257, 1000, 5003 };
+	uint32_t stream = 0;
+	for (size_t stride : strides)
+	{
+		for (size_t count : counts)
+		{
+			CHECK(VerticesRoundTrip(MakeVertexBytes(count, stride, ++stream), stride));
+		}
+	}
+
+	// 所有字节相同或都是随机数时，只出现0位或8位的组
+	CHECK(VerticesRoundTrip(std::vector<uint8_t>(24 * 300, 0xA5), 24));
+	std::vector<uint8_t> noise(24 * 300);
+	for (size_t i = 0; i < noise.size(); ++i)
+		noise[i] = static_cast<uint8_t>(CounterRng::Random4(CodecSeed, 1000, i).y);
+	CHECK(VerticesRoundTrip(noise, 24));
+
+	// 差值恰好为zigzag映射的边界值：-1、1、-2、2、-8、8、-128与127
+	std::vector<uint8_t> edges;
+	for (int delta : { -1, 1, -2, 2, -8, 8, -128, 127 })
+	{
+		uint8_t value = 0;
+		for (size_t i = 0; i < 40; ++i)
+			edges.push_back(value = static_cast<uint8_t>(value + delta));
+	}
+	CHECK(VerticesRoundTrip(edges, 1));
+
+	// 模型顶点
+	for (const char* filePath : { "Ning.obj", "Jie.obj" })
+	{
+		auto meshData = Geometry::CreateModel<VertexPosNormalTangentTex>(filePath, false, false);
+		CHECK(VerticesRoundTrip(ToBytes(meshData.vertexVec), sizeof(VertexPosNormalTangentTex)));
+	}
+}
+
+BENCHMARK_CASE(MeshCodecRatioAndDecode)
+{
+	BenchmarkCodec("Ning", Geometry::CreateModel<VertexPosNormalColor>("Ning.obj", false, false));
+	BenchmarkCodec("Jie", Geometry::CreateModel<VertexPosNormalColor>("Jie.obj", false, false));
+	BenchmarkCodec("sphere", Geometry::CreateSphere<VertexPosNormalTex, DWORD>(1.0f, 400, 400));
+	BenchmarkCodec("grid", Geometry::CreateGrid<VertexPosNormalTex, DWORD>(XMFLOAT2(100.0f, 100.0f), XMUINT2(500, 500)));
+}
@@ -0,0 +1,273 @@
+#include "TestFramework.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "Geometry.h"
+using namespace DirectX;
+
+namespace
+{
+	// 与被测实现的结果比较时允许的夹角(弧度)，被测实现以单精度计算
+	constexpr double MaxAngleError = 1.0e-3;
+	// 折痕判断处于边界附近的角点不参与比较，单精度与双精度可能得到不同的判断
+	constexpr double CreaseMargin = 1.0e-4;
+
+	struct Vector3d
+	{
+		double x, y, z;
+	};
+
+	Vector3d ToDouble(const XMFLOAT3& v) { return { v.x, v.y, v.z }; }
+	Vector3d operator-(const Vector3d& a, const Vector3d& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	Vector3d operator+(const Vector3d& a, const Vector3d& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	Vector3d operator*(const Vector3d& a, double s) { return { a.x * s, a.y * s, a.z * s }; }
+	double Dot(const Vector3d& a, const Vector3d& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	double Length(const Vector3d& a) { return sqrt(Dot(a, a)); }
+	Vector3d Cross(const Vector3d& a, const Vector3d& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+	Vector3d Normalize(const Vector3d& a)
+	{
+		double length = Length(a);
+		return length > 0.0 ? a * (1.0 / length) : Vector3d{ 0.0, 0.0, 0.0 };
+	}
+	double AngleBetween(const Vector3d& a, const Vector3d& b)
+	{
+		return 2.0 * asin((std::min)(Length(Normalize(a) - Normalize(b)) * 0.5, 1.0));
+	}
+
+	// 三角形在第k个角点处的内角
+	double CornerAngle(const Vector3d p[3], int k)
+	{
+		Vector3d e1 = Normalize(p[(k + 1) % 3] - p[k]), e2 = Normalize(p[(k + 2) % 3] - p[k]);
+		return acos((std::max)(-1.0, (std::min)(1.0, Dot(e1, e2))));
+	}
+
+	// 标量参考：逐角点遍历所有三角形，在坐标相同的角点处累加与本三角形法线夹角不超过折痕角的三角形法线，
+	// 以内角加权；不做排序与分组，复杂度为角点数的平方，只用于小网格或抽样的角点
+	Vector3d ReferenceCornerNormal(const std::vector<XMFLOAT3>& positions, const std::vector<UINT>& corners,
+		size_t corner, double cosCrease, bool& nearCrease)
+	{
+		auto triangle = [&](size_t t, Vector3d p[3]) {
+			for (int k = 0; k < 3; ++k)
+				p[k] = ToDouble(positions[corners[t * 3 + k]]);
+		};
+		Vector3d p[3];
+		triangle(corner / 3, p);
+		Vector3d faceNormal = Normalize(Cross(p[1] - p[0], p[2] - p[0]));
+		const XMFLOAT3& pos = positions[corners[corner]];
+
+		Vector3d sum = {};
+		nearCrease = false;
+		for (size_t other = 0; other < corners.size(); ++other)
+		{
+			const XMFLOAT3& otherPos = positions[corners[other]];
+			if (otherPos.x != pos.x || otherPos.y != pos.y || otherPos.z != pos.z)
+				continue;
+			Vector3d q[3];
+			triangle(other / 3, q);
+			Vector3d otherNormal = Normalize(Cross(q[1] - q[0], q[2] - q[0]));
+			double cosine = Dot(faceNormal, otherNormal);
+			nearCrease |= fabs(cosine - cosCrease) < CreaseMargin;
+			if (cosine >= cosCrease)
+				sum = sum + otherNormal * CornerAngle(q, static_cast<int>(other % 3));
+		}
+		return sum;
+	}
+
+	// 逐角点与标量参考比较，stride为抽样间隔
+	void CheckNormalsAgainstReference(const std::vector<XMFLOAT3>& positions, const std::vector<UINT>& corners, size_t stride)
+	{
+		std::vector<XMFLOAT3> threaded = MeshNormals::GenerateCornerNormals(positions, corners);
+		std::vector<XMFLOAT3> serial = MeshNormals::GenerateCornerNormals(positions, corners, MeshNormals::DefaultCreaseAngle, false);
+		CHECK(threaded.size() == corners.size());
+		// 多线程与单线程的结果逐位相同
+		CHECK(serial.size() == threaded.size() &&
+			memcmp(serial.data(), threaded.data(), serial.size() * sizeof(XMFLOAT3)) == 0);
+
+		double cosCrease = cos(static_cast<double>(MeshNormals::DefaultCreaseAngle));
+		double maxError = 0.0;
+		size_t compared = 0;
+		for (size_t c = 0; c < corners.size(); c += stride)
+		{
+			bool nearCrease = false;
+			Vector3d reference = ReferenceCornerNormal(positions, corners, c, cosCrease, nearCrease);
+			if (nearCrease || Length(reference) < 1.0e-6)
+				continue;
+			Vector3d normal = ToDouble(threaded[c]);
+			CHECK(fabs(Length(normal) - 1.0) < 1.0e-5);
+			maxError = (std::max)(maxError, AngleBetween(normal, reference));
+			++compared;
+		}
+		printf("  %zu corners compared, max angle error %.2e rad\n", compared, maxError);
+		CHECK(compared > 0);
+		CHECK(maxError <= MaxAngleError);
+	}
+
+	template<class VertexType>
+	void GetPositionsAndCorners(const Geometry::MeshData<VertexType, DWORD>& meshData,
+		std::vector<XMFLOAT3>& positions, std::vector<UINT>& corners)
+	{
+		positions.clear();
+		for (const VertexType& vertex : meshData.vertexVec)
+			positions.push_back(vertex.pos);
+		corners.assign(meshData.indexVec.begin(), meshData.indexVec.end());
+	}
+
+	// 标量参考：同一顶点上纹理空间手性相同的角点，将三角形切线投影到顶点法线的切平面上按内角加权平均
+	Vector3d ReferenceTangent(const std::vector<VertexPosNormalTangentTex>& vertices, const std::vector<DWORD>& indices,
+		size_t corner, bool& orientation)
+	{
+		auto cornerTangent = [&](size_t c, bool& cornerOrientation, double& weight) {
+			size_t t = c / 3;
+			const VertexPosNormalTangentTex* v[3] = { &vertices[indices[t * 3]], &vertices[indices[t * 3 + 1]], &vertices[indices[t * 3 + 2]] };
+			Vector3d p[3] = { ToDouble(v[0]->pos), ToDouble(v[1]->pos), ToDouble(v[2]->pos) };
+			Vector3d e1 = p[1] - p[0], e2 = p[2] - p[0];
+			double du1 = double(v[1]->tex.x) - v[0]->tex.x, dv1 = double(v[1]->tex.y) - v[0]->tex.y;
+			double du2 = double(v[2]->tex.x) - v[0]->tex.x, dv2 = double(v[2]->tex.y) - v[0]->tex.y;
+			double signedArea = du1 * dv2 - du2 * dv1;
+			cornerOrientation = signedArea >= 0.0;
+			Vector3d faceTangent = signedArea != 0.0 ? (e1 * dv2 - e2 * dv1) * (1.0 / signedArea) : Vector3d{};
+			Vector3d normal = Normalize(ToDouble(vertices[indices[c]].normal));
+			Vector3d tangent = faceTangent - normal * Dot(normal, faceTangent);
+			bool degenerate = Length(Cross(e1, e2)) == 0.0 || Length(tangent) == 0.0;
+			weight = degenerate ? 0.0 : CornerAngle(p, static_cast<int>(c % 3));
+			return Normalize(tangent);
+		};
+
+		double weight = 0.0;
+		cornerTangent(corner, orientation, weight);
+		Vector3d sum = {};
+		for (size_t other = 0; other < indices.size(); ++other)
+		{
+			if (indices[other] != indices[corner])
+				continue;
+			bool otherOrientation = false;
+			Vector3d tangent = cornerTangent(other, otherOrientation, weight);
+			if (otherOrientation == orientation)
+				sum = sum + tangent * weight;
+		}
+		return sum;
+	}
+
+	// 由带法线与纹理坐标的网格生成切线，与标量参考比较，返回拆分出的顶点数
+	size_t CheckTangentsAgainstReference(const char* name, const Geometry::MeshData<VertexPosNormalTex, DWORD>& meshData)
+	{
+		std::vector<VertexPosNormalTangentTex> inputVertices(meshData.vertexVec.size());
+		for (size_t i = 0; i < inputVertices.size(); ++i)
+		{
+			inputVertices[i].pos = meshData.vertexVec[i].pos;
+			inputVertices[i].normal = meshData.vertexVec[i].normal;
+			inputVertices[i].tangent = XMFLOAT4();
+			inputVertices[i].tex = meshData.vertexVec[i].tex;
+		}
+		const std::vector<DWORD>& inputIndices = meshData.indexVec;
+
+		std::vector<VertexPosNormalTangentTex> vertices = inputVertices;
+		std::vector<DWORD> indices = inputIndices;
+		MeshNormals::GenerateTangents(vertices, indices);
+		std::vector<VertexPosNormalTangentTex> serialVertices = inputVertices;
+		std::vector<DWORD> serialIndices = inputIndices;
+		MeshNormals::GenerateTangents(serialVertices, serialIndices, false);
+		// 多线程与单线程的结果逐位相同
+		CHECK(serialVertices.size() == vertices.size() &&
+			memcmp(serialVertices.data(), vertices.data(), vertices.size() * sizeof(VertexPosNormalTangentTex)) == 0);
+		CHECK(serialIndices == indices);
+		CHECK(indices.size() == inputIndices.size());
+
+		double maxError = 0.0;
+		size_t compared = 0;
+		for (size_t c = 0; c < indices.size(); ++c)
+		{
+			const VertexPosNormalTangentTex& vertex = vertices[indices[c]];
+			const VertexPosNormalTangentTex& input = inputVertices[inputIndices[c]];
+			Vector3d tangent = { vertex.tangent.x, vertex.tangent.y, vertex.tangent.z };
+			Vector3d normal = Normalize(ToDouble(vertex.normal));
+			// 拆分顶点不改变位置、法线与纹理坐标，切线为单位向量且与法线垂直
+			CHECK(memcmp(&vertex.pos, &input.pos, sizeof(XMFLOAT3)) == 0);
+			CHECK(memcmp(&vertex.normal, &input.normal, sizeof(XMFLOAT3)) == 0);
+			CHECK(memcmp(&vertex.tex, &input.tex, sizeof(XMFLOAT2)) == 0);
+
+			bool orientation = false;
+			Vector3d reference = ReferenceTangent(inputVertices, inputIndices, c, orientation);
+			CHECK(vertex.tangent.w == (orientation ? 1.0f : -1.0f));
+			if (Length(reference) < 1.0e-6)
+				continue;
+			CHECK(fabs(Length(tangent) - 1.0) < 1.0e-5);
+			CHECK(fabs(Dot(tangent, normal)) < 1.0e-4);
+			maxError = (std::max)(maxError, AngleBetween(tangent, reference));
+			++compared;
+		}
+		printf("  %s: %zu corners compared, max angle error %.2e rad\n", name, compared, maxError);
+		CHECK(compared > 0);
+		CHECK(maxError <= MaxAngleError);
+		return vertices.size() - inputVertices.size();
+	}
+}
+
+TEST_CASE(MeshNormals_CornerNormalsMatchReference)
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<UINT> corners;
+
+	// 长方体各面之间为90°，超过默认折痕角，每个角点的法线都是所在面的法线
+	GetPositionsAndCorners(Geometry::CreateBox<VertexPosNormalColor, DWORD>(), positions, corners);
+	std::vector<XMFLOAT3> boxNormals = MeshNormals::GenerateCornerNormals(positions, corners);
+	for (size_t t = 0; t < corners.size() / 3; ++t)
+	{
+		Vector3d p[3] = { ToDouble(positions[corners[t * 3]]), ToDouble(positions[corners[t * 3 + 1]]), ToDouble(positions[corners[t * 3 + 2]]) };
+		Vector3d faceNormal = Cross(p[1] - p[0], p[2] - p[0]);
+		for (int k = 0; k < 3; ++k)
+			CHECK(AngleBetween(ToDouble(boxNormals[t * 3 + k]), faceNormal) < 1.0e-6);
+	}
+	CheckNormalsAgainstReference(positions, corners, 1);
+
+	// 圆柱的侧面平滑、与顶底面之间为硬边
+	GetPositionsAndCorners(Geometry::CreateCylinder<VertexPosNormalColor, DWORD>(1.0f, 2.0f, 24, 4), positions, corners);
+	CheckNormalsAgainstReference(positions, corners, 1);
+
+	// 模型文件中的网格，抽样比较
+	for (const char* filePath : { "Ning.obj", "Jie.obj" })
+	{
+		GetPositionsAndCorners(Geometry::CreateModel<VertexPosNormalColor>(filePath, false, false), positions, corners);
+		CheckNormalsAgainstReference(positions, corners, 7);
+	}
+}
+
+TEST_CASE(MeshNormals_TangentsMatchReference)
+{
+	// 模型文件中没有纹理坐标，使用带纹理坐标的几何体
+	CheckTangentsAgainstReference("box", Geometry::CreateBox<VertexPosNormalTex, DWORD>());
+	CheckTangentsAgainstReference("sphere", Geometry::CreateSphere<VertexPosNormalTex, DWORD>(1.0f, 20, 20));
+	CheckTangentsAgainstReference("cylinder", Geometry::CreateCylinder<VertexPosNormalTex, DWORD>(1.0f, 2.0f, 24, 4));
+
+	// 纹理坐标在x = 0处镜像，中间一列顶点两侧的手性相反，须拆分为两个顶点
+	auto grid = Geometry::CreateGrid<VertexPosNormalTex, DWORD>(XMFLOAT2(10.0f, 10.0f), XMUINT2(8, 8), XMFLOAT2(1.0f, 1.0f));
+	for (VertexPosNormalTex& vertex : grid.vertexVec)
+		vertex.tex.x = fabsf(vertex.pos.x);
+	size_t splitCount = CheckTangentsAgainstReference("mirrored grid", grid);
+	CHECK(splitCount == 9);
+}
+
+TEST_CASE(MeshNormals_SharedCopiesMatch)
+{
+	// 各次作业是独立的项目，MeshNormals与ThreadPool在编程作业3与7中各有一份，两份须保持一致
+	namespace fs = std::filesystem;
+	const fs::path otherDir = fs::u8path("../编程作业3-林间飞行-1120231313");
+	auto readAll = [](const fs::path& path) {
+		std::ifstream fin(path, std::ios::binary);
+		CHECK(fin.is_open());
+		return std::vector<char>(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	};
+	for (const char* fileName : { "MeshNormals.h", "ThreadPool.h", "ThreadPool.cpp" })
+	{
+		std::vector<char> ours = readAll(fs::u8path(fileName));
+		CHECK(!ours.empty());
+		CHECK(ours == readAll(otherDir / fs::u8path(fileName)));
+	}
+}
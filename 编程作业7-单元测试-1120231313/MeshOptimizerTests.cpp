@@ -0,0 +1,111 @@
+#include "TestFramework.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <vector>
+#include "MeshOptimizer.h"
+using namespace DirectX;
+
+namespace
+{
+	// 带有原始编号的顶点，重排后仍能找回每个顶点优化前的位置
+	struct TaggedVertex
+	{
+		XMFLOAT3 pos;
+		UINT id;
+	};
+
+	using Triangle = std::array<UINT, 3>;
+
+	// 将模型转换为带编号的顶点，保留索引与子网格
+	Geometry::MeshData<TaggedVertex, DWORD> LoadTagged(const char* filePath)
+	{
+		auto model = Geometry::CreateModel<VertexPosNormalColor>(filePath, false, false);
+		Geometry::MeshData<TaggedVertex, DWORD> meshData;
+		meshData.vertexVec.resize(model.vertexVec.size());
+		for (size_t i = 0; i < model.vertexVec.size(); ++i)
+			meshData.vertexVec[i] = { model.vertexVec[i].pos, static_cast<UINT>(i) };
+		meshData.indexVec = std::move(model.indexVec);
+		meshData.submeshes = std::move(model.submeshes);
+		return meshData;
+	}
+
+	// 取出[indexStart, indexStart + indexCount)中的三角形，以原始编号表示
+	// sortCorners为true时每个三角形的编号排序；否则只旋转到最小编号在前，保留环绕方向
+	std::vector<Triangle> GetTriangles(const Geometry::MeshData<TaggedVertex, DWORD>& meshData,
+		size_t indexStart, size_t indexCount, bool sortCorners)
+	{
+		std::vector<Triangle> triangles;
+		for (size_t i = indexStart; i + 2 < indexStart + indexCount; i += 3)
+		{
+			Triangle t = { meshData.vertexVec[meshData.indexVec[i]].id, meshData.vertexVec[meshData.indexVec[i + 1]].id,
+				meshData.vertexVec[meshData.indexVec[i + 2]].id };
+			if (sortCorners)
+				std::sort(t.begin(), t.end());
+			else
+				std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+			triangles.push_back(t);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// 优化前后每个子网格(没有子网格时为整个网格)的三角形集合相同，环绕方向不变
+	void CheckTrianglesUnchanged(Geometry::MeshData<TaggedVertex, DWORD> meshData, bool optimizeOverdraw)
+	{
+		std::vector<std::pair<size_t, size_t>> ranges;
+		for (const Geometry::Submesh& submesh : meshData.submeshes)
+			ranges.emplace_back(submesh.indexStart, submesh.indexCount);
+		if (ranges.empty())
+			ranges.emplace_back(0, meshData.indexVec.size());
+
+		std::vector<std::vector<Triangle>> sortedBefore, rotatedBefore;
+		for (const auto& range : ranges)
+		{
+			sortedBefore.push_back(GetTriangles(meshData, range.first, range.second, true));
+			rotatedBefore.push_back(GetTriangles(meshData, range.first, range.second, false));
+		}
+		size_t indexCount = meshData.indexVec.size();
+
+		MeshOptimizer::OptimizeReport report = MeshOptimizer::Optimize(meshData, optimizeOverdraw);
+		printf("  ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", report.before.acmr, report.after.acmr,
+			report.before.atvr, report.after.atvr);
+		CHECK(report.after.acmr <= report.before.acmr);
+		CHECK(meshData.indexVec.size() == indexCount);
+
+		for (size_t r = 0; r < ranges.size(); ++r)
+		{
+			CHECK(GetTriangles(meshData, ranges[r].first, ranges[r].second, true) == sortedBefore[r]);
+			CHECK(GetTriangles(meshData, ranges[r].first, ranges[r].second, false) == rotatedBefore[r]);
+		}
+
+		// 顶点读取优化后顶点按首次引用的顺序排列
+		UINT nextVertex = 0;
+		for (DWORD index : meshData.indexVec)
+		{
+			CHECK(index <= nextVertex);
+			if (index == nextVertex)
+				++nextVertex;
+		}
+		CHECK(nextVertex == meshData.vertexVec.size());
+	}
+}
+
+TEST_CASE(MeshOptimizer_TrianglesUnchanged)
+{
+	for (const char* filePath : { "Ning.obj", "Jie.obj" })
+	{
+		CheckTrianglesUnchanged(LoadTagged(filePath), false);
+		CheckTrianglesUnchanged(LoadTagged(filePath), true);
+	}
+
+	// 多个子网格时三角形只在各自的范围内重排
+	auto meshData = LoadTagged("Jie.obj");
+	size_t half = meshData.indexVec.size() / 6 * 3;
+	meshData.submeshes.resize(2);
+	meshData.submeshes[0].indexStart = 0;
+	meshData.submeshes[0].indexCount = static_cast<UINT>(half);
+	meshData.submeshes[1].indexStart = static_cast<UINT>(half);
+	meshData.submeshes[1].indexCount = static_cast<UINT>(meshData.indexVec.size() - half);
+	CheckTrianglesUnchanged(meshData, true);
+}
@@ -0,0 +1,67 @@
+#include "TestFramework.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include "MeshRegistry.h"
+
+namespace
+{
+	// 同一个文件的不同写法，工作目录为编程作业7所在目录
+	// 最后一种经过含中文的目录，检查规范化不依赖系统区域设置
+	const std::vector<std::string> ningSpellings = {
+		"Ning.obj",
+		"./Ning.obj",
+		"Texture/../Ning.obj",
+		"./Texture/.././Ning.obj",
+		u8"../编程作业7-镜中世界-1120231313/Ning.obj",
+#ifdef _WIN32
+		"NING.OBJ",
+		"Texture\\..\\ning.obj",
+#endif
+	};
+}
+
+TEST_CASE(MeshRegistry_CanonicalPathSpellings)
+{
+	std::string expected = MeshRegistry::CanonicalPath(ningSpellings[0]);
+	bool same = true;
+	for (const std::string& path : ningSpellings)
+		same &= MeshRegistry::CanonicalPath(path) == expected;
+	CHECK(same);
+	CHECK(MeshRegistry::CanonicalPath("Jie.obj") != expected);
+
+	// 结果为UTF-8，中文目录名原样保留
+	std::string chinese = MeshRegistry::CanonicalPath(u8"../编程作业7-镜中世界-1120231313");
+	CHECK(chinese.find(u8"编程作业7-镜中世界-1120231313") != std::string::npos);
+	// 不存在的文件同样能规范化
+	CHECK(MeshRegistry::CanonicalPath(u8"不存在/../模型.obj") == MeshRegistry::CanonicalPath(u8"./模型.obj"));
+}
+
+TEST_CASE(MeshRegistry_SpellingsShareEntry)
+{
+	MeshRegistry registry;
+	size_t loaderCalls = 0;
+	auto loader = [&loaderCalls]() {
+		++loaderCalls;
+		return std::make_shared<MeshResource>();
+	};
+
+	// 每种写法都应取得同一份网格，loader只调用一次
+	std::vector<MeshHandle> handles;
+	for (const std::string& path : ningSpellings)
+		handles.push_back(registry.Acquire<VertexPosNormalTex>(nullptr, path, loader));
+	bool same = true;
+	for (const MeshHandle& handle : handles)
+		same &= handle == handles[0];
+	CHECK(same);
+	CHECK(loaderCalls == 1);
+	CHECK(registry.GetLoadCount() == 1);
+	CHECK(registry.GetRequestCount() == ningSpellings.size());
+
+	// 不同文件、不同顶点格式各自加载
+	MeshHandle jie = registry.Acquire<VertexPosNormalTex>(nullptr, "Jie.obj", loader);
+	MeshHandle ningColor = registry.Acquire<VertexPosNormalColor>(nullptr, "Ning.obj", loader);
+	CHECK(jie != handles[0]);
+	CHECK(ningColor != handles[0]);
+	CHECK(loaderCalls == 3);
+}
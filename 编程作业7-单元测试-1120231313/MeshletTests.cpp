@@ -0,0 +1,174 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <vector>
+#include "MeshletBuilder.h"
+using namespace DirectX;
+
+namespace
+{
+	// 测试用的网格与簇，在固定的摄像机位置下剔除
+	struct ClusteredMesh
+	{
+		Geometry::MeshData<VertexPosNormalColor, DWORD> meshData;
+		std::vector<MeshletBuilder::Meshlet> meshlets;
+	};
+
+	ClusteredMesh BuildSphere()
+	{
+		ClusteredMesh mesh;
+		mesh.meshData = Geometry::CreateSphere<VertexPosNormalColor, DWORD>(2.0f, 40, 40);
+		mesh.meshlets = MeshletBuilder::BuildMeshlets(mesh.meshData);
+		return mesh;
+	}
+
+	// 与GameApp相同的投影，以及镜面反射(z = 40平面)与几何着色器的镜像(x = 30平面)
+	XMMATRIX GetViewProj(FXMVECTOR eye, FXMVECTOR target)
+	{
+		return XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) *
+			XMMatrixPerspectiveFovLH(XM_PI / 3, 16.0f / 9.0f, 0.5f, 1000.0f);
+	}
+	const XMMATRIX& GetReflection()
+	{
+		static const XMMATRIX reflection = XMMatrixReflect(XMVectorSet(0.0f, 0.0f, -1.0f, 40.0f));
+		return reflection;
+	}
+	const XMMATRIX& GetGSMirror()
+	{
+		static const XMMATRIX gsMirror = XMMatrixReflect(XMVectorSet(1.0f, 0.0f, 0.0f, -30.0f));
+		return gsMirror;
+	}
+
+	// 逐三角形判断簇在某个副本中是否确实可见：存在一个三角形在屏幕上为顺时针(默认光栅化状态下的正面)，
+	// 且至少一个顶点位于视锥体内；变换后在世界空间中判断，不依赖剔除代码中的行列式
+	bool IsMeshletVisible(const ClusteredMesh& mesh, const MeshletBuilder::Meshlet& meshlet,
+		FXMMATRIX transform, CXMMATRIX viewProj, FXMVECTOR eye)
+	{
+		const auto& vertices = mesh.meshData.vertexVec;
+		const auto& indices = mesh.meshData.indexVec;
+		for (UINT i = meshlet.indexStart; i < meshlet.indexStart + meshlet.indexCount; i += 3)
+		{
+			XMVECTOR w[3];
+			bool inFrustum = false;
+			for (int k = 0; k < 3; ++k)
+			{
+				w[k] = XMVector3TransformCoord(XMLoadFloat3(&vertices[indices[i + k]].pos), transform);
+				XMFLOAT4 clip;
+				XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(w[k], 1.0f), viewProj));
+				inFrustum |= clip.w > 0.0f && fabsf(clip.x) <= clip.w && fabsf(clip.y) <= clip.w && clip.z >= 0.0f && clip.z <= clip.w;
+			}
+			// 左手坐标系中，从摄像机看去为顺时针的三角形，其叉积朝向摄像机
+			float facing = XMVectorGetX(XMVector3Dot(XMVector3Cross(w[1] - w[0], w[2] - w[0]), eye - w[0]));
+			if (inFrustum && facing > 0.0f)
+				return true;
+		}
+		return false;
+	}
+
+	// 剔除并检查结果的保守性：确实可见的簇一定保留，返回的绘制范围恰好覆盖保留的簇
+	MeshletBuilder::CullStatistics CullAndCheck(const ClusteredMesh& mesh, const XMMATRIX* transforms, size_t transformCount,
+		FXMVECTOR eye, FXMVECTOR target)
+	{
+		XMMATRIX viewProj = GetViewProj(eye, target);
+		XMFLOAT3 eyePos;
+		XMStoreFloat3(&eyePos, eye);
+		std::vector<MeshletBuilder::DrawRange> ranges;
+		MeshletBuilder::CullStatistics stats = MeshletBuilder::CullMeshlets(mesh.meshlets, transforms, transformCount,
+			viewProj, eyePos, ranges);
+		CHECK(stats.meshletCount == mesh.meshlets.size());
+
+		UINT keptIndices = 0, culledIndices = 0;
+		for (const MeshletBuilder::Meshlet& meshlet : mesh.meshlets)
+		{
+			bool kept = false;
+			for (const MeshletBuilder::DrawRange& range : ranges)
+				kept |= meshlet.indexStart >= range.indexStart && meshlet.indexStart < range.indexStart + range.indexCount;
+			bool visible = false;
+			for (size_t c = 0; c < transformCount; ++c)
+				visible |= IsMeshletVisible(mesh, meshlet, transforms[c], viewProj, eye);
+			CHECK(kept || !visible);
+			(kept ? keptIndices : culledIndices) += meshlet.indexCount;
+		}
+		UINT rangeIndices = 0;
+		for (const MeshletBuilder::DrawRange& range : ranges)
+			rangeIndices += range.indexCount;
+		CHECK(rangeIndices == keptIndices);
+		CHECK(stats.frustumCulled + stats.backfaceCulled <= stats.meshletCount);
+
+		printf("  %u meshlets: %u frustum culled, %u backface culled\n", stats.meshletCount, stats.frustumCulled, stats.backfaceCulled);
+		return stats;
+	}
+}
+
+TEST_CASE(Meshlet_CullIdentity)
+{
+	ClusteredMesh mesh = BuildSphere();
+	CHECK(mesh.meshlets.size() > 8);
+	XMMATRIX world = XMMatrixTranslation(0.0f, 0.0f, 10.0f);
+
+	// 正对球体：整个球在视锥体内，背面约一半的簇被剔除
+	auto stats = CullAndCheck(mesh, &world, 1, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f));
+	CHECK(stats.frustumCulled == 0);
+	CHECK(stats.backfaceCulled > 0);
+	CHECK(stats.backfaceCulled < stats.meshletCount);
+
+	// 背对球体：全部在视锥体外
+	stats = CullAndCheck(mesh, &world, 1, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, -1.0f, 1.0f));
+	CHECK(stats.frustumCulled == stats.meshletCount);
+
+	// 球体位于视野右侧边缘：一部分簇在视锥体外
+	stats = CullAndCheck(mesh, &world, 1, XMVectorSet(-9.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(-9.0f, 0.0f, 10.0f, 1.0f));
+	CHECK(stats.frustumCulled > 0);
+	CHECK(stats.frustumCulled < stats.meshletCount);
+}
+
+TEST_CASE(Meshlet_CullReflected)
+{
+	// 镜面反射后的副本行列式为负，默认光栅化状态下正面翻转，剔除须按翻转后的正面判断
+	ClusteredMesh mesh = BuildSphere();
+	XMMATRIX world = XMMatrixRotationY(0.7f) * XMMatrixTranslation(5.0f, 1.0f, 30.0f);
+	XMMATRIX reflected = world * GetReflection();
+	CHECK(XMVectorGetX(XMMatrixDeterminant(reflected)) < 0.0f);
+
+	// 摄像机在镜子前看向镜中的副本(位于z = 50附近)
+	auto stats = CullAndCheck(mesh, &reflected, 1, XMVectorSet(5.0f, 1.0f, 20.0f, 1.0f), XMVectorSet(5.0f, 1.0f, 50.0f, 1.0f));
+	CHECK(stats.frustumCulled == 0);
+	CHECK(stats.backfaceCulled > 0);
+	CHECK(stats.backfaceCulled < stats.meshletCount);
+}
+
+TEST_CASE(Meshlet_CullGSMirrored)
+{
+	// 与GameApp相同的两份副本：正常物体为(world, world * gsMirror)，反射物体为(world * reflection, world * reflection * gsMirror)
+	ClusteredMesh mesh = BuildSphere();
+	XMMATRIX world = XMMatrixRotationX(0.3f) * XMMatrixTranslation(26.0f, 0.0f, 20.0f);
+
+	XMMATRIX copies[2] = { world, world * GetGSMirror() };
+	CHECK(XMVectorGetX(XMMatrixDeterminant(copies[1])) < 0.0f);
+	// 摄像机位于镜像平面上，两份副本分居两侧，都在视野内
+	auto stats = CullAndCheck(mesh, copies, 2, XMVectorSet(30.0f, 0.0f, 5.0f, 1.0f), XMVectorSet(30.0f, 0.0f, 20.0f, 1.0f));
+	CHECK(stats.frustumCulled == 0);
+	// 任一副本可见即保留，两份副本各自的背面不同，合起来被剔除的簇少于单独一份
+	XMMATRIX viewProj = GetViewProj(XMVectorSet(30.0f, 0.0f, 5.0f, 1.0f), XMVectorSet(30.0f, 0.0f, 20.0f, 1.0f));
+	std::vector<MeshletBuilder::DrawRange> ranges;
+	auto single = MeshletBuilder::CullMeshlets(mesh.meshlets, copies, 1, viewProj, XMFLOAT3(30.0f, 0.0f, 5.0f), ranges);
+	CHECK(stats.backfaceCulled < single.backfaceCulled);
+
+	// 只有镜像副本在视野内：摄像机靠近x > 30的一侧，另一份副本被视锥体排除，剔除只取决于翻转后的正面
+	stats = CullAndCheck(mesh, copies, 2, XMVectorSet(38.0f, 0.0f, 12.0f, 1.0f), XMVectorSet(38.0f, 0.0f, 20.0f, 1.0f));
+	CHECK(stats.frustumCulled == 0);
+	CHECK(stats.backfaceCulled > 0);
+
+	// 反射后再镜像，两份副本的行列式分别为负与正
+	XMMATRIX reflected[2] = { world * GetReflection(), world * GetReflection() * GetGSMirror() };
+	CHECK(XMVectorGetX(XMMatrixDeterminant(reflected[0])) < 0.0f);
+	CHECK(XMVectorGetX(XMMatrixDeterminant(reflected[1])) > 0.0f);
+	stats = CullAndCheck(mesh, reflected, 2, XMVectorSet(30.0f, 0.0f, 45.0f, 1.0f), XMVectorSet(30.0f, 0.0f, 60.0f, 1.0f));
+	CHECK(stats.frustumCulled == 0);
+	// 分别只让其中一份副本位于视野内
+	for (float x : { 22.0f, 38.0f })
+	{
+		stats = CullAndCheck(mesh, reflected, 2, XMVectorSet(x, 0.0f, 52.0f, 1.0f), XMVectorSet(x, 0.0f, 60.0f, 1.0f));
+		CHECK(stats.frustumCulled == 0);
+		CHECK(stats.backfaceCulled > 0);
+	}
+}
@@ -0,0 +1,367 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Geometry.h"
+#include <Psapi.h>
+
+#pragma comment(lib, "psapi.lib")
+
+namespace
+{
+	// 合成文件的网格边长，生成的文件约10MB，足以按1MB的最小块大小切分为多块
+	constexpr int SyntheticGridSize = 300;
+	// 与CreateModel中的最小块大小一致
+	constexpr size_t MinChunkSize = 1 << 20;
+	// 流式读取内存测试的网格边长，生成的文件约90MB，全部属性与颜色数组约36MB
+	constexpr int StreamingGridSize = 1000;
+	// 流式读取期间工作集增长的上限，窗口、子网格与其去重表合计约15MB
+	constexpr size_t StreamingMemoryCap = 24 << 20;
+	// 读取耗时基准测试的合成网格边长，含vn时四分之一的格子为四边形、其余为两个三角形，共约101万个面
+	constexpr int BenchmarkGridSize = 760;
+
+	template<class VertexType>
+	bool SameMesh(const Geometry::MeshData<VertexType, DWORD>& a, const Geometry::MeshData<VertexType, DWORD>& b)
+	{
+		if (a.vertexVec.size() != b.vertexVec.size() || a.indexVec.size() != b.indexVec.size() ||
+			a.submeshes.size() != b.submeshes.size())
+			return false;
+		// 顶点与索引按字节比较
+		if (!a.vertexVec.empty() && memcmp(a.vertexVec.data(), b.vertexVec.data(), a.vertexVec.size() * sizeof(VertexType)) != 0)
+			return false;
+		if (!a.indexVec.empty() && memcmp(a.indexVec.data(), b.indexVec.data(), a.indexVec.size() * sizeof(DWORD)) != 0)
+			return false;
+		// 子网格含有std::string，逐项比较，材质参数按字节比较
+		for (size_t i = 0; i < a.submeshes.size(); ++i)
+		{
+			const Geometry::Submesh& x = a.submeshes[i];
+			const Geometry::Submesh& y = b.submeshes[i];
+			if (x.materialName != y.materialName || x.hasMaterial != y.hasMaterial ||
+				x.indexStart != y.indexStart || x.indexCount != y.indexCount ||
+				memcmp(&x.material, &y.material, sizeof(Material)) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// 分别以单线程与多线程读取同一文件(不使用缓存)，结果须逐字节相同
+	template<class VertexType>
+	void CheckParallelMatchesSerial(const std::string& filePath)
+	{
+		auto serial = Geometry::CreateModel<VertexType>(filePath, false, false);
+		auto parallel = Geometry::CreateModel<VertexType>(filePath, true, false);
+		CHECK(!serial.indexVec.empty());
+		CHECK(SameMesh(serial, parallel));
+	}
+
+	// 生成一个网格状的OBJ文件，包含注释、对象与分组、vt/vn、相对索引、三角形与四边形，
+	// 以及反复切换的usemtl(同名材质的三角形分散在各块中)
+	void WriteSyntheticObj(const std::string& filePath, bool withNormals, int gridSize = SyntheticGridSize)
+	{
+		std::ofstream fout(filePath, std::ios::binary);
+		if (!fout)
+			throw std::runtime_error("Failed to create the synthetic OBJ file.");
+
+		const int n = gridSize;
+		fout << "# synthetic grid " << n << "x" << n << "\nmtllib synthetic.mtl\no grid\n";
+		for (int i = 0; i <= n; ++i)
+		{
+			for (int j = 0; j <= n; ++j)
+			{
+				fout << "v " << j << " " << ((i * 7 + j * 3) % 11) * 0.05f << " " << i << "\n";
+				fout << "vt " << j / float(n) << " " << i / float(n) << "\n";
+				if (withNormals)
+					fout << "vn " << (j % 5) * 0.1f << " 1 " << (i % 3) * 0.1f << "\n";
+			}
+		}
+		const char* materials[] = { "stone", "moss", "bark" };
+		const int count = (n + 1) * (n + 1);
+		for (int i = 0; i < n; ++i)
+		{
+			fout << "g row" << i << "\nusemtl " << materials[(i / 7) % 3] << "\n";
+			for (int j = 0; j < n; ++j)
+			{
+				int a = i * (n + 1) + j + 1, b = a + n + 1;
+				if (withNormals && (i + j) % 4 == 0)
+				{
+					fout << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " "
+						<< b + 1 << "/" << b + 1 << "/" << b + 1 << " " << a + 1 << "/" << a + 1 << "/" << a + 1 << "\n";
+				}
+				else if (withNormals)
+				{
+					fout << "f " << a << "//" << a << " " << b << "//" << b << " " << b + 1 << "//" << b + 1 << "\n";
+					fout << "f " << a << "//" << a << " " << b + 1 << "//" << b + 1 << " " << a + 1 << "//" << a + 1 << "\n";
+				}
+				else
+				{
+					// 相对索引：-1为到目前为止的最后一个位置
+					fout << "f " << a - count - 1 << "/" << a << " " << b - count - 1 << "/" << b << " "
+						<< b - count << "/" << b + 1 << " " << a - count << "/" << a + 1 << "\n";
+				}
+			}
+		}
+	}
+
+	// 确认合成文件在多线程模式下确实会被切分为多块
+	size_t CountChunks(const std::string& filePath)
+	{
+		MappedFile file;
+		if (!file.Open(filePath))
+			return 0;
+		return ObjReader::SplitLines(file.Begin(), file.End(), 64, MinChunkSize).size() - 1;
+	}
+
+	// 将网格按索引展开为每个角点一个顶点
+	template<class VertexType>
+	void AppendCorners(std::vector<VertexType>& corners, const Geometry::MeshData<VertexType, DWORD>& meshData)
+	{
+		for (DWORD index : meshData.indexVec)
+			corners.push_back(meshData.vertexVec[index]);
+	}
+
+	// 以很小的窗口与子网格上限流式读取，所有子网格拼接后须与CreateModel逐字节相同
+	template<class VertexType>
+	void CheckStreamMatchesCreate(const std::string& filePath)
+	{
+		static constexpr size_t windowSize = 4096;
+		static constexpr size_t maxChunkVertices = 300;
+		static constexpr size_t maxChunkTriangles = 200;
+
+		std::vector<VertexType> streamed;
+		size_t chunkCount = 0;
+		Geometry::StreamModel<VertexType>(filePath, [&](const Geometry::MeshData<VertexType, DWORD>& chunk) {
+			CHECK(chunk.vertexVec.size() <= maxChunkVertices);
+			CHECK(chunk.indexVec.size() <= 3 * maxChunkTriangles);
+			AppendCorners(streamed, chunk);
+			++chunkCount;
+		}, windowSize, maxChunkVertices, maxChunkTriangles);
+
+		std::vector<VertexType> created;
+		AppendCorners(created, Geometry::CreateModel<VertexType>(filePath, false, false));
+		CHECK(chunkCount > 1);
+		CHECK(streamed.size() == created.size());
+		CHECK(streamed.size() == created.size() &&
+			memcmp(streamed.data(), created.data(), streamed.size() * sizeof(VertexType)) == 0);
+	}
+
+	// 原先的读取方式：getline逐行复制为字符串，再逐行用istringstream解析，只作为基准测试的对照
+	// 与原实现一样只取面记录中每个顶点的第一个整数，返回三角形数目
+	size_t LoadObjLegacy(const std::string& filePath)
+	{
+		std::ifstream file(filePath);
+		if (!file.is_open())
+			throw std::runtime_error("Failed to open OBJ file.");
+
+		std::string line;
+		std::vector<std::string> s_vertices, s_indices, s_normals;
+		while (std::getline(file, line))
+		{
+			if (line.size() > 1 && line[0] == 'v' && line[1] == ' ')
+				s_vertices.push_back(line.substr(2));
+			else if (line.size() > 2 && line[0] == 'v' && line[1] == 'n')
+				s_normals.push_back(line.substr(3));
+			else if (line.size() > 1 && line[0] == 'f')
+				s_indices.push_back(line.substr(2));
+		}
+
+		std::vector<DirectX::XMFLOAT3> positions(s_vertices.size()), normals(s_normals.size());
+		for (size_t i = 0; i < s_vertices.size(); ++i)
+		{
+			std::istringstream data(s_vertices[i]);
+			data >> positions[i].x >> positions[i].y >> positions[i].z;
+		}
+		for (size_t i = 0; i < s_normals.size(); ++i)
+		{
+			std::istringstream data(s_normals[i]);
+			data >> normals[i].x >> normals[i].y >> normals[i].z;
+		}
+		std::vector<DWORD> indices(3 * s_indices.size());
+		for (size_t i = 0; i < s_indices.size(); ++i)
+		{
+			std::istringstream data(s_indices[i]);
+			std::string s_a, s_b, s_c;
+			data >> s_a >> s_b >> s_c;
+			int a, b, c;
+			std::istringstream ss_a(s_a), ss_b(s_b), ss_c(s_c);
+			ss_a >> a;
+			ss_b >> b;
+			ss_c >> c;
+			indices[3 * i] = a - 1;
+			indices[3 * i + 1] = b - 1;
+			indices[3 * i + 2] = c - 1;
+		}
+		return s_indices.size();
+	}
+
+	// 比较原先的读取方式与CreateModel的单线程、多线程模式(均不使用缓存)
+	void BenchmarkObjLoad(const std::string& filePath, int repeatCount)
+	{
+		double legacy = TestFramework::MeasureMilliseconds(repeatCount, [&]() { LoadObjLegacy(filePath); });
+		double serial = TestFramework::MeasureMilliseconds(repeatCount, [&]() {
+			Geometry::CreateModel<VertexPosNormalColor>(filePath, false, false);
+		});
+		double parallel = TestFramework::MeasureMilliseconds(repeatCount, [&]() {
+			Geometry::CreateModel<VertexPosNormalColor>(filePath, true, false);
+		});
+		printf("  %-24s legacy %9.2f ms | mapped %9.2f ms (%5.1fx) | parallel %9.2f ms (%5.1fx)\n", filePath.c_str(),
+			legacy, serial, legacy / serial, parallel, legacy / parallel);
+	}
+
+	// 进程当前的工作集字节数
+	size_t GetWorkingSetSize()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.WorkingSetSize;
+	}
+}
+
+TEST_CASE(ObjParallelMatchesSerial_Models)
+{
+	for (const char* filePath : { "Ning.obj", "Jie.obj" })
+	{
+		CheckParallelMatchesSerial<VertexPosNormalColor>(filePath);
+		CheckParallelMatchesSerial<VertexPosNormalTex>(filePath);
+		CheckParallelMatchesSerial<VertexPosNormalTangentTex>(filePath);
+	}
+}
+
+TEST_CASE(ObjParallelMatchesSerial_MultiChunk)
+{
+	const std::string filePath = "ObjLoaderTests.obj";
+	for (bool withNormals : { true, false })
+	{
+		WriteSyntheticObj(filePath, withNormals);
+		CHECK(CountChunks(filePath) > 4);
+		CheckParallelMatchesSerial<VertexPosNormalColor>(filePath);
+		CheckParallelMatchesSerial<VertexPosNormalTangentTex>(filePath);
+	}
+	remove(filePath.c_str());
+}
+
+TEST_CASE(StreamModelMatchesCreateModel)
+{
+	// 两个模型都只有一种材质且含有vn，CreateModel不会重排三角形，也不会生成法线
+	for (const char* filePath : { "Ning.obj", "Jie.obj" })
+	{
+		CheckStreamMatchesCreate<VertexPosNormalColor>(filePath);
+		CheckStreamMatchesCreate<VertexPosNormalTex>(filePath);
+	}
+}
+
+TEST_CASE(StreamModelBoundedMemory)
+{
+	const std::string filePath = "StreamModelTests.obj";
+	WriteSyntheticObj(filePath, false, StreamingGridSize);
+
+	// 进程的峰值工作集包含之前各测试的占用，因此在每个子网格交出时采样当前工作集，与开始前比较
+	size_t baseline = GetWorkingSetSize();
+	size_t peak = baseline;
+	size_t triangleCount = 0;
+	Geometry::StreamModel<VertexPosNormalColor>(filePath, [&](const Geometry::MeshData<VertexPosNormalColor, DWORD>& chunk) {
+		peak = (std::max)(peak, GetWorkingSetSize());
+		triangleCount += chunk.indexVec.size() / 3;
+	});
+	printf("  working set grew by %.1f MB while streaming\n", (peak - baseline) / 1048576.0);
+	CHECK(triangleCount == size_t(2) * StreamingGridSize * StreamingGridSize);
+	CHECK(peak - baseline < StreamingMemoryCap);
+	remove(filePath.c_str());
+}
+
+TEST_CASE(StreamModelConcurrentAndEmpty)
+{
+	// 同一文件的两次流式读取同时进行，各自使用独立的临时文件，结果互不影响
+	std::vector<VertexPosNormalColor> created;
+	AppendCorners(created, Geometry::CreateModel<VertexPosNormalColor>("Jie.obj", false, false));
+	std::vector<VertexPosNormalColor> streamed[2];
+	std::thread workers[2];
+	for (int i = 0; i < 2; ++i)
+	{
+		workers[i] = std::thread([&streamed, i]() {
+			Geometry::StreamModel<VertexPosNormalColor>("Jie.obj", [&](const Geometry::MeshData<VertexPosNormalColor, DWORD>& chunk) {
+				AppendCorners(streamed[i], chunk);
+			}, 4096, 300, 200);
+		});
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+	for (const auto& corners : streamed)
+	{
+		CHECK(corners.size() == created.size() &&
+			memcmp(corners.data(), created.data(), created.size() * sizeof(VertexPosNormalColor)) == 0);
+	}
+
+	// 没有任何v/vt/vn记录时临时文件为空，不做映射，也不交出子网格
+	const std::string filePath = "StreamModelEmpty.obj";
+	{
+		std::ofstream fout(filePath, std::ios::binary);
+		fout << "# no geometry\no empty\n";
+	}
+	size_t chunkCount = 0;
+	Geometry::StreamModel<VertexPosNormalColor>(filePath, [&](const Geometry::MeshData<VertexPosNormalColor, DWORD>&) {
+		++chunkCount;
+	});
+	CHECK(chunkCount == 0);
+	remove(filePath.c_str());
+}
+
+BENCHMARK_CASE(ObjLoadTime)
+{
+	// 文件都含有vn，CreateModel不需要生成法线，但除解析外还要去重顶点并生成颜色，对照只解析文本
+	BenchmarkObjLoad("Ning.obj", 10);
+	BenchmarkObjLoad("Jie.obj", 10);
+
+	const std::string filePath = "ObjLoadBenchmark.obj";
+	WriteSyntheticObj(filePath, true, BenchmarkGridSize);
+	BenchmarkObjLoad(filePath, 3);
+	remove(filePath.c_str());
+}
+
+TEST_CASE(ObjForwardReferences)
+{
+	// 面在v/vt/vn之前出现，正数索引引用文件中后出现的记录；相对索引只能引用此前的记录
+	const std::string filePath = "ObjForwardReferences.obj";
+	{
+		std::ofstream fout(filePath, std::ios::binary);
+		fout << "f 1/1/1 2/2/1 3/3/1\nf 1 3 4\n"
+			"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+			"vt 0 0\nvt 1 0\nvt 1 1\nvn 0 0 -1\n"
+			"f -4 -2 -1\n";
+	}
+	auto serial = Geometry::CreateModel<VertexPosNormalTex>(filePath, false, false);
+	auto parallel = Geometry::CreateModel<VertexPosNormalTex>(filePath, true, false);
+	CHECK(serial.indexVec.size() == 9);
+	CHECK(SameMesh(serial, parallel));
+	// 第一个三角形的第二个角点引用了后文的第二个位置与纹理坐标
+	const VertexPosNormalTex& corner = serial.vertexVec[serial.indexVec[1]];
+	CHECK(corner.tex.x == 1.0f && corner.tex.y == 1.0f);
+	CHECK(corner.normal.z == -1.0f);
+
+	std::vector<VertexPosNormalTex> streamed, created;
+	Geometry::StreamModel<VertexPosNormalTex>(filePath, [&](const Geometry::MeshData<VertexPosNormalTex, DWORD>& chunk) {
+		AppendCorners(streamed, chunk);
+	});
+	AppendCorners(created, serial);
+	CHECK(streamed.size() == created.size() &&
+		memcmp(streamed.data(), created.data(), streamed.size() * sizeof(VertexPosNormalTex)) == 0);
+
+	// 超出整个文件记录数目的正数索引仍然无效
+	{
+		std::ofstream fout(filePath, std::ios::binary);
+		fout << "f 1 2 5\nv 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n";
+	}
+	bool threw = false;
+	try
+	{
+		Geometry::CreateModel<VertexPosNormalTex>(filePath, false, false);
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+	remove(filePath.c_str());
+}
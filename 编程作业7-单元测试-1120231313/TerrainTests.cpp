@@ -0,0 +1,282 @@
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+// 地形只在编程作业3中使用，与编程作业7的头文件分开在本文件中包含
+#include "../编程作业3-林间飞行-1120231313/Terrain.h"
+using namespace DirectX;
+
+namespace
+{
+	// 与编程作业3相同的高度函数：中心较为平坦，越往外山丘越高
+	float SceneHeight(float x, float z)
+	{
+		float r = sqrtf(x * x + z * z);
+		float t = (std::min)((std::max)((r - 60.0f) / 120.0f, 0.0f), 1.0f);
+		return -10.0f + 1.5f * sinf(0.21f * x) * sinf(0.17f * z)
+			+ t * t * (25.0f * sinf(0.023f * x) * cosf(0.019f * z) + 12.0f * sinf(0.051f * x + 0.037f * z) + 15.0f);
+	}
+
+	// 块内顶点的行列号
+	struct GridVertex
+	{
+		int row, column;
+	};
+
+	GridVertex GetGridVertex(UINT chunkCells, WORD index)
+	{
+		return { static_cast<int>(index / (chunkCells + 1)), static_cast<int>(index % (chunkCells + 1)) };
+	}
+
+	// 块在某条边上的线段，以沿边方向的坐标表示
+	// 北边row = 0，东边column = n，南边row = n，西边column = 0
+	std::set<std::pair<int, int>> GetEdgeSegments(const Terrain& terrain, UINT level, UINT edgeFlags, UINT edge)
+	{
+		int n = static_cast<int>(terrain.GetChunkCells());
+		auto onEdge = [n, edge](const GridVertex& v) {
+			switch (edge)
+			{
+			case Terrain::EdgeNorth: return v.row == 0;
+			case Terrain::EdgeEast: return v.column == n;
+			case Terrain::EdgeSouth: return v.row == n;
+			default: return v.column == 0;
+			}
+		};
+		auto along = [edge](const GridVertex& v) {
+			return edge == Terrain::EdgeNorth || edge == Terrain::EdgeSouth ? v.column : v.row;
+		};
+
+		std::set<std::pair<int, int>> segments;
+		Terrain::DrawRange range = terrain.GetDrawRange(level, edgeFlags);
+		const std::vector<WORD>& indices = terrain.GetIndices();
+		for (UINT i = range.startIndex; i < range.startIndex + range.indexCount; i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				GridVertex a = GetGridVertex(n, indices[i + k]), b = GetGridVertex(n, indices[i + (k + 1) % 3]);
+				if (onEdge(a) && onEdge(b))
+					segments.emplace((std::min)(along(a), along(b)), (std::max)(along(a), along(b)));
+			}
+		}
+		return segments;
+	}
+
+	UINT OppositeEdge(UINT edge)
+	{
+		return edge == Terrain::EdgeNorth ? Terrain::EdgeSouth : edge == Terrain::EdgeSouth ? Terrain::EdgeNorth :
+			edge == Terrain::EdgeEast ? Terrain::EdgeWest : Terrain::EdgeEast;
+	}
+
+	Terrain::View MakeTestView(const XMFLOAT3& eyePos, float farZ)
+	{
+		// 与GameApp相同：竖直视野60°、视口高度600像素、误差上限2像素
+		Terrain::View view;
+		view.eyePos = eyePos;
+		view.pixelsPerUnit = 600.0f / (2.0f * tanf(XM_PI / 6));
+		view.farZ = farZ;
+		view.maxPixelError = 2.0f;
+		return view;
+	}
+
+	// 观察点到块包围盒的距离，与SelectLod的算法相同
+	float ChunkDistance(const Terrain& terrain, const XMFLOAT2& terrainSize, UINT chunkCountX, UINT chunk, const XMFLOAT3& eyePos)
+	{
+		UINT n = terrain.GetChunkCells();
+		UINT rowCount = terrain.GetChunkCount() / chunkCountX * n + 1, columnCount = chunkCountX * n + 1;
+		float dx = terrainSize.x / (columnCount - 1), dz = terrainSize.y / (rowCount - 1);
+		UINT firstRow = chunk / chunkCountX * n, firstColumn = chunk % chunkCountX * n;
+		float minY = terrain.GetHeight(firstRow, firstColumn), maxY = minY;
+		for (UINT row = firstRow; row <= firstRow + n; ++row)
+		{
+			for (UINT column = firstColumn; column <= firstColumn + n; ++column)
+			{
+				minY = (std::min)(minY, terrain.GetHeight(row, column));
+				maxY = (std::max)(maxY, terrain.GetHeight(row, column));
+			}
+		}
+		XMVECTOR boundsMin = XMVectorSet(-terrainSize.x / 2 + firstColumn * dx, minY, terrainSize.y / 2 - (firstRow + n) * dz, 0.0f);
+		XMVECTOR boundsMax = XMVectorSet(-terrainSize.x / 2 + (firstColumn + n) * dx, maxY, terrainSize.y / 2 - firstRow * dz, 0.0f);
+		XMVECTOR eye = XMLoadFloat3(&eyePos);
+		return XMVectorGetX(XMVector3Length(eye - XMVectorClamp(eye, boundsMin, boundsMax)));
+	}
+
+	// 检查选出的层级：相邻块最多相差一级，接缝标记恰好对应更粗的相邻块，每块的屏幕空间误差不超过上限
+	void CheckSelection(const Terrain& terrain, const XMFLOAT2& terrainSize, UINT chunkCountX, const Terrain::View& view,
+		const std::vector<Terrain::ChunkLod>& chunkLods)
+	{
+		UINT chunkCount = terrain.GetChunkCount();
+		UINT chunkCountZ = chunkCount / chunkCountX;
+		std::vector<int> levels(chunkCount, -1);
+		bool ok = true;
+		for (const Terrain::ChunkLod& chunkLod : chunkLods)
+		{
+			ok &= ChunkDistance(terrain, terrainSize, chunkCountX, chunkLod.chunk, view.eyePos) <= view.farZ;
+			CHECK(chunkLod.chunk < chunkCount && chunkLod.level < terrain.GetLevelCount());
+			CHECK(levels[chunkLod.chunk] == -1);
+			levels[chunkLod.chunk] = static_cast<int>(chunkLod.level);
+		}
+
+		for (const Terrain::ChunkLod& chunkLod : chunkLods)
+		{
+			UINT x = chunkLod.chunk % chunkCountX, z = chunkLod.chunk / chunkCountX;
+			const std::pair<UINT, int> neighbors[4] = {
+				{ Terrain::EdgeNorth, z > 0 ? static_cast<int>(chunkLod.chunk - chunkCountX) : -1 },
+				{ Terrain::EdgeEast, x + 1 < chunkCountX ? static_cast<int>(chunkLod.chunk + 1) : -1 },
+				{ Terrain::EdgeSouth, z + 1 < chunkCountZ ? static_cast<int>(chunkLod.chunk + chunkCountX) : -1 },
+				{ Terrain::EdgeWest, x > 0 ? static_cast<int>(chunkLod.chunk - 1) : -1 }
+			};
+			for (const auto& neighbor : neighbors)
+			{
+				// 视距外的相邻块不绘制，不参与比较
+				if (neighbor.second < 0 || levels[neighbor.second] < 0)
+					continue;
+				int difference = levels[neighbor.second] - static_cast<int>(chunkLod.level);
+				ok &= abs(difference) <= 1;
+				ok &= ((chunkLod.edgeFlags & neighbor.first) != 0) == (difference == 1);
+			}
+			// 只会把层级调细，选出的层级不会超出屏幕空间误差
+			float error = terrain.GetGeometricError(chunkLod.chunk, chunkLod.level);
+			float distance = ChunkDistance(terrain, terrainSize, chunkCountX, chunkLod.chunk, view.eyePos);
+			ok &= chunkLod.level == 0 || error * view.pixelsPerUnit <= view.maxPixelError * distance;
+		}
+		CHECK(ok);
+	}
+
+	size_t CountTriangles(const Terrain& terrain, const std::vector<Terrain::ChunkLod>& chunkLods)
+	{
+		size_t triangleCount = 0;
+		for (const Terrain::ChunkLod& chunkLod : chunkLods)
+			triangleCount += terrain.GetDrawRange(chunkLod.level, chunkLod.edgeFlags).indexCount / 3;
+		return triangleCount;
+	}
+}
+
+TEST_CASE(Terrain_StitchingMatchesAcrossBorders)
+{
+	Terrain terrain = Terrain::Create(XMFLOAT2(64.0f, 64.0f), XMUINT2(2, 2), 32, SceneHeight);
+	UINT n = terrain.GetChunkCells();
+	const std::vector<WORD>& indices = terrain.GetIndices();
+	const UINT edges[4] = { Terrain::EdgeNorth, Terrain::EdgeEast, Terrain::EdgeSouth, Terrain::EdgeWest };
+	bool covered = true, stitched = true;
+
+	for (UINT level = 0; level < terrain.GetLevelCount(); ++level)
+	{
+		for (UINT edgeFlags = 0; edgeFlags < Terrain::EdgeVariantCount; ++edgeFlags)
+		{
+			// 每种组合都恰好覆盖整个块，所有三角形俯视为顺时针(朝上)且面积不为0
+			Terrain::DrawRange range = terrain.GetDrawRange(level, edgeFlags);
+			covered &= range.indexCount % 3 == 0 && range.startIndex + range.indexCount <= indices.size();
+			long long doubleArea = 0;
+			bool upward = true;
+			for (UINT i = range.startIndex; i < range.startIndex + range.indexCount; i += 3)
+			{
+				GridVertex v0 = GetGridVertex(n, indices[i]), v1 = GetGridVertex(n, indices[i + 1]), v2 = GetGridVertex(n, indices[i + 2]);
+				// 行号向南增大、列号向东增大，俯视为顺时针时该叉积为正
+				long long cross = static_cast<long long>(v1.column - v0.column) * (v2.row - v0.row) -
+					static_cast<long long>(v1.row - v0.row) * (v2.column - v0.column);
+				upward &= cross > 0;
+				doubleArea += cross;
+			}
+			covered &= upward && doubleArea == 2LL * n * n;
+
+			// 本块的边标记为接缝时相邻块粗一级，否则层级相同(更细的相邻块由它自己的接缝处理)，
+			// 相邻块在公共边上没有接缝标记，其余边任意；两块在公共边上的线段须完全相同
+			for (UINT edge : edges)
+			{
+				std::set<std::pair<int, int>> segments = GetEdgeSegments(terrain, level, edgeFlags, edge);
+				UINT neighborLevel = (edgeFlags & edge) && level + 1 < terrain.GetLevelCount() ? level + 1 : level;
+				for (UINT neighborFlags = 0; neighborFlags < Terrain::EdgeVariantCount; ++neighborFlags)
+				{
+					if (!(neighborFlags & OppositeEdge(edge)))
+						stitched &= GetEdgeSegments(terrain, neighborLevel, neighborFlags, OppositeEdge(edge)) == segments;
+				}
+			}
+		}
+	}
+	CHECK(covered);
+	CHECK(stitched);
+}
+
+TEST_CASE(Terrain_SelectLodNeighbors)
+{
+	// 与编程作业3相同的地形：512x512，16x16块，每块32x32格
+	const XMFLOAT2 terrainSize(512.0f, 512.0f);
+	const UINT chunkCountX = 16;
+	Terrain terrain = Terrain::Create(terrainSize, XMUINT2(chunkCountX, 16), 32, SceneHeight);
+
+	const XMFLOAT3 eyes[] = {
+		XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(150.0f, 40.0f, -80.0f), XMFLOAT3(-250.0f, 5.0f, 250.0f),
+		XMFLOAT3(0.0f, 300.0f, 0.0f), XMFLOAT3(600.0f, 20.0f, 0.0f)
+	};
+	std::vector<Terrain::ChunkLod> chunkLods;
+	for (const XMFLOAT3& eyePos : eyes)
+	{
+		for (float farZ : { 100.0f, 250.0f, 1000.0f })
+		{
+			Terrain::View view = MakeTestView(eyePos, farZ);
+			terrain.SelectLod(view, chunkLods);
+			CheckSelection(terrain, terrainSize, chunkCountX, view, chunkLods);
+		}
+	}
+
+	// 高空俯视与远离地形时都只需要较粗的层级
+	terrain.SelectLod(MakeTestView(XMFLOAT3(0.0f, 2000.0f, 0.0f), 5000.0f), chunkLods);
+	CHECK(chunkLods.size() == terrain.GetChunkCount());
+	for (const Terrain::ChunkLod& chunkLod : chunkLods)
+		CHECK(chunkLod.level > 0);
+
+	// 视距外的块不绘制
+	terrain.SelectLod(MakeTestView(XMFLOAT3(0.0f, 0.0f, 0.0f), 40.0f), chunkLods);
+	CHECK(!chunkLods.empty() && chunkLods.size() < terrain.GetChunkCount());
+
+	// SelectLod不修改地形，两个线程以不同的观察参数同时调用，结果与依次调用相同
+	std::vector<Terrain::ChunkLod> expected[2], results[2];
+	Terrain::View views[2] = { MakeTestView(eyes[1], 1000.0f), MakeTestView(eyes[2], 1000.0f) };
+	for (int k = 0; k < 2; ++k)
+		terrain.SelectLod(views[k], expected[k]);
+	std::thread worker([&]() {
+		for (int repeat = 0; repeat < 200; ++repeat)
+			terrain.SelectLod(views[1], results[1]);
+	});
+	for (int repeat = 0; repeat < 200; ++repeat)
+		terrain.SelectLod(views[0], results[0]);
+	worker.join();
+	for (int k = 0; k < 2; ++k)
+	{
+		CHECK(results[k].size() == expected[k].size());
+		bool same = results[k].size() == expected[k].size();
+		for (size_t i = 0; same && i < results[k].size(); ++i)
+			same = results[k][i].chunk == expected[k][i].chunk && results[k][i].level == expected[k][i].level &&
+				results[k][i].edgeFlags == expected[k][i].edgeFlags;
+		CHECK(same);
+	}
+}
+
+TEST_CASE(Terrain_TriangleCountScaling)
+{
+	// 64x64块的地形，每块32x32格、每格1个单位，摄像机在中心上方
+	// 视距每增大一倍，三角形数的增长远小于绘制块数的增长
+	const XMFLOAT2 terrainSize(2048.0f, 2048.0f);
+	const UINT chunkCountX = 64;
+	Terrain terrain = Terrain::Create(terrainSize, XMUINT2(chunkCountX, 64), 32, SceneHeight);
+	std::vector<Terrain::ChunkLod> chunkLods;
+	size_t firstChunks = 0, firstTriangles = 0, lastChunks = 0, lastTriangles = 0;
+	for (float farZ : { 250.0f, 500.0f, 1000.0f, 2000.0f, 3000.0f })
+	{
+		Terrain::View view = MakeTestView(XMFLOAT3(0.0f, 20.0f, 0.0f), farZ);
+		terrain.SelectLod(view, chunkLods);
+		CheckSelection(terrain, terrainSize, chunkCountX, view, chunkLods);
+		size_t triangleCount = CountTriangles(terrain, chunkLods);
+		printf("  view distance %6.0f: %4zu chunks, %7zu triangles\n", farZ, chunkLods.size(), triangleCount);
+		if (firstChunks == 0)
+			firstChunks = chunkLods.size(), firstTriangles = triangleCount;
+		lastChunks = chunkLods.size(), lastTriangles = triangleCount;
+	}
+	// 视距增大12倍：块数约增大18倍，三角形数的增长不超过视距的增长
+	CHECK(lastTriangles * firstChunks < lastChunks * firstTriangles);
+	CHECK(lastTriangles < firstTriangles * 12);
+}
@@ -0,0 +1,66 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+namespace
+{
+	struct TestEntry
+	{
+		const char* name;
+		TestFramework::TestFunc func;
+		bool benchmark;
+	};
+
+	// 函数内的静态变量保证注册时已经构造，不依赖各编译单元的初始化顺序
+	std::vector<TestEntry>& GetTests()
+	{
+		static std::vector<TestEntry> tests;
+		return tests;
+	}
+
+	size_t s_FailureCount = 0;
+}
+
+namespace TestFramework
+{
+	Registrar::Registrar(const char* name, TestFunc func, bool benchmark)
+	{
+		GetTests().push_back({ name, func, benchmark });
+	}
+
+	void ReportFailure(const char* file, int line, const char* expression)
+	{
+		++s_FailureCount;
+		printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+	}
+
+	int RunAll(bool benchmark)
+	{
+		int testCount = 0;
+		int failedTests = 0;
+		for (const TestEntry& test : GetTests())
+		{
+			if (test.benchmark != benchmark)
+				continue;
+			++testCount;
+			printf("[ RUN  ] %s\n", test.name);
+			size_t failuresBefore = s_FailureCount;
+			try
+			{
+				test.func();
+			}
+			catch (const std::exception& e)
+			{
+				++s_FailureCount;
+				printf("  unexpected exception: %s\n", e.what());
+			}
+			bool passed = s_FailureCount == failuresBefore;
+			printf("[ %s ] %s\n", passed ? " OK " : "FAIL", test.name);
+			if (!passed)
+				++failedTests;
+		}
+		printf("%d %s, %d failed\n", testCount, benchmark ? "benchmarks" : "tests", failedTests);
+		return failedTests;
+	}
+}
@@ -0,0 +1,60 @@
+//***************************************************************************************
+// TestFramework.h
+//
+// 控制台测试的最小框架：测试用TEST_CASE定义并自动注册，CHECK失败时记录位置后继续执行，
+// 基准测试用BENCHMARK_CASE定义，只在命令行带--benchmark时运行
+// Minimal console test harness with self-registering test cases, non-fatal checks and benchmarks.
+//***************************************************************************************
+
+#ifndef TESTFRAMEWORK_H
+#define TESTFRAMEWORK_H
+
+#include <algorithm>
+#include <chrono>
+
+namespace TestFramework
+{
+	using TestFunc = void(*)();
+
+	// 注册一个测试，由TEST_CASE与BENCHMARK_CASE在静态初始化阶段构造
+	struct Registrar
+	{
+		Registrar(const char* name, TestFunc func, bool benchmark = false);
+	};
+
+	// 记录当前测试中的一次检查失败
+	void ReportFailure(const char* file, int line, const char* expression);
+
+	// 按注册顺序运行所有测试(benchmark为true时运行所有基准测试)，测试抛出的异常也记为失败；返回失败的测试数目
+	int RunAll(bool benchmark = false);
+
+	// 重复执行func，返回最短一次的耗时(毫秒)
+	template<class Func>
+	double MeasureMilliseconds(int repeatCount, Func&& func)
+	{
+		double best = 0.0;
+		for (int i = 0; i < repeatCount; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			func();
+			double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = i == 0 ? elapsed : (std::min)(best, elapsed);
+		}
+		return best;
+	}
+}
+
+#define TEST_CASE(name)																\
+	static void name();																\
+	static TestFramework::Registrar name##Registrar(#name, name);					\
+	static void name()
+
+#define BENCHMARK_CASE(name)														\
+	static void name();																\
+	static TestFramework::Registrar name##Registrar(#name, name, true);				\
+	static void name()
+
+#define CHECK(expr)																	\
+	((expr) ? (void)0 : TestFramework::ReportFailure(__FILE__, __LINE__, #expr))
+
+#endif
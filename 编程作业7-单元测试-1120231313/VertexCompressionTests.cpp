@@ -0,0 +1,160 @@
+#include "TestFramework.h"
+#include <cmath>
+#include <vector>
+#include "CounterRng.h"
+#include "VertexCompression.h"
+using namespace DirectX;
+
+namespace
+{
+	// 随机样本的数目与种子
+	constexpr size_t SampleCount = 100000;
+	constexpr uint32_t SampleSeed = 20240611;
+
+	// 两个单位向量的夹角，用弦长换算以免acos在夹角很小时失去精度
+	double AngleBetween(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMFLOAT3 x, y;
+		XMStoreFloat3(&x, a);
+		XMStoreFloat3(&y, b);
+		double dx = double(x.x) - y.x, dy = double(x.y) - y.y, dz = double(x.z) - y.z;
+		return 2.0 * asin((std::min)(sqrt(dx * dx + dy * dy + dz * dz) * 0.5, 1.0));
+	}
+
+	// 编码后解码，返回与原方向的夹角，同时检查解码结果为单位向量
+	double NormalRoundTripError(FXMVECTOR normal)
+	{
+		XMVECTOR n = XMVector3Normalize(normal);
+		XMVECTOR decoded = VertexCompression::DecodeNormal(VertexCompression::EncodeNormal(n));
+		CHECK(fabsf(XMVectorGetX(XMVector3Length(decoded)) - 1.0f) < 1.0e-5f);
+		return AngleBetween(n, decoded);
+	}
+
+	// 在球面上均匀分布的随机方向
+	XMVECTOR RandomDirection(size_t id)
+	{
+		XMFLOAT4 r = CounterRng::Uniform4(SampleSeed, 0, id);
+		float z = 2.0f * r.x - 1.0f;
+		float s, c;
+		XMScalarSinCos(&s, &c, r.y * XM_2PI);
+		float radius = sqrtf((std::max)(1.0f - z * z, 0.0f));
+		return XMVectorSet(radius * c, radius * s, z, 0.0f);
+	}
+}
+
+TEST_CASE(VertexCompression_NormalRoundTrip)
+{
+	double maxError = 0.0;
+	for (size_t i = 0; i < SampleCount; ++i)
+		maxError = (std::max)(maxError, NormalRoundTripError(RandomDirection(i)));
+	CHECK(maxError <= VertexCompression::MaxNormalError);
+}
+
+TEST_CASE(VertexCompression_NormalFold)
+{
+	// 坐标轴与两极
+	const XMFLOAT3 axes[] = {
+		XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f),
+		XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f),
+		XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f),
+	};
+	for (const XMFLOAT3& axis : axes)
+		CHECK(NormalRoundTripError(XMLoadFloat3(&axis)) <= VertexCompression::MaxNormalError);
+
+	// 赤道附近(z≈0，含-0)以及折叠后的下半球，方位角覆盖各象限与对角线
+	const float heights[] = { 0.0f, -0.0f, 1.0e-7f, -1.0e-7f, 1.0e-4f, -1.0e-4f, 1.0e-2f, -1.0e-2f, -0.5f, -0.999f };
+	double maxError = 0.0;
+	for (float z : heights)
+	{
+		for (int k = 0; k < 720; ++k)
+		{
+			float s, c;
+			XMScalarSinCos(&s, &c, k * (XM_2PI / 720.0f));
+			float radius = sqrtf(1.0f - z * z);
+			maxError = (std::max)(maxError, NormalRoundTripError(XMVectorSet(radius * c, radius * s, z, 0.0f)));
+		}
+	}
+	CHECK(maxError <= VertexCompression::MaxNormalError);
+
+	// 下半球的法线解码后仍在下半球，上半球的仍在上半球
+	CHECK(XMVectorGetZ(VertexCompression::DecodeNormal(VertexCompression::EncodeNormal(XMVectorSet(0.6f, 0.0f, -0.8f, 0.0f)))) < 0.0f);
+	CHECK(XMVectorGetZ(VertexCompression::DecodeNormal(VertexCompression::EncodeNormal(XMVectorSet(0.6f, 0.0f, 0.8f, 0.0f)))) > 0.0f);
+}
+
+TEST_CASE(VertexCompression_PositionRoundTrip)
+{
+	// y轴边长为0的平面网格，以及所有轴边长都为0的单点
+	std::vector<XMFLOAT3> positions(SampleCount);
+	for (size_t i = 0; i < SampleCount; ++i)
+	{
+		XMFLOAT4 r = CounterRng::Uniform4(SampleSeed, 1, i);
+		positions[i] = XMFLOAT3(r.x * 200.0f - 100.0f, 3.25f, r.z * 0.01f + 7.0f);
+	}
+	const XMFLOAT3 single(-2.5f, 0.0f, 1.0e6f);
+
+	for (size_t set = 0; set < 2; ++set)
+	{
+		const XMFLOAT3* pPositions = set == 0 ? positions.data() : &single;
+		size_t count = set == 0 ? positions.size() : 1;
+		VertexCompression::PositionBounds bounds = VertexCompression::ComputePositionBounds(pPositions, count);
+		CHECK(bounds.scale.y == 0.0f);
+
+		// 量化误差不超过半个步长，另加浮点运算的舍入误差
+		float tolerance = bounds.GetMaxError() + 1.0e-6f * (fabsf(bounds.offset.x) + fabsf(bounds.scale.x) +
+			fabsf(bounds.offset.y) + fabsf(bounds.scale.y) + fabsf(bounds.offset.z) + fabsf(bounds.scale.z));
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR pos = XMLoadFloat3(pPositions + i);
+			XMVECTOR decoded = VertexCompression::DecodePosition(VertexCompression::EncodePosition(pos, bounds), bounds);
+			CHECK(XMVectorGetX(XMVector3Length(decoded - pos)) <= tolerance);
+			// 边长为0的轴精确还原
+			CHECK(XMVectorGetY(decoded) == pPositions[i].y);
+			CHECK(XMVectorGetW(decoded) == 1.0f);
+		}
+	}
+}
+
+TEST_CASE(VertexCompression_ColorRoundTrip)
+{
+	float maxError = 0.0f;
+	for (size_t i = 0; i < SampleCount; ++i)
+	{
+		XMFLOAT4 color = CounterRng::Uniform4(SampleSeed, 2, i);
+		XMFLOAT4 decoded;
+		XMStoreFloat4(&decoded, VertexCompression::DecodeColor(VertexCompression::EncodeColor(XMLoadFloat4(&color))));
+		maxError = (std::max)(maxError, (std::max)(fabsf(decoded.x - color.x), fabsf(decoded.y - color.y)));
+		maxError = (std::max)(maxError, (std::max)(fabsf(decoded.z - color.z), fabsf(decoded.w - color.w)));
+	}
+	CHECK(maxError <= VertexCompression::MaxColorError + 1.0e-7f);
+
+	// 超出[0, 1]的分量截断到边界
+	XMVECTOR outOfRange = XMVectorSet(-0.5f, 1.7f, 255.0f, -1.0e-6f);
+	XMFLOAT4 decoded;
+	XMStoreFloat4(&decoded, VertexCompression::DecodeColor(VertexCompression::EncodeColor(outOfRange)));
+	CHECK(decoded.x == 0.0f);
+	CHECK(decoded.y == 1.0f);
+	CHECK(decoded.z == 1.0f);
+	CHECK(decoded.w == 0.0f);
+}
+
+TEST_CASE(VertexCompression_TexCoordRoundTrip)
+{
+	// 半精度在[2^-14, 1]内为规格化数，相对误差不超过半个ulp
+	float maxRelativeError = 0.0f;
+	for (size_t i = 0; i < SampleCount; ++i)
+	{
+		XMFLOAT4 r = CounterRng::Uniform4(SampleSeed, 3, i);
+		XMFLOAT2 tex((std::max)(r.x, 1.0f / 16384.0f), (std::max)(r.y * r.y, 1.0f / 16384.0f));
+		XMFLOAT2 decoded;
+		XMStoreFloat2(&decoded, VertexCompression::DecodeTexCoord(VertexCompression::EncodeTexCoord(XMLoadFloat2(&tex))));
+		maxRelativeError = (std::max)(maxRelativeError, fabsf(decoded.x - tex.x) / tex.x);
+		maxRelativeError = (std::max)(maxRelativeError, fabsf(decoded.y - tex.y) / tex.y);
+	}
+	CHECK(maxRelativeError <= VertexCompression::MaxTexCoordRelativeError);
+
+	// 0与1精确还原
+	XMFLOAT2 decoded;
+	XMStoreFloat2(&decoded, VertexCompression::DecodeTexCoord(VertexCompression::EncodeTexCoord(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f))));
+	CHECK(decoded.x == 0.0f);
+	CHECK(decoded.y == 1.0f);
+}
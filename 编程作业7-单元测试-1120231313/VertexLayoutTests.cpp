@@ -0,0 +1,229 @@
+#include "TestFramework.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "CounterRng.h"
+#include "Geometry.h"
+using namespace DirectX;
+
+namespace
+{
+	//
+	// 由VertexTraits生成之前在Vertex.cpp中手写的输入布局，作为生成结果的对照
+	//
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPos[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosColor[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosTex[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosSize[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "SIZE", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosNormalColor[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosNormalTex[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosNormalTangentTex[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 40, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosNormalColorPacked[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr D3D11_INPUT_ELEMENT_DESC ExpectedVertexPosNormalTexPacked[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	constexpr bool SameString(const char* a, const char* b)
+	{
+		while (*a && *a == *b)
+			++a, ++b;
+		return *a == *b;
+	}
+
+	constexpr bool SameElement(const D3D11_INPUT_ELEMENT_DESC& a, const D3D11_INPUT_ELEMENT_DESC& b)
+	{
+		return SameString(a.SemanticName, b.SemanticName) && a.SemanticIndex == b.SemanticIndex &&
+			a.Format == b.Format && a.InputSlot == b.InputSlot && a.AlignedByteOffset == b.AlignedByteOffset &&
+			a.InputSlotClass == b.InputSlotClass && a.InstanceDataStepRate == b.InstanceDataStepRate;
+	}
+
+	template<size_t N, size_t M>
+	constexpr bool SameLayout(const D3D11_INPUT_ELEMENT_DESC (&a)[N], const D3D11_INPUT_ELEMENT_DESC (&b)[M])
+	{
+		if (N != M)
+			return false;
+		for (size_t i = 0; i < N; ++i)
+		{
+			if (!SameElement(a[i], b[i]))
+				return false;
+		}
+		return true;
+	}
+
+	// 分流布局与交错布局的元素一一对应，每个元素位于语义对应的输入槽、偏移为0
+	template<class VertexType>
+	constexpr bool IsStreamLayoutConsistent()
+	{
+		using Traits = VertexTraits<VertexType>;
+		for (size_t i = 0; i < Traits::elementCount; ++i)
+		{
+			const D3D11_INPUT_ELEMENT_DESC& element = Traits::inputLayout[i];
+			const D3D11_INPUT_ELEMENT_DESC& stream = Traits::streamInputLayout[i];
+			if (!SameString(element.SemanticName, stream.SemanticName) || element.Format != stream.Format ||
+				stream.AlignedByteOffset != 0 || stream.InputSlot >= VertexStreamCount ||
+				!SameString(GetSemanticName(static_cast<VertexSemantic>(stream.InputSlot)), stream.SemanticName))
+				return false;
+		}
+		return true;
+	}
+
+#define CHECK_VERTEX_LAYOUT(VertexType)														\
+	static_assert(SameLayout(VertexTraits<VertexType>::inputLayout, Expected##VertexType),	\
+		#VertexType " input layout differs from the hand-written layout!");					\
+	static_assert(IsStreamLayoutConsistent<VertexType>(), #VertexType " stream layout is inconsistent!")
+
+	CHECK_VERTEX_LAYOUT(VertexPos);
+	CHECK_VERTEX_LAYOUT(VertexPosColor);
+	CHECK_VERTEX_LAYOUT(VertexPosTex);
+	CHECK_VERTEX_LAYOUT(VertexPosSize);
+	CHECK_VERTEX_LAYOUT(VertexPosNormalColor);
+	CHECK_VERTEX_LAYOUT(VertexPosNormalTex);
+	CHECK_VERTEX_LAYOUT(VertexPosNormalTangentTex);
+	CHECK_VERTEX_LAYOUT(VertexPosNormalColorPacked);
+	CHECK_VERTEX_LAYOUT(VertexPosNormalTexPacked);
+
+#undef CHECK_VERTEX_LAYOUT
+
+	// 改用VertexTraits之前的转换：按输入布局的语义名查表后逐元素复制，作为对照与基准
+	template<class VertexType>
+	void InsertVertexElementLegacy(VertexType& vertexDst, const Geometry::Internal::VertexData& vertexSrc)
+	{
+		static std::string semanticName;
+		static const std::map<std::string, std::pair<size_t, size_t>> semanticSizeMap = {
+			{"POSITION", std::pair<size_t, size_t>(0, 12)},
+			{"NORMAL", std::pair<size_t, size_t>(12, 24)},
+			{"TANGENT", std::pair<size_t, size_t>(24, 40)},
+			{"COLOR", std::pair<size_t, size_t>(40, 56)},
+			{"TEXCOORD", std::pair<size_t, size_t>(56, 64)}
+		};
+
+		for (size_t i = 0; i < ARRAYSIZE(VertexType::inputLayout); i++)
+		{
+			semanticName = VertexType::inputLayout[i].SemanticName;
+			const auto& range = semanticSizeMap.at(semanticName);
+			memcpy_s(reinterpret_cast<char*>(&vertexDst) + VertexType::inputLayout[i].AlignedByteOffset,
+				range.second - range.first,
+				reinterpret_cast<const char*>(&vertexSrc) + range.first,
+				range.second - range.first);
+		}
+	}
+
+	std::vector<Geometry::Internal::VertexData> MakeVertexData(size_t count)
+	{
+		std::vector<Geometry::Internal::VertexData> data(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMFLOAT4 a = CounterRng::Uniform4(20240713, 0, i), b = CounterRng::Uniform4(20240713, 1, i);
+			XMFLOAT4 c = CounterRng::Uniform4(20240713, 2, i), d = CounterRng::Uniform4(20240713, 3, i);
+			data[i] = { XMFLOAT3(a.x, a.y, a.z), XMFLOAT3(b.x, b.y, b.z), c, d, XMFLOAT2(a.w, b.w) };
+		}
+		return data;
+	}
+
+	template<class VertexType>
+	void ConvertVertices(const std::vector<Geometry::Internal::VertexData>& data, std::vector<VertexType>& vertices)
+	{
+		for (size_t i = 0; i < data.size(); ++i)
+			Geometry::Internal::InsertVertexElement(vertices[i], data[i]);
+	}
+
+	template<class VertexType>
+	void ConvertVerticesLegacy(const std::vector<Geometry::Internal::VertexData>& data, std::vector<VertexType>& vertices)
+	{
+		for (size_t i = 0; i < data.size(); ++i)
+			InsertVertexElementLegacy(vertices[i], data[i]);
+	}
+
+	// 两种转换的结果逐字节相同
+	template<class VertexType>
+	bool SameConversion(const std::vector<Geometry::Internal::VertexData>& data)
+	{
+		std::vector<VertexType> vertices(data.size()), legacy(data.size());
+		ConvertVertices(data, vertices);
+		ConvertVerticesLegacy(data, legacy);
+		return memcmp(vertices.data(), legacy.data(), data.size() * sizeof(VertexType)) == 0;
+	}
+
+	template<class VertexType>
+	void BenchmarkConversion(const char* name, const std::vector<Geometry::Internal::VertexData>& data)
+	{
+		std::vector<VertexType> vertices(data.size());
+		double legacy = TestFramework::MeasureMilliseconds(5, [&]() { ConvertVerticesLegacy(data, vertices); });
+		double traits = TestFramework::MeasureMilliseconds(5, [&]() { ConvertVertices(data, vertices); });
+		printf("  %-26s legacy %8.2f ms | traits %8.2f ms (%5.1fx)\n", name, legacy, traits, legacy / traits);
+	}
+}
+
+TEST_CASE(VertexLayout_MatchesStructs)
+{
+	// 各顶点结构体的inputLayout在Vertex.cpp中绑定到生成的数组，创建输入布局时使用的正是这些数组
+	CHECK(SameLayout(VertexPos::inputLayout, ExpectedVertexPos));
+	CHECK(SameLayout(VertexPosColor::inputLayout, ExpectedVertexPosColor));
+	CHECK(SameLayout(VertexPosTex::inputLayout, ExpectedVertexPosTex));
+	CHECK(SameLayout(VertexPosSize::inputLayout, ExpectedVertexPosSize));
+	CHECK(SameLayout(VertexPosNormalColor::inputLayout, ExpectedVertexPosNormalColor));
+	CHECK(SameLayout(VertexPosNormalTex::inputLayout, ExpectedVertexPosNormalTex));
+	CHECK(SameLayout(VertexPosNormalTangentTex::inputLayout, ExpectedVertexPosNormalTangentTex));
+	CHECK(SameLayout(VertexPosNormalColorPacked::inputLayout, ExpectedVertexPosNormalColorPacked));
+	CHECK(SameLayout(VertexPosNormalTexPacked::inputLayout, ExpectedVertexPosNormalTexPacked));
+}
+
+TEST_CASE(VertexLayout_ConversionMatchesLegacy)
+{
+	std::vector<Geometry::Internal::VertexData> data = MakeVertexData(1000);
+	CHECK(SameConversion<VertexPos>(data));
+	CHECK(SameConversion<VertexPosColor>(data));
+	CHECK(SameConversion<VertexPosTex>(data));
+	CHECK(SameConversion<VertexPosNormalColor>(data));
+	CHECK(SameConversion<VertexPosNormalTex>(data));
+	CHECK(SameConversion<VertexPosNormalTangentTex>(data));
+}
+
+BENCHMARK_CASE(VertexConversion)
+{
+	std::vector<Geometry::Internal::VertexData> data = MakeVertexData(2000000);
+	BenchmarkConversion<VertexPos>("VertexPos", data);
+	BenchmarkConversion<VertexPosNormalColor>("VertexPosNormalColor", data);
+	BenchmarkConversion<VertexPosNormalTangentTex>("VertexPosNormalTangentTex", data);
+}
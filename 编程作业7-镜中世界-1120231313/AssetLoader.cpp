@@ -0,0 +1,113 @@
+#include "AssetLoader.h"
+#include <Windows.h>
+
+AssetLoader::AssetLoader(size_t threadCount)
+	: m_RunningCount(), m_PendingCount(), m_Stop(false)
+{
+	if (threadCount == 0)
+		threadCount = 1;
+	m_Threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+		m_Threads.emplace_back(&AssetLoader::WorkerLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+		m_Jobs.clear();
+	}
+	m_Condition.notify_all();
+	for (std::thread& thread : m_Threads)
+		thread.join();
+}
+
+void AssetLoader::Load(std::function<void()> job, std::function<void()> onReady)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back({ std::move(job), std::move(onReady) });
+		++m_PendingCount;
+	}
+	m_Condition.notify_one();
+}
+
+size_t AssetLoader::Dispatch()
+{
+	std::vector<Completion> completions;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		completions.swap(m_Completions);
+		m_PendingCount -= completions.size();
+	}
+
+	// 在锁外执行回调，回调中可以继续提交任务
+	for (size_t i = 0; i < completions.size(); ++i)
+	{
+		if (completions[i].error)
+		{
+			// 其余已完成的回调放回队列，下次派发时执行
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Completions.insert(m_Completions.begin(),
+				std::make_move_iterator(completions.begin() + i + 1), std::make_move_iterator(completions.end()));
+			m_PendingCount += completions.size() - i - 1;
+			std::rethrow_exception(completions[i].error);
+		}
+		if (completions[i].onReady)
+			completions[i].onReady();
+	}
+	return completions.size();
+}
+
+size_t AssetLoader::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_PendingCount;
+}
+
+void AssetLoader::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Idle.wait(lock, [this]() { return m_Jobs.empty() && m_RunningCount == 0; });
+}
+
+void AssetLoader::WorkerLoop()
+{
+	// WIC纹理加载需要在当前线程上初始化COM
+	HRESULT hrCom = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+			if (m_Stop)
+				break;
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+			++m_RunningCount;
+		}
+
+		Completion completion;
+		try
+		{
+			job.job();
+			completion.onReady = std::move(job.onReady);
+		}
+		catch (...)
+		{
+			completion.error = std::current_exception();
+		}
+
+		{
+			// 互斥量保证job写入的数据在主线程取出完成回调后可见
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Completions.push_back(std::move(completion));
+			--m_RunningCount;
+		}
+		m_Idle.notify_all();
+	}
+	if (SUCCEEDED(hrCom))
+		CoUninitialize();
+}
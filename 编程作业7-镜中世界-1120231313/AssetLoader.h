@@ -0,0 +1,70 @@
+//***************************************************************************************
+// AssetLoader.h
+//
+// 后台资源加载队列：文件读取、解析与GPU资源创建在加载线程上完成，完成回调交由主线程执行
+// Background asset loading queue with completion callbacks dispatched on the main thread.
+//***************************************************************************************
+
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AssetLoader
+{
+public:
+	// threadCount为加载线程数目，至少为1
+	explicit AssetLoader(size_t threadCount);
+	// 尚未开始的加载任务与尚未派发的完成回调会被丢弃，正在执行的任务完成后才返回
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// 提交一个加载任务，按提交顺序由空闲的加载线程执行
+	// job在加载线程上运行，可以读取文件并通过ID3D11Device创建资源，但不能使用设备上下文；
+	// job写入的数据在onReady中及之后对主线程可见，onReady由Dispatch在主线程上调用
+	// job抛出的异常会在Dispatch中重新抛出，此时不调用onReady
+	void Load(std::function<void()> job, std::function<void()> onReady = nullptr);
+
+	// 在当前线程上执行已完成任务的onReady，应每帧在主线程上调用；返回执行的数目
+	size_t Dispatch();
+
+	// 获取已提交但尚未派发完成回调的任务数目
+	size_t GetPendingCount() const;
+	// 阻塞直到所有已提交的任务都已完成，不执行完成回调
+	void WaitIdle();
+
+private:
+	struct Job
+	{
+		std::function<void()> job;
+		std::function<void()> onReady;
+	};
+	struct Completion
+	{
+		std::function<void()> onReady;
+		std::exception_ptr error;
+	};
+
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> m_Threads;				// 加载线程
+	std::deque<Job> m_Jobs;							// 待执行的任务
+	std::vector<Completion> m_Completions;			// 已完成、待派发的回调
+	size_t m_RunningCount;							// 正在执行的任务数目
+	size_t m_PendingCount;							// 尚未派发的任务数目
+	mutable std::mutex m_Mutex;						// 保护以上所有成员
+	std::condition_variable m_Condition;			// 通知加载线程有新任务或需要退出
+	std::condition_variable m_Idle;					// 通知WaitIdle所有任务已完成
+	bool m_Stop;									// 是否正在析构
+};
+
+#endif
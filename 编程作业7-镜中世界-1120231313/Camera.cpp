@@ -54,6 +54,11 @@ DirectX::XMFLOAT3 Camera::GetLook() const
 	return m_Look;
 }
 
+float Camera::GetFovY() const
+{
+	return m_FovY;
+}
+
 float Camera::GetNearWindowWidth() const
 {
 	return m_Aspect * m_NearWindowHeight;
@@ -31,6 +31,7 @@ public:
 	DirectX::XMFLOAT3 GetLook() const;
 
 	// 获取视锥体信息
+	float GetFovY() const;
 	float GetNearWindowWidth() const;
 	float GetNearWindowHeight() const;
 	float GetFarWindowWidth() const;
@@ -0,0 +1,172 @@
+//***************************************************************************************
+// CounterRng.h
+//
+// 基于计数器的无状态随机数(Philox4x32-10)：由(种子, 流, 实例编号)直接算出随机数，支持4路SIMD批量生成
+// Stateless counter-based random numbers (Philox4x32-10) keyed on (seed, stream, instance id) with SIMD batches.
+//***************************************************************************************
+
+#ifndef COUNTERRNG_H
+#define COUNTERRNG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <DirectXMath.h>
+
+#if !defined(_XM_NO_INTRINSICS_) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#include <emmintrin.h>
+#define COUNTERRNG_SSE2
+#endif
+
+namespace CounterRng
+{
+	// Philox4x32-10：counter为128位计数器，(key0, key1)为64位密钥，返回128位随机数
+	// 同一输入总得到同一输出，不依赖任何全局状态，可在任意线程以任意顺序调用
+	DirectX::XMUINT4 Philox4x32(const DirectX::XMUINT4& counter, uint32_t key0, uint32_t key1);
+
+	// 以(seed, stream)为密钥、(id, draw)为计数器生成4个32位随机数
+	// seed区分场景，stream区分用途，id为实例编号，draw为同一实例需要4个以上随机数时的序号
+	DirectX::XMUINT4 Random4(uint32_t seed, uint32_t stream, uint64_t id, uint32_t draw = 0);
+
+	// 将32位随机数的高24位映射到[0, 1)
+	float ToUnitFloat(uint32_t bits);
+
+	// 生成4个[0, 1)内的浮点数
+	DirectX::XMFLOAT4 Uniform4(uint32_t seed, uint32_t stream, uint64_t id, uint32_t draw = 0);
+
+	// 为编号在[firstId, firstId + count)内的实例各生成4个[0, 1)内的浮点数，写入out[0, count)
+	// 每次计算4个实例，结果与逐个调用Uniform4逐位相同，因此可以任意划分区间并行生成
+	void GenerateUniform4(uint32_t seed, uint32_t stream, uint64_t firstId, size_t count,
+		DirectX::XMFLOAT4* out, uint32_t draw = 0);
+}
+
+namespace CounterRng
+{
+	namespace Internal
+	{
+		static constexpr uint32_t PhiloxM0 = 0xD2511F53u;
+		static constexpr uint32_t PhiloxM1 = 0xCD9E8D57u;
+		static constexpr uint32_t PhiloxW0 = 0x9E3779B9u;
+		static constexpr uint32_t PhiloxW1 = 0xBB67AE85u;
+		static constexpr int PhiloxRounds = 10;
+
+		inline void MulHiLo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo)
+		{
+			uint64_t product = static_cast<uint64_t>(a) * b;
+			hi = static_cast<uint32_t>(product >> 32);
+			lo = static_cast<uint32_t>(product);
+		}
+
+#ifdef COUNTERRNG_SSE2
+		// 4路32位无符号乘法，分别返回64位乘积的高32位与低32位
+		inline void MulHiLo(__m128i a, __m128i b, __m128i& hi, __m128i& lo)
+		{
+			__m128i even = _mm_mul_epu32(a, b);
+			__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+			// 整理为[lo0, lo2, hi0, hi2]与[lo1, lo3, hi1, hi3]后交错
+			even = _mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));
+			odd = _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));
+			lo = _mm_unpacklo_epi32(even, odd);
+			hi = _mm_unpackhi_epi32(even, odd);
+		}
+
+		// 4个实例的计数器按分量分开存放，同时完成10轮Philox
+		inline void Philox4x32(__m128i& c0, __m128i& c1, __m128i& c2, __m128i& c3, uint32_t key0, uint32_t key1)
+		{
+			const __m128i m0 = _mm_set1_epi32(static_cast<int>(PhiloxM0));
+			const __m128i m1 = _mm_set1_epi32(static_cast<int>(PhiloxM1));
+			for (int round = 0; round < PhiloxRounds; ++round)
+			{
+				__m128i hi0, lo0, hi1, lo1;
+				MulHiLo(c0, m0, hi0, lo0);
+				MulHiLo(c2, m1, hi1, lo1);
+				__m128i k0 = _mm_set1_epi32(static_cast<int>(key0));
+				__m128i k1 = _mm_set1_epi32(static_cast<int>(key1));
+				c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), k0);
+				c1 = lo1;
+				c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), k1);
+				c3 = lo0;
+				key0 += PhiloxW0;
+				key1 += PhiloxW1;
+			}
+		}
+
+		// 与ToUnitFloat相同的映射，右移后不超过2^24，转换与乘法都是精确的
+		inline __m128 ToUnitFloat(__m128i bits)
+		{
+			return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(bits, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+		}
+#endif
+	}
+
+	inline DirectX::XMUINT4 Philox4x32(const DirectX::XMUINT4& counter, uint32_t key0, uint32_t key1)
+	{
+		uint32_t c0 = counter.x, c1 = counter.y, c2 = counter.z, c3 = counter.w;
+		for (int round = 0; round < Internal::PhiloxRounds; ++round)
+		{
+			uint32_t hi0, lo0, hi1, lo1;
+			Internal::MulHiLo(Internal::PhiloxM0, c0, hi0, lo0);
+			Internal::MulHiLo(Internal::PhiloxM1, c2, hi1, lo1);
+			c0 = hi1 ^ c1 ^ key0;
+			c1 = lo1;
+			c2 = hi0 ^ c3 ^ key1;
+			c3 = lo0;
+			key0 += Internal::PhiloxW0;
+			key1 += Internal::PhiloxW1;
+		}
+		return DirectX::XMUINT4(c0, c1, c2, c3);
+	}
+
+	inline DirectX::XMUINT4 Random4(uint32_t seed, uint32_t stream, uint64_t id, uint32_t draw)
+	{
+		DirectX::XMUINT4 counter(static_cast<uint32_t>(id), static_cast<uint32_t>(id >> 32), draw, 0);
+		return Philox4x32(counter, seed, stream);
+	}
+
+	inline float ToUnitFloat(uint32_t bits)
+	{
+		return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+	}
+
+	inline DirectX::XMFLOAT4 Uniform4(uint32_t seed, uint32_t stream, uint64_t id, uint32_t draw)
+	{
+		DirectX::XMUINT4 bits = Random4(seed, stream, id, draw);
+		return DirectX::XMFLOAT4(ToUnitFloat(bits.x), ToUnitFloat(bits.y), ToUnitFloat(bits.z), ToUnitFloat(bits.w));
+	}
+
+	inline void GenerateUniform4(uint32_t seed, uint32_t stream, uint64_t firstId, size_t count,
+		DirectX::XMFLOAT4* out, uint32_t draw)
+	{
+		size_t i = 0;
+#ifdef COUNTERRNG_SSE2
+		const __m128i laneOffsets = _mm_set_epi32(3, 2, 1, 0);
+		for (; i + 4 <= count; i += 4)
+		{
+			// 编号的低32位逐路加上0~3，进位加到高32位上(无符号比较借助翻转符号位完成)
+			uint64_t id = firstId + i;
+			__m128i low = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(id)));
+			__m128i c0 = _mm_add_epi32(low, laneOffsets);
+			const __m128i signBit = _mm_set1_epi32(static_cast<int>(0x80000000u));
+			__m128i carry = _mm_cmplt_epi32(_mm_xor_si128(c0, signBit), _mm_xor_si128(low, signBit));
+			__m128i c1 = _mm_sub_epi32(_mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(id >> 32))), carry);
+			__m128i c2 = _mm_set1_epi32(static_cast<int>(draw));
+			__m128i c3 = _mm_setzero_si128();
+			Internal::Philox4x32(c0, c1, c2, c3, seed, stream);
+
+			// 结果按分量存放，转置为每个实例的XMFLOAT4
+			__m128 x = Internal::ToUnitFloat(c0);
+			__m128 y = Internal::ToUnitFloat(c1);
+			__m128 z = Internal::ToUnitFloat(c2);
+			__m128 w = Internal::ToUnitFloat(c3);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_storeu_ps(&out[i].x, x);
+			_mm_storeu_ps(&out[i + 1].x, y);
+			_mm_storeu_ps(&out[i + 2].x, z);
+			_mm_storeu_ps(&out[i + 3].x, w);
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = Uniform4(seed, stream, firstId + i, draw);
+	}
+}
+
+#endif
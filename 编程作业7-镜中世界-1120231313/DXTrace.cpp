@@ -1,5 +1,6 @@
 #include "DXTrace.h"
 #include <cstdio>
+#include <stdexcept>
 
 HRESULT WINAPI DXTraceW(_In_z_ const WCHAR* strFile, _In_ DWORD dwLine, _In_ HRESULT hr,
 	_In_opt_ const WCHAR* strMsg, _In_ bool bPopMsgBox)
@@ -62,4 +63,22 @@ HRESULT WINAPI DXTraceW(_In_z_ const WCHAR* strFile, _In_ DWORD dwLine, _In_ HRE
 	}
 
 	return hr;
-}
\ No newline at end of file
+}
+
+void WINAPI DXThrowIfFailed(_In_z_ const WCHAR* strFile, _In_ DWORD dwLine, _In_ HRESULT hr, _In_opt_ const WCHAR* strMsg)
+{
+	if (SUCCEEDED(hr))
+		return;
+
+	DXTraceW(strFile, dwLine, hr, strMsg, false);
+
+	// 先按宽字符格式化，再转为UTF-8；用sprintf_s的%ls转换依赖线程的区域设置，
+	// 工作线程默认的"C"区域下路径中的中文会丢失
+	WCHAR strBufferW[1024];
+	_snwprintf_s(strBufferW, _TRUNCATE, L"%ls(%lu): %ls failed (0x%0.8x)", strFile ? strFile : L"", dwLine, strMsg ? strMsg : L"", hr);
+	char strBuffer[3072];
+	int len = WideCharToMultiByte(CP_UTF8, 0, strBufferW, -1, strBuffer, sizeof(strBuffer), nullptr, nullptr);
+	if (len <= 0)
+		strBuffer[0] = '\0';
+	throw std::runtime_error(strBuffer);
+}
@@ -23,6 +23,13 @@
 // 返回值: 形参hr
 HRESULT WINAPI DXTraceW(_In_z_ const WCHAR* strFile, _In_ DWORD dwLine, _In_ HRESULT hr, _In_opt_ const WCHAR* strMsg, _In_ bool bPopMsgBox);
 
+// ------------------------------
+// DXThrowIfFailed函数
+// ------------------------------
+// hr表示失败时，在调试输出窗口中输出错误信息(不弹窗)，然后抛出std::runtime_error，其what()为UTF-8编码
+// 参数含义同DXTraceW，用于不能弹出消息窗口的加载线程
+void WINAPI DXThrowIfFailed(_In_z_ const WCHAR* strFile, _In_ DWORD dwLine, _In_ HRESULT hr, _In_opt_ const WCHAR* strMsg);
+
 
 // ------------------------------
 // HR宏
@@ -45,6 +52,14 @@ HRESULT WINAPI DXTraceW(_In_z_ const WCHAR* strFile, _In_ DWORD dwLine, _In_ HRE
 	#endif 
 #endif
 
+// ------------------------------
+// HR_THROW宏
+// ------------------------------
+// Debug与Release模式下都检查返回值，失败时抛出异常，由调用方(如AssetLoader)转交给主线程处理
+#ifndef HR_THROW
+#define HR_THROW(x) DXThrowIfFailed(__FILEW__, (DWORD)__LINE__, (x), L#x)
+#endif
+
 
 
 #endif
@@ -0,0 +1,136 @@
+#include "ForestAnimation.h"
+#include <cmath>
+#include <algorithm>
+#include "CounterRng.h"
+#include "ThreadPool.h"
+using namespace DirectX;
+
+namespace
+{
+	// 每个并行任务处理的格子组数(每组4个格子)
+	constexpr size_t GroupGrainSize = 64;
+	// 每个并行任务生成初始旋转的子字符数目
+	constexpr size_t ChildGrainSize = 4096;
+}
+
+void ForestAnimation::Init(int size, uint32_t seed, uint32_t stream)
+{
+	size_t side = static_cast<size_t>(2 * size + 1);
+	m_CellCount = side * side;
+	size_t paddedCount = (m_CellCount + 3) & ~size_t(3);
+	m_Phases.assign(paddedCount, 0.0f);
+	m_Lengths.assign(paddedCount, 0.0f);
+	m_Heights.assign(paddedCount, 0.0f);
+	m_OffsetsX.assign(paddedCount, 0.0f);
+	m_OffsetsZ.assign(paddedCount, 0.0f);
+	m_ChildBases.resize(m_CellCount * ChildCount);
+
+	size_t cell = 0;
+	for (int i = -size; i <= size; i++)
+	{
+		for (int j = -size; j <= size; j++, cell++)
+		{
+			float length = static_cast<float>(abs(i) + abs(j));
+			m_Phases[cell] = static_cast<float>(i + j);
+			m_Lengths[cell] = length;
+			m_Heights[cell] = (11.5f - length) * (11.5f - length) * 0.015f;
+			m_OffsetsX[cell] = i * 2.0f;
+			m_OffsetsZ[cell] = j * 2.0f;
+		}
+	}
+
+	// 子字符的初始旋转只需生成一次，随机数只取决于子字符编号，因此可以任意划分区间并行生成
+	// Rz(rz + angle) = Rz(rz) * Rz(angle)，随时间变化的Rz(angle)在Update中统一乘上
+	ThreadPool::Get().ParallelFor(m_ChildBases.size(), ChildGrainSize, [&](size_t begin, size_t end) {
+		std::vector<XMFLOAT4> randoms(end - begin);
+		CounterRng::GenerateUniform4(seed, stream, begin, end - begin, randoms.data());
+		for (size_t child = begin; child < end; ++child)
+		{
+			const XMFLOAT4& r = randoms[child - begin];
+			XMStoreFloat3x3(&m_ChildBases[child], XMMatrixRotationX(r.x * XM_2PI) *
+				XMMatrixRotationY(r.y * XM_2PI) * XMMatrixRotationZ(r.z * XM_2PI));
+		}
+	});
+}
+
+void ForestAnimation::Update(float angle, InstanceTransforms& parentWorlds, InstanceTransforms& childWorlds) const
+{
+	// 所有格子共用的部分
+	float bob = cosf(angle * 0.6f);
+	XMMATRIX spin = XMMatrixRotationZ(angle);
+
+	size_t groupCount = (m_CellCount + 3) / 4;
+	ThreadPool::Get().ParallelFor(groupCount, GroupGrainSize, [&](size_t begin, size_t end) {
+		XMFLOAT4A scales, sinX, cosX, sinY, cosY, heights;
+		XMMATRIX children[ChildCount];
+		for (size_t group = begin; group < end; ++group)
+		{
+			// 4个格子一组计算三角函数
+			size_t first = group * 4;
+			XMVECTOR phase = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_Phases[first]));
+			XMVECTOR length = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_Lengths[first]));
+			XMVECTOR height = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_Heights[first]));
+			XMVECTOR s, c;
+			XMStoreFloat4A(&scales, XMVectorMultiplyAdd(XMVectorSin(phase + XMVectorReplicate(angle * 0.15f)),
+				XMVectorReplicate(0.25f), XMVectorReplicate(0.25f)));
+			XMVectorSinCos(&s, &c, phase + XMVectorReplicate(angle));
+			XMStoreFloat4A(&sinX, s);
+			XMStoreFloat4A(&cosX, c);
+			XMVectorSinCos(&s, &c, length * XMVectorReplicate(angle * 0.05f));
+			XMStoreFloat4A(&sinY, s);
+			XMStoreFloat4A(&cosY, c);
+			XMStoreFloat4A(&heights, height * XMVectorReplicate(bob));
+
+			size_t count = (std::min)(m_CellCount - first, size_t(4));
+			for (size_t k = 0; k < count; ++k)
+			{
+				size_t cell = first + k;
+				float scale = (&scales.x)[k];
+				float sx = (&sinX.x)[k], cx = (&cosX.x)[k];
+				float sy = (&sinY.x)[k], cy = (&cosY.x)[k];
+				float ox = m_OffsetsX[cell], oz = m_OffsetsZ[cell];
+
+				// 公转与浮动：mTranslateXY * Ry * mTranslateZ
+				XMMATRIX place(
+					cy, 0.0f, -sy, 0.0f,
+					0.0f, 1.0f, 0.0f, 0.0f,
+					sy, 0.0f, cy, 0.0f,
+					ox * cy + oz * sy, (&heights.x)[k], oz * cy - ox * sy, 1.0f);
+
+				// 母字符：mScale * Rx * place
+				parentWorlds.Store(cell, XMMATRIX(
+					XMVectorSet(scale * cy, 0.0f, -scale * sy, 0.0f),
+					XMVectorSet(scale * sx * sy, scale * cx, scale * sx * cy, 0.0f),
+					XMVectorSet(scale * cx * sy, -scale * sx, scale * cx * cy, 0.0f),
+					place.r[3]));
+
+				// 子字符：mTranslateChild * Rx * mScaleChild * (base * Rz(angle)) * place
+				// 记tail = Rz(angle) * place，缩放并入tail的线性部分，则线性部分为Rx * base * tail，
+				// Rx只有两行需要混合；mTranslateChild * Rx的平移恰为Rx前两行之和的3倍，
+				// 因此平移为线性部分前两行之和的3倍再加上tail的平移，每个子字符省去两次完整的4x4乘法
+				XMMATRIX tail = XMMatrixMultiply(spin, place);
+				float childScale = scale * 0.6f;
+				XMVECTOR t0 = tail.r[0] * childScale, t1 = tail.r[1] * childScale, t2 = tail.r[2] * childScale;
+				XMVECTOR vcx = XMVectorReplicate(cx), vsx = XMVectorReplicate(sx);
+				const XMFLOAT3X3* pBase = &m_ChildBases[cell * ChildCount];
+				for (size_t child = 0; child < ChildCount; ++child)
+				{
+					XMMATRIX base = XMLoadFloat3x3(&pBase[child]);
+					XMVECTOR rows[3] = {
+						base.r[0],
+						XMVectorMultiplyAdd(vcx, base.r[1], vsx * base.r[2]),
+						XMVectorMultiplyAdd(vcx, base.r[2], -vsx * base.r[1])
+					};
+					XMMATRIX& world = children[child];
+					for (int row = 0; row < 3; ++row)
+					{
+						world.r[row] = XMVectorMultiplyAdd(XMVectorSplatX(rows[row]), t0,
+							XMVectorMultiplyAdd(XMVectorSplatY(rows[row]), t1, XMVectorSplatZ(rows[row]) * t2));
+					}
+					world.r[3] = XMVectorMultiplyAdd(world.r[0] + world.r[1], XMVectorReplicate(3.0f), tail.r[3]);
+				}
+				childWorlds.StoreBatch(cell * ChildCount, ChildCount, children);
+			}
+		}
+	});
+}
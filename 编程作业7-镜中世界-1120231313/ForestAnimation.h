@@ -0,0 +1,48 @@
+//***************************************************************************************
+// ForestAnimation.h
+//
+// 字符森林的动画：各格子的不变量按分量连续存放，随时间变化的部分按格子区间在线程池上分组计算
+// Data-oriented character forest animation with SoA invariants and batched, multi-threaded updates.
+//***************************************************************************************
+
+#ifndef FORESTANIMATION_H
+#define FORESTANIMATION_H
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "InstanceTransforms.h"
+
+class ForestAnimation
+{
+public:
+	// 每个母字符周围的子字符数目
+	static constexpr size_t ChildCount = 6;
+
+	// 生成(2 * size + 1)²个格子的不变量，格子按i从-size到size、j从-size到size的顺序排列
+	// 子字符的初始旋转由CounterRng以(seed, stream, 子字符编号)生成，相同参数总得到相同的森林
+	void Init(int size, uint32_t seed, uint32_t stream);
+
+	// 获取母字符与子字符的数目
+	size_t GetParentCount() const { return m_CellCount; }
+	size_t GetChildCount() const { return m_CellCount * ChildCount; }
+
+	// 计算angle时刻的世界矩阵，写入parentWorlds与childWorlds，两者须已分别容纳GetParentCount()与GetChildCount()个实例
+	// 第c个格子的子字符位于childWorlds[c * ChildCount, (c + 1) * ChildCount)
+	// 所有节点每帧都在变化，直接由格子的不变量算出世界矩阵
+	// 开销与矩阵数目成正比，size为12时约4千个矩阵；size为200时超过110万个矩阵、写入约72MB，
+	// 单核上每帧需要数十毫秒，只能依靠线程池分摊，这样的规模不适合逐帧在CPU上更新
+	void Update(float angle, InstanceTransforms& parentWorlds, InstanceTransforms& childWorlds) const;
+
+private:
+	size_t m_CellCount = 0;
+	// 以下数组按格子存放，长度向上取整到4的倍数，以便4个格子一组读取
+	std::vector<float> m_Phases;					// i + j，自转与缩放的相位
+	std::vector<float> m_Lengths;					// |i| + |j|，公转的角速度系数
+	std::vector<float> m_Heights;					// 上下浮动的幅度
+	std::vector<float> m_OffsetsX;					// 格子的位置
+	std::vector<float> m_OffsetsZ;
+	std::vector<DirectX::XMFLOAT3X3> m_ChildBases;	// 子字符不随时间变化的旋转Rx * Ry * Rz，每个格子ChildCount个
+};
+
+#endif
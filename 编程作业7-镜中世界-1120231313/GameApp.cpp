@@ -8,12 +8,18 @@ GameApp::GameApp(HINSTANCE hInstance)
 	m_CameraMode(CameraMode::FirstPerson),
 	m_CBFrame(),
 	m_CBOnResize(),
-	m_CBRarely()
+	m_CBRarely(),
+	m_DepthShadersReady(false),
+	m_ModelShadersReady(false),
+	m_PlaneShadersReady(false),
+	m_pAssetLoader(std::make_unique<AssetLoader>((std::max)(2u, std::thread::hardware_concurrency() / 2)))
 {
 }
 
 GameApp::~GameApp()
 {
+	// 先等待正在执行的加载任务结束，它们会写入本对象的成员
+	m_pAssetLoader.reset();
 }
 
 bool GameApp::Init()
@@ -26,6 +32,7 @@ bool GameApp::Init()
 
 	if (!InitResource())
 		return false;
+	// 以上只提交了加载任务，资源陆续加载完成后在UpdateScene中生效，不必等待即可开始绘制
 
 	// 初始化鼠标，键盘不需要
 	m_pMouse->SetWindow(m_hMainWnd);
@@ -54,6 +61,31 @@ void GameApp::OnResize()
 
 void GameApp::UpdateScene(float dt)
 {
+	// 使已加载完成的资源生效；加载失败的资源只报告错误，其就绪标记保持未设置，其余资源照常绘制
+	for (;;)
+	{
+		try
+		{
+			m_pAssetLoader->Dispatch();
+			break;
+		}
+		catch (const std::exception& e)
+		{
+			// Dispatch已将其余完成的回调放回队列，继续派发
+#if defined(DEBUG) || defined(_DEBUG)
+			// 异常信息为UTF-8编码，转为宽字符输出，避免按ANSI代码页解释导致中文乱码
+			int len = MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, nullptr, 0);
+			std::wstring message(len > 0 ? len - 1 : 0, L'\0');
+			if (len > 0)
+				MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &message[0], len);
+			message += L'\n';
+			OutputDebugStringW(message.c_str());
+#else
+			UNREFERENCED_PARAMETER(e);
+#endif
+		}
+	}
+
 	// 更新鼠标事件，获取相对偏移量
 	Mouse::State mouseState = m_pMouse->GetState();
 	Mouse::State lastMouseState = m_MouseTracker.GetLastState();
@@ -127,10 +159,8 @@ void GameApp::UpdateScene(float dt)
 		auto idx = m_CBFrame.numDirLight;
 		auto color = XMFLOAT4(0.85546875, 0.7421875, 0.984375, 1.0f);
 
-		std::random_device rd;
-		std::mt19937 gen(rd());
-		std::uniform_real_distribution<float> dis(0.0f, 1.0f);
-		auto direction = XMFLOAT3(dis(gen), dis(gen), dis(gen));
+		auto r = CounterRng::Uniform4(sceneSeed, DirLightStream, idx);
+		auto direction = XMFLOAT3(r.x, r.y, r.z);
 		auto d_normalized = XMVector3Normalize(XMLoadFloat3(&direction));
 		XMStoreFloat3(&direction, d_normalized);
 
@@ -148,10 +178,8 @@ void GameApp::UpdateScene(float dt)
 	// 更新光源
 	if (m_CBFrame.numPointLight)
 	{
-		std::random_device rd;
-		std::mt19937 gen(rd());
-		std::uniform_real_distribution<float> dis(-0.5f, 0.5f);
-		auto delta = XMVectorSet(dis(gen), 0.0f, dis(gen), 0.0f);
+		auto r = CounterRng::Uniform4(sceneSeed, PointLightStream, m_PointLightStep++);
+		auto delta = XMVectorSet(r.x - 0.5f, 0.0f, r.y - 0.5f, 0.0f);
 		auto dir = XMLoadFloat3(&m_PointLightDirection[0]);
 		dir = XMVector3Normalize(dir + delta);
 		XMStoreFloat3(&m_PointLightDirection[0], dir);
@@ -167,47 +195,16 @@ void GameApp::UpdateScene(float dt)
 	}
 
 
-	m_Worlds.clear();
-	// m_Worlds[0] 和 [1] 存储 母字符 与 子字符 的世界矩阵 
-	m_Worlds.resize(2);
 	angle += dt;
 
 	XMFLOAT2 texOffset = XMFLOAT2(angle * 0.1f, 0.0f);
 	m_Plane.SetTexOffset(texOffset);
 
-	for (int i = -size; i <= size; i++)
-	{
-		for (int j = -size; j <= size; j++)
-		{
-			float length = abs(i) + abs(j);
-			float scale = (sinf(0.05 * angle * 3.0f + i + j) + 1) * 0.25;
-			auto mScale = XMMatrixScaling(scale, scale, scale);
-
-			auto mRotateSelf = XMMatrixRotationX(angle + i + j);
-			auto mRotateCommon = XMMatrixRotationY(angle * length * 0.05);
-			auto mTranslateXY = XMMatrixTranslation(i * 2.0, 0.0, j * 2.0);
-			auto mTranslateZ = XMMatrixTranslation(0, pow((11.5 - length), 2) * cos(angle * 0.6) * 0.015, 0);
-
-			auto mTranslate = mTranslateXY * mRotateCommon * mTranslateZ;
-
-			// 计算出变换然后存储到世界矩阵的数组中
-			m_Worlds[0].push_back(mScale * mRotateSelf * mTranslate);
-			// 每个子字符是从同一个起点开始的，所以设置种子每次一致
-			// 疑似可以通过初始化一个起始位置，但是这样的话代码结构又要大改
-			srand(length + i * j);
-
-			scale *= 0.6;
-			auto mTranslateChild = XMMatrixTranslation(3, 3, 0);
-			for (int k = 0; k < 6; ++k)
-			{
-				auto mScaleChild = XMMatrixScaling(scale, scale, scale);
-				auto mRotateChild = XMMatrixRotationX(rand()) * XMMatrixRotationY(rand()) * XMMatrixRotationZ(rand() + angle);
-				// 计算出变换然后存储到世界矩阵的数组中
-				m_Worlds[1].push_back(mTranslateChild * mRotateSelf * mScaleChild * mRotateChild * mTranslate);
-			}
-
-		}
-	}
+	// m_Worlds[0] 和 [1] 存储 母字符 与 子字符 的世界矩阵，在线程池上原地更新
+	m_ForestAnimation.Update(angle, m_Worlds[0], m_Worlds[1]);
+	// 法线变换所需的逆矩阵对所有实例批量计算，反射与正常两个绘制阶段共用
+	for (size_t i = 0; i < m_Worlds.size(); ++i)
+		m_Worlds[i].ComputeInverses(m_WorldInverses[i]);
 
 	
 	// 退出程序，这里应向窗口发送销毁信息
@@ -229,11 +226,20 @@ void GameApp::DrawScene()
 	m_pd3dImmediateContext->ClearDepthStencilView(m_pDepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
 	// 镜面反射 模板缓冲区
-	m_pd3dImmediateContext->RSSetState(nullptr);
-	m_pd3dImmediateContext->OMSetDepthStencilState(RenderStates::DSSWriteStencil.Get(), 1);
-	m_pd3dImmediateContext->OMSetBlendState(RenderStates::BSNoColorWrite.Get(), nullptr, 0xffffffff);
+	// 只写模板不写颜色，输入布局只读取镜子的位置分量，且不需要像素着色器
+	if (m_DepthShadersReady)
+	{
+		m_pd3dImmediateContext->RSSetState(nullptr);
+		m_pd3dImmediateContext->OMSetDepthStencilState(RenderStates::DSSWriteStencil.Get(), 1);
+		m_pd3dImmediateContext->OMSetBlendState(RenderStates::BSNoColorWrite.Get(), nullptr, 0xffffffff);
 
-	m_Mirror.Draw(m_pd3dImmediateContext.Get());
+		m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPos.Get());
+		m_pd3dImmediateContext->VSSetShader(m_pDepthVS.Get(), nullptr, 0);
+		m_pd3dImmediateContext->GSSetShader(nullptr, nullptr, 0);
+		m_pd3dImmediateContext->PSSetShader(nullptr, nullptr, 0);
+
+		m_Mirror.Draw(m_pd3dImmediateContext.Get());
+	}
 
 	// 镜面中物体
 	m_CBRarely.isReflection = true;
@@ -242,41 +248,69 @@ void GameApp::DrawScene()
 	memcpy_s(mappedData.pData, sizeof(CBChangesRarely), &m_CBRarely, sizeof(CBChangesRarely));
 	m_pd3dImmediateContext->Unmap(m_pConstantBuffers[3].Get(), 0);
 
+	// 按实例到摄像机的距离选择模型的LOD级别：物体单位长度投影到屏幕上的像素数
+	XMVECTOR eyePos = m_pCamera->GetPositionXM();
+	float projScale = m_ClientHeight / (2.0f * tanf(0.5f * m_pCamera->GetFovY()));
+	auto lodScale = [&](FXMMATRIX world)
+	{
+		float worldScale = XMVectorGetX(XMVector3Length(world.r[0]));
+		float distance = XMVectorGetX(XMVector3Length(world.r[3] - eyePos));
+		return projScale * worldScale / (std::max)(distance, 1e-3f);
+	};
+	// 反射物体按镜像后的位置计算距离
+	XMMATRIX reflection = XMMatrixTranspose(m_CBRarely.reflection);
+
+	// 按簇剔除模型，几何着色器Basic_GS_3D会为每个三角形再输出一份关于x = 30平面的镜像副本，两份都要考虑
+	XMMATRIX viewProj = m_pCamera->GetViewProjXM();
+	XMFLOAT3 eyePosition = m_pCamera->GetPosition();
+	XMMATRIX gsMirror = XMMatrixReflect(XMVectorSet(1.0f, 0.0f, 0.0f, -30.0f));
+	XMMATRIX copies[2];
+
 	// 不透明的反射物体
-	m_pd3dImmediateContext->OMSetDepthStencilState(RenderStates::DSSDrawWithStencil.Get(), 1);
-	m_pd3dImmediateContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
+	if (m_ModelShadersReady)
+	{
+		m_pd3dImmediateContext->OMSetDepthStencilState(RenderStates::DSSDrawWithStencil.Get(), 1);
+		m_pd3dImmediateContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
 
-	m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalColor.Get());
-	m_pd3dImmediateContext->RSSetState(nullptr);
+		m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalColorPacked.Get());
+		m_pd3dImmediateContext->RSSetState(nullptr);
 
-	m_pd3dImmediateContext->VSSetShader(m_pVertexShader3D.Get(), nullptr, 0);
-	m_pd3dImmediateContext->GSSetShader(m_pGeometryShader3D.Get(), nullptr, 0);
-	m_pd3dImmediateContext->PSSetShader(m_pPixelShader3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->VSSetShader(m_pVertexShader3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->GSSetShader(m_pGeometryShader3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->PSSetShader(m_pPixelShader3D.Get(), nullptr, 0);
 
-	for (int i = 0; i < m_Models.size(); ++i)
-	{
-		for (int j = 0; j < m_Worlds[i].size(); j++)
+		for (int i = 0; i < m_Models.size(); ++i)
 		{
-			auto world = m_Worlds[i][j];
-			m_Models[i].SetWorldMatrix(world);
-			m_Models[i].SetMaterial(m_Materials[i][j]);
-			m_Models[i].SetColor(m_Colors[i][j]);
-			m_Models[i].Draw(m_pd3dImmediateContext.Get());
+			for (size_t j = 0; j < m_Worlds[i].GetCount(); ++j)
+			{
+				auto world = m_Worlds[i].Load(j);
+				copies[0] = XMMatrixMultiply(world, reflection);
+				copies[1] = XMMatrixMultiply(copies[0], gsMirror);
+				m_Models[i].SelectLod((std::max)(lodScale(copies[0]), lodScale(copies[1])));
+				m_Models[i].CullMeshlets(copies, 2, viewProj, eyePosition);
+				m_Models[i].SetWorldMatrix(world, m_WorldInverses[i].Load(j));
+				m_Models[i].SetMaterial(m_Materials[i][j]);
+				m_Models[i].SetColor(m_Colors[i][j]);
+				m_Models[i].Draw(m_pd3dImmediateContext.Get());
+			}
 		}
 	}
 
 	// 透明的反射物体
-	m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalTex.Get());
-	m_pd3dImmediateContext->RSSetState(RenderStates::RSNoCull.Get());
-	m_pd3dImmediateContext->OMSetDepthStencilState(RenderStates::DSSDrawWithStencil.Get(), 1);
-	m_pd3dImmediateContext->OMSetBlendState(RenderStates::BSTransparent.Get(), nullptr, 0xFFFFFFFF);
+	if (m_PlaneShadersReady)
+	{
+		m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalTex.Get());
+		m_pd3dImmediateContext->RSSetState(RenderStates::RSNoCull.Get());
+		m_pd3dImmediateContext->OMSetDepthStencilState(RenderStates::DSSDrawWithStencil.Get(), 1);
+		m_pd3dImmediateContext->OMSetBlendState(RenderStates::BSTransparent.Get(), nullptr, 0xFFFFFFFF);
 
-	m_pd3dImmediateContext->VSSetShader(m_pPlaneVS3D.Get(), nullptr, 0);
-	m_pd3dImmediateContext->GSSetShader(nullptr, nullptr, 0);
-	m_pd3dImmediateContext->PSSetShader(m_pPlanePS3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->VSSetShader(m_pPlaneVS3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->GSSetShader(nullptr, nullptr, 0);
+		m_pd3dImmediateContext->PSSetShader(m_pPlanePS3D.Get(), nullptr, 0);
 
-	m_Plane.Draw(m_pd3dImmediateContext.Get());
-	m_Mirror.Draw(m_pd3dImmediateContext.Get());
+		m_Plane.Draw(m_pd3dImmediateContext.Get());
+		m_Mirror.Draw(m_pd3dImmediateContext.Get());
+	}
 
 	// 正常物体
 	m_CBRarely.isReflection = false;
@@ -285,40 +319,49 @@ void GameApp::DrawScene()
 	m_pd3dImmediateContext->Unmap(m_pConstantBuffers[3].Get(), 0);
 
 	// 不透明的正常物体
+	if (m_ModelShadersReady)
+	{
+		m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalColorPacked.Get());
+		m_pd3dImmediateContext->RSSetState(nullptr);
+		m_pd3dImmediateContext->OMSetDepthStencilState(nullptr, 0);
+		m_pd3dImmediateContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
 
-	m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalColor.Get());
-	m_pd3dImmediateContext->RSSetState(nullptr);
-	m_pd3dImmediateContext->OMSetDepthStencilState(nullptr, 0);
-	m_pd3dImmediateContext->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
-
-	m_pd3dImmediateContext->VSSetShader(m_pVertexShader3D.Get(), nullptr, 0);
-	m_pd3dImmediateContext->GSSetShader(m_pGeometryShader3D.Get(), nullptr, 0);
-	m_pd3dImmediateContext->PSSetShader(m_pPixelShader3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->VSSetShader(m_pVertexShader3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->GSSetShader(m_pGeometryShader3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->PSSetShader(m_pPixelShader3D.Get(), nullptr, 0);
 
-	for (int i = 0; i < m_Models.size(); ++i)
-	{
-		for (int j = 0; j < m_Worlds[i].size(); j++)
+		for (int i = 0; i < m_Models.size(); ++i)
 		{
-			auto world = m_Worlds[i][j];
-			m_Models[i].SetWorldMatrix(world);
-			m_Models[i].SetMaterial(m_Materials[i][j]);
-			m_Models[i].SetColor(m_Colors[i][j]);
-			m_Models[i].Draw(m_pd3dImmediateContext.Get());
+			for (size_t j = 0; j < m_Worlds[i].GetCount(); ++j)
+			{
+				auto world = m_Worlds[i].Load(j);
+				copies[0] = world;
+				copies[1] = XMMatrixMultiply(world, gsMirror);
+				m_Models[i].SelectLod((std::max)(lodScale(copies[0]), lodScale(copies[1])));
+				m_Models[i].CullMeshlets(copies, 2, viewProj, eyePosition);
+				m_Models[i].SetWorldMatrix(world, m_WorldInverses[i].Load(j));
+				m_Models[i].SetMaterial(m_Materials[i][j]);
+				m_Models[i].SetColor(m_Colors[i][j]);
+				m_Models[i].Draw(m_pd3dImmediateContext.Get());
+			}
 		}
 	}
 
 	// 透明的正常物体
-	m_pd3dImmediateContext->RSSetState(RenderStates::RSNoCull.Get());
-	m_pd3dImmediateContext->OMSetDepthStencilState(nullptr, 0);
-	m_pd3dImmediateContext->OMSetBlendState(RenderStates::BSTransparent.Get(), nullptr, 0xFFFFFFFF);
+	if (m_PlaneShadersReady)
+	{
+		m_pd3dImmediateContext->RSSetState(RenderStates::RSNoCull.Get());
+		m_pd3dImmediateContext->OMSetDepthStencilState(nullptr, 0);
+		m_pd3dImmediateContext->OMSetBlendState(RenderStates::BSTransparent.Get(), nullptr, 0xFFFFFFFF);
 
-	m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalTex.Get());
+		m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalTex.Get());
 
-	m_pd3dImmediateContext->VSSetShader(m_pPlaneVS3D.Get(), nullptr, 0);
-	m_pd3dImmediateContext->GSSetShader(nullptr, nullptr, 0);
-	m_pd3dImmediateContext->PSSetShader(m_pPlanePS3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->VSSetShader(m_pPlaneVS3D.Get(), nullptr, 0);
+		m_pd3dImmediateContext->GSSetShader(nullptr, nullptr, 0);
+		m_pd3dImmediateContext->PSSetShader(m_pPlanePS3D.Get(), nullptr, 0);
 
-	m_Plane.Draw(m_pd3dImmediateContext.Get());
+		m_Plane.Draw(m_pd3dImmediateContext.Get());
+	}
 
 	HR(m_pSwapChain->Present(0, 0));
 }
@@ -326,29 +369,57 @@ void GameApp::DrawScene()
 
 bool GameApp::InitEffect()
 {
-	ComPtr<ID3DBlob> blob;
-
-	// 创建顶点着色器(3D)
-	HR(CreateShaderFromFile(L"HLSL\\Basic_VS_3D.cso", L"HLSL\\Basic_VS_3D.hlsl", "VS_3D", "vs_5_0", blob.ReleaseAndGetAddressOf()));
-	HR(m_pd3dDevice->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pVertexShader3D.GetAddressOf()));
-	// 创建顶点布局(3D)
-	HR(m_pd3dDevice->CreateInputLayout(VertexPosNormalColor::inputLayout, ARRAYSIZE(VertexPosNormalColor::inputLayout),
-		blob->GetBufferPointer(), blob->GetBufferSize(), m_pVertexLayoutPosNormalColor.GetAddressOf()));
-
-	HR(CreateShaderFromFile(L"HLSL\\Plane_VS.cso", L"HLSL\\Plane_VS.hlsl", "VS_3D", "vs_5_0", blob.ReleaseAndGetAddressOf()));
-	HR(m_pd3dDevice->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pPlaneVS3D.GetAddressOf()));
-	HR(m_pd3dDevice->CreateInputLayout(VertexPosNormalTex::inputLayout, ARRAYSIZE(VertexPosNormalTex::inputLayout),
-		blob->GetBufferPointer(), blob->GetBufferSize(), m_pVertexLayoutPosNormalTex.GetAddressOf()));
-	// 创建像素着色器(3D)
-	HR(CreateShaderFromFile(L"HLSL\\Basic_PS_3D.cso", L"HLSL\\Basic_PS_3D.hlsl", "PS_3D", "ps_5_0", blob.ReleaseAndGetAddressOf()));
-	HR(m_pd3dDevice->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pPixelShader3D.GetAddressOf()));
-
-	HR(CreateShaderFromFile(L"HLSL\\Plane_PS.cso", L"HLSL\\Plane_PS.hlsl", "PS_3D", "ps_5_0", blob.ReleaseAndGetAddressOf()));
-	HR(m_pd3dDevice->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pPlanePS3D.GetAddressOf()));
-
-	// 创建几何着色器(3D)
-	HR(CreateShaderFromFile(L"HLSL\\Basic_GS_3D.cso", L"HLSL\\Basic_GS_3D.hlsl", "GS_3D", "gs_5_0", blob.ReleaseAndGetAddressOf()));
-	HR(m_pd3dDevice->CreateGeometryShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pGeometryShader3D.GetAddressOf()));
+	// 着色器的读取或编译较慢，按所属的渲染阶段分组在加载线程上创建，每组全部创建完成后该阶段才开始绘制
+	// 加载线程上用HR_THROW检查返回值，失败的组不会开始绘制，错误由Dispatch转交给主线程
+	ID3D11Device* device = m_pd3dDevice.Get();
+
+	m_pAssetLoader->Load([this, device]()
+	{
+		ComPtr<ID3DBlob> blob;
+		// 创建顶点着色器(3D)
+		HR_THROW(CreateShaderFromFile(L"HLSL\\Basic_VS_3D.cso", L"HLSL\\Basic_VS_3D.hlsl", "VS_3D", "vs_5_0", blob.ReleaseAndGetAddressOf()));
+		HR_THROW(device->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pVertexShader3D.GetAddressOf()));
+		// 创建顶点布局(3D)
+		HR_THROW(device->CreateInputLayout(VertexPosNormalColorPacked::inputLayout, ARRAYSIZE(VertexPosNormalColorPacked::inputLayout),
+			blob->GetBufferPointer(), blob->GetBufferSize(), m_pVertexLayoutPosNormalColorPacked.GetAddressOf()));
+		// 创建像素着色器(3D)
+		HR_THROW(CreateShaderFromFile(L"HLSL\\Basic_PS_3D.cso", L"HLSL\\Basic_PS_3D.hlsl", "PS_3D", "ps_5_0", blob.ReleaseAndGetAddressOf()));
+		HR_THROW(device->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pPixelShader3D.GetAddressOf()));
+		// 创建几何着色器(3D)
+		HR_THROW(CreateShaderFromFile(L"HLSL\\Basic_GS_3D.cso", L"HLSL\\Basic_GS_3D.hlsl", "GS_3D", "gs_5_0", blob.ReleaseAndGetAddressOf()));
+		HR_THROW(device->CreateGeometryShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pGeometryShader3D.GetAddressOf()));
+
+		D3D11SetDebugObjectName(m_pVertexLayoutPosNormalColorPacked.Get(), "VertexPosNormalColorPackedLayout");
+		D3D11SetDebugObjectName(m_pVertexShader3D.Get(), "Basic_VS_3D");
+		D3D11SetDebugObjectName(m_pPixelShader3D.Get(), "Basic_PS_3D");
+	}, [this]() { m_ModelShadersReady = true; });
+
+	m_pAssetLoader->Load([this, device]()
+	{
+		ComPtr<ID3DBlob> blob;
+		HR_THROW(CreateShaderFromFile(L"HLSL\\Plane_VS.cso", L"HLSL\\Plane_VS.hlsl", "VS_3D", "vs_5_0", blob.ReleaseAndGetAddressOf()));
+		HR_THROW(device->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pPlaneVS3D.GetAddressOf()));
+		// 平面与镜子的顶点按分量分流存放
+		HR_THROW(device->CreateInputLayout(VertexTraits<VertexPosNormalTex>::streamInputLayout, ARRAYSIZE(VertexTraits<VertexPosNormalTex>::streamInputLayout),
+			blob->GetBufferPointer(), blob->GetBufferSize(), m_pVertexLayoutPosNormalTex.GetAddressOf()));
+
+		HR_THROW(CreateShaderFromFile(L"HLSL\\Plane_PS.cso", L"HLSL\\Plane_PS.hlsl", "PS_3D", "ps_5_0", blob.ReleaseAndGetAddressOf()));
+		HR_THROW(device->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pPlanePS3D.GetAddressOf()));
+
+		D3D11SetDebugObjectName(m_pVertexLayoutPosNormalTex.Get(), "VertexPosNormalTexLayout");
+	}, [this]() { m_PlaneShadersReady = true; });
+
+	m_pAssetLoader->Load([this, device]()
+	{
+		ComPtr<ID3DBlob> blob;
+		// 创建只输出位置的顶点着色器，只从位置分量的顶点缓冲区读取
+		HR_THROW(CreateShaderFromFile(L"HLSL\\Depth_VS.cso", L"HLSL\\Depth_VS.hlsl", "VS_3D", "vs_5_0", blob.ReleaseAndGetAddressOf()));
+		HR_THROW(device->CreateVertexShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, m_pDepthVS.GetAddressOf()));
+		HR_THROW(device->CreateInputLayout(VertexTraits<VertexPos>::streamInputLayout, ARRAYSIZE(VertexTraits<VertexPos>::streamInputLayout),
+			blob->GetBufferPointer(), blob->GetBufferSize(), m_pVertexLayoutPos.GetAddressOf()));
+
+		D3D11SetDebugObjectName(m_pVertexLayoutPos.Get(), "VertexPosLayout");
+	}, [this]() { m_DepthShadersReady = true; });
 
 	return true;
 }
@@ -375,18 +446,29 @@ bool GameApp::InitResource()
 	HR(m_pd3dDevice->CreateBuffer(&cbd, nullptr, m_pConstantBuffers[3].GetAddressOf()));
 	// ******************
 	// 初始化游戏对象
-	ComPtr<ID3D11ShaderResourceView> texture;
+	// 纹理与模型在加载线程上读取并创建，完成回调中才交给要绘制的物体，未加载完成的物体不绘制
+	ID3D11Device* device = m_pd3dDevice.Get();
 	Material material;
 
 	// 头像平面
-	HR(CreateWICTextureFromFile(m_pd3dDevice.Get(), L"Texture\\Avatar.bmp", nullptr, texture.GetAddressOf()));
-	m_Plane.SetBuffer(m_pd3dDevice.Get(), Geometry::CreatePlane<VertexPosNormalTex, WORD>(
-		XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT2(20.0f, 20.0f), XMFLOAT2(1.0f, 1.0f)));
-	m_Plane.SetTexture(texture.Get());
 	material.ambient = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.4);
 	material.diffuse = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.25);
 	material.specular = XMFLOAT4(0.1f, 0.1f, 0.1f, 0.3);
 	m_Plane.SetMaterial(material);
+	auto plane = std::make_shared<GameObject>();
+	m_pAssetLoader->Load([plane, device]()
+	{
+		ComPtr<ID3D11ShaderResourceView> texture;
+		HR_THROW(CreateWICTextureFromFile(device, L"Texture\\Avatar.bmp", nullptr, texture.GetAddressOf()));
+		plane->SetBuffer(device, Geometry::ToSoA(Geometry::CreatePlane<VertexPosNormalTex, WORD>(
+			XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT2(20.0f, 20.0f), XMFLOAT2(1.0f, 1.0f))));
+		plane->SetTexture(texture.Get());
+	}, [this, plane]()
+	{
+		// 世界矩阵等属性可能已被主线程修改，只取网格与纹理
+		m_Plane.SetMesh(plane->GetMesh());
+		m_Plane.SetTexture(plane->GetTexture());
+	});
 	auto mScale = XMMatrixScaling(1.0f, 1.0f, 1.0f);
 
 	auto mRotateSelf = XMMatrixRotationX(-DirectX::XM_PIDIV2);
@@ -398,11 +480,20 @@ bool GameApp::InitResource()
 	m_Plane.SetWorldMatrix(mScale * mRotateSelf * mTranslate);
 
 	// 镜子平面
-	HR(CreateDDSTextureFromFile(m_pd3dDevice.Get(), L"Texture\\ice.dds", nullptr, texture.GetAddressOf()));
-	m_Mirror.SetBuffer(m_pd3dDevice.Get(), Geometry::CreatePlane<VertexPosNormalTex, WORD>(
-		XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT2(160.0f, 20.0f), XMFLOAT2(1.0f, 1.0f)));
-	m_Mirror.SetTexture(texture.Get());
 	m_Mirror.SetMaterial(material);
+	auto mirror = std::make_shared<GameObject>();
+	m_pAssetLoader->Load([mirror, device]()
+	{
+		ComPtr<ID3D11ShaderResourceView> texture;
+		HR_THROW(CreateDDSTextureFromFile(device, L"Texture\\ice.dds", nullptr, texture.GetAddressOf()));
+		mirror->SetBuffer(device, Geometry::ToSoA(Geometry::CreatePlane<VertexPosNormalTex, WORD>(
+			XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT2(160.0f, 20.0f), XMFLOAT2(1.0f, 1.0f))));
+		mirror->SetTexture(texture.Get());
+	}, [this, mirror]()
+	{
+		m_Mirror.SetMesh(mirror->GetMesh());
+		m_Mirror.SetTexture(mirror->GetTexture());
+	});
 	mRotateCommon = XMMatrixRotationY(0.0f);
 	mRotateSelf = XMMatrixRotationX(-DirectX::XM_PIDIV2);
 	mTranslateXY = XMMatrixTranslation(30.0f, 0.0f, 0.0f);
@@ -415,68 +506,123 @@ bool GameApp::InitResource()
 		"Ning.obj",
 		"Jie.obj"
 	};
-	for (const auto& path : model_paths)
+	// 同一模型只解析、上传一次，之后的请求共享同一份网格
+	auto load_model = [device](const std::string& path)
 	{
-		GameObject model;
-		model.SetBuffer(m_pd3dDevice.Get(), Geometry::CreateModel(path));
-		m_Models.push_back(model);
-	}
-
-	// 初始化模型的世界矩阵
-	m_Worlds.resize(m_Models.size());
-	auto init_world = [&](std::vector<XMMATRIX>& world, int size)
-	{
-		for (int i = -size; i <= size; i++)
-			for (int j = -size; j <= size; j++)
+		auto meshData = Geometry::CreateModel(path);
+		// 合并导出工具产生的重合顶点，颜色是按位置随机生成的，不参与比较
+		MeshWelder::WeldOptions weldOptions;
+		weldOptions.colorTolerance = MeshWelder::IgnoreAttribute;
+		MeshWelder::WeldReport weldReport = MeshWelder::Weld(meshData, weldOptions);
+		// 重排三角形与顶点顺序，减少每帧大量实例绘制时的顶点着色器调用与过度绘制
+		MeshOptimizer::OptimizeReport report = MeshOptimizer::Optimize(meshData, true);
+#if defined(DEBUG) || defined(_DEBUG)
+		char reportStr[256];
+		sprintf_s(reportStr, "%s: weld removed %zu of %zu vertices, %zu degenerate triangles\n", path.c_str(),
+			weldReport.vertexCountBefore - weldReport.vertexCountAfter, weldReport.vertexCountBefore,
+			weldReport.triangleCountBefore - weldReport.triangleCountAfter);
+		OutputDebugStringA(reportStr);
+		sprintf_s(reportStr, "%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, Overdraw %.3f -> %.3f\n", path.c_str(),
+			report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr,
+			report.overdrawBefore.overdraw, report.overdrawAfter.overdraw);
+		OutputDebugStringA(reportStr);
+#else
+		UNREFERENCED_PARAMETER(weldReport);
+		UNREFERENCED_PARAMETER(report);
+#endif
+		// 生成共享顶点的LOD链，绘制时按屏幕空间误差选择
+		auto lodChain = MeshSimplifier::BuildLodChain(meshData, { 0.5f, 0.25f, 0.125f });
+#if defined(DEBUG) || defined(_DEBUG)
+		for (size_t level = 0; level < lodChain.levels.size(); ++level)
+		{
+			sprintf_s(reportStr, "%s: LOD%zu %u triangles, error %.4f\n", path.c_str(), level,
+				lodChain.levels[level].indexCount / 3, lodChain.levels[level].error);
+			OutputDebugStringA(reportStr);
+		}
+#endif
+		// 每一级划分为簇，绘制时逐实例剔除不可见的簇；簇不跨越子网格，绘制范围在材质切换处可以直接拆分
+		std::vector<std::vector<MeshletBuilder::Meshlet>> meshlets;
+		for (const MeshSimplifier::LodLevel& level : lodChain.levels)
+		{
+			meshlets.emplace_back();
+			if (level.submeshes.empty())
 			{
-				auto mScaleMatrix = XMMatrixScaling(.5, .5, .5);
-				auto mRotationMatrix = XMMatrixRotationY(0.0f);
-				auto mTranslationXYMatrix = XMMatrixTranslation(i * 2.0f, 0.0f, j * 2.0f);
-				auto W = mScaleMatrix * mRotationMatrix * mTranslationXYMatrix;
-				world.push_back(W);
+				meshlets.back() = MeshletBuilder::BuildMeshlets(lodChain.meshData.vertexVec, lodChain.meshData.indexVec,
+					level.indexStart, level.indexCount);
+				continue;
 			}
+			for (const Geometry::Submesh& submesh : level.submeshes)
+			{
+				auto submeshMeshlets = MeshletBuilder::BuildMeshlets(lodChain.meshData.vertexVec, lodChain.meshData.indexVec,
+					submesh.indexStart, submesh.indexCount);
+				meshlets.back().insert(meshlets.back().end(), submeshMeshlets.begin(), submeshMeshlets.end());
+			}
+		}
+		// 顶点压缩为16字节的量化格式后上传，位置由解码矩阵在绘制时还原
+		VertexCompression::PositionBounds bounds;
+		auto packedData = VertexCompression::CompressMesh<VertexPosNormalColorPacked>(lodChain.meshData, &bounds);
+		auto mesh = MeshResource::Create(device, packedData);
+		XMStoreFloat4x4(&mesh->positionDecode, bounds.GetDecodeMatrix());
+		mesh->lodLevels = lodChain.levels;
+		mesh->meshlets = std::move(meshlets);
+		return mesh;
 	};
-	init_world(m_Worlds[0], size);
-	init_world(m_Worlds[1], size * 6);
+	// 模型先以空网格占位，世界矩阵、材质等可以照常更新
+	m_Models.resize(model_paths.size());
+	for (size_t i = 0; i < model_paths.size(); ++i)
+	{
+		auto mesh = std::make_shared<MeshHandle>();
+		std::string path = model_paths[i];
+		m_pAssetLoader->Load([mesh, device, path, load_model]()
+		{
+			*mesh = MeshRegistry::Get().Acquire<VertexPosNormalColorPacked>(device, path,
+				[&load_model, &path]() { return load_model(path); });
+		}, [this, mesh, i]() { m_Models[i].SetMesh(std::move(*mesh)); });
+	}
+
+	// 初始化模型的世界矩阵，数组只分配一次，之后每帧由动画原地更新
+	m_ForestAnimation.Init(size, sceneSeed, ForestRotationStream);
+	m_Worlds.resize(m_Models.size());
+	m_Worlds[0].Resize(m_ForestAnimation.GetParentCount());
+	m_Worlds[1].Resize(m_ForestAnimation.GetChildCount());
+	m_ForestAnimation.Update(angle, m_Worlds[0], m_Worlds[1]);
+	m_WorldInverses.resize(m_Worlds.size());
+	for (size_t i = 0; i < m_Worlds.size(); ++i)
+		m_Worlds[i].ComputeInverses(m_WorldInverses[i]);
 
 	// 初始化模型材质
 	m_Materials.resize(m_Models.size());
-	auto init_mat = [&](std::vector<Material>& mats, int size)
+	auto init_mat = [&](std::vector<Material>& mats, int size, RandomStream stream)
 	{
-		for (int i = 0; i < (2 * size + 1) * (2 * size + 1); i++)
+		// 每个实例的4个随机数批量生成，依次用于灰度与三种光照分量的w
+		std::vector<XMFLOAT4> randoms((2 * size + 1) * (2 * size + 1));
+		CounterRng::GenerateUniform4(sceneSeed, stream, 0, randoms.size(), randoms.data());
+		mats.resize(randoms.size());
+		for (size_t i = 0; i < randoms.size(); i++)
 		{
-			Material material;
-			std::random_device rd;
-			std::mt19937 gen(rd());
-			std::uniform_real_distribution<float> dis(0.0f, 1.0f);
-			auto factor = dis(gen);
-			auto color = XMFLOAT3(factor, factor, factor);
-
-			material.ambient = XMFLOAT4(color.x, color.y, color.z, dis(gen));
-			material.diffuse = XMFLOAT4(color.x * 0.8, color.y * 0.8, color.z * 0.8, dis(gen));
-			material.specular = XMFLOAT4(color.x * 0.1, color.y * 0.1, color.z * 0.1, dis(gen));
-
-			mats.push_back(material);
+			const XMFLOAT4& r = randoms[i];
+			auto color = XMFLOAT3(r.x, r.x, r.x);
+
+			Material& material = mats[i];
+			material.ambient = XMFLOAT4(color.x, color.y, color.z, r.y);
+			material.diffuse = XMFLOAT4(color.x * 0.8, color.y * 0.8, color.z * 0.8, r.z);
+			material.specular = XMFLOAT4(color.x * 0.1, color.y * 0.1, color.z * 0.1, r.w);
 		}
 	};
-	init_mat(m_Materials[0], size);
-	init_mat(m_Materials[1], size * 6);
+	init_mat(m_Materials[0], size, ParentMaterialStream);
+	init_mat(m_Materials[1], size * 6, ChildMaterialStream);
 
 	// 初始化模型颜色
 	m_Colors.resize(m_Models.size());
-	auto init_color = [&](std::vector<XMFLOAT4>& colors, int size)
+	auto init_color = [&](std::vector<XMFLOAT4>& colors, int size, RandomStream stream)
 		{
-			for (int i = 0; i < (2 * size + 1) * (2 * size + 1); i++)
-			{
-				std::random_device rd;
-				std::mt19937 gen(rd());
-				std::uniform_real_distribution<float> dis(0.0f, 1.0f);
-
-				colors.push_back(XMFLOAT4(dis(gen), dis(gen), dis(gen), 1.0f));
-			}
+			colors.resize((2 * size + 1) * (2 * size + 1));
+			CounterRng::GenerateUniform4(sceneSeed, stream, 0, colors.size(), colors.data());
+			for (XMFLOAT4& color : colors)
+				color.w = 1.0f;
 		};
-	init_color(m_Colors[0], size);
-	init_color(m_Colors[1], size * 6);
+	init_color(m_Colors[0], size, ParentColorStream);
+	init_color(m_Colors[1], size * 6, ChildColorStream);
 
 	// ******************
 	// 初始化光栅化器状态
@@ -557,9 +703,7 @@ bool GameApp::InitResource()
 	// 给渲染管线各个阶段绑定好所需资源
 	// 设置图元类型，设定输入布局
 	m_pd3dImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	m_pd3dImmediateContext->IASetInputLayout(m_pVertexLayoutPosNormalColor.Get());
-	// 默认绑定3D着色器
-	m_pd3dImmediateContext->VSSetShader(m_pVertexShader3D.Get(), nullptr, 0);
+	// 着色器与输入布局在绘制各阶段时绑定
 	// 预先绑定各自所需的缓冲区，其中每帧更新的缓冲区需要绑定到两个缓冲区上
 	m_pd3dImmediateContext->VSSetConstantBuffers(0, 1, m_pConstantBuffers[0].GetAddressOf());
 	m_pd3dImmediateContext->VSSetConstantBuffers(1, 1, m_pConstantBuffers[1].GetAddressOf());
@@ -567,80 +711,70 @@ bool GameApp::InitResource()
 	m_pd3dImmediateContext->VSSetConstantBuffers(3, 1, m_pConstantBuffers[3].GetAddressOf());
 
 
-	m_pd3dImmediateContext->GSSetShader(m_pGeometryShader3D.Get(), nullptr, 0);
 	m_pd3dImmediateContext->GSSetConstantBuffers(1, 1, m_pConstantBuffers[1].GetAddressOf());
 	m_pd3dImmediateContext->GSSetConstantBuffers(2, 1, m_pConstantBuffers[2].GetAddressOf());
 
 	m_pd3dImmediateContext->PSSetConstantBuffers(0, 1, m_pConstantBuffers[0].GetAddressOf());
 	m_pd3dImmediateContext->PSSetConstantBuffers(1, 1, m_pConstantBuffers[1].GetAddressOf());
 	m_pd3dImmediateContext->PSSetConstantBuffers(3, 1, m_pConstantBuffers[3].GetAddressOf());
-	m_pd3dImmediateContext->PSSetShader(m_pPixelShader3D.Get(), nullptr, 0);
-	
 	m_pd3dImmediateContext->PSSetSamplers(0, 1, m_pSamplerState.GetAddressOf());
 
 	// ******************
 	// 设置调试对象名
 	//
-	D3D11SetDebugObjectName(m_pVertexLayoutPosNormalColor.Get(), "VertexPosNormalColorLayout");
-	D3D11SetDebugObjectName(m_pVertexLayoutPosNormalTex.Get(), "VertexPosNormalTexLayout");
 	D3D11SetDebugObjectName(m_pConstantBuffers[0].Get(), "CBDrawing");
 	D3D11SetDebugObjectName(m_pConstantBuffers[1].Get(), "CBFrame");
 	D3D11SetDebugObjectName(m_pConstantBuffers[2].Get(), "CBOnResize");
 	D3D11SetDebugObjectName(m_pConstantBuffers[3].Get(), "CBRarely");
-	D3D11SetDebugObjectName(m_pVertexShader3D.Get(), "Basic_VS_3D");
-	D3D11SetDebugObjectName(m_pPixelShader3D.Get(), "Basic_PS_3D");
 	D3D11SetDebugObjectName(m_pSamplerState.Get(), "SSLinearWrap");
 
 	return true;
 }
 
 GameApp::GameObject::GameObject()
-	: m_IndexCount(), m_VertexStride(), m_Material(), m_TexOffset(0.0f, 0.0f), m_TexScale(1.0f, 1.0f)
+	: m_Material(), m_LodLevel(), m_TexOffset(0.0f, 0.0f), m_TexScale(1.0f, 1.0f)
 {
-	XMStoreFloat4x4(&m_WorldMatrix, XMMatrixIdentity());
+	XMStoreFloat3x4(&m_WorldMatrix, XMMatrixIdentity());
+	XMStoreFloat3x4(&m_WorldInverse, XMMatrixIdentity());
 }
 
 DirectX::XMFLOAT3 GameApp::GameObject::GetPosition() const
 {
-	return XMFLOAT3(m_WorldMatrix(3, 0), m_WorldMatrix(3, 1), m_WorldMatrix(3, 2));
+	return XMFLOAT3(m_WorldMatrix.m[0][3], m_WorldMatrix.m[1][3], m_WorldMatrix.m[2][3]);
 }
 
 template<class VertexType, class IndexType>
 void GameApp::GameObject::SetBuffer(ID3D11Device * device, const Geometry::MeshData<VertexType, IndexType>& meshData)
 {
-	// 释放旧资源
-	m_pVertexBuffer.Reset();
-	m_pIndexBuffer.Reset();
-
-	// 设置顶点缓冲区描述
-	m_VertexStride = sizeof(VertexType);
-	D3D11_BUFFER_DESC vbd;
-	ZeroMemory(&vbd, sizeof(vbd));
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = (UINT)meshData.vertexVec.size() * m_VertexStride;
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbd.CPUAccessFlags = 0;
-	// 新建顶点缓冲区
-	D3D11_SUBRESOURCE_DATA InitData;
-	ZeroMemory(&InitData, sizeof(InitData));
-	InitData.pSysMem = meshData.vertexVec.data();
-	HR(device->CreateBuffer(&vbd, &InitData, m_pVertexBuffer.GetAddressOf()));
-
-
-	// 设置索引缓冲区描述
-	m_IndexCount = (UINT)meshData.indexVec.size();
-	D3D11_BUFFER_DESC ibd;
-	ZeroMemory(&ibd, sizeof(ibd));
-	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = m_IndexCount * sizeof(IndexType);
-	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibd.CPUAccessFlags = 0;
-	// 新建索引缓冲区
-	InitData.pSysMem = meshData.indexVec.data();
-	HR(device->CreateBuffer(&ibd, &InitData, m_pIndexBuffer.GetAddressOf()));
+	SetMesh(MeshResource::Create(device, meshData));
+}
 
+template<class IndexType>
+void GameApp::GameObject::SetBuffer(ID3D11Device * device, const Geometry::MeshDataSoA<IndexType>& meshData)
+{
+	SetMesh(MeshResource::Create(device, meshData));
+}
 
+void GameApp::GameObject::SetMesh(MeshHandle mesh)
+{
+	m_pMesh = std::move(mesh);
+	m_LodLevel = 0;
+	m_DrawRanges.clear();
+	if (m_pMesh)
+	{
+		m_DrawRanges.assign(1, { 0, m_pMesh->indexCount });
+		SelectLod(0.0f);
+	}
+}
+
+const MeshHandle& GameApp::GameObject::GetMesh() const
+{
+	return m_pMesh;
+}
 
+ID3D11ShaderResourceView* GameApp::GameObject::GetTexture() const
+{
+	return m_pTexture.Get();
 }
 
 void GameApp::GameObject::SetTexture(ID3D11ShaderResourceView * texture)
@@ -655,7 +789,7 @@ void GameApp::GameObject::SetMaterial(const Material& material)
 
 void GameApp::GameObject::SetWorldMatrix(const XMFLOAT4X4 & world)
 {
-	m_WorldMatrix = world;
+	SetWorldMatrix(XMLoadFloat4x4(&world));
 }
 
 void GameApp::GameObject::SetColor(const XMFLOAT4& color)
@@ -665,7 +799,14 @@ void GameApp::GameObject::SetColor(const XMFLOAT4& color)
 
 void XM_CALLCONV GameApp::GameObject::SetWorldMatrix(XMMATRIX world)
 {
-	XMStoreFloat4x4(&m_WorldMatrix, world);
+	XMStoreFloat3x4(&m_WorldMatrix, world);
+	XMStoreFloat3x4(&m_WorldInverse, XMMatrixInverse(nullptr, world));
+}
+
+void XM_CALLCONV GameApp::GameObject::SetWorldMatrix(FXMMATRIX world, CXMMATRIX worldInverse)
+{
+	XMStoreFloat3x4(&m_WorldMatrix, world);
+	XMStoreFloat3x4(&m_WorldInverse, worldInverse);
 }
 
 void GameApp::GameObject::SetTexOffset(const XMFLOAT2& offset)
@@ -673,13 +814,37 @@ void GameApp::GameObject::SetTexOffset(const XMFLOAT2& offset)
 	m_TexOffset = offset;
 }
 
+void GameApp::GameObject::SelectLod(float pixelsPerUnit, float maxPixelError)
+{
+	if (!m_pMesh || m_pMesh->lodLevels.empty())
+		return;
+	const std::vector<MeshSimplifier::LodLevel>& lodLevels = m_pMesh->lodLevels;
+	m_LodLevel = MeshSimplifier::SelectLodLevel(lodLevels, pixelsPerUnit, maxPixelError);
+	m_DrawRanges.assign(1, { lodLevels[m_LodLevel].indexStart, lodLevels[m_LodLevel].indexCount });
+}
+
+void GameApp::GameObject::CullMeshlets(const XMMATRIX* transforms, size_t transformCount,
+	const XMMATRIX& viewProj, const XMFLOAT3& eyePos)
+{
+	if (!m_pMesh || m_LodLevel >= m_pMesh->meshlets.size())
+		return;
+	MeshletBuilder::CullMeshlets(m_pMesh->meshlets[m_LodLevel], transforms, transformCount, viewProj, eyePos, m_DrawRanges);
+}
+
 void GameApp::GameObject::Draw(ID3D11DeviceContext * deviceContext)
 {
+	// 所有簇都被剔除时不需要绘制
+	if (!m_pMesh || m_DrawRanges.empty())
+		return;
+
 	// 设置顶点/索引缓冲区
-	UINT strides = m_VertexStride;
-	UINT offsets = 0;
-	deviceContext->IASetVertexBuffers(0, 1, m_pVertexBuffer.GetAddressOf(), &strides, &offsets);
-	deviceContext->IASetIndexBuffer(m_pIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+	const MeshResource& mesh = *m_pMesh;
+	UINT offsets[VertexStreamCount] = {};
+	ID3D11Buffer* pVertexBuffers[VertexStreamCount];
+	for (UINT i = 0; i < mesh.vertexBufferCount; ++i)
+		pVertexBuffers[i] = mesh.vertexBuffers[i].Get();
+	deviceContext->IASetVertexBuffers(0, mesh.vertexBufferCount, pVertexBuffers, mesh.vertexStrides, offsets);
+	deviceContext->IASetIndexBuffer(mesh.indexBuffer.Get(), mesh.indexFormat, 0);
 
 	// 获取之前已经绑定到渲染管线上的常量缓冲区并进行修改
 	ComPtr<ID3D11Buffer> cBuffer = nullptr;
@@ -687,34 +852,70 @@ void GameApp::GameObject::Draw(ID3D11DeviceContext * deviceContext)
 	CBChangesEveryDrawing cbDrawing;
 
 	// 内部进行转置，这样外部就不需要提前转置了
-	XMMATRIX W = XMLoadFloat4x4(&m_WorldMatrix);
-	cbDrawing.world = XMMatrixTranspose(W);
-	cbDrawing.worldInvTranspose = XMMatrixInverse(nullptr, W);	// 两次转置抵消
+	// 量化位置先经解码矩阵还原到模型空间，法线不受位置量化影响，仍使用世界矩阵的逆转置
+	XMMATRIX W = XMLoadFloat3x4(&m_WorldMatrix);
+	cbDrawing.world = XMMatrixTranspose(XMLoadFloat4x4(&mesh.positionDecode) * W);
+	cbDrawing.worldInvTranspose = XMLoadFloat3x4(&m_WorldInverse);	// 两次转置抵消
 	cbDrawing.material = m_Material;
 	cbDrawing.color = m_Color;
 	cbDrawing.texOffset = m_TexOffset;
 	cbDrawing.texScale = m_TexScale;
 
 	// 更新常量缓冲区
-	D3D11_MAPPED_SUBRESOURCE mappedData;
-	HR(deviceContext->Map(cBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
-	memcpy_s(mappedData.pData, sizeof(CBChangesEveryDrawing), &cbDrawing, sizeof(CBChangesEveryDrawing));
-	deviceContext->Unmap(cBuffer.Get(), 0);
+	auto updateConstantBuffer = [&]()
+	{
+		D3D11_MAPPED_SUBRESOURCE mappedData;
+		HR(deviceContext->Map(cBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+		memcpy_s(mappedData.pData, sizeof(CBChangesEveryDrawing), &cbDrawing, sizeof(CBChangesEveryDrawing));
+		deviceContext->Unmap(cBuffer.Get(), 0);
+	};
 
 	// 设置纹理
 	deviceContext->PSSetShaderResources(0, 1, m_pTexture.GetAddressOf());
-	// 可以开始绘制
-	deviceContext->DrawIndexed(m_IndexCount, 0, 0);
+
+	// 没有子网格时整个网格使用物体的材质
+	const std::vector<Geometry::Submesh>& submeshes = mesh.lodLevels.empty() ? mesh.submeshes : mesh.lodLevels[m_LodLevel].submeshes;
+	if (submeshes.empty())
+	{
+		updateConstantBuffer();
+		// 可以开始绘制
+		for (const MeshletBuilder::DrawRange& range : m_DrawRanges)
+			deviceContext->DrawIndexed(range.indexCount, range.indexStart, 0);
+		return;
+	}
+
+	// 子网格与待绘制范围都按索引升序排列，依次取交集；材质与上一次上传的相同时不再更新常量缓冲区
+	bool uploaded = false;
+	size_t r = 0;
+	for (const Geometry::Submesh& submesh : submeshes)
+	{
+		UINT submeshEnd = submesh.indexStart + submesh.indexCount;
+		while (r < m_DrawRanges.size() && m_DrawRanges[r].indexStart + m_DrawRanges[r].indexCount <= submesh.indexStart)
+			++r;
+		if (r == m_DrawRanges.size())
+			break;
+		if (m_DrawRanges[r].indexStart >= submeshEnd)
+			continue;
+
+		const Material& material = submesh.hasMaterial ? submesh.material : m_Material;
+		if (!uploaded || memcmp(&cbDrawing.material, &material, sizeof(Material)) != 0)
+		{
+			cbDrawing.material = material;
+			updateConstantBuffer();
+			uploaded = true;
+		}
+		for (size_t i = r; i < m_DrawRanges.size() && m_DrawRanges[i].indexStart < submeshEnd; ++i)
+		{
+			UINT start = (std::max)(m_DrawRanges[i].indexStart, submesh.indexStart);
+			UINT end = (std::min)(m_DrawRanges[i].indexStart + m_DrawRanges[i].indexCount, submeshEnd);
+			deviceContext->DrawIndexed(end - start, start, 0);
+		}
+	}
 }
 
 void GameApp::GameObject::SetDebugObjectName(const std::string& name)
 {
-#if (defined(DEBUG) || defined(_DEBUG)) && (GRAPHICS_DEBUGGER_OBJECT_NAME)
-	std::string vbName = name + ".VertexBuffer";
-	std::string ibName = name + ".IndexBuffer";
-	m_pVertexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(vbName.length()), vbName.c_str());
-	m_pIndexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(ibName.length()), ibName.c_str());
-#else
-	UNREFERENCED_PARAMETER(name);
-#endif
+	// 共享的网格以最后一次设置的名字为准
+	if (m_pMesh)
+		m_pMesh->SetDebugObjectName(name);
 }
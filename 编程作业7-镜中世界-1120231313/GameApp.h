@@ -2,10 +2,19 @@
 #define GAMEAPP_H
 
 #include "d3dApp.h"
+#include "AssetLoader.h"
+#include "ForestAnimation.h"
+#include "InstanceTransforms.h"
 #include "Geometry.h"
+#include "MeshOptimizer.h"
+#include "MeshWelder.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MeshRegistry.h"
+#include "VertexCompression.h"
 #include "LightHelper.h"
 #include "Camera.h"
-#include <random>
+#include "CounterRng.h"
 
 #include "RenderStates.h"
 #include "DDSTextureLoader.h"	
@@ -58,35 +67,52 @@ public:
 
 		// 获取位置
 		DirectX::XMFLOAT3 GetPosition() const;
-		// 设置缓冲区
+		// 设置缓冲区，创建只属于该物体的网格
 		template<class VertexType, class IndexType>
 		void SetBuffer(ID3D11Device * device, const Geometry::MeshData<VertexType, IndexType>& meshData);
-		// 设置材质
+		// 为每个非空的分量创建单独的顶点缓冲区，需配合VertexTraits的streamInputLayout使用
+		// 输入布局只含部分分量时(如只含位置的深度/模板绘制)，其余分量不会被读取
+		template<class IndexType>
+		void SetBuffer(ID3D11Device * device, const Geometry::MeshDataSoA<IndexType>& meshData);
+		// 设置共享的网格，LOD级别重置为最精细一级
+		void SetMesh(MeshHandle mesh);
+		// 获取网格
+		const MeshHandle& GetMesh() const;
+		// 设置材质，网格的子网格在材质库中找到了材质时改用子网格自身的材质
 		void SetMaterial(const Material& material);
 		// 设置颜色
 		void SetColor(const DirectX::XMFLOAT4& color);
 		// 设置纹理
 		void SetTexture(ID3D11ShaderResourceView * texture);
-		// 设置矩阵
+		// 获取纹理
+		ID3D11ShaderResourceView* GetTexture() const;
+		// 设置矩阵，法线变换所需的逆矩阵在设置时计算一次
 		void SetWorldMatrix(const DirectX::XMFLOAT4X4& world);
 		void XM_CALLCONV SetWorldMatrix(DirectX::XMMATRIX world);
+		// 设置矩阵及其已经算好的逆矩阵(只使用左上3x3部分)
+		void XM_CALLCONV SetWorldMatrix(DirectX::FXMMATRIX world, DirectX::CXMMATRIX worldInverse);
 		// 设置纹理坐标偏移
 		void SetTexOffset(const DirectX::XMFLOAT2& offset);
-		// 绘制
+		// 按物体单位长度投影到屏幕上的像素数，选择屏幕空间误差不超过maxPixelError的最粗糙一级
+		void SelectLod(float pixelsPerUnit, float maxPixelError = 1.0f);
+		// 剔除当前LOD级别中不可见的簇，transforms为本次绘制产生的各副本的完整世界变换
+		void CullMeshlets(const DirectX::XMMATRIX* transforms, size_t transformCount,
+			const DirectX::XMMATRIX& viewProj, const DirectX::XMFLOAT3& eyePos);
+		// 绘制，缓冲区只绑定一次，有子网格时按子网格切换材质，每个子网格绘制其与待绘制范围的交集
 		void Draw(ID3D11DeviceContext * deviceContext);
 
 		// 设置调试对象名
 		// 若缓冲区被重新设置，调试对象名也需要被重新设置
 		void SetDebugObjectName(const std::string& name);
 	private:
-		DirectX::XMFLOAT4X4 m_WorldMatrix;				    // 世界矩阵
+		DirectX::XMFLOAT3X4 m_WorldMatrix;				    // 世界矩阵(仿射，按XMFLOAT3X4转置存放)
+		DirectX::XMFLOAT3X4 m_WorldInverse;					// 世界矩阵的逆，左上3x3部分用于变换法线
 		Material m_Material;								// 物体材质
 		DirectX::XMFLOAT4 m_Color;							// 颜色
 		ComPtr<ID3D11ShaderResourceView> m_pTexture;		// 纹理
-		ComPtr<ID3D11Buffer> m_pVertexBuffer;				// 顶点缓冲区
-		ComPtr<ID3D11Buffer> m_pIndexBuffer;				// 索引缓冲区
-		UINT m_VertexStride;								// 顶点字节大小
-		UINT m_IndexCount;								    // 索引数目	
+		MeshHandle m_pMesh;									// 网格，可能与其它物体共享
+		size_t m_LodLevel;									// 当前的LOD级别
+		std::vector<MeshletBuilder::DrawRange> m_DrawRanges;	// 待绘制的索引范围
 		DirectX::XMFLOAT2 m_TexOffset;						// 纹理坐标偏移
 		DirectX::XMFLOAT2 m_TexScale;						// 纹理坐标缩放
 	};
@@ -104,7 +130,9 @@ public:
 	void DrawScene();
 
 private:
+	// 提交着色器的加载任务
 	bool InitEffect();
+	// 创建常量缓冲区与渲染状态，并提交纹理与模型的加载任务
 	bool InitResource();
 
 private:
@@ -112,12 +140,28 @@ private:
 	static constexpr int size = 12;
 	// 定义了游戏至此的角度
 	float angle = 0;
-	ComPtr<ID3D11InputLayout> m_pVertexLayoutPosNormalColor;	// 无材质顶点输入布局
-	ComPtr<ID3D11InputLayout> m_pVertexLayoutPosNormalTex;		// 有材质顶点输入布局
+	// 场景的随机种子，相同种子总生成相同的场景
+	static constexpr uint32_t sceneSeed = 1120231313;
+	// 场景中各用途的随机数流，同一种子下各流互不相关
+	enum RandomStream : uint32_t
+	{
+		ForestRotationStream,		// 子字符的初始旋转
+		ParentMaterialStream,		// 母字符的材质
+		ChildMaterialStream,		// 子字符的材质
+		ParentColorStream,			// 母字符的颜色
+		ChildColorStream,			// 子字符的颜色
+		DirLightStream,				// 新增方向光的方向
+		PointLightStream			// 点光源的随机游走
+	};
+	ComPtr<ID3D11InputLayout> m_pVertexLayoutPosNormalColorPacked;	// 模型的压缩顶点输入布局
+	ComPtr<ID3D11InputLayout> m_pVertexLayoutPosNormalTex;		// 有材质顶点输入布局(分流存放)
+	ComPtr<ID3D11InputLayout> m_pVertexLayoutPos;				// 只读取位置分量的输入布局(分流存放)
 	ComPtr<ID3D11Buffer> m_pConstantBuffers[4];				    // 常量缓冲区
 
 	std::vector<GameObject> m_Models;							// 所有模型
-	std::vector<std::vector<DirectX::XMMATRIX>> m_Worlds;		// 所有模型的世界矩阵
+	ForestAnimation m_ForestAnimation;							// 字符森林的动画
+	std::vector<InstanceTransforms> m_Worlds;					// 所有模型各实例的世界矩阵
+	std::vector<InstanceTransforms> m_WorldInverses;			// 所有模型各实例世界矩阵线性部分的逆，每帧批量计算一次
 	std::vector<std::vector<Material>> m_Materials;				// 所有模型的材质
 	std::vector<std::vector<DirectX::XMFLOAT4>> m_Colors;		// 所有模型的颜色
 	GameObject m_Plane;											// 平面
@@ -127,6 +171,7 @@ private:
 
 	ComPtr<ID3D11VertexShader> m_pVertexShader3D;				// 用于3D的顶点着色器
 	ComPtr<ID3D11VertexShader> m_pPlaneVS3D;					// 用于平面的顶点着色器
+	ComPtr<ID3D11VertexShader> m_pDepthVS;						// 只输出位置的顶点着色器，用于模板标记
 	ComPtr<ID3D11PixelShader> m_pPixelShader3D;				    // 用于3D的像素着色器
 	ComPtr<ID3D11PixelShader> m_pPlanePS3D;						// 用于平面的像素着色器
 	ComPtr<ID3D11GeometryShader> m_pGeometryShader3D;			// 用于3D的几何着色器
@@ -141,6 +186,13 @@ private:
 	CameraMode m_CameraMode;									// 摄像机模式
 
 	DirectX::XMFLOAT3 m_PointLightDirection[10];				// 点光源运动方向
+	uint32_t m_PointLightStep = 0;								// 点光源已随机游走的步数
+
+	// 各渲染阶段的着色器与输入布局由加载线程创建，完成回调执行前主线程不会访问
+	bool m_DepthShadersReady;									// 模板标记阶段的着色器已就绪
+	bool m_ModelShadersReady;									// 模型的着色器已就绪
+	bool m_PlaneShadersReady;									// 平面与镜子的着色器已就绪
+	std::unique_ptr<AssetLoader> m_pAssetLoader;				// 后台资源加载
 };
 
 
@@ -11,19 +11,40 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <thread>
+#include <filesystem>
 #include "Vertex.h"
 #include <wrl/client.h>
 #include "d3dUtil.h"
+#include "LightHelper.h"
+#include "ObjReader.h"
+#include "MeshCache.h"
+#include "MeshNormals.h"
+#include "ThreadPool.h"
+#include "CounterRng.h"
 
 namespace Geometry
 {
+	// 子网格，与网格的其余部分共享顶点与索引数组，以一段连续的索引使用同一个材质绘制
+	struct Submesh
+	{
+		std::string materialName;	// 材质名
+		Material material;			// 材质库中的材质参数
+		bool hasMaterial;			// 材质库中是否找到了该材质，找不到时绘制使用物体自身的材质
+		UINT indexStart;			// 在索引数组中的起始位置
+		UINT indexCount;			// 索引数目
+	};
+
 	// 网格数据
 	template<class VertexType = VertexPosNormalTex, class IndexType = WORD>
 	struct MeshData
 	{
 		std::vector<VertexType> vertexVec;	// 顶点数组
 		std::vector<IndexType> indexVec;	// 索引数组
+		std::vector<Submesh> submeshes;		// 按材质划分的子网格，按索引顺序排列；为空时整个网格只有一个材质
 
 		MeshData()
 		{
@@ -33,6 +54,59 @@ namespace Geometry
 		}
 	};
 
+	// 按分量分流存放的网格数据，各分量分别连续存放，便于逐分量做SIMD处理，
+	// 也可以为每个分量创建单独的顶点缓冲区(输入槽与VertexSemantic的序号一致)
+	// 不含某一分量时对应数组为空，否则长度与positions相同
+	template<class IndexType = WORD>
+	struct MeshDataSoA
+	{
+		std::vector<DirectX::XMFLOAT3> positions;	// 位置
+		std::vector<DirectX::XMFLOAT3> normals;		// 法线
+		std::vector<DirectX::XMFLOAT4> tangents;	// 切线
+		std::vector<DirectX::XMFLOAT4> colors;		// 颜色
+		std::vector<DirectX::XMFLOAT2> texCoords;	// 纹理坐标
+		std::vector<IndexType> indexVec;			// 索引数组
+		std::vector<Submesh> submeshes;				// 按材质划分的子网格，为空时整个网格只有一个材质
+
+		MeshDataSoA()
+		{
+			static_assert(sizeof(IndexType) == 2 || sizeof(IndexType) == 4, "The size of IndexType must be 2 bytes or 4 bytes!");
+			static_assert(std::is_unsigned<IndexType>::value, "IndexType must be unsigned integer!");
+		}
+
+		size_t VertexCount() const { return positions.size(); }
+	};
+
+	// 将交错存放的顶点拆分为各分量的数组，只生成顶点类型中含有的分量，按位复制
+	template<class VertexType, class IndexType>
+	MeshDataSoA<IndexType> ToSoA(const MeshData<VertexType, IndexType>& meshData);
+	// 将各分量的数组合并为交错存放的顶点，顶点类型需要的分量缺失时抛出std::runtime_error
+	template<class VertexType, class IndexType>
+	MeshData<VertexType, IndexType> ToAoS(const MeshDataSoA<IndexType>& meshData);
+
+	// 从OBJ文件读取模型，parallel为true时按行分块多线程解析，结果与单线程一致
+	// useCache为true时优先读取同目录下的.meshbin缓存(每种顶点格式一个)，缓存缺失或过期则解析后重新写入
+	// 面的每个"v/vt/vn"组合生成一个唯一顶点，多边形面按扇形三角化
+	// 索引统一以32位返回，SetBuffer会在顶点数目允许时改用16位索引上传
+	// 文件中没有vn时为含法线的顶点类型生成角度加权的平滑法线(折痕角见MeshNormals::DefaultCreaseAngle)，
+	// 顶点类型含切线时按MikkTSpace的方式生成切线
+	// 文件中有usemtl时三角形按材质首次出现的顺序分组(组内保持文件中的顺序)，每组成为一个子网格，
+	// 材质参数从mtllib引用的材质库读取，材质库或材质缺失时该子网格的hasMaterial为false
+	template<class VertexType = VertexPosNormalColor>
+	MeshData<VertexType, DWORD> CreateModel(const std::string& filePath, bool parallel = false, bool useCache = true);
+
+	// 以流式方式读取OBJ文件，文件按windowSize字节的窗口顺序读取，不会整体载入内存
+	// 三角形按出现顺序划分为若干子网格，每个子网格拥有独立的顶点与索引，
+	// 且顶点数不超过maxChunkVertices、三角形数不超过maxChunkTriangles，
+	// 逐个通过onChunk(const MeshData<VertexType, DWORD>&)交出，回调返回后子网格的内存即被复用
+	// v/vt/vn属性解析后写入系统临时目录中的临时文件并以内存映射读取，每个窗口结束后重新映射，
+	// 驻留内存的属性只有当前窗口中的面所引用的部分，内存占用与文件大小无关；
+	// 所有子网格的三角形依次拼接后与CreateModel的结果一致
+	// (不生成缺失的法线与切线，这两者需要整个网格的邻接信息；也不按材质分组，三角形保持文件中的顺序)
+	template<class VertexType = VertexPosNormalColor, class ChunkFunc>
+	void StreamModel(const std::string& filePath, const ChunkFunc& onChunk,
+		size_t windowSize = 4 << 20, size_t maxChunkVertices = 65536, size_t maxChunkTriangles = 131072);
+
 	// 创建一个平面
 	template<class VertexType = VertexPosNormalTex, class IndexType = WORD>
 	MeshData<VertexType, IndexType> CreatePlane(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT2& planeSize = { 10.0f, 10.0f },
@@ -41,6 +115,41 @@ namespace Geometry
 	MeshData<VertexType, IndexType> CreatePlane(float centerX = 0.0f, float centerY = 0.0f, float centerZ = 0.0f,
 		float width = 10.0f, float depth = 10.0f, float texU = 1.0f, float texV = 1.0f,
 		const DirectX::XMFLOAT4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	//
+	// 以下生成器在细分较多时按行划分，在线程池上并行生成顶点与索引，
+	// 每行写入的位置是固定的，结果与单线程生成(parallel为false)逐位相同
+	// 顶点数目超出索引类型的范围时抛出std::runtime_error
+	//
+
+	// 创建一个网格平面，位于XZ平面、中心在原点、法线朝+Y，slices为X、Z方向上的格子数
+	template<class VertexType = VertexPosNormalTex, class IndexType = DWORD>
+	MeshData<VertexType, IndexType> CreateGrid(const DirectX::XMFLOAT2& gridSize = { 10.0f, 10.0f },
+		const DirectX::XMUINT2& slices = { 10, 10 }, const DirectX::XMFLOAT2& maxTexCoord = { 1.0f, 1.0f },
+		const DirectX::XMFLOAT4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, bool parallel = true);
+
+	// 创建高度场，在网格平面的基础上以heightFunc(x, z)作为各顶点的高度
+	// heightFunc会在多个线程上并行调用，需要是线程安全的；法线与切线由相邻顶点的高度差分得到
+	template<class VertexType = VertexPosNormalTex, class IndexType = DWORD, class HeightFunc>
+	MeshData<VertexType, IndexType> CreateHeightfield(const DirectX::XMFLOAT2& terrainSize, const DirectX::XMUINT2& slices,
+		const DirectX::XMFLOAT2& maxTexCoord, const HeightFunc& heightFunc,
+		const DirectX::XMFLOAT4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, bool parallel = true);
+
+	// 创建立方体，中心在原点，每个面4个顶点
+	template<class VertexType = VertexPosNormalTex, class IndexType = WORD>
+	MeshData<VertexType, IndexType> CreateBox(float width = 2.0f, float height = 2.0f, float depth = 2.0f,
+		const DirectX::XMFLOAT4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	// 创建球体，中心在原点，levels为纬线方向的分段数，slices为经线方向的分段数
+	template<class VertexType = VertexPosNormalTex, class IndexType = WORD>
+	MeshData<VertexType, IndexType> CreateSphere(float radius = 1.0f, UINT levels = 20, UINT slices = 20,
+		const DirectX::XMFLOAT4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, bool parallel = true);
+
+	// 创建带上下底面的圆柱体，中心在原点、轴沿Y方向，slices为圆周的分段数，stacks为高度方向的分段数
+	template<class VertexType = VertexPosNormalTex, class IndexType = WORD>
+	MeshData<VertexType, IndexType> CreateCylinder(float radius = 1.0f, float height = 2.0f, UINT slices = 20, UINT stacks = 10,
+		float texU = 1.0f, float texV = 1.0f, const DirectX::XMFLOAT4& color = { 1.0f, 1.0f, 1.0f, 1.0f },
+		bool parallel = true);
 }
 
 namespace Geometry
@@ -60,27 +169,482 @@ namespace Geometry
 			DirectX::XMFLOAT2 tex;
 		};
 
-		// 根据目标顶点类型选择性将数据插入
+		// 语义在VertexData中对应的成员
+		template<VertexSemantic Semantic>
+		constexpr auto GetVertexDataMember()
+		{
+			static_assert(Semantic != VertexSemantic::Size, "VertexData has no SIZE element!");
+			if constexpr (Semantic == VertexSemantic::Position)
+				return &VertexData::pos;
+			else if constexpr (Semantic == VertexSemantic::Normal)
+				return &VertexData::normal;
+			else if constexpr (Semantic == VertexSemantic::Tangent)
+				return &VertexData::tangent;
+			else if constexpr (Semantic == VertexSemantic::Color)
+				return &VertexData::color;
+			else
+				return &VertexData::tex;
+		}
+
+		// 语义在MeshDataSoA中对应的分量数组
+		template<VertexSemantic Semantic, class MeshDataSoAType>
+		inline auto& GetStream(MeshDataSoAType& meshData)
+		{
+			static_assert(Semantic != VertexSemantic::Size, "MeshDataSoA has no SIZE stream!");
+			if constexpr (Semantic == VertexSemantic::Position)
+				return meshData.positions;
+			else if constexpr (Semantic == VertexSemantic::Normal)
+				return meshData.normals;
+			else if constexpr (Semantic == VertexSemantic::Tangent)
+				return meshData.tangents;
+			else if constexpr (Semantic == VertexSemantic::Color)
+				return meshData.colors;
+			else
+				return meshData.texCoords;
+		}
+
+		// 根据目标顶点类型选择性将数据插入，元素的偏移与大小均为编译期常量，可以在工作线程中调用
 		template<class VertexType>
 		inline void InsertVertexElement(VertexType& vertexDst, const VertexData& vertexSrc)
 		{
-			static std::string semanticName;
-			static const std::map<std::string, std::pair<size_t, size_t>> semanticSizeMap = {
-				{"POSITION", std::pair<size_t, size_t>(0, 12)},
-				{"NORMAL", std::pair<size_t, size_t>(12, 24)},
-				{"TANGENT", std::pair<size_t, size_t>(24, 40)},
-				{"COLOR", std::pair<size_t, size_t>(40, 56)},
-				{"TEXCOORD", std::pair<size_t, size_t>(56, 64)}
+			VertexTraits<VertexType>::ForEachElement([&](auto element) {
+				using Element = decltype(element);
+				constexpr auto member = GetVertexDataMember<Element::semantic>();
+				static_assert(sizeof(vertexSrc.*member) == Element::size, "Vertex element must be a 32-bit float vector!");
+				memcpy(reinterpret_cast<char*>(&vertexDst) + Element::offset, &(vertexSrc.*member), Element::size);
+			});
+		}
+
+		// OBJ文件中的原始数据
+		struct ObjData
+		{
+			std::vector<DirectX::XMFLOAT3> positions;		// v，已放大20倍
+			std::vector<DirectX::XMFLOAT2> texCoords;		// vt，v方向已翻转
+			std::vector<DirectX::XMFLOAT3> normals;			// vn
+			std::vector<ObjReader::FaceVertex> corners;		// 三角化后每个三角形的三个顶点，索引从0开始，缺省为-1
+		};
+
+		// 以"v/vt/vn"组合为键的哈希
+		struct FaceVertexHash
+		{
+			size_t operator()(const ObjReader::FaceVertex& vertex) const
+			{
+				uint64_t key = static_cast<uint32_t>(vertex.position) * 0x9E3779B97F4A7C15ull;
+				key ^= (static_cast<uint32_t>(vertex.texCoord) + (key << 6) + (key >> 2)) * 0xC2B2AE3D27D4EB4Full;
+				key ^= (static_cast<uint32_t>(vertex.normal) + (key << 6) + (key >> 2)) * 0x165667B19E3779F9ull;
+				return static_cast<size_t>(key ^ (key >> 32));
+			}
+		};
+
+		struct FaceVertexEqual
+		{
+			bool operator()(const ObjReader::FaceVertex& lhs, const ObjReader::FaceVertex& rhs) const
+			{
+				return lhs.position == rhs.position && lhs.texCoord == rhs.texCoord && lhs.normal == rhs.normal;
+			}
+		};
+
+		// 解析位置记录"v x y z"，坐标放大20倍
+		inline void ParseObjPosition(const char* content, const char* lineEnd, DirectX::XMFLOAT3& pos)
+		{
+			content = ObjReader::ParseFloat(content, lineEnd, pos.x);
+			content = ObjReader::ParseFloat(content, lineEnd, pos.y);
+			content = ObjReader::ParseFloat(content, lineEnd, pos.z);
+			pos.x *= 20; // 线性变换坐标
+			pos.y *= 20;
+			pos.z *= 20;
+		}
+
+		// 解析纹理坐标记录"vt u v"
+		inline void ParseObjTexCoord(const char* content, const char* lineEnd, DirectX::XMFLOAT2& tex)
+		{
+			content = ObjReader::ParseFloat(content, lineEnd, tex.x);
+			content = ObjReader::ParseFloat(content, lineEnd, tex.y);
+			tex.y = 1.0f - tex.y;	// OBJ的v轴向上，D3D纹理坐标的v轴向下
+		}
+
+		// 解析法线记录"vn x y z"
+		inline void ParseObjNormal(const char* content, const char* lineEnd, DirectX::XMFLOAT3& normal)
+		{
+			content = ObjReader::ParseFloat(content, lineEnd, normal.x);
+			content = ObjReader::ParseFloat(content, lineEnd, normal.y);
+			content = ObjReader::ParseFloat(content, lineEnd, normal.z);
+		}
+
+		// 解析面记录，以第一个顶点为扇心三角化，对每个三角形调用func(v0, v1, v2)
+		// counts为此前各类记录的数目，用于解析相对索引；totals为整个文件中的数目，用于检查引用后文的正数索引
+		// 顶点数不足3的面被忽略(与统计阶段一致)
+		template<class Func>
+		inline void ParseObjFace(const char* content, const char* lineEnd, const ObjReader::RecordCounts& counts,
+			const ObjReader::RecordCounts& totals, const Func& func)
+		{
+			ObjReader::FaceVertex first = {}, prev = {}, curr = {};
+			for (size_t i = 0; (content = ObjReader::SkipSpaces(content, lineEnd)) < lineEnd; ++i)
+			{
+				content = ObjReader::ParseFaceVertex(content, lineEnd, curr);
+				curr.position = ObjReader::ResolveIndex(curr.position, counts.positionCount, totals.positionCount);
+				curr.texCoord = ObjReader::ResolveIndex(curr.texCoord, counts.texCoordCount, totals.texCoordCount);
+				curr.normal = ObjReader::ResolveIndex(curr.normal, counts.normalCount, totals.normalCount);
+				if (i == 0)
+					first = curr;
+				else if (i >= 2)
+					func(first, prev, curr);
+				prev = curr;
+			}
+		}
+
+		// 解析[begin, end)内的OBJ记录，写入objData中已分配好的数组
+		// first为该范围之前各类记录的数目，用于分块解析时确定输出位置以及解析相对索引，
+		// objData中的数组按整个文件的记录数目分配，其大小用于检查正数索引
+		// pMaterials不为nullptr时记录mtllib与usemtl，每条usemtl记为一个从当前索引开始、数目为0的分组
+		inline void ParseObjRecords(const char* begin, const char* end, ObjData& objData,
+			const ObjReader::RecordCounts& first = {}, ObjReader::MaterialGroups* pMaterials = nullptr)
+		{
+			ObjReader::RecordCounts counts = first;
+			ObjReader::RecordCounts totals = {};
+			totals.positionCount = objData.positions.size();
+			totals.texCoordCount = objData.texCoords.size();
+			totals.normalCount = objData.normals.size();
+			size_t cIndex = 3 * first.triangleCount;
+			const char* content = nullptr;
+			for (const char* p = begin; p < end; )
+			{
+				const char* lineEnd = ObjReader::LineEnd(p, end);
+				switch (ObjReader::ReadRecordType(p, lineEnd, content))
+				{
+				case ObjReader::RecordType::Position:
+					ParseObjPosition(content, lineEnd, objData.positions[counts.positionCount++]);
+					break;
+				case ObjReader::RecordType::TexCoord:
+					ParseObjTexCoord(content, lineEnd, objData.texCoords[counts.texCoordCount++]);
+					break;
+				case ObjReader::RecordType::Normal:
+					ParseObjNormal(content, lineEnd, objData.normals[counts.normalCount++]);
+					break;
+				case ObjReader::RecordType::Face:
+					ParseObjFace(content, lineEnd, counts, totals, [&](const ObjReader::FaceVertex& v0,
+						const ObjReader::FaceVertex& v1, const ObjReader::FaceVertex& v2) {
+						objData.corners[cIndex++] = v0;
+						objData.corners[cIndex++] = v1;
+						objData.corners[cIndex++] = v2;
+					});
+					break;
+				case ObjReader::RecordType::UseMaterial:
+					if (pMaterials)
+						pMaterials->groups.push_back({ ObjReader::ReadName(content, lineEnd), static_cast<uint32_t>(cIndex), 0 });
+					break;
+				case ObjReader::RecordType::MaterialLibrary:
+					if (pMaterials)
+						pMaterials->libraries.push_back(ObjReader::ReadName(content, lineEnd));
+					break;
+				default:
+					break;
+				}
+				p = lineEnd + 1;
+			}
+		}
+
+		// 合并各块记录的mtllib与usemtl，并将角点按材质稳定地重排，使同一材质的三角形连续存放
+		// 同名的usemtl归为同一组，各组按材质首次出现的顺序排列，第一条usemtl之前的面归入名字为空的组
+		inline ObjReader::MaterialGroups GroupObjMaterials(const std::vector<ObjReader::MaterialGroups>& chunkMaterials,
+			std::vector<ObjReader::FaceVertex>& corners)
+		{
+			ObjReader::MaterialGroups materials;
+			std::vector<ObjReader::MaterialGroup> uses;
+			for (const ObjReader::MaterialGroups& chunk : chunkMaterials)
+			{
+				for (const std::string& library : chunk.libraries)
+				{
+					if (std::find(materials.libraries.begin(), materials.libraries.end(), library) == materials.libraries.end())
+						materials.libraries.push_back(library);
+				}
+				uses.insert(uses.end(), chunk.groups.begin(), chunk.groups.end());
+			}
+			if (uses.empty())
+				return materials;
+
+			// 每个三角形所属的组
+			size_t triangleCount = corners.size() / 3;
+			std::vector<UINT> triangleGroups(triangleCount);
+			std::vector<size_t> groupSizes;
+			std::unordered_map<std::string, UINT> groupIds;
+			auto addGroup = [&](const std::string& name, size_t begin, size_t end)
+			{
+				if (begin >= end)
+					return;
+				auto result = groupIds.emplace(name, static_cast<UINT>(materials.groups.size()));
+				if (result.second)
+				{
+					materials.groups.push_back({ name, 0, 0 });
+					groupSizes.push_back(0);
+				}
+				UINT id = result.first->second;
+				std::fill(triangleGroups.begin() + begin, triangleGroups.begin() + end, id);
+				groupSizes[id] += end - begin;
 			};
+			addGroup(std::string(), 0, uses[0].indexStart / 3);
+			for (size_t i = 0; i < uses.size(); ++i)
+				addGroup(uses[i].materialName, uses[i].indexStart / 3, i + 1 < uses.size() ? uses[i + 1].indexStart / 3 : triangleCount);
+
+			// 计数排序，组内保持原有顺序
+			std::vector<size_t> groupOffsets(groupSizes.size());
+			for (size_t g = 0, offset = 0; g < groupSizes.size(); ++g)
+			{
+				groupOffsets[g] = offset;
+				materials.groups[g].indexStart = static_cast<uint32_t>(offset * 3);
+				materials.groups[g].indexCount = static_cast<uint32_t>(groupSizes[g] * 3);
+				offset += groupSizes[g];
+			}
+			if (materials.groups.size() > 1)
+			{
+				std::vector<ObjReader::FaceVertex> sorted(corners.size());
+				for (size_t t = 0; t < triangleCount; ++t)
+				{
+					size_t dst = groupOffsets[triangleGroups[t]]++;
+					memcpy(&sorted[dst * 3], &corners[t * 3], 3 * sizeof(ObjReader::FaceVertex));
+				}
+				corners.swap(sorted);
+			}
+			return materials;
+		}
+
+		// 读取OBJ文件objPath引用的材质库，为每个材质分组生成子网格
+		inline std::vector<Submesh> LoadObjSubmeshes(const std::string& objPath, const ObjReader::MaterialGroups& materials)
+		{
+			std::vector<Submesh> submeshes;
+			if (materials.groups.empty())
+				return submeshes;
+
+			// 材质库路径相对于OBJ文件所在目录，缺失的材质库被忽略
+			std::vector<ObjReader::MtlMaterial> mtlMaterials;
+			std::filesystem::path directory = std::filesystem::path(objPath).parent_path();
+			for (const std::string& library : materials.libraries)
+				ObjReader::ReadMaterialLibrary((directory / library).string(), mtlMaterials);
+			// 同名材质以先出现的为准
+			std::unordered_map<std::string, const ObjReader::MtlMaterial*> materialMap;
+			for (const ObjReader::MtlMaterial& mtl : mtlMaterials)
+				materialMap.emplace(mtl.name, &mtl);
 
-			for (size_t i = 0; i < ARRAYSIZE(VertexType::inputLayout); i++)
+			submeshes.reserve(materials.groups.size());
+			for (const ObjReader::MaterialGroup& group : materials.groups)
 			{
-				semanticName = VertexType::inputLayout[i].SemanticName;
-				const auto& range = semanticSizeMap.at(semanticName);
-				memcpy_s(reinterpret_cast<char*>(&vertexDst) + VertexType::inputLayout[i].AlignedByteOffset,
-					range.second - range.first,
-					reinterpret_cast<const char*>(&vertexSrc) + range.first,
-					range.second - range.first);
+				Submesh submesh = {};
+				submesh.materialName = group.materialName;
+				submesh.indexStart = group.indexStart;
+				submesh.indexCount = group.indexCount;
+				auto it = materialMap.find(group.materialName);
+				if (it != materialMap.end())
+				{
+					// 镜面反射强度存放在specular.w，不透明度存放在diffuse.w
+					const ObjReader::MtlMaterial& mtl = *it->second;
+					submesh.material.ambient = DirectX::XMFLOAT4(mtl.ambient.x, mtl.ambient.y, mtl.ambient.z, 1.0f);
+					submesh.material.diffuse = DirectX::XMFLOAT4(mtl.diffuse.x, mtl.diffuse.y, mtl.diffuse.z, mtl.opacity);
+					submesh.material.specular = DirectX::XMFLOAT4(mtl.specular.x, mtl.specular.y, mtl.specular.z, mtl.shininess);
+					submesh.material.Reflect = DirectX::XMFLOAT4();
+					submesh.hasMaterial = true;
+				}
+				submeshes.push_back(std::move(submesh));
+			}
+			return submeshes;
+		}
+
+		// 顶点随机颜色的种子，同一模型每次加载得到相同的颜色
+		static constexpr uint32_t ObjColorSeed = 0x4F424A43u;
+
+		// 将位置移动到质心，并为每个位置生成随机颜色(颜色只取决于位置的编号，与分块数目无关)
+		inline std::vector<DirectX::XMFLOAT4> CenterObjPositions(std::vector<DirectX::XMFLOAT3>& positions)
+		{
+			// 计算质心
+			size_t positionCount = positions.size();
+			float centerX = 0.0f;
+			float centerY = 0.0f;
+			float centerZ = 0.0f;
+			for (const DirectX::XMFLOAT3& pos : positions)
+			{
+				centerX += pos.x;
+				centerY += pos.y;
+				centerZ += pos.z;
+			}
+			centerX /= positionCount;
+			centerY /= positionCount;
+			centerZ /= positionCount;
+
+			// 移动到中心并赋予随机颜色，共享同一位置的顶点颜色相同
+			for (DirectX::XMFLOAT3& pos : positions)
+			{
+				pos.x -= centerX;
+				pos.y -= centerY;
+				pos.z -= centerZ;
+			}
+			std::vector<DirectX::XMFLOAT4> colors(positionCount);
+			CounterRng::GenerateUniform4(ObjColorSeed, 0, 0, positionCount, colors.data());
+			for (DirectX::XMFLOAT4& color : colors)
+				color.w = 0.0f;
+			return colors;
+		}
+
+		// 由"v/vt/vn"组合生成一个顶点
+		template<class VertexType>
+		inline void MakeObjVertex(VertexType& vertexDst, const ObjData& objData, const std::vector<DirectX::XMFLOAT4>& colors,
+			const ObjReader::FaceVertex& corner)
+		{
+			VertexData vertexData;
+			vertexData.pos = objData.positions[corner.position];
+			vertexData.normal = corner.normal >= 0 ? objData.normals[corner.normal] : DirectX::XMFLOAT3();
+			vertexData.tangent = DirectX::XMFLOAT4();
+			vertexData.color = colors[corner.position];
+			vertexData.tex = corner.texCoord >= 0 ? objData.texCoords[corner.texCoord] : DirectX::XMFLOAT2();
+			InsertVertexElement(vertexDst, vertexData);
+		}
+
+		// 生成器每个并行任务处理的最少顶点数
+		static constexpr size_t GeneratorGrainSize = 16384;
+
+		// 检查顶点数目能否用IndexType表示
+		template<class IndexType>
+		inline void CheckVertexCount(size_t vertexCount)
+		{
+			if (vertexCount > static_cast<size_t>(IndexType(~IndexType(0))) + 1)
+			{
+				throw std::runtime_error("Too many vertices for the index type.");
+			}
+		}
+
+		// 每行有rowSize个元素时，每个并行任务处理的行数
+		inline size_t GeneratorGrainRows(size_t rowSize)
+		{
+			return (std::max)(GeneratorGrainSize / (std::max)(rowSize, size_t(1)), size_t(1));
+		}
+
+		// 按行并行执行func(begin, end)，parallel为false时在当前线程上一次执行完
+		template<class Func>
+		inline void GeneratorFor(size_t rowCount, size_t grainRows, bool parallel, const Func& func)
+		{
+			if (parallel)
+				ThreadPool::Get().ParallelFor(rowCount, grainRows, func);
+			else if (rowCount > 0)
+				func(size_t(0), rowCount);
+		}
+
+		// 生成(slices.x + 1) * (slices.y + 1)个顶点的网格，顶点按行从+Z到-Z、每行从-X到+X排列
+		// heights为各顶点的高度，为nullptr时网格位于XZ平面
+		template<class VertexType, class IndexType>
+		inline void BuildGrid(MeshData<VertexType, IndexType>& meshData, const DirectX::XMFLOAT2& gridSize,
+			const DirectX::XMUINT2& slices, const DirectX::XMFLOAT2& maxTexCoord, const float* heights,
+			const DirectX::XMFLOAT4& color, bool parallel)
+		{
+			using namespace DirectX;
+
+			UINT columnCount = slices.x + 1, rowCount = slices.y + 1;
+			size_t vertexCount = static_cast<size_t>(columnCount) * rowCount;
+			CheckVertexCount<IndexType>(vertexCount);
+			meshData.vertexVec.resize(vertexCount);
+			meshData.indexVec.resize(static_cast<size_t>(slices.x) * slices.y * 6);
+
+			float dx = gridSize.x / slices.x, dz = gridSize.y / slices.y;
+			float du = maxTexCoord.x / slices.x, dv = maxTexCoord.y / slices.y;
+			auto heightAt = [&](UINT i, UINT j)
+			{
+				return heights[static_cast<size_t>(i) * columnCount + j];
+			};
+
+			GeneratorFor(rowCount, GeneratorGrainRows(columnCount), parallel, [&](size_t begin, size_t end) {
+				VertexData vertexData = { XMFLOAT3(), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f), color, XMFLOAT2() };
+				for (UINT i = static_cast<UINT>(begin); i < end; ++i)
+				{
+					float z = gridSize.y / 2 - i * dz;
+					VertexType* pVertex = meshData.vertexVec.data() + static_cast<size_t>(i) * columnCount;
+					for (UINT j = 0; j < columnCount; ++j)
+					{
+						float x = -gridSize.x / 2 + j * dx;
+						float y = 0.0f;
+						if (heights)
+						{
+							// 中心差分，边界处使用单侧差分
+							y = heightAt(i, j);
+							UINT j0 = j > 0 ? j - 1 : j, j1 = j < slices.x ? j + 1 : j;
+							UINT i0 = i > 0 ? i - 1 : i, i1 = i < slices.y ? i + 1 : i;
+							float dydx = (heightAt(i, j1) - heightAt(i, j0)) / ((j1 - j0) * dx);
+							float dydz = (heightAt(i0, j) - heightAt(i1, j)) / ((i1 - i0) * dz);
+							XMStoreFloat3(&vertexData.normal, XMVector3Normalize(XMVectorSet(-dydx, 1.0f, -dydz, 0.0f)));
+							XMStoreFloat4(&vertexData.tangent, XMVectorSetW(XMVector3Normalize(XMVectorSet(1.0f, dydx, 0.0f, 0.0f)), 1.0f));
+						}
+						vertexData.pos = XMFLOAT3(x, y, z);
+						vertexData.tex = XMFLOAT2(j * du, i * dv);
+						InsertVertexElement(pVertex[j], vertexData);
+					}
+				}
+			});
+
+			// 每个格子两个三角形，与CreatePlane的绕序一致
+			GeneratorFor(slices.y, GeneratorGrainRows(slices.x * 6), parallel, [&](size_t begin, size_t end) {
+				for (UINT i = static_cast<UINT>(begin); i < end; ++i)
+				{
+					IndexType* pIndex = meshData.indexVec.data() + static_cast<size_t>(i) * slices.x * 6;
+					for (UINT j = 0; j < slices.x; ++j)
+					{
+						IndexType farLeft = static_cast<IndexType>(i * columnCount + j);
+						IndexType nearLeft = static_cast<IndexType>(farLeft + columnCount);
+						*pIndex++ = nearLeft;
+						*pIndex++ = farLeft;
+						*pIndex++ = static_cast<IndexType>(farLeft + 1);
+						*pIndex++ = static_cast<IndexType>(farLeft + 1);
+						*pIndex++ = static_cast<IndexType>(nearLeft + 1);
+						*pIndex++ = nearLeft;
+					}
+				}
+			});
+		}
+
+		// 在线程池上并行执行func(0) ~ func(taskCount - 1)，全部完成后返回
+		template<class Func>
+		inline void ParallelTasks(size_t taskCount, const Func& func)
+		{
+			ThreadPool::Get().ParallelFor(taskCount, 1, [&func](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i)
+					func(i);
+			});
+		}
+
+		// 文件中没有vn时生成平滑法线：同一位置上相同的角点法线只保存一次并作为vn写回角点，
+		// 之后按"v/vt/vn"去重时折痕两侧的角点自然成为不同的顶点
+		inline void GenerateObjNormals(ObjData& objData, bool threaded)
+		{
+			std::vector<UINT> cornerPositions(objData.corners.size());
+			for (size_t i = 0; i < objData.corners.size(); ++i)
+			{
+				if (objData.corners[i].position < 0)
+				{
+					throw std::runtime_error("Invalid vertex index in OBJ file.");
+				}
+				cornerPositions[i] = static_cast<UINT>(objData.corners[i].position);
+			}
+			std::vector<DirectX::XMFLOAT3> cornerNormals = MeshNormals::GenerateCornerNormals(objData.positions, cornerPositions,
+				MeshNormals::DefaultCreaseAngle, threaded);
+
+			std::vector<int> positionNormal(objData.positions.size(), -1);
+			std::vector<int> nextNormal;
+			objData.normals.clear();
+			for (size_t i = 0; i < objData.corners.size(); ++i)
+			{
+				int& firstNormal = positionNormal[cornerPositions[i]];
+				int normal = firstNormal, lastNormal = -1;
+				while (normal >= 0 && memcmp(&objData.normals[normal], &cornerNormals[i], sizeof(DirectX::XMFLOAT3)) != 0)
+				{
+					lastNormal = normal;
+					normal = nextNormal[normal];
+				}
+				if (normal < 0)
+				{
+					normal = static_cast<int>(objData.normals.size());
+					objData.normals.push_back(cornerNormals[i]);
+					nextNormal.push_back(-1);
+					if (lastNormal >= 0)
+						nextNormal[lastNormal] = normal;
+					else
+						firstNormal = normal;
+				}
+				objData.corners[i].normal = normal;
 			}
 		}
 	}
@@ -89,122 +653,331 @@ namespace Geometry
 	// 几何体方法的实现
 	//
 
-	inline MeshData<VertexPosNormalColor, WORD> CreateModel(const std::string& filePath)
+	template<class VertexType>
+	inline MeshData<VertexType, DWORD> CreateModel(const std::string& filePath, bool parallel, bool useCache)
 	{
 		using namespace DirectX;
 
-		std::ifstream file(filePath);
-		if (!file.is_open())
+		MappedFile file;
+		if (!file.Open(filePath))
 		{
 			throw std::runtime_error("Failed to open OBJ file.");
 		}
 
-		std::random_device rd;
-		std::mt19937 gen(rd());
-		std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+		// 源文件内容未变化时直接读取二进制缓存，跳过文本解析
+		MeshData<VertexType, DWORD> meshData;
+		uint64_t sourceHash = 0;
+		std::string cachePath = MeshCache::GetCachePath<VertexType, DWORD>(filePath);
+		ObjReader::MaterialGroups materials;
+		if (useCache)
+		{
+			sourceHash = MeshCache::HashBytes(file.Begin(), file.Size());
+			if (MeshCache::Load(cachePath, file.Size(), sourceHash, meshData.vertexVec, meshData.indexVec, &materials))
+			{
+				meshData.submeshes = Internal::LoadObjSubmeshes(filePath, materials);
+				return meshData;
+			}
+		}
+
+		// 按行切分文件，单线程模式下只有一块
+		static constexpr size_t minChunkSize = 1 << 20;
+		size_t maxChunks = parallel ? std::thread::hardware_concurrency() : 1;
+		std::vector<const char*> bounds = ObjReader::SplitLines(file.Begin(), file.End(), maxChunks, minChunkSize);
+		size_t chunkCount = bounds.size() - 1;
+
+		// 并行统计每块中各类记录的数目
+		std::vector<ObjReader::RecordCounts> chunkCounts(chunkCount + 1);
+		Internal::ParallelTasks(chunkCount, [&](size_t i) {
+			chunkCounts[i + 1] = ObjReader::CountRecords(bounds[i], bounds[i + 1]);
+		});
+
+		// 前缀和得到每块的输出起始位置，chunkCounts[i]即第i块之前的记录数目
+		for (size_t i = 1; i <= chunkCount; ++i)
+		{
+			chunkCounts[i].positionCount += chunkCounts[i - 1].positionCount;
+			chunkCounts[i].texCoordCount += chunkCounts[i - 1].texCoordCount;
+			chunkCounts[i].normalCount += chunkCounts[i - 1].normalCount;
+			chunkCounts[i].faceCount += chunkCounts[i - 1].faceCount;
+			chunkCounts[i].triangleCount += chunkCounts[i - 1].triangleCount;
+		}
+
+		// 一次性分配好原始数据的数组
+		const ObjReader::RecordCounts& totalCounts = chunkCounts[chunkCount];
+		Internal::ObjData objData;
+		objData.positions.resize(totalCounts.positionCount);
+		objData.texCoords.resize(totalCounts.texCoordCount);
+		objData.normals.resize(totalCounts.normalCount);
+		objData.corners.resize(3 * totalCounts.triangleCount);
+
+		// 在映射区域上并行原地解析，各块直接写入数组中互不重叠的区间
+		std::vector<ObjReader::MaterialGroups> chunkMaterials(chunkCount);
+		Internal::ParallelTasks(chunkCount, [&](size_t i) {
+			Internal::ParseObjRecords(bounds[i], bounds[i + 1], objData, chunkCounts[i], &chunkMaterials[i]);
+		});
+		uint64_t sourceSize = file.Size();
+		file.Close();
+
+		// 按材质分组，之后生成的顶点与索引都按分组后的三角形顺序排列
+		materials = Internal::GroupObjMaterials(chunkMaterials, objData.corners);
 
-		std::string line;
-		std::vector<std::string> s_vertices, s_indices, s_normals;
+		// 移动到质心并生成随机颜色
+		std::vector<XMFLOAT4> colors = Internal::CenterObjPositions(objData.positions);
+		size_t positionCount = objData.positions.size();
 
-		// 存储每行的内容
-		while (std::getline(file, line))
+		// 没有vn时生成平滑法线
+		if constexpr (MeshNormals::HasNormal<VertexType>::value)
 		{
-			if (!line.empty())
+			if (totalCounts.normalCount == 0)
+				Internal::GenerateObjNormals(objData, parallel);
+		}
+
+		// 按"v/vt/vn"组合去重生成顶点，顶点顺序为首次出现的顺序
+		// 大多数位置只对应一种组合，每个位置首次出现的组合直接按位置索引查表，其余组合才进入哈希表
+		static constexpr DWORD invalidVertex = ~0u;
+		std::vector<DWORD> positionVertex(positionCount, invalidVertex);
+		std::vector<ObjReader::FaceVertex> vertexKeys;
+		std::unordered_map<ObjReader::FaceVertex, DWORD, Internal::FaceVertexHash, Internal::FaceVertexEqual> vertexMap;
+		Internal::FaceVertexEqual equal;
+		vertexKeys.reserve(positionCount);
+		meshData.vertexVec.reserve(positionCount);
+		meshData.indexVec.resize(objData.corners.size());
+		for (size_t i = 0; i < objData.corners.size(); ++i)
+		{
+			const ObjReader::FaceVertex& corner = objData.corners[i];
+			if (corner.position < 0)
 			{
-				if (line.size() > 1 && line[0] == 'v')
-					if (line[1] != 'n')
-						s_vertices.push_back(line.substr(2));
-					else
-						s_normals.push_back(line.substr(3));
-				else if (line[0] == 'f')
-					s_indices.push_back(line.substr(2));
+				throw std::runtime_error("Invalid vertex index in OBJ file.");
+			}
+
+			DWORD& firstVertex = positionVertex[corner.position];
+			if (firstVertex != invalidVertex && equal(vertexKeys[firstVertex], corner))
+			{
+				meshData.indexVec[i] = firstVertex;
+				continue;
 			}
+
+			DWORD vertexIndex = static_cast<DWORD>(meshData.vertexVec.size());
+			if (firstVertex == invalidVertex)
+				firstVertex = vertexIndex;
+			else
+			{
+				auto result = vertexMap.emplace(corner, vertexIndex);
+				if (!result.second)
+				{
+					meshData.indexVec[i] = result.first->second;
+					continue;
+				}
+			}
+
+			meshData.vertexVec.emplace_back();
+			Internal::MakeObjVertex(meshData.vertexVec.back(), objData, colors, corner);
+			vertexKeys.push_back(corner);
+			meshData.indexVec[i] = vertexIndex;
 		}
-		file.close();
 
-		MeshData<VertexPosNormalColor, WORD> meshData;
-		size_t vertexCount = s_vertices.size();
-		size_t normalCount = s_normals.size();
-		size_t indexCount = 3 * s_indices.size();
-		meshData.vertexVec.resize(vertexCount);
-		meshData.indexVec.resize(indexCount);
+		// 生成切线，手性不同的角点会拆分顶点
+		if constexpr (MeshNormals::HasTangentSpace<VertexType>::value)
+			MeshNormals::GenerateTangents(meshData.vertexVec, meshData.indexVec, parallel);
 
-		float centerX = 0.0f;
-		float centerY = 0.0f;
-		float centerZ = 0.0f;
+		// 写入缓存供下次启动使用，失败时不影响本次加载
+		if (useCache)
+			MeshCache::Save(cachePath, sourceSize, sourceHash, meshData.vertexVec, meshData.indexVec, &materials);
 
-		std::vector<XMFLOAT3> tempVertices(vertexCount);	// 临时存储顶点
-		std::vector<XMFLOAT3> tempNormals(normalCount);		// 临时存储法线
+		meshData.submeshes = Internal::LoadObjSubmeshes(filePath, materials);
+		return meshData;
+	}
 
-		// 读取顶点并计算质心
-		for (size_t i = 0; i < s_vertices.size(); ++i)
-		{
-			std::istringstream data(s_vertices[i]);
-			float x, y, z;
-			data >> x >> y >> z;
-			x *= 20; // 线性变换坐标
-			y *= 20;
-			z *= 20;
 
-			tempVertices[i] = XMFLOAT3(x, y, z); // 存储原始顶点
+	template<class VertexType, class ChunkFunc>
+	inline void StreamModel(const std::string& filePath, const ChunkFunc& onChunk, size_t windowSize,
+		size_t maxChunkVertices, size_t maxChunkTriangles)
+	{
+		using namespace DirectX;
 
-			centerX += x;
-			centerY += y;
-			centerZ += z;
+		WindowedFile file(windowSize);
+		if (!file.Open(filePath))
+		{
+			throw std::runtime_error("Failed to open OBJ file.");
 		}
 
-		// 计算质心
-		centerX /= vertexCount;
-		centerY /= vertexCount;
-		centerZ /= vertexCount;
+		// 第一遍：统计各类记录的数目，以便属性数组一次分配到位
+		ObjReader::RecordCounts totalCounts = {};
+		const char* begin = nullptr;
+		const char* end = nullptr;
+		while (file.Next(begin, end))
+		{
+			ObjReader::RecordCounts counts = ObjReader::CountRecords(begin, end);
+			totalCounts.positionCount += counts.positionCount;
+			totalCounts.texCoordCount += counts.texCoordCount;
+			totalCounts.normalCount += counts.normalCount;
+		}
 
-		// 读取法线
-		for (size_t i = 0; i < s_normals.size(); i++)
+		// 第二遍：只解析顶点属性，面可能引用文件中任意位置的属性，因此按位置、纹理坐标、法线的顺序
+		// 分段写入临时文件，同时按文件顺序累加位置得到质心(与CreateModel的累加顺序相同)
+		size_t positionCount = totalCounts.positionCount;
+		size_t texCoordCount = totalCounts.texCoordCount;
+		size_t normalCount = totalCounts.normalCount;
+		uint64_t positionOffset = 0;
+		uint64_t texCoordOffset = positionOffset + positionCount * sizeof(XMFLOAT3);
+		uint64_t normalOffset = texCoordOffset + texCoordCount * sizeof(XMFLOAT2);
+		// 临时文件在系统临时目录中创建，名字唯一，多个读取任务可以同时进行，也不要求模型目录可写
+		TempFile spill;
+		if (!spill.Create())
 		{
-			std::istringstream normal(s_normals[i]);
-			float x, y, z;
-			normal >> x >> y >> z;
+			throw std::runtime_error("Failed to create the OBJ attribute spill file.");
+		}
+		float centerX = 0.0f;
+		float centerY = 0.0f;
+		float centerZ = 0.0f;
+		{
+			static constexpr size_t spillBatch = 16384;
+			std::vector<XMFLOAT3> positions, normals;
+			std::vector<XMFLOAT2> texCoords;
+			positions.reserve(spillBatch);
+			texCoords.reserve(spillBatch);
+			normals.reserve(spillBatch);
+			auto spillBuffer = [&spill](auto& buffer, uint64_t& offset) {
+				size_t bytes = buffer.size() * sizeof(buffer[0]);
+				if (bytes > 0 && !spill.Write(offset, buffer.data(), bytes))
+				{
+					throw std::runtime_error("Failed to write the OBJ attribute spill file.");
+				}
+				offset += bytes;
+				buffer.clear();
+			};
 
-			tempNormals[i] = XMFLOAT3(x, y, z);
+			const char* content = nullptr;
+			file.Rewind();
+			while (file.Next(begin, end))
+			{
+				for (const char* p = begin; p < end; )
+				{
+					const char* lineEnd = ObjReader::LineEnd(p, end);
+					switch (ObjReader::ReadRecordType(p, lineEnd, content))
+					{
+					case ObjReader::RecordType::Position:
+						positions.emplace_back();
+						Internal::ParseObjPosition(content, lineEnd, positions.back());
+						centerX += positions.back().x;
+						centerY += positions.back().y;
+						centerZ += positions.back().z;
+						if (positions.size() == spillBatch)
+							spillBuffer(positions, positionOffset);
+						break;
+					case ObjReader::RecordType::TexCoord:
+						texCoords.emplace_back();
+						Internal::ParseObjTexCoord(content, lineEnd, texCoords.back());
+						if (texCoords.size() == spillBatch)
+							spillBuffer(texCoords, texCoordOffset);
+						break;
+					case ObjReader::RecordType::Normal:
+						normals.emplace_back();
+						Internal::ParseObjNormal(content, lineEnd, normals.back());
+						if (normals.size() == spillBatch)
+							spillBuffer(normals, normalOffset);
+						break;
+					default:
+						break;
+					}
+					p = lineEnd + 1;
+				}
+			}
+			spillBuffer(positions, positionOffset);
+			spillBuffer(texCoords, texCoordOffset);
+			spillBuffer(normals, normalOffset);
 		}
+		centerX /= positionCount;
+		centerY /= positionCount;
+		centerZ /= positionCount;
 
-		Internal::VertexData vertexData;
+		// 映射临时文件，三段属性的起始位置；文件中没有任何属性时临时文件为空，不做映射
+		const XMFLOAT3* positions = nullptr;
+		const XMFLOAT2* texCoords = nullptr;
+		const XMFLOAT3* normals = nullptr;
+		auto mapAttributes = [&]() {
+			if (positionCount == 0 && texCoordCount == 0 && normalCount == 0)
+				return;
+			const char* pData = spill.Map();
+			positions = reinterpret_cast<const XMFLOAT3*>(pData);
+			texCoords = reinterpret_cast<const XMFLOAT2*>(pData + positionCount * sizeof(XMFLOAT3));
+			normals = reinterpret_cast<const XMFLOAT3*>(pData + positionCount * sizeof(XMFLOAT3) +
+				texCoordCount * sizeof(XMFLOAT2));
+		};
 
-		VertexPosNormalColor* vertices = new VertexPosNormalColor[vertexCount];
-		WORD* indices = new WORD[indexCount];
-		size_t vIndex = 0, iIndex = 0;
+		// 第三遍：逐个三角形加入当前子网格，顶点只在子网格内部去重
+		MeshData<VertexType, DWORD> chunk;
+		std::unordered_map<ObjReader::FaceVertex, DWORD, Internal::FaceVertexHash, Internal::FaceVertexEqual> vertexMap;
+		auto flush = [&]() {
+			if (!chunk.indexVec.empty())
+				onChunk(chunk);
+			chunk.vertexVec.clear();
+			chunk.indexVec.clear();
+			vertexMap.clear();
+		};
+		auto addVertex = [&](const ObjReader::FaceVertex& corner) {
+			if (corner.position < 0 || static_cast<size_t>(corner.position) >= positionCount ||
+				corner.texCoord >= static_cast<int>(texCoordCount) || corner.normal >= static_cast<int>(normalCount))
+			{
+				throw std::runtime_error("Invalid vertex index in OBJ file.");
+			}
 
-		// 重新赋值顶点并移动到中心
-		for (size_t i = 0; i < vertexCount; ++i)
-		{
-			vertexData =
+			auto result = vertexMap.emplace(corner, static_cast<DWORD>(chunk.vertexVec.size()));
+			if (result.second)
 			{
-				XMFLOAT3(tempVertices[i].x - centerX, tempVertices[i].y - centerY, tempVertices[i].z - centerZ),
-				tempNormals[i],
-				XMFLOAT4(-1.0f, 0.0f, 0.0f, 1.0f),
-				XMFLOAT4(dis(gen), dis(gen), dis(gen), 0.0f), // 随机颜色
-				XMFLOAT2(0.0f, 1.0f)
-			};
-			Internal::InsertVertexElement(meshData.vertexVec[vIndex++], vertexData);
-		}
-		for (size_t i = 0; i < s_indices.size(); ++i)
+				// 与CreateModel相同地移动到质心，颜色按位置编号直接生成，不保存整个颜色数组
+				Internal::VertexData vertexData;
+				const XMFLOAT3& pos = positions[corner.position];
+				vertexData.pos = XMFLOAT3(pos.x - centerX, pos.y - centerY, pos.z - centerZ);
+				vertexData.normal = corner.normal >= 0 ? normals[corner.normal] : XMFLOAT3();
+				vertexData.tangent = XMFLOAT4();
+				vertexData.color = CounterRng::Uniform4(Internal::ObjColorSeed, 0, corner.position);
+				vertexData.color.w = 0.0f;
+				vertexData.tex = corner.texCoord >= 0 ? texCoords[corner.texCoord] : XMFLOAT2();
+				chunk.vertexVec.emplace_back();
+				Internal::InsertVertexElement(chunk.vertexVec.back(), vertexData);
+			}
+			chunk.indexVec.push_back(result.first->second);
+		};
+
+		if (maxChunkVertices < 3)
+			maxChunkVertices = 3;
+		if (maxChunkTriangles < 1)
+			maxChunkTriangles = 1;
+		chunk.vertexVec.reserve(maxChunkVertices);
+		chunk.indexVec.reserve(3 * maxChunkTriangles);
+		ObjReader::RecordCounts counts = {};
+		const char* content = nullptr;
+		file.Rewind();
+		while (file.Next(begin, end))
 		{
-			std::istringstream data(s_indices[i]);
-			std::string s_a, s_b, s_c;
-			data >> s_a >> s_b >> s_c;
-			int a, b, c;
-			std::istringstream ss_a(s_a), ss_b(s_b), ss_c(s_c);
-			ss_a >> a;
-			ss_b >> b;
-			ss_c >> c;
-			meshData.indexVec[iIndex++] = a - 1;
-			meshData.indexVec[iIndex++] = b - 1;
-			meshData.indexVec[iIndex++] = c - 1;
+			// 每个窗口重新映射，解除映射时释放上一个窗口访问过的属性页
+			mapAttributes();
+			for (const char* p = begin; p < end; )
+			{
+				const char* lineEnd = ObjReader::LineEnd(p, end);
+				switch (ObjReader::ReadRecordType(p, lineEnd, content))
+				{
+				case ObjReader::RecordType::Position: ++counts.positionCount; break;
+				case ObjReader::RecordType::TexCoord: ++counts.texCoordCount; break;
+				case ObjReader::RecordType::Normal: ++counts.normalCount; break;
+				case ObjReader::RecordType::Face:
+					Internal::ParseObjFace(content, lineEnd, counts, totalCounts, [&](const ObjReader::FaceVertex& v0,
+						const ObjReader::FaceVertex& v1, const ObjReader::FaceVertex& v2) {
+						// 按最坏情况(三个顶点均为新顶点)判断，保证子网格顶点数不超过上限
+						if (chunk.vertexVec.size() + 3 > maxChunkVertices || chunk.indexVec.size() >= 3 * maxChunkTriangles)
+							flush();
+						addVertex(v0);
+						addVertex(v1);
+						addVertex(v2);
+					});
+					break;
+				default:
+					break;
+				}
+				p = lineEnd + 1;
+			}
 		}
-
-		delete[] vertices;		// 释放临时顶点数据
-		delete[] indices;		// 释放临时索引数据
-		return meshData;
+		flush();
 	}
 
 
@@ -245,6 +1018,301 @@ namespace Geometry
 		meshData.indexVec = { 0, 1, 2, 2, 3, 0 };
 		return meshData;
 	}
+
+	template<class VertexType, class IndexType>
+	inline MeshData<VertexType, IndexType> CreateGrid(const DirectX::XMFLOAT2& gridSize, const DirectX::XMUINT2& slices,
+		const DirectX::XMFLOAT2& maxTexCoord, const DirectX::XMFLOAT4& color, bool parallel)
+	{
+		MeshData<VertexType, IndexType> meshData;
+		Internal::BuildGrid(meshData, gridSize, slices, maxTexCoord, nullptr, color, parallel);
+		return meshData;
+	}
+
+	template<class VertexType, class IndexType, class HeightFunc>
+	inline MeshData<VertexType, IndexType> CreateHeightfield(const DirectX::XMFLOAT2& terrainSize, const DirectX::XMUINT2& slices,
+		const DirectX::XMFLOAT2& maxTexCoord, const HeightFunc& heightFunc, const DirectX::XMFLOAT4& color, bool parallel)
+	{
+		// 先并行采样所有顶点的高度，法线需要用到相邻顶点的高度
+		UINT columnCount = slices.x + 1, rowCount = slices.y + 1;
+		Internal::CheckVertexCount<IndexType>(static_cast<size_t>(columnCount) * rowCount);
+		std::vector<float> heights(static_cast<size_t>(columnCount) * rowCount);
+		float dx = terrainSize.x / slices.x, dz = terrainSize.y / slices.y;
+		Internal::GeneratorFor(rowCount, Internal::GeneratorGrainRows(columnCount), parallel, [&](size_t begin, size_t end) {
+			for (UINT i = static_cast<UINT>(begin); i < end; ++i)
+			{
+				float z = terrainSize.y / 2 - i * dz;
+				for (UINT j = 0; j < columnCount; ++j)
+					heights[static_cast<size_t>(i) * columnCount + j] = heightFunc(-terrainSize.x / 2 + j * dx, z);
+			}
+		});
+
+		MeshData<VertexType, IndexType> meshData;
+		Internal::BuildGrid(meshData, terrainSize, slices, maxTexCoord, heights.data(), color, parallel);
+		return meshData;
+	}
+
+	template<class VertexType, class IndexType>
+	inline MeshData<VertexType, IndexType> CreateBox(float width, float height, float depth, const DirectX::XMFLOAT4& color)
+	{
+		using namespace DirectX;
+
+		MeshData<VertexType, IndexType> meshData;
+		meshData.vertexVec.resize(24);
+		meshData.indexVec.resize(36);
+
+		// 每个面的法线、切线(纹理u方向)与纹理v的反方向，三者满足cross(up, tangent) = normal
+		static const XMFLOAT3 faces[6][3] = {
+			{ XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) },		// 右面(+X)
+			{ XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) },	// 左面(-X)
+			{ XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) },		// 顶面(+Y)
+			{ XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },	// 底面(-Y)
+			{ XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) },	// 背面(+Z)
+			{ XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) }		// 正面(-Z)
+		};
+		// 每个面的四个角在(切线, 向上)方向上的符号与纹理坐标，顺序与CreatePlane相同
+		static const float corners[4][4] = {
+			{ -1.0f, -1.0f, 0.0f, 1.0f }, { -1.0f, 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 1.0f, 1.0f }
+		};
+
+		XMVECTOR halfExtents = XMVectorSet(width / 2, height / 2, depth / 2, 0.0f);
+		Internal::VertexData vertexData;
+		IndexType vIndex = 0, iIndex = 0;
+		for (UINT face = 0; face < 6; ++face)
+		{
+			XMVECTOR normal = XMLoadFloat3(&faces[face][0]);
+			XMVECTOR tangent = XMLoadFloat3(&faces[face][1]);
+			XMVECTOR up = XMLoadFloat3(&faces[face][2]);
+			IndexType base = vIndex;
+			for (UINT k = 0; k < 4; ++k)
+			{
+				XMVECTOR pos = (normal + tangent * corners[k][0] + up * corners[k][1]) * halfExtents;
+				XMStoreFloat3(&vertexData.pos, pos);
+				vertexData.normal = faces[face][0];
+				vertexData.tangent = XMFLOAT4(faces[face][1].x, faces[face][1].y, faces[face][1].z, 1.0f);
+				vertexData.color = color;
+				vertexData.tex = XMFLOAT2(corners[k][2], corners[k][3]);
+				Internal::InsertVertexElement(meshData.vertexVec[vIndex++], vertexData);
+			}
+			for (IndexType offset : { IndexType(0), IndexType(1), IndexType(2), IndexType(2), IndexType(3), IndexType(0) })
+				meshData.indexVec[iIndex++] = static_cast<IndexType>(base + offset);
+		}
+		return meshData;
+	}
+
+	template<class VertexType, class IndexType>
+	inline MeshData<VertexType, IndexType> CreateSphere(float radius, UINT levels, UINT slices, const DirectX::XMFLOAT4& color, bool parallel)
+	{
+		using namespace DirectX;
+
+		// 顶端点、底端点与levels - 1个纬圈，每圈slices + 1个顶点，起点和终点位置相同但纹理坐标不同
+		levels = (std::max)(levels, 2u);
+		slices = (std::max)(slices, 3u);
+		UINT ringSize = slices + 1;
+		size_t vertexCount = 2 + static_cast<size_t>(levels - 1) * ringSize;
+		Internal::CheckVertexCount<IndexType>(vertexCount);
+
+		MeshData<VertexType, IndexType> meshData;
+		meshData.vertexVec.resize(vertexCount);
+		meshData.indexVec.resize(6 * static_cast<size_t>(levels - 1) * slices);
+
+		float perPhi = XM_PI / levels;
+		float perTheta = XM_2PI / slices;
+		auto ringVertex = [ringSize](UINT i, UINT j) { return 1 + (i - 1) * ringSize + j; };
+
+		Internal::VertexData vertexData;
+		vertexData = { XMFLOAT3(0.0f, radius, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f), color, XMFLOAT2(0.0f, 0.0f) };
+		Internal::InsertVertexElement(meshData.vertexVec.front(), vertexData);
+		vertexData = { XMFLOAT3(0.0f, -radius, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT4(-1.0f, 0.0f, 0.0f, 1.0f), color, XMFLOAT2(0.0f, 1.0f) };
+		Internal::InsertVertexElement(meshData.vertexVec.back(), vertexData);
+
+		// 各纬圈的顶点
+		Internal::GeneratorFor(levels - 1, Internal::GeneratorGrainRows(ringSize), parallel, [&](size_t begin, size_t end) {
+			Internal::VertexData vertexData;
+			vertexData.color = color;
+			for (UINT i = static_cast<UINT>(begin) + 1; i <= end; ++i)
+			{
+				float phi = perPhi * i;
+				for (UINT j = 0; j <= slices; ++j)
+				{
+					float theta = perTheta * j;
+					XMFLOAT3 normal = XMFLOAT3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+					vertexData.pos = XMFLOAT3(radius * normal.x, radius * normal.y, radius * normal.z);
+					vertexData.normal = normal;
+					vertexData.tangent = XMFLOAT4(-sinf(theta), 0.0f, cosf(theta), 1.0f);
+					vertexData.tex = XMFLOAT2(theta / XM_2PI, phi / XM_PI);
+					Internal::InsertVertexElement(meshData.vertexVec[ringVertex(i, j)], vertexData);
+				}
+			}
+		});
+
+		// 索引按纬带划分：第0带与顶端点相连，第levels - 1带与底端点相连，其余每带每格两个三角形
+		// 顶端与底端的纬带各有slices个三角形，中间的纬带各有2 * slices个三角形
+		UINT bottom = static_cast<UINT>(vertexCount - 1);
+		Internal::GeneratorFor(levels, Internal::GeneratorGrainRows(6 * slices), parallel, [&](size_t begin, size_t end) {
+			for (UINT band = static_cast<UINT>(begin); band < end; ++band)
+			{
+				IndexType* pIndex = meshData.indexVec.data() + (band == 0 ? 0 : static_cast<size_t>(3 * slices) * (2 * band - 1));
+				for (UINT j = 0; j < slices; ++j)
+				{
+					if (band == 0)
+					{
+						*pIndex++ = 0;
+						*pIndex++ = static_cast<IndexType>(ringVertex(1, j + 1));
+						*pIndex++ = static_cast<IndexType>(ringVertex(1, j));
+					}
+					else if (band == levels - 1)
+					{
+						*pIndex++ = static_cast<IndexType>(ringVertex(band, j));
+						*pIndex++ = static_cast<IndexType>(ringVertex(band, j + 1));
+						*pIndex++ = static_cast<IndexType>(bottom);
+					}
+					else
+					{
+						*pIndex++ = static_cast<IndexType>(ringVertex(band, j));
+						*pIndex++ = static_cast<IndexType>(ringVertex(band, j + 1));
+						*pIndex++ = static_cast<IndexType>(ringVertex(band + 1, j + 1));
+						*pIndex++ = static_cast<IndexType>(ringVertex(band + 1, j + 1));
+						*pIndex++ = static_cast<IndexType>(ringVertex(band + 1, j));
+						*pIndex++ = static_cast<IndexType>(ringVertex(band, j));
+					}
+				}
+			}
+		});
+		return meshData;
+	}
+
+	template<class VertexType, class IndexType>
+	inline MeshData<VertexType, IndexType> CreateCylinder(float radius, float height, UINT slices, UINT stacks,
+		float texU, float texV, const DirectX::XMFLOAT4& color, bool parallel)
+	{
+		using namespace DirectX;
+
+		// 侧面为(stacks + 1) * (slices + 1)个顶点，上下底面各有一个中心点与slices + 1个边缘顶点
+		slices = (std::max)(slices, 3u);
+		stacks = (std::max)(stacks, 1u);
+		UINT ringSize = slices + 1;
+		size_t sideVertexCount = static_cast<size_t>(stacks + 1) * ringSize;
+		size_t vertexCount = sideVertexCount + 2 * (1 + static_cast<size_t>(ringSize));
+		Internal::CheckVertexCount<IndexType>(vertexCount);
+
+		MeshData<VertexType, IndexType> meshData;
+		meshData.vertexVec.resize(vertexCount);
+		meshData.indexVec.resize(6 * static_cast<size_t>(stacks) * slices + 6 * static_cast<size_t>(slices));
+
+		float perTheta = XM_2PI / slices;
+		float stackHeight = height / stacks;
+
+		// 侧面顶点，自下而上逐圈生成
+		Internal::GeneratorFor(stacks + 1, Internal::GeneratorGrainRows(ringSize), parallel, [&](size_t begin, size_t end) {
+			Internal::VertexData vertexData;
+			vertexData.color = color;
+			for (UINT i = static_cast<UINT>(begin); i < end; ++i)
+			{
+				float y = -height / 2 + i * stackHeight;
+				VertexType* pVertex = meshData.vertexVec.data() + static_cast<size_t>(i) * ringSize;
+				for (UINT j = 0; j <= slices; ++j)
+				{
+					float theta = perTheta * j;
+					float c = cosf(theta), s = sinf(theta);
+					vertexData.pos = XMFLOAT3(radius * c, y, radius * s);
+					vertexData.normal = XMFLOAT3(c, 0.0f, s);
+					vertexData.tangent = XMFLOAT4(-s, 0.0f, c, 1.0f);
+					vertexData.tex = XMFLOAT2(theta / XM_2PI * texU, texV - i * texV / stacks);
+					Internal::InsertVertexElement(pVertex[j], vertexData);
+				}
+			}
+		});
+
+		Internal::GeneratorFor(stacks, Internal::GeneratorGrainRows(6 * slices), parallel, [&](size_t begin, size_t end) {
+			for (UINT i = static_cast<UINT>(begin); i < end; ++i)
+			{
+				IndexType* pIndex = meshData.indexVec.data() + static_cast<size_t>(i) * slices * 6;
+				for (UINT j = 0; j < slices; ++j)
+				{
+					IndexType lower = static_cast<IndexType>(i * ringSize + j);
+					IndexType upper = static_cast<IndexType>(lower + ringSize);
+					*pIndex++ = lower;
+					*pIndex++ = upper;
+					*pIndex++ = static_cast<IndexType>(upper + 1);
+					*pIndex++ = static_cast<IndexType>(upper + 1);
+					*pIndex++ = static_cast<IndexType>(lower + 1);
+					*pIndex++ = lower;
+				}
+			}
+		});
+
+		// 上下底面，底面的三角形与顶面绕序相反
+		Internal::VertexData vertexData;
+		size_t vIndex = sideVertexCount;
+		size_t iIndex = 6 * static_cast<size_t>(stacks) * slices;
+		for (int side = 1; side >= -1; side -= 2)
+		{
+			float y = side * height / 2;
+			IndexType center = static_cast<IndexType>(vIndex);
+			vertexData = { XMFLOAT3(0.0f, y, 0.0f), XMFLOAT3(0.0f, static_cast<float>(side), 0.0f),
+				XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f), color, XMFLOAT2(0.5f, 0.5f) };
+			Internal::InsertVertexElement(meshData.vertexVec[vIndex++], vertexData);
+			for (UINT j = 0; j <= slices; ++j)
+			{
+				float theta = perTheta * j;
+				float c = cosf(theta), s = sinf(theta);
+				vertexData.pos = XMFLOAT3(radius * c, y, radius * s);
+				vertexData.tex = XMFLOAT2(0.5f + 0.5f * c, 0.5f - 0.5f * side * s);
+				Internal::InsertVertexElement(meshData.vertexVec[vIndex++], vertexData);
+			}
+			for (UINT j = 0; j < slices; ++j)
+			{
+				meshData.indexVec[iIndex++] = center;
+				meshData.indexVec[iIndex++] = static_cast<IndexType>(center + 1 + (side > 0 ? j + 1 : j));
+				meshData.indexVec[iIndex++] = static_cast<IndexType>(center + 1 + (side > 0 ? j : j + 1));
+			}
+		}
+		return meshData;
+	}
+
+	template<class VertexType, class IndexType>
+	inline MeshDataSoA<IndexType> ToSoA(const MeshData<VertexType, IndexType>& meshData)
+	{
+		MeshDataSoA<IndexType> soaData;
+		soaData.indexVec = meshData.indexVec;
+		soaData.submeshes = meshData.submeshes;
+		size_t vertexCount = meshData.vertexVec.size();
+		const char* src = reinterpret_cast<const char*>(meshData.vertexVec.data());
+
+		VertexTraits<VertexType>::ForEachElement([&](auto element) {
+			using Element = decltype(element);
+			auto& stream = Internal::GetStream<Element::semantic>(soaData);
+			static_assert(sizeof(stream[0]) == Element::size, "Vertex element must be a 32-bit float vector!");
+			stream.resize(vertexCount);
+			char* dst = reinterpret_cast<char*>(stream.data());
+			for (size_t i = 0; i < vertexCount; ++i)
+				memcpy(dst + i * Element::size, src + i * sizeof(VertexType) + Element::offset, Element::size);
+		});
+		return soaData;
+	}
+
+	template<class VertexType, class IndexType>
+	inline MeshData<VertexType, IndexType> ToAoS(const MeshDataSoA<IndexType>& meshData)
+	{
+		MeshData<VertexType, IndexType> aosData;
+		aosData.indexVec = meshData.indexVec;
+		aosData.submeshes = meshData.submeshes;
+		size_t vertexCount = meshData.VertexCount();
+		aosData.vertexVec.resize(vertexCount);
+		char* dst = reinterpret_cast<char*>(aosData.vertexVec.data());
+
+		VertexTraits<VertexType>::ForEachElement([&](auto element) {
+			using Element = decltype(element);
+			const auto& stream = Internal::GetStream<Element::semantic>(meshData);
+			static_assert(sizeof(stream[0]) == Element::size, "Vertex element must be a 32-bit float vector!");
+			if (stream.size() != vertexCount)
+				throw std::runtime_error(std::string("MeshDataSoA is missing the ") + GetSemanticName(Element::semantic) + " stream!");
+			const char* src = reinterpret_cast<const char*>(stream.data());
+			for (size_t i = 0; i < vertexCount; ++i)
+				memcpy(dst + i * sizeof(VertexType) + Element::offset, src + i * Element::size, Element::size);
+		});
+		return aosData;
+	}
 }
 
 
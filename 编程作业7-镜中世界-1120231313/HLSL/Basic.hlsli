@@ -40,6 +40,15 @@ cbuffer CBChangesRarely : register(b3)
 
 
 
+// 八面体编码法线的解码
+float3 OctDecode(float2 oct)
+{
+    float3 n = float3(oct, 1.0f - abs(oct.x) - abs(oct.y));
+    float fold = saturate(-n.z);
+    n.xy -= fold * (n.xy >= 0.0f ? 1.0f : -1.0f);
+    return normalize(n);
+}
+
 struct VertexPosNormalTex
 {
     float3 PosL : POSITION;
@@ -54,6 +63,14 @@ struct VertexPosNormalColor
     float4 Color : COLOR;
 };
 
+// 压缩顶点：位置为包围盒内的归一化坐标(由g_World还原)，法线为八面体编码
+struct VertexPosNormalColorPacked
+{
+    float3 PosL : POSITION;
+    float2 NormalOct : NORMAL;
+    float4 Color : COLOR;
+};
+
 struct VertexPosTex
 {
     float3 PosL : POSITION;
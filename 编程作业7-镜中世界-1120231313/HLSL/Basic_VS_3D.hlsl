@@ -1,12 +1,13 @@
 #include "Basic.hlsli"
 
 // 顶点着色器(3D)
-VertexPosHWNormalColor VS_3D(VertexPosNormalColor vIn)
+VertexPosHWNormalColor VS_3D(VertexPosNormalColorPacked vIn)
 {
     VertexPosHWNormalColor vOut;
     matrix viewProj = mul(g_View, g_Proj);
     float4 posW = mul(float4(vIn.PosL, 1.0f), g_World);
-    float3 normalW = mul(vIn.NormalL, (float3x3) g_WorldInvTranspose);
+    float3 normalL = OctDecode(vIn.NormalOct);
+    float3 normalW = mul(normalL, (float3x3) g_WorldInvTranspose);
     
     [flatten]
     if (g_IsReflection)
@@ -17,7 +18,7 @@ VertexPosHWNormalColor VS_3D(VertexPosNormalColor vIn)
 
     vOut.PosH = mul(posW, viewProj);
     vOut.PosW = posW.xyz;
-    vOut.NormalW = mul(vIn.NormalL, (float3x3) g_WorldInvTranspose);
+    vOut.NormalW = mul(normalL, (float3x3) g_WorldInvTranspose);
     vOut.Color = m_Color;
     return vOut;
 }
@@ -0,0 +1,17 @@
+#include "Basic.hlsli"
+
+// 顶点着色器(3D)，只输出位置，用于模板/深度标记
+// 输入布局只读取位置分量的顶点缓冲区
+float4 VS_3D(float3 posL : POSITION) : SV_POSITION
+{
+    matrix viewProj = mul(g_View, g_Proj);
+    float4 posW = mul(float4(posL, 1.0f), g_World);
+    
+    [flatten]
+    if (g_IsReflection)
+    {
+        posW = mul(posW, g_Reflection);
+    }
+
+    return mul(posW, viewProj);
+}
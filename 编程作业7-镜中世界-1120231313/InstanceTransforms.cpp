@@ -0,0 +1,121 @@
+#include "InstanceTransforms.h"
+#include <utility>
+#include "ThreadPool.h"
+using namespace DirectX;
+
+namespace
+{
+	// 每个并行任务计算逆矩阵的实例组数(每组4个实例)
+	constexpr size_t InverseGrainSize = 1024;
+	// 各行长度平方之差与行间点积相对于长度平方不超过该值时视为均匀缩放
+	constexpr float UniformScaleTolerance = 1e-5f;
+}
+
+InstanceTransforms::InstanceTransforms(InstanceTransforms&& other) noexcept
+	: m_Worlds(std::move(other.m_Worlds)), m_Count(other.m_Count)
+{
+	other.m_Worlds.clear();
+	other.m_Count = 0;
+}
+
+InstanceTransforms& InstanceTransforms::operator=(InstanceTransforms&& other) noexcept
+{
+	if (this != &other)
+	{
+		m_Worlds = std::move(other.m_Worlds);
+		m_Count = other.m_Count;
+		other.m_Worlds.clear();
+		other.m_Count = 0;
+	}
+	return *this;
+}
+
+void InstanceTransforms::Resize(size_t count)
+{
+	m_Worlds.assign((count + 3) & ~size_t(3), XMMatrixIdentity());
+	m_Count = count;
+}
+
+void XM_CALLCONV InstanceTransforms::Store(size_t index, FXMMATRIX world)
+{
+	XMMATRIX& m = m_Worlds[index];
+	m.r[0] = XMVectorSetW(world.r[0], 0.0f);
+	m.r[1] = XMVectorSetW(world.r[1], 0.0f);
+	m.r[2] = XMVectorSetW(world.r[2], 0.0f);
+	m.r[3] = XMVectorSetW(world.r[3], 1.0f);
+}
+
+void InstanceTransforms::StoreBatch(size_t first, size_t count, const XMMATRIX* worlds)
+{
+	for (size_t k = 0; k < count; ++k)
+		Store(first + k, worlds[k]);
+}
+
+void InstanceTransforms::ComputeInverses(InstanceTransforms& inverses) const
+{
+	if (inverses.m_Count != m_Count)
+		inverses.Resize(m_Count);
+
+	// 补齐的实例为单位矩阵，可以与其余实例一起按整组计算
+	size_t groupCount = m_Worlds.size() / 4;
+	ThreadPool::Get().ParallelFor(groupCount, InverseGrainSize, [&](size_t begin, size_t end) {
+		for (size_t group = begin; group < end; ++group)
+		{
+			const XMMATRIX* worlds = &m_Worlds[group * 4];
+			// m[row][column]为4个实例世界矩阵第row行第column列的取值，由4个实例的第row行转置得到
+			XMVECTOR m[3][3];
+			for (size_t row = 0; row < 3; ++row)
+			{
+				XMMATRIX lanes = XMMatrixTranspose(XMMATRIX(worlds[0].r[row], worlds[1].r[row], worlds[2].r[row], worlds[3].r[row]));
+				for (size_t column = 0; column < 3; ++column)
+					m[row][column] = lanes.r[column];
+			}
+
+			auto dot = [](const XMVECTOR* a, const XMVECTOR* b) {
+				return XMVectorMultiplyAdd(a[0], b[0], XMVectorMultiplyAdd(a[1], b[1], XMVectorMultiply(a[2], b[2])));
+			};
+			XMVECTOR lengthSq0 = dot(m[0], m[0]);
+			XMVECTOR deviation = XMVectorMax(
+				XMVectorMax(XMVectorAbs(dot(m[1], m[1]) - lengthSq0), XMVectorAbs(dot(m[2], m[2]) - lengthSq0)),
+				XMVectorMax(XMVectorAbs(dot(m[0], m[1])), XMVectorMax(XMVectorAbs(dot(m[0], m[2])), XMVectorAbs(dot(m[1], m[2])))));
+
+			XMVECTOR inv[3][3];
+			if (XMVector4LessOrEqual(deviation, lengthSq0 * XMVectorReplicate(UniformScaleTolerance)))
+			{
+				// 刚体或均匀缩放：M = sR，M^-1 = M^T / s²
+				XMVECTOR invLengthSq = XMVectorReciprocal(lengthSq0);
+				for (size_t row = 0; row < 3; ++row)
+					for (size_t column = 0; column < 3; ++column)
+						inv[row][column] = m[column][row] * invLengthSq;
+			}
+			else
+			{
+				// 一般情况：M^-1的第column列为另两行的叉积除以行列式
+				XMVECTOR cross[3][3];
+				for (size_t k = 0; k < 3; ++k)
+				{
+					const XMVECTOR* a = m[(k + 1) % 3];
+					const XMVECTOR* b = m[(k + 2) % 3];
+					cross[k][0] = a[1] * b[2] - a[2] * b[1];
+					cross[k][1] = a[2] * b[0] - a[0] * b[2];
+					cross[k][2] = a[0] * b[1] - a[1] * b[0];
+				}
+				XMVECTOR invDet = XMVectorReciprocal(dot(m[0], cross[0]));
+				for (size_t row = 0; row < 3; ++row)
+					for (size_t column = 0; column < 3; ++column)
+						inv[row][column] = cross[column][row] * invDet;
+			}
+
+			// 转置回各实例的第row行，第4列为0，平移行为(0, 0, 0, 1)
+			XMMATRIX* out = &inverses.m_Worlds[group * 4];
+			for (size_t row = 0; row < 3; ++row)
+			{
+				XMMATRIX lanes = XMMatrixTranspose(XMMATRIX(inv[row][0], inv[row][1], inv[row][2], XMVectorZero()));
+				for (size_t k = 0; k < 4; ++k)
+					out[k].r[row] = lanes.r[k];
+			}
+			for (size_t k = 0; k < 4; ++k)
+				out[k].r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	});
+}
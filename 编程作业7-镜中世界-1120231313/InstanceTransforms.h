@@ -0,0 +1,49 @@
+//***************************************************************************************
+// InstanceTransforms.h
+//
+// 实例变换存储：每个实例一个完整的世界矩阵连续存放，数目补齐到4的倍数，以便4个实例一组计算逆矩阵
+// Contiguous instance world matrices padded to groups of four for batched SIMD inverses.
+//***************************************************************************************
+
+#ifndef INSTANCETRANSFORMS_H
+#define INSTANCETRANSFORMS_H
+
+#include <cstddef>
+#include <vector>
+#include <DirectXMath.h>
+
+class InstanceTransforms
+{
+public:
+	InstanceTransforms() = default;
+
+	InstanceTransforms(const InstanceTransforms&) = delete;
+	InstanceTransforms& operator=(const InstanceTransforms&) = delete;
+	InstanceTransforms(InstanceTransforms&& other) noexcept;
+	InstanceTransforms& operator=(InstanceTransforms&& other) noexcept;
+
+	// 重新分配count个实例，原有内容被丢弃，所有实例置为单位矩阵
+	void Resize(size_t count);
+	// 获取实例数目
+	size_t GetCount() const { return m_Count; }
+
+	// 保存仿射世界矩阵，第4列总是置为(0, 0, 0, 1)；不同实例可以在不同线程中同时保存
+	void XM_CALLCONV Store(size_t index, DirectX::FXMMATRIX world);
+	// 将worlds[0, count)保存到[first, first + count)内的实例
+	void StoreBatch(size_t first, size_t count, const DirectX::XMMATRIX* worlds);
+	// 读取一个实例的世界矩阵；index也可以是[GetCount(), GetPaddedCount())内的补齐实例，总是单位矩阵
+	DirectX::XMMATRIX Load(size_t index) const { return m_Worlds[index]; }
+	// 获取向上取整到4的倍数的实例数目
+	size_t GetPaddedCount() const { return m_Worlds.size(); }
+
+	// 对所有实例计算线性部分(左上3x3)的逆矩阵，平移为0，写入inverses，数目不同时重新分配
+	// 其转置即法线变换矩阵；4个实例转置到向量的4个分量上同时计算，整组都是刚体或均匀缩放
+	// (各行等长且两两正交)时逆矩阵即转置除以缩放的平方，否则按伴随矩阵计算；各组在线程池上并行
+	void ComputeInverses(InstanceTransforms& inverses) const;
+
+private:
+	std::vector<DirectX::XMMATRIX> m_Worlds;		// 长度向上取整到4的倍数，补齐的实例保持单位矩阵
+	size_t m_Count = 0;								// 实例数目
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "MeshCache.h"
+#include <cstdio>
+
+namespace
+{
+	const char s_Magic[8] = "MESHBIN";
+
+	// 向上对齐到BlobAlignment
+	uint64_t AlignBlob(uint64_t offset)
+	{
+		return (offset + MeshCache::BlobAlignment - 1) & ~(MeshCache::BlobAlignment - 1);
+	}
+
+	// 写入整块数据
+	bool WriteAll(HANDLE hFile, const void* data, uint64_t size)
+	{
+		const char* p = static_cast<const char*>(data);
+		while (size > 0)
+		{
+			DWORD chunk = size > 0x40000000ull ? 0x40000000u : static_cast<DWORD>(size);
+			DWORD written = 0;
+			if (!WriteFile(hFile, p, chunk, &written, nullptr) || written != chunk)
+				return false;
+			p += chunk;
+			size -= chunk;
+		}
+		return true;
+	}
+
+	// 写入零填充直到文件偏移到达target
+	bool WritePadding(HANDLE hFile, uint64_t& offset, uint64_t target)
+	{
+		static const char zeros[MeshCache::BlobAlignment] = {};
+		while (offset < target)
+		{
+			uint64_t size = target - offset;
+			if (size > sizeof(zeros))
+				size = sizeof(zeros);
+			if (!WriteAll(hFile, zeros, size))
+				return false;
+			offset += size;
+		}
+		return true;
+	}
+}
+
+uint64_t MeshCache::HashBytes(const void* data, size_t size, uint64_t seed)
+{
+	// 以8字节为单位的FNV-1a变体，尾部按字节处理
+	static constexpr uint64_t prime = 1099511628211ull;
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+
+	size_t wordCount = size / sizeof(uint64_t);
+	for (size_t i = 0; i < wordCount; ++i)
+	{
+		uint64_t word;
+		memcpy(&word, p + i * sizeof(uint64_t), sizeof(uint64_t));
+		hash = (hash ^ word) * prime;
+		hash ^= hash >> 29;
+	}
+	for (size_t i = wordCount * sizeof(uint64_t); i < size; ++i)
+		hash = (hash ^ p[i]) * prime;
+
+	return hash ^ size;
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath, uint64_t layoutHash, uint32_t indexSize)
+{
+	// 例如 Ning.obj.0123456789abcdef.u32.meshbin
+	char suffix[48];
+	snprintf(suffix, sizeof(suffix), ".%016llx.u%u.meshbin", static_cast<unsigned long long>(layoutHash), indexSize * 8);
+	return sourcePath + suffix;
+}
+
+MeshCache::Header MeshCache::Internal::MakeHeader(uint64_t layoutHash, uint32_t vertexStride, uint32_t indexSize,
+	uint64_t vertexCount, uint64_t indexCount, uint64_t sourceSize, uint64_t sourceHash)
+{
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, s_Magic, sizeof(header.magic));
+	header.version = Version;
+	header.headerSize = sizeof(Header);
+	header.layoutHash = layoutHash;
+	header.vertexStride = vertexStride;
+	header.indexSize = indexSize;
+	header.vertexCount = vertexCount;
+	header.indexCount = indexCount;
+	header.sourceSize = sourceSize;
+	header.sourceHash = sourceHash;
+	return header;
+}
+
+const MeshCache::Header* MeshCache::Internal::Validate(const MappedFile& file, const Header& expected)
+{
+	if (file.Size() < sizeof(Header))
+		return nullptr;
+
+	const Header* header = reinterpret_cast<const Header*>(file.Begin());
+	if (memcmp(header->magic, expected.magic, sizeof(header->magic)) != 0 ||
+		header->version != expected.version ||
+		header->headerSize != expected.headerSize ||
+		header->layoutHash != expected.layoutHash ||
+		header->vertexStride != expected.vertexStride ||
+		header->indexSize != expected.indexSize ||
+		header->sourceSize != expected.sourceSize ||
+		header->sourceHash != expected.sourceHash)
+		return nullptr;
+
+	// 防止截断或损坏的文件越界访问，数据块内容由解码器检查
+	uint64_t vertexBytes = header->vertexBlobSize;
+	uint64_t indexBytes = header->indexBlobSize;
+	if (vertexBytes > file.Size() || indexBytes > file.Size())
+		return nullptr;
+	// 每个顶点块至少占4字节，每个三角形至少占1字节，避免按损坏的数目分配过大的数组
+	if (header->vertexCount > vertexBytes / sizeof(uint32_t) * MeshCodec::VertexBlockSize ||
+		header->indexCount > indexBytes * 3 + 2)
+		return nullptr;
+	if (header->materialTableSize > file.Size() ||
+		header->vertexOffset % BlobAlignment != 0 || header->indexOffset % BlobAlignment != 0 ||
+		header->vertexOffset < sizeof(Header) + header->materialTableSize || header->vertexOffset + vertexBytes > file.Size() ||
+		header->indexOffset < header->vertexOffset + vertexBytes || header->indexOffset + indexBytes > file.Size())
+		return nullptr;
+
+	return header;
+}
+
+bool MeshCache::Internal::WriteBlobs(const std::string& cachePath, Header& header,
+	const void* materialTable, const void* vertexData, const void* indexData)
+{
+	uint64_t tableBytes = header.materialTableSize;
+	uint64_t vertexBytes = header.vertexBlobSize;
+	uint64_t indexBytes = header.indexBlobSize;
+	header.vertexOffset = AlignBlob(sizeof(Header) + tableBytes);
+	header.indexOffset = AlignBlob(header.vertexOffset + vertexBytes);
+
+	// 先写入临时文件再替换，避免其他进程读到写了一半的缓存
+	std::string tempPath = cachePath + ".tmp";
+	HANDLE hFile = CreateFileA(tempPath.c_str(), GENERIC_WRITE, 0, nullptr,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	uint64_t offset = sizeof(Header) + tableBytes;
+	bool success = WriteAll(hFile, &header, sizeof(Header)) &&
+		WriteAll(hFile, materialTable, tableBytes) &&
+		WritePadding(hFile, offset, header.vertexOffset) &&
+		WriteAll(hFile, vertexData, vertexBytes);
+	offset += vertexBytes;
+	success = success &&
+		WritePadding(hFile, offset, header.indexOffset) &&
+		WriteAll(hFile, indexData, indexBytes);
+	CloseHandle(hFile);
+
+	if (!success || !MoveFileExA(tempPath.c_str(), cachePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+std::vector<uint8_t> MeshCache::Internal::EncodeMaterialTable(const ObjReader::MaterialGroups& materials)
+{
+	std::vector<uint8_t> table;
+	auto writeUint = [&table](uint32_t value)
+	{
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+		table.insert(table.end(), p, p + sizeof(value));
+	};
+	auto writeString = [&](const std::string& str)
+	{
+		writeUint(static_cast<uint32_t>(str.size()));
+		table.insert(table.end(), str.begin(), str.end());
+	};
+
+	writeUint(static_cast<uint32_t>(materials.libraries.size()));
+	for (const std::string& library : materials.libraries)
+		writeString(library);
+	writeUint(static_cast<uint32_t>(materials.groups.size()));
+	for (const ObjReader::MaterialGroup& group : materials.groups)
+	{
+		writeString(group.materialName);
+		writeUint(group.indexStart);
+		writeUint(group.indexCount);
+	}
+	return table;
+}
+
+bool MeshCache::Internal::DecodeMaterialTable(const uint8_t* data, size_t size, uint64_t indexCount, ObjReader::MaterialGroups& materials)
+{
+	materials = ObjReader::MaterialGroups();
+	const uint8_t* end = data + size;
+	auto readUint = [&](uint32_t& value)
+	{
+		if (end - data < static_cast<ptrdiff_t>(sizeof(value)))
+			return false;
+		memcpy(&value, data, sizeof(value));
+		data += sizeof(value);
+		return true;
+	};
+	auto readString = [&](std::string& str)
+	{
+		uint32_t length;
+		if (!readUint(length) || static_cast<size_t>(end - data) < length)
+			return false;
+		str.assign(reinterpret_cast<const char*>(data), length);
+		data += length;
+		return true;
+	};
+
+	uint32_t libraryCount = 0, groupCount = 0;
+	if (!readUint(libraryCount) || libraryCount > size)
+		return false;
+	materials.libraries.resize(libraryCount);
+	for (std::string& library : materials.libraries)
+	{
+		if (!readString(library))
+			return false;
+	}
+	if (!readUint(groupCount) || groupCount > size)
+		return false;
+	materials.groups.resize(groupCount);
+	for (ObjReader::MaterialGroup& group : materials.groups)
+	{
+		if (!readString(group.materialName) || !readUint(group.indexStart) || !readUint(group.indexCount) ||
+			static_cast<uint64_t>(group.indexStart) + group.indexCount > indexCount)
+			return false;
+	}
+	return data == end;
+}
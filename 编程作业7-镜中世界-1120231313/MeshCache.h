@@ -0,0 +1,185 @@
+//***************************************************************************************
+// MeshCache.h
+//
+// 二进制网格缓存(.meshbin)，保存解析完成并经MeshCodec压缩的顶点/索引数组，避免每次启动重新解析文本模型
+// Binary mesh cache (.meshbin) holding the compressed vertex/index arrays of a parsed model.
+//***************************************************************************************
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <d3d11_1.h>
+#include <DirectXMath.h>
+#include "ObjReader.h"
+#include "MeshCodec.h"
+
+namespace MeshCache
+{
+	// 文件格式版本，格式变化时需递增，旧缓存会被自动重建
+	static constexpr uint32_t Version = 5;
+	// 顶点/索引数据块的对齐字节数(页大小)
+	static constexpr uint64_t BlobAlignment = 4096;
+
+	// 文件头，位于文件起始处
+	struct Header
+	{
+		char magic[8];					// "MESHBIN"
+		uint32_t version;				// 格式版本
+		uint32_t headerSize;			// sizeof(Header)
+		uint64_t layoutHash;			// 顶点输入布局的哈希
+		uint32_t vertexStride;			// 顶点字节大小
+		uint32_t indexSize;				// 索引字节大小
+		uint64_t vertexCount;			// 顶点数目
+		uint64_t indexCount;			// 索引数目
+		uint64_t materialTableSize;		// 紧跟在文件头之后的材质分组表的字节数
+		uint64_t vertexOffset;			// 顶点数据块的文件偏移(页对齐)
+		uint64_t indexOffset;			// 索引数据块的文件偏移(页对齐)
+		uint64_t vertexBlobSize;		// 压缩后顶点数据块的字节数
+		uint64_t indexBlobSize;			// 压缩后索引数据块的字节数
+		uint64_t sourceSize;			// 源文件字节数
+		uint64_t sourceHash;			// 源文件内容的哈希
+		DirectX::XMFLOAT3 boundsMin;	// 包围盒最小点
+		DirectX::XMFLOAT3 boundsMax;	// 包围盒最大点
+	};
+
+	// 计算一段内存的64位哈希
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+	// 计算顶点输入布局的哈希，顶点结构体变化后旧缓存即失效
+	template<class VertexType>
+	uint64_t LayoutHash();
+
+	// 源文件对应的缓存路径，文件名含顶点布局哈希与索引字节数，
+	// 同一模型以不同顶点格式加载时各自使用独立的缓存，不会相互覆盖
+	std::string GetCachePath(const std::string& sourcePath, uint64_t layoutHash, uint32_t indexSize);
+	template<class VertexType, class IndexType>
+	std::string GetCachePath(const std::string& sourcePath);
+
+	// 读取缓存，若缓存不存在、版本或布局不符、或源文件哈希不匹配则返回false
+	// pMaterials不为nullptr时读出材质分组
+	template<class VertexType, class IndexType>
+	bool Load(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash,
+		std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+		ObjReader::MaterialGroups* pMaterials = nullptr, Header* pHeader = nullptr);
+
+	// 写入缓存，失败时返回false(例如目录只读)，不影响正常加载
+	// 材质分组只保存材质库与材质的名字，材质参数在每次加载时重新从材质库读取
+	template<class VertexType, class IndexType>
+	bool Save(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash,
+		const std::vector<VertexType>& vertices, const std::vector<IndexType>& indices,
+		const ObjReader::MaterialGroups* pMaterials = nullptr);
+
+	namespace Internal
+	{
+		// 校验映射后的缓存文件，返回文件头；不匹配时返回nullptr
+		const Header* Validate(const MappedFile& file, const Header& expected);
+		// 写出文件头、材质分组表与两个页对齐的数据块，各部分大小取自header中的materialTableSize、vertexBlobSize与indexBlobSize
+		bool WriteBlobs(const std::string& cachePath, Header& header,
+			const void* materialTable, const void* vertexData, const void* indexData);
+		// 材质分组表的序列化，各字符串以32位长度开头
+		std::vector<uint8_t> EncodeMaterialTable(const ObjReader::MaterialGroups& materials);
+		// 反序列化材质分组表，数据损坏或索引范围超出indexCount时返回false
+		bool DecodeMaterialTable(const uint8_t* data, size_t size, uint64_t indexCount, ObjReader::MaterialGroups& materials);
+		// 填写除数据块偏移外的文件头
+		Header MakeHeader(uint64_t layoutHash, uint32_t vertexStride, uint32_t indexSize,
+			uint64_t vertexCount, uint64_t indexCount, uint64_t sourceSize, uint64_t sourceHash);
+	}
+}
+
+namespace MeshCache
+{
+	template<class VertexType>
+	inline uint64_t LayoutHash()
+	{
+		uint64_t hash = HashBytes(nullptr, 0);
+		for (const D3D11_INPUT_ELEMENT_DESC& desc : VertexType::inputLayout)
+		{
+			hash = HashBytes(desc.SemanticName, strlen(desc.SemanticName), hash);
+			uint32_t fields[3] = { desc.SemanticIndex, static_cast<uint32_t>(desc.Format), desc.AlignedByteOffset };
+			hash = HashBytes(fields, sizeof(fields), hash);
+		}
+		return hash;
+	}
+
+	template<class VertexType, class IndexType>
+	inline std::string GetCachePath(const std::string& sourcePath)
+	{
+		return GetCachePath(sourcePath, LayoutHash<VertexType>(), sizeof(IndexType));
+	}
+
+	template<class VertexType, class IndexType>
+	inline bool Load(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash,
+		std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+		ObjReader::MaterialGroups* pMaterials, Header* pHeader)
+	{
+		Header expected = Internal::MakeHeader(LayoutHash<VertexType>(), sizeof(VertexType), sizeof(IndexType),
+			0, 0, sourceSize, sourceHash);
+		MappedFile file;
+		if (!file.Open(cachePath))
+			return false;
+		const Header* header = Internal::Validate(file, expected);
+		if (!header)
+			return false;
+
+		// 直接从映射区域解码，数据损坏时视为缓存失效
+		const uint8_t* vertexBlob = reinterpret_cast<const uint8_t*>(file.Begin() + header->vertexOffset);
+		const uint8_t* indexBlob = reinterpret_cast<const uint8_t*>(file.Begin() + header->indexOffset);
+		if (!MeshCodec::DecodeVertexBuffer(vertices, static_cast<size_t>(header->vertexCount), vertexBlob, static_cast<size_t>(header->vertexBlobSize)) ||
+			!MeshCodec::DecodeIndexBuffer(indices, static_cast<size_t>(header->indexCount), indexBlob, static_cast<size_t>(header->indexBlobSize)))
+		{
+			vertices.clear();
+			indices.clear();
+			return false;
+		}
+		if (pMaterials)
+		{
+			const uint8_t* materialTable = reinterpret_cast<const uint8_t*>(file.Begin() + sizeof(Header));
+			if (!Internal::DecodeMaterialTable(materialTable, static_cast<size_t>(header->materialTableSize), header->indexCount, *pMaterials))
+			{
+				vertices.clear();
+				indices.clear();
+				return false;
+			}
+		}
+		if (pHeader)
+			*pHeader = *header;
+		return true;
+	}
+
+	template<class VertexType, class IndexType>
+	inline bool Save(const std::string& cachePath, uint64_t sourceSize, uint64_t sourceHash,
+		const std::vector<VertexType>& vertices, const std::vector<IndexType>& indices,
+		const ObjReader::MaterialGroups* pMaterials)
+	{
+		Header header = Internal::MakeHeader(LayoutHash<VertexType>(), sizeof(VertexType), sizeof(IndexType),
+			vertices.size(), indices.size(), sourceSize, sourceHash);
+
+		// 包围盒
+		if (!vertices.empty())
+		{
+			header.boundsMin = header.boundsMax = vertices[0].pos;
+			for (const VertexType& vertex : vertices)
+			{
+				header.boundsMin.x = vertex.pos.x < header.boundsMin.x ? vertex.pos.x : header.boundsMin.x;
+				header.boundsMin.y = vertex.pos.y < header.boundsMin.y ? vertex.pos.y : header.boundsMin.y;
+				header.boundsMin.z = vertex.pos.z < header.boundsMin.z ? vertex.pos.z : header.boundsMin.z;
+				header.boundsMax.x = vertex.pos.x > header.boundsMax.x ? vertex.pos.x : header.boundsMax.x;
+				header.boundsMax.y = vertex.pos.y > header.boundsMax.y ? vertex.pos.y : header.boundsMax.y;
+				header.boundsMax.z = vertex.pos.z > header.boundsMax.z ? vertex.pos.z : header.boundsMax.z;
+			}
+		}
+
+		std::vector<uint8_t> materialTable = Internal::EncodeMaterialTable(pMaterials ? *pMaterials : ObjReader::MaterialGroups());
+		std::vector<uint8_t> vertexBlob = MeshCodec::EncodeVertexBuffer(vertices);
+		std::vector<uint8_t> indexBlob = MeshCodec::EncodeIndexBuffer(indices);
+		header.materialTableSize = materialTable.size();
+		header.vertexBlobSize = vertexBlob.size();
+		header.indexBlobSize = indexBlob.size();
+		return Internal::WriteBlobs(cachePath, header, materialTable.data(), vertexBlob.data(), indexBlob.data());
+	}
+}
+
+#endif
@@ -0,0 +1,535 @@
+#include "MeshCodec.h"
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include "ThreadPool.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHCODEC_SSE2
+#endif
+
+namespace
+{
+	//
+	// 索引编码
+	//
+	// 每个三角形以一个编码字节开头：
+	//   低4位为命中的边在边FIFO中的位置(0为最新)，15表示未命中
+	//   命中时，第4~5位为三角形的旋转(命中的边是第几条边)，第6~7位为第三个顶点的编码方式
+	//   未命中时，其后跟一个字节，依次以2位保存三个顶点的编码方式
+	// 之后按顺序跟随各顶点编码方式所需的附加数据
+	//
+
+	// FIFO容量
+	constexpr uint32_t FifoSize = 16;
+	// 边FIFO未命中的编码，边FIFO只能引用最新的15条边
+	constexpr uint32_t EdgeMiss = 15;
+	// 空的FIFO项
+	constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+	// 顶点的编码方式
+	enum VertexKind : uint32_t
+	{
+		KindNext = 0,		// 尚未出现过的下一个顶点，无附加数据
+		KindFifo = 1,		// 顶点FIFO中的顶点，附加1字节位置
+		KindExplicit = 2	// 相对下一个顶点的差值，附加zigzag变长整数
+	};
+
+	struct Edge
+	{
+		uint32_t a, b;
+	};
+
+	// 编码端与解码端以相同顺序更新的状态
+	struct IndexCoderState
+	{
+		Edge edges[FifoSize];
+		uint32_t vertices[FifoSize];
+		uint32_t edgeHead = 0;
+		uint32_t vertexHead = 0;
+		uint32_t next = 0;		// 大于所有已出现顶点的最小索引
+
+		IndexCoderState()
+		{
+			for (uint32_t i = 0; i < FifoSize; ++i)
+			{
+				edges[i] = { InvalidIndex, InvalidIndex };
+				vertices[i] = InvalidIndex;
+			}
+		}
+
+		void PushEdge(uint32_t a, uint32_t b)
+		{
+			edges[edgeHead] = { a, b };
+			edgeHead = (edgeHead + 1) % FifoSize;
+		}
+
+		void PushVertex(uint32_t v)
+		{
+			vertices[vertexHead] = v;
+			vertexHead = (vertexHead + 1) % FifoSize;
+		}
+
+		// 第i新的边/顶点
+		const Edge& GetEdge(uint32_t i) const { return edges[(edgeHead + FifoSize - 1 - i) % FifoSize]; }
+		uint32_t GetVertex(uint32_t i) const { return vertices[(vertexHead + FifoSize - 1 - i) % FifoSize]; }
+	};
+
+	inline uint64_t ZigZag(int64_t value)
+	{
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	inline int64_t UnZigZag(uint64_t value)
+	{
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+
+	inline uint8_t* WriteVarint(uint8_t* p, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			*p++ = static_cast<uint8_t>(value | 0x80);
+			value >>= 7;
+		}
+		*p++ = static_cast<uint8_t>(value);
+		return p;
+	}
+
+	inline bool ReadVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+	{
+		value = 0;
+		for (uint32_t shift = 0; shift < 64; shift += 7)
+		{
+			if (p == end)
+				return false;
+			uint8_t byte = *p++;
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	// 选择顶点的编码方式并更新状态，附加数据写入extra
+	uint32_t EncodeVertex(IndexCoderState& state, uint32_t v, uint8_t*& extra)
+	{
+		if (v == state.next)
+		{
+			++state.next;
+			state.PushVertex(v);
+			return KindNext;
+		}
+		for (uint32_t i = 0; i < FifoSize; ++i)
+		{
+			if (state.GetVertex(i) == v)
+			{
+				*extra++ = static_cast<uint8_t>(i);
+				return KindFifo;
+			}
+		}
+		extra = WriteVarint(extra, ZigZag(static_cast<int64_t>(v) - static_cast<int64_t>(state.next)));
+		if (v >= state.next)
+			state.next = v + 1;
+		state.PushVertex(v);
+		return KindExplicit;
+	}
+
+	bool DecodeVertex(IndexCoderState& state, uint32_t kind, const uint8_t*& p, const uint8_t* end, uint32_t& v)
+	{
+		switch (kind)
+		{
+		case KindNext:
+			if (state.next == InvalidIndex)
+				return false;
+			v = state.next++;
+			state.PushVertex(v);
+			return true;
+		case KindFifo:
+			if (p == end || *p >= FifoSize)
+				return false;
+			v = state.GetVertex(*p++);
+			return v != InvalidIndex;
+		case KindExplicit:
+		{
+			uint64_t code;
+			if (!ReadVarint(p, end, code))
+				return false;
+			int64_t value = static_cast<int64_t>(state.next) + UnZigZag(code);
+			if (value < 0 || value >= static_cast<int64_t>(InvalidIndex))
+				return false;
+			v = static_cast<uint32_t>(value);
+			if (v >= state.next)
+				state.next = v + 1;
+			state.PushVertex(v);
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	//
+	// 顶点编码
+	//
+	// 顶点按VertexBlockSize个一块，每块以4字节的块数据长度开头，其后依次为各字节平面：
+	//   平面内每个顶点的该字节与前一顶点之差经zigzag映射后，每16个一组选择0/2/4/8位宽打包
+	//   平面开头是各组的位宽编码(每组2位)，其后是各组的打包数据
+	// 每块的第一个顶点与0做差分，因此各块可以独立解码
+	//
+
+	constexpr size_t GroupSize = 16;
+	// 位宽编码对应的位数
+	constexpr uint32_t GroupBits[4] = { 0, 2, 4, 8 };
+	// 并行解码的粒度(块数目)
+	constexpr size_t DecodeGrainSize = 16;
+
+	inline uint8_t ZigZag8(uint8_t delta)
+	{
+		return static_cast<uint8_t>((delta << 1) ^ static_cast<uint8_t>(static_cast<int8_t>(delta) >> 7));
+	}
+
+	inline uint8_t UnZigZag8(uint8_t value)
+	{
+		return static_cast<uint8_t>((value >> 1) ^ (0u - (value & 1u)));
+	}
+
+	// 一个平面中各组的打包数据字节数
+	inline size_t GroupBytes(uint32_t bitsCode)
+	{
+		return GroupSize * GroupBits[bitsCode] / 8;
+	}
+
+	void EncodeVertexBlock(const uint8_t* vertices, size_t vertexCount, size_t vertexStride, std::vector<uint8_t>& out)
+	{
+		size_t groupCount = (vertexCount + GroupSize - 1) / GroupSize;
+		size_t headerSize = (groupCount + 3) / 4;
+		uint8_t deltas[MeshCodec::VertexBlockSize];
+
+		for (size_t k = 0; k < vertexStride; ++k)
+		{
+			memset(deltas, 0, sizeof(deltas));
+			uint8_t prev = 0;
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				uint8_t curr = vertices[i * vertexStride + k];
+				deltas[i] = ZigZag8(static_cast<uint8_t>(curr - prev));
+				prev = curr;
+			}
+
+			size_t headerPos = out.size();
+			out.resize(headerPos + headerSize, 0);
+			for (size_t g = 0; g < groupCount; ++g)
+			{
+				const uint8_t* group = deltas + g * GroupSize;
+				uint8_t bitsOr = 0;
+				for (size_t j = 0; j < GroupSize; ++j)
+					bitsOr |= group[j];
+				uint32_t bitsCode = bitsOr == 0 ? 0 : bitsOr < 4 ? 1 : bitsOr < 16 ? 2 : 3;
+				out[headerPos + g / 4] |= static_cast<uint8_t>(bitsCode << (g % 4 * 2));
+
+				size_t dataPos = out.size();
+				out.resize(dataPos + GroupBytes(bitsCode), 0);
+				uint8_t* data = out.data() + dataPos;
+				switch (bitsCode)
+				{
+				case 1:
+					for (size_t j = 0; j < GroupSize; ++j)
+						data[j / 4] |= static_cast<uint8_t>(group[j] << (j % 4 * 2));
+					break;
+				case 2:
+					for (size_t j = 0; j < GroupSize; ++j)
+						data[j / 2] |= static_cast<uint8_t>(group[j] << (j % 2 * 4));
+					break;
+				case 3:
+					memcpy(data, group, GroupSize);
+					break;
+				}
+			}
+		}
+	}
+
+	// 解码一组16个差值，完成zigzag逆映射与前缀和，prev为前一个顶点的该字节，返回本组最后一个值
+#if defined(MESHCODEC_SSE2)
+	inline uint8_t DecodeGroup(uint32_t bitsCode, const uint8_t* data, uint8_t prev, uint8_t* out)
+	{
+		__m128i v;
+		switch (bitsCode)
+		{
+		case 0:
+			v = _mm_setzero_si128();
+			break;
+		case 1:
+		{
+			// 每字节4个2位值，依次展开后按字节、再按16位交错恢复原顺序
+			int packed;
+			memcpy(&packed, data, sizeof(int));
+			__m128i bytes = _mm_cvtsi32_si128(packed);
+			__m128i mask = _mm_set1_epi8(3);
+			__m128i s0 = _mm_and_si128(bytes, mask);
+			__m128i s1 = _mm_and_si128(_mm_srli_epi16(bytes, 2), mask);
+			__m128i s2 = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+			__m128i s3 = _mm_and_si128(_mm_srli_epi16(bytes, 6), mask);
+			v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(s0, s1), _mm_unpacklo_epi8(s2, s3));
+			break;
+		}
+		case 2:
+		{
+			__m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+			__m128i mask = _mm_set1_epi8(15);
+			v = _mm_unpacklo_epi8(_mm_and_si128(bytes, mask), _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+			break;
+		}
+		default:
+			v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+			break;
+		}
+
+		// zigzag逆映射：(v >> 1) ^ -(v & 1)
+		__m128i one = _mm_set1_epi8(1);
+		__m128i half = _mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi8(0x7F));
+		v = _mm_xor_si128(half, _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, one)));
+
+		// 16字节的前缀和
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+		v = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(prev)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+		return out[GroupSize - 1];
+	}
+#else
+	inline uint8_t DecodeGroup(uint32_t bitsCode, const uint8_t* data, uint8_t prev, uint8_t* out)
+	{
+		for (size_t j = 0; j < GroupSize; ++j)
+		{
+			uint8_t value;
+			switch (bitsCode)
+			{
+			case 0: value = 0; break;
+			case 1: value = (data[j / 4] >> (j % 4 * 2)) & 3; break;
+			case 2: value = (data[j / 2] >> (j % 2 * 4)) & 15; break;
+			default: value = data[j]; break;
+			}
+			prev = static_cast<uint8_t>(prev + UnZigZag8(value));
+			out[j] = prev;
+		}
+		return prev;
+	}
+#endif
+
+	// planes为vertexStride * VertexBlockSize字节的临时空间，先按平面解码，再转置为顶点数组
+	bool DecodeVertexBlock(uint8_t* vertices, size_t vertexCount, size_t vertexStride, const uint8_t* p, const uint8_t* end, uint8_t* planes)
+	{
+		size_t groupCount = (vertexCount + GroupSize - 1) / GroupSize;
+		size_t headerSize = (groupCount + 3) / 4;
+
+		for (size_t k = 0; k < vertexStride; ++k)
+		{
+			if (static_cast<size_t>(end - p) < headerSize)
+				return false;
+			const uint8_t* header = p;
+			p += headerSize;
+
+			uint8_t* plane = planes + k * MeshCodec::VertexBlockSize;
+			uint8_t prev = 0;
+			for (size_t g = 0; g < groupCount; ++g)
+			{
+				uint32_t bitsCode = (header[g / 4] >> (g % 4 * 2)) & 3;
+				size_t groupBytes = GroupBytes(bitsCode);
+				// SIMD读取可能越过组的末尾，剩余数据不足16字节时先复制出来
+				uint8_t padded[GroupSize] = {};
+				const uint8_t* data = p;
+				if (static_cast<size_t>(end - p) < GroupSize)
+				{
+					if (static_cast<size_t>(end - p) < groupBytes)
+						return false;
+					memcpy(padded, p, groupBytes);
+					data = padded;
+				}
+				prev = DecodeGroup(bitsCode, data, prev, plane + g * GroupSize);
+				p += groupBytes;
+			}
+		}
+		if (p != end)
+			return false;
+
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			uint8_t* vertex = vertices + i * vertexStride;
+			for (size_t k = 0; k < vertexStride; ++k)
+				vertex[k] = planes[k * MeshCodec::VertexBlockSize + i];
+		}
+		return true;
+	}
+}
+
+std::vector<uint8_t> MeshCodec::EncodeIndices(const uint32_t* indices, size_t indexCount)
+{
+	std::vector<uint8_t> out;
+	out.reserve(indexCount / 2 + 16);
+	IndexCoderState state;
+	// 一个三角形最多2个编码字节与3个10字节的变长整数
+	uint8_t extra[32];
+
+	size_t triangleCount = indexCount / 3;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		const uint32_t* tri = indices + t * 3;
+		uint8_t* p = extra;
+
+		// 尝试以三角形的某条边匹配最近的边，相邻三角形共享的边方向相反
+		bool hit = false;
+		for (uint32_t rotation = 0; rotation < 3 && !hit; ++rotation)
+		{
+			uint32_t x = tri[rotation], y = tri[(rotation + 1) % 3], z = tri[(rotation + 2) % 3];
+			for (uint32_t e = 0; e < EdgeMiss; ++e)
+			{
+				const Edge& edge = state.GetEdge(e);
+				if (edge.a == y && edge.b == x)
+				{
+					uint32_t kind = EncodeVertex(state, z, p);
+					out.push_back(static_cast<uint8_t>(e | (rotation << 4) | (kind << 6)));
+					state.PushEdge(y, z);
+					state.PushEdge(z, x);
+					hit = true;
+					break;
+				}
+			}
+		}
+
+		if (!hit)
+		{
+			uint32_t kinds = 0;
+			for (uint32_t i = 0; i < 3; ++i)
+				kinds |= EncodeVertex(state, tri[i], p) << (i * 2);
+			out.push_back(static_cast<uint8_t>(EdgeMiss));
+			out.push_back(static_cast<uint8_t>(kinds));
+			state.PushEdge(tri[0], tri[1]);
+			state.PushEdge(tri[1], tri[2]);
+			state.PushEdge(tri[2], tri[0]);
+		}
+		out.insert(out.end(), extra, p);
+	}
+
+	// 不足一个三角形的尾部索引直接保存
+	for (size_t i = triangleCount * 3; i < indexCount; ++i)
+	{
+		uint8_t* p = WriteVarint(extra, indices[i]);
+		out.insert(out.end(), extra, p);
+	}
+	return out;
+}
+
+bool MeshCodec::DecodeIndices(uint32_t* indices, size_t indexCount, const uint8_t* data, size_t size)
+{
+	const uint8_t* p = data;
+	const uint8_t* end = data + size;
+	IndexCoderState state;
+
+	size_t triangleCount = indexCount / 3;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		if (p == end)
+			return false;
+		uint32_t code = *p++;
+		uint32_t* tri = indices + t * 3;
+
+		uint32_t e = code & 15;
+		if (e != EdgeMiss)
+		{
+			uint32_t rotation = (code >> 4) & 3;
+			const Edge edge = state.GetEdge(e);
+			if (rotation == 3 || edge.a == InvalidIndex)
+				return false;
+			uint32_t x = edge.b, y = edge.a, z;
+			if (!DecodeVertex(state, code >> 6, p, end, z))
+				return false;
+			tri[rotation] = x;
+			tri[(rotation + 1) % 3] = y;
+			tri[(rotation + 2) % 3] = z;
+			state.PushEdge(y, z);
+			state.PushEdge(z, x);
+		}
+		else
+		{
+			if (code != EdgeMiss || p == end)
+				return false;
+			uint32_t kinds = *p++;
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				if (!DecodeVertex(state, (kinds >> (i * 2)) & 3, p, end, tri[i]))
+					return false;
+			}
+			state.PushEdge(tri[0], tri[1]);
+			state.PushEdge(tri[1], tri[2]);
+			state.PushEdge(tri[2], tri[0]);
+		}
+	}
+
+	for (size_t i = triangleCount * 3; i < indexCount; ++i)
+	{
+		uint64_t value;
+		if (!ReadVarint(p, end, value) || value >= InvalidIndex)
+			return false;
+		indices[i] = static_cast<uint32_t>(value);
+	}
+	return p == end;
+}
+
+std::vector<uint8_t> MeshCodec::EncodeVertices(const void* vertices, size_t vertexCount, size_t vertexStride)
+{
+	const uint8_t* src = static_cast<const uint8_t*>(vertices);
+	std::vector<uint8_t> out;
+	out.reserve(vertexCount * vertexStride / 2 + 16);
+	for (size_t start = 0; start < vertexCount; start += VertexBlockSize)
+	{
+		size_t count = (std::min)(VertexBlockSize, vertexCount - start);
+		size_t sizePos = out.size();
+		out.resize(sizePos + sizeof(uint32_t));
+		EncodeVertexBlock(src + start * vertexStride, count, vertexStride, out);
+		uint32_t blockSize = static_cast<uint32_t>(out.size() - sizePos - sizeof(uint32_t));
+		memcpy(out.data() + sizePos, &blockSize, sizeof(uint32_t));
+	}
+	return out;
+}
+
+bool MeshCodec::DecodeVertices(void* vertices, size_t vertexCount, size_t vertexStride, const uint8_t* data, size_t size)
+{
+	// 先遍历块长度得到每块的起始位置
+	size_t blockCount = (vertexCount + VertexBlockSize - 1) / VertexBlockSize;
+	std::vector<size_t> blockOffsets(blockCount + 1);
+	size_t offset = 0;
+	for (size_t b = 0; b < blockCount; ++b)
+	{
+		uint32_t blockSize;
+		if (size - offset < sizeof(uint32_t))
+			return false;
+		memcpy(&blockSize, data + offset, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+		if (size - offset < blockSize)
+			return false;
+		blockOffsets[b] = offset;
+		offset += blockSize;
+	}
+	if (offset != size)
+		return false;
+	blockOffsets[blockCount] = size + sizeof(uint32_t);
+
+	uint8_t* dst = static_cast<uint8_t*>(vertices);
+	std::atomic<bool> success{ true };
+	ThreadPool::Get().ParallelFor(blockCount, DecodeGrainSize, [&](size_t begin, size_t end) {
+		std::vector<uint8_t> planes(vertexStride * VertexBlockSize);
+		for (size_t b = begin; b < end; ++b)
+		{
+			size_t start = b * VertexBlockSize;
+			size_t count = (std::min)(VertexBlockSize, vertexCount - start);
+			const uint8_t* blockEnd = data + blockOffsets[b + 1] - sizeof(uint32_t);
+			if (!DecodeVertexBlock(dst + start * vertexStride, count, vertexStride, data + blockOffsets[b], blockEnd, planes.data()))
+				success = false;
+		}
+	});
+	return success;
+}
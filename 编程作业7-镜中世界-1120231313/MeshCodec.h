@@ -0,0 +1,105 @@
+//***************************************************************************************
+// MeshCodec.h
+//
+// 索引/顶点数据的无损压缩编解码，用于磁盘上的网格资源
+// Lossless index/vertex stream codec for on-disk mesh assets.
+//***************************************************************************************
+
+#ifndef MESHCODEC_H
+#define MESHCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <type_traits>
+
+namespace MeshCodec
+{
+	// 顶点数据按块编码，每块的顶点数目，块之间互不依赖，可以并行解码
+	static constexpr size_t VertexBlockSize = 256;
+
+	// 编码三角形列表的索引：每个三角形优先复用最近三角形的一条边(边FIFO)，
+	// 剩余的顶点依次尝试"下一个新顶点"、最近顶点(顶点FIFO)与增量变长整数
+	// 三角形顺序与三角形内的顶点顺序都被原样保留，索引数目不是3的倍数时尾部单独保存
+	std::vector<uint8_t> EncodeIndices(const uint32_t* indices, size_t indexCount);
+	// 解码索引到indices中，indexCount需与编码时相同，数据不完整或损坏时返回false
+	bool DecodeIndices(uint32_t* indices, size_t indexCount, const uint8_t* data, size_t size);
+
+	// 编码顶点数据：按字节平面与前一顶点做差分，再按每16个差值一组以0/2/4/8位打包
+	// 对经过顶点读取顺序优化的网格效果最好
+	std::vector<uint8_t> EncodeVertices(const void* vertices, size_t vertexCount, size_t vertexStride);
+	// 解码顶点数据到vertices中，vertexCount与vertexStride需与编码时相同，数据不完整或损坏时返回false
+	// 顶点块较多时在线程池上并行解码
+	bool DecodeVertices(void* vertices, size_t vertexCount, size_t vertexStride, const uint8_t* data, size_t size);
+
+	// 按索引类型编码/解码索引数组
+	template<class IndexType>
+	std::vector<uint8_t> EncodeIndexBuffer(const std::vector<IndexType>& indices);
+	template<class IndexType>
+	bool DecodeIndexBuffer(std::vector<IndexType>& indices, size_t indexCount, const uint8_t* data, size_t size);
+
+	// 编码/解码顶点数组
+	template<class VertexType>
+	std::vector<uint8_t> EncodeVertexBuffer(const std::vector<VertexType>& vertices);
+	template<class VertexType>
+	bool DecodeVertexBuffer(std::vector<VertexType>& vertices, size_t vertexCount, const uint8_t* data, size_t size);
+}
+
+namespace MeshCodec
+{
+	template<class IndexType>
+	inline std::vector<uint8_t> EncodeIndexBuffer(const std::vector<IndexType>& indices)
+	{
+		static_assert(std::is_unsigned<IndexType>::value && sizeof(IndexType) <= 4, "IndexType must be WORD or DWORD!");
+		if constexpr (sizeof(IndexType) == sizeof(uint32_t))
+		{
+			return EncodeIndices(reinterpret_cast<const uint32_t*>(indices.data()), indices.size());
+		}
+		else
+		{
+			std::vector<uint32_t> wideIndices(indices.begin(), indices.end());
+			return EncodeIndices(wideIndices.data(), wideIndices.size());
+		}
+	}
+
+	template<class IndexType>
+	inline bool DecodeIndexBuffer(std::vector<IndexType>& indices, size_t indexCount, const uint8_t* data, size_t size)
+	{
+		static_assert(std::is_unsigned<IndexType>::value && sizeof(IndexType) <= 4, "IndexType must be WORD or DWORD!");
+		indices.resize(indexCount);
+		if constexpr (sizeof(IndexType) == sizeof(uint32_t))
+		{
+			return DecodeIndices(reinterpret_cast<uint32_t*>(indices.data()), indexCount, data, size);
+		}
+		else
+		{
+			std::vector<uint32_t> wideIndices(indexCount);
+			if (!DecodeIndices(wideIndices.data(), indexCount, data, size))
+				return false;
+			for (size_t i = 0; i < indexCount; ++i)
+			{
+				if (wideIndices[i] > static_cast<uint32_t>(IndexType(~IndexType(0))))
+					return false;
+				indices[i] = static_cast<IndexType>(wideIndices[i]);
+			}
+			return true;
+		}
+	}
+
+	template<class VertexType>
+	inline std::vector<uint8_t> EncodeVertexBuffer(const std::vector<VertexType>& vertices)
+	{
+		static_assert(std::is_trivially_copyable<VertexType>::value, "VertexType must be trivially copyable!");
+		return EncodeVertices(vertices.data(), vertices.size(), sizeof(VertexType));
+	}
+
+	template<class VertexType>
+	inline bool DecodeVertexBuffer(std::vector<VertexType>& vertices, size_t vertexCount, const uint8_t* data, size_t size)
+	{
+		static_assert(std::is_trivially_copyable<VertexType>::value, "VertexType must be trivially copyable!");
+		vertices.resize(vertexCount);
+		return DecodeVertices(vertices.data(), vertexCount, sizeof(VertexType), data, size);
+	}
+}
+
+#endif
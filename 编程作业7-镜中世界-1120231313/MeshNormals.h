@@ -0,0 +1,340 @@
+//***************************************************************************************
+// MeshNormals.h
+//
+// 角度加权的平滑法线与MikkTSpace方式的切线生成
+// Angle-weighted smooth normal and MikkTSpace-style tangent generation.
+//***************************************************************************************
+
+#ifndef MESHNORMALS_H
+#define MESHNORMALS_H
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <Windows.h>
+#include <DirectXMath.h>
+#include "ThreadPool.h"
+
+namespace MeshNormals
+{
+	// 默认的折痕角，相邻面的法线夹角超过该值时共享的边保持为硬边
+	static constexpr float DefaultCreaseAngle = DirectX::XM_PI / 3.0f;
+
+	// 顶点类型是否含有normal成员
+	template<class VertexType, class = void>
+	struct HasNormal : std::false_type {};
+	template<class VertexType>
+	struct HasNormal<VertexType, decltype(void(std::declval<VertexType&>().normal))> : std::true_type {};
+
+	// 顶点类型是否含有normal、tangent与tex成员
+	template<class VertexType, class = void>
+	struct HasTangentSpace : std::false_type {};
+	template<class VertexType>
+	struct HasTangentSpace<VertexType, decltype(void(std::declval<VertexType&>().normal),
+		void(std::declval<VertexType&>().tangent), void(std::declval<VertexType&>().tex))> : std::true_type {};
+
+	// 由三角形各角点所在的位置生成角度加权的平滑法线，返回每个角点的单位法线
+	// 坐标相同的位置视为同一位置，只有法线与该角点所在三角形的法线夹角不超过creaseAngle的三角形参与平滑
+	// threaded为false时在当前线程上执行，结果与多线程执行逐位相同，可作为标量参考
+	std::vector<DirectX::XMFLOAT3> GenerateCornerNormals(const std::vector<DirectX::XMFLOAT3>& positions,
+		const std::vector<UINT>& cornerPositions, float creaseAngle = DefaultCreaseAngle, bool threaded = true);
+
+	// 为网格生成平滑法线并写入顶点，位置相同的顶点之间也会平滑
+	// 同一顶点在折痕两侧得到不同法线时会被复制拆分，索引随之改写
+	template<class VertexType, class IndexType>
+	void GenerateNormals(std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+		float creaseAngle = DefaultCreaseAngle, bool threaded = true);
+
+	// 按MikkTSpace的方式生成切线：逐角点将三角形的纹理空间切线投影到顶点法线的切平面上按角度加权平均，
+	// 同一顶点上纹理空间手性相同的角点共享切线，手性不同时拆分顶点
+	// tangent.w为副切线的符号，副切线 = tangent.w * cross(normal, tangent.xyz)
+	template<class VertexType, class IndexType>
+	void GenerateTangents(std::vector<VertexType>& vertices, std::vector<IndexType>& indices, bool threaded = true);
+}
+
+namespace MeshNormals
+{
+	namespace Internal
+	{
+		//
+		// 以下函数仅供内部实现使用
+		//
+
+		// 并行任务的粒度(三角形或角点数目)
+		static constexpr size_t GrainSize = 4096;
+
+		// 在线程池上或当前线程上处理[0, count)
+		template<class Func>
+		inline void ForRanges(size_t count, bool threaded, const Func& func)
+		{
+			if (threaded)
+				ThreadPool::Get().ParallelFor(count, GrainSize, func);
+			else if (count > 0)
+				func(size_t(0), count);
+		}
+
+		// 按键值对角点做计数排序，得到每个键对应的角点列表，同一键内角点保持升序
+		inline void BuildCornerLists(const UINT* cornerKeys, size_t cornerCount, size_t keyCount,
+			std::vector<UINT>& offsets, std::vector<UINT>& corners)
+		{
+			offsets.assign(keyCount + 1, 0);
+			for (size_t i = 0; i < cornerCount; ++i)
+				++offsets[cornerKeys[i] + 1];
+			for (size_t i = 0; i < keyCount; ++i)
+				offsets[i + 1] += offsets[i];
+			corners.resize(cornerCount);
+			std::vector<UINT> fillOffsets(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < cornerCount; ++i)
+				corners[fillOffsets[cornerKeys[i]]++] = static_cast<UINT>(i);
+		}
+
+		// 三角形在三个角点处的内角
+		inline void CornerAngles(DirectX::FXMVECTOR p0, DirectX::FXMVECTOR p1, DirectX::FXMVECTOR p2, float angles[3])
+		{
+			using namespace DirectX;
+			XMVECTOR e01 = XMVector3Normalize(p1 - p0), e02 = XMVector3Normalize(p2 - p0), e12 = XMVector3Normalize(p2 - p1);
+			angles[0] = acosf((std::max)(-1.0f, (std::min)(1.0f, XMVectorGetX(XMVector3Dot(e01, e02)))));
+			angles[1] = acosf((std::max)(-1.0f, (std::min)(1.0f, -XMVectorGetX(XMVector3Dot(e01, e12)))));
+			angles[2] = DirectX::XM_PI - angles[0] - angles[1];
+		}
+
+		// 与n垂直的任一单位向量
+		inline DirectX::XMVECTOR AnyPerpendicular(DirectX::FXMVECTOR n)
+		{
+			using namespace DirectX;
+			XMVECTOR axis = fabsf(XMVectorGetX(n)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+			return XMVector3Normalize(XMVector3Cross(axis, n));
+		}
+
+		// 将每个角点的属性写回顶点：同一顶点的角点属性相同时共享，不同时复制出新顶点并改写索引
+		template<class VertexType, class IndexType, class Attribute, class Assign>
+		inline void AssignCornerAttributes(std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+			const std::vector<Attribute>& cornerValues, const Assign& assign)
+		{
+			static constexpr size_t noCopy = ~size_t(0);
+			std::vector<Attribute> vertexValues(vertices.size());
+			std::vector<bool> assigned(vertices.size());
+			std::vector<size_t> nextCopy(vertices.size(), noCopy);
+			for (size_t c = 0; c < indices.size(); ++c)
+			{
+				const Attribute& value = cornerValues[c];
+				size_t vertex = indices[c];
+				if (!assigned[vertex])
+				{
+					assigned[vertex] = true;
+					vertexValues[vertex] = value;
+					assign(vertices[vertex], value);
+					continue;
+				}
+
+				// 在该顶点及其副本中查找属性相同的
+				size_t last = vertex;
+				while (vertex != noCopy && memcmp(&vertexValues[vertex], &value, sizeof(Attribute)) != 0)
+				{
+					last = vertex;
+					vertex = nextCopy[vertex];
+				}
+				if (vertex == noCopy)
+				{
+					vertex = vertices.size();
+					if (vertex > static_cast<size_t>(static_cast<IndexType>(~IndexType(0))))
+						throw std::runtime_error("Too many vertices for the index type.");
+					vertices.push_back(vertices[last]);
+					vertexValues.push_back(value);
+					assigned.push_back(true);
+					nextCopy.push_back(noCopy);
+					nextCopy[last] = vertex;
+					assign(vertices.back(), value);
+				}
+				indices[c] = static_cast<IndexType>(vertex);
+			}
+		}
+
+		// 为坐标相同的位置分配相同的编号
+		inline std::vector<UINT> WeldPositions(const std::vector<DirectX::XMFLOAT3>& positions, size_t& positionCount)
+		{
+			std::vector<UINT> order(positions.size());
+			for (size_t i = 0; i < positions.size(); ++i)
+				order[i] = static_cast<UINT>(i);
+			auto lessPos = [&positions](UINT lhs, UINT rhs)
+			{
+				const DirectX::XMFLOAT3& a = positions[lhs];
+				const DirectX::XMFLOAT3& b = positions[rhs];
+				return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+			};
+			std::sort(order.begin(), order.end(), lessPos);
+
+			std::vector<UINT> positionIds(positions.size());
+			positionCount = 0;
+			for (size_t i = 0; i < order.size(); ++i)
+			{
+				if (i == 0 || lessPos(order[i - 1], order[i]))
+					++positionCount;
+				positionIds[order[i]] = static_cast<UINT>(positionCount - 1);
+			}
+			return positionIds;
+		}
+	}
+
+	inline std::vector<DirectX::XMFLOAT3> GenerateCornerNormals(const std::vector<DirectX::XMFLOAT3>& positions,
+		const std::vector<UINT>& cornerPositions, float creaseAngle, bool threaded)
+	{
+		using namespace DirectX;
+
+		size_t triangleCount = cornerPositions.size() / 3;
+		size_t cornerCount = triangleCount * 3;
+
+		// 逐三角形计算单位法线与各角点的内角，退化三角形的法线为零
+		std::vector<XMFLOAT3> faceNormals(triangleCount);
+		std::vector<float> cornerAngles(cornerCount);
+		Internal::ForRanges(triangleCount, threaded, [&](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; ++t)
+			{
+				XMVECTOR p0 = XMLoadFloat3(&positions[cornerPositions[t * 3]]);
+				XMVECTOR p1 = XMLoadFloat3(&positions[cornerPositions[t * 3 + 1]]);
+				XMVECTOR p2 = XMLoadFloat3(&positions[cornerPositions[t * 3 + 2]]);
+				XMVECTOR cross = XMVector3Cross(p1 - p0, p2 - p0);
+				float length = XMVectorGetX(XMVector3Length(cross));
+				if (length > 0.0f)
+				{
+					XMStoreFloat3(&faceNormals[t], cross / length);
+					Internal::CornerAngles(p0, p1, p2, &cornerAngles[t * 3]);
+				}
+				else
+				{
+					faceNormals[t] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+					cornerAngles[t * 3] = cornerAngles[t * 3 + 1] = cornerAngles[t * 3 + 2] = 0.0f;
+				}
+			}
+		});
+
+		// 每个位置上的角点列表，坐标相同而索引不同的位置(如纹理接缝处重复的v)视为同一位置
+		size_t weldedCount = 0;
+		std::vector<UINT> positionIds = Internal::WeldPositions(positions, weldedCount);
+		std::vector<UINT> cornerKeys(cornerCount);
+		for (size_t c = 0; c < cornerCount; ++c)
+			cornerKeys[c] = positionIds[cornerPositions[c]];
+		std::vector<UINT> offsets, corners;
+		Internal::BuildCornerLists(cornerKeys.data(), cornerCount, weldedCount, offsets, corners);
+
+		// 逐角点累加同一位置上、与本三角形法线夹角不超过折痕角的三角形法线，累加顺序固定因而结果与线程数无关
+		float cosCrease = cosf(creaseAngle);
+		std::vector<XMFLOAT3> cornerNormals(cornerCount);
+		Internal::ForRanges(cornerCount, threaded, [&](size_t begin, size_t end) {
+			for (size_t c = begin; c < end; ++c)
+			{
+				XMVECTOR faceNormal = XMLoadFloat3(&faceNormals[c / 3]);
+				bool degenerate = XMVectorGetX(XMVector3LengthSq(faceNormal)) == 0.0f;
+				XMVECTOR sum = XMVectorZero();
+				UINT position = cornerKeys[c];
+				for (UINT i = offsets[position]; i < offsets[position + 1]; ++i)
+				{
+					UINT other = corners[i];
+					XMVECTOR otherNormal = XMLoadFloat3(&faceNormals[other / 3]);
+					if (degenerate || XMVectorGetX(XMVector3Dot(faceNormal, otherNormal)) >= cosCrease)
+						sum += otherNormal * cornerAngles[other];
+				}
+
+				float length = XMVectorGetX(XMVector3Length(sum));
+				if (length > 0.0f)
+					XMStoreFloat3(&cornerNormals[c], sum / length);
+				else if (!degenerate)
+					XMStoreFloat3(&cornerNormals[c], faceNormal);
+				else
+					cornerNormals[c] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+			}
+		});
+		return cornerNormals;
+	}
+
+	template<class VertexType, class IndexType>
+	inline void GenerateNormals(std::vector<VertexType>& vertices, std::vector<IndexType>& indices, float creaseAngle, bool threaded)
+	{
+		std::vector<DirectX::XMFLOAT3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+			positions[i] = vertices[i].pos;
+
+		indices.resize(indices.size() / 3 * 3);
+		std::vector<UINT> cornerPositions(indices.begin(), indices.end());
+
+		std::vector<DirectX::XMFLOAT3> cornerNormals = GenerateCornerNormals(positions, cornerPositions, creaseAngle, threaded);
+		Internal::AssignCornerAttributes(vertices, indices, cornerNormals,
+			[](VertexType& vertex, const DirectX::XMFLOAT3& normal) { vertex.normal = normal; });
+	}
+
+	template<class VertexType, class IndexType>
+	inline void GenerateTangents(std::vector<VertexType>& vertices, std::vector<IndexType>& indices, bool threaded)
+	{
+		using namespace DirectX;
+
+		indices.resize(indices.size() / 3 * 3);
+		size_t cornerCount = indices.size();
+		size_t triangleCount = cornerCount / 3;
+
+		// 逐角点计算投影到顶点切平面上的三角形切线、内角权重与纹理空间手性
+		std::vector<XMFLOAT3> cornerTangents(cornerCount);
+		std::vector<float> cornerWeights(cornerCount);
+		std::vector<UINT> cornerKeys(cornerCount);	// 顶点编号 * 2 + 手性
+		Internal::ForRanges(triangleCount, threaded, [&](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; ++t)
+			{
+				const VertexType& v0 = vertices[indices[t * 3]];
+				const VertexType& v1 = vertices[indices[t * 3 + 1]];
+				const VertexType& v2 = vertices[indices[t * 3 + 2]];
+				XMVECTOR p0 = XMLoadFloat3(&v0.pos), p1 = XMLoadFloat3(&v1.pos), p2 = XMLoadFloat3(&v2.pos);
+				XMVECTOR e1 = p1 - p0, e2 = p2 - p0;
+				float du1 = v1.tex.x - v0.tex.x, dv1 = v1.tex.y - v0.tex.y;
+				float du2 = v2.tex.x - v0.tex.x, dv2 = v2.tex.y - v0.tex.y;
+
+				// 纹理坐标的有向面积为正时保持手性，退化时按保持手性处理且不参与加权
+				float signedArea = du1 * dv2 - du2 * dv1;
+				bool orientation = signedArea >= 0.0f;
+				XMVECTOR faceTangent = signedArea != 0.0f ? (e1 * dv2 - e2 * dv1) / signedArea : XMVectorZero();
+				float angles[3];
+				Internal::CornerAngles(p0, p1, p2, angles);
+				if (XMVectorGetX(XMVector3LengthSq(XMVector3Cross(e1, e2))) == 0.0f)
+					angles[0] = angles[1] = angles[2] = 0.0f;
+
+				for (int k = 0; k < 3; ++k)
+				{
+					size_t c = t * 3 + k;
+					XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertices[indices[c]].normal));
+					XMVECTOR tangent = faceTangent - normal * XMVector3Dot(normal, faceTangent);
+					float length = XMVectorGetX(XMVector3Length(tangent));
+					XMStoreFloat3(&cornerTangents[c], length > 0.0f ? tangent / length : XMVectorZero());
+					cornerWeights[c] = length > 0.0f ? angles[k] : 0.0f;
+					cornerKeys[c] = static_cast<UINT>(indices[c]) * 2 + (orientation ? 1 : 0);
+				}
+			}
+		});
+
+		// 同一顶点上手性相同的角点组成一组
+		std::vector<UINT> offsets, corners;
+		Internal::BuildCornerLists(cornerKeys.data(), cornerCount, vertices.size() * 2, offsets, corners);
+
+		std::vector<XMFLOAT4> tangents(cornerCount);
+		Internal::ForRanges(cornerCount, threaded, [&](size_t begin, size_t end) {
+			for (size_t c = begin; c < end; ++c)
+			{
+				UINT key = cornerKeys[c];
+				XMVECTOR sum = XMVectorZero();
+				for (UINT i = offsets[key]; i < offsets[key + 1]; ++i)
+					sum += XMLoadFloat3(&cornerTangents[corners[i]]) * cornerWeights[corners[i]];
+
+				float length = XMVectorGetX(XMVector3Length(sum));
+				XMVECTOR tangent = length > 0.0f ? sum / length :
+					Internal::AnyPerpendicular(XMVector3Normalize(XMLoadFloat3(&vertices[indices[c]].normal)));
+				XMStoreFloat4(&tangents[c], XMVectorSetW(tangent, (key & 1) ? 1.0f : -1.0f));
+			}
+		});
+
+		Internal::AssignCornerAttributes(vertices, indices, tangents,
+			[](VertexType& vertex, const XMFLOAT4& tangent) { vertex.tangent = tangent; });
+	}
+}
+
+#endif
@@ -0,0 +1,562 @@
+//***************************************************************************************
+// MeshOptimizer.h
+//
+// 网格后处理优化：顶点缓存友好的三角形重排与顶点读取顺序重排
+// Post-load mesh optimization: vertex cache and vertex fetch reordering.
+//***************************************************************************************
+
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include "Geometry.h"
+
+namespace MeshOptimizer
+{
+	// 统计ACMR/ATVR时模拟的FIFO顶点缓存大小
+	static constexpr size_t DefaultCacheSize = 16;
+
+	// 顶点缓存统计
+	struct VertexCacheStatistics
+	{
+		size_t vertexTransforms;	// 模拟得到的顶点着色器调用次数
+		float acmr;					// 平均每个三角形的顶点变换次数(Average Cache Miss Ratio)，理想值约0.5
+		float atvr;					// 顶点变换次数与被引用顶点数之比(Average Transformed Vertex Ratio)，理想值为1
+	};
+
+	// 过度绘制统计
+	struct OverdrawStatistics
+	{
+		size_t pixelsCovered;		// 被网格覆盖的像素数目
+		size_t pixelsShaded;		// 通过深度测试、需要执行像素着色器的片元数目
+		float overdraw;				// 平均每个被覆盖像素的着色次数，理想值为1
+	};
+
+	// 优化前后的统计结果
+	struct OptimizeReport
+	{
+		VertexCacheStatistics before;
+		VertexCacheStatistics after;
+		OverdrawStatistics overdrawBefore;	// 仅在启用过度绘制优化时统计
+		OverdrawStatistics overdrawAfter;
+	};
+
+	// 以大小为cacheSize的FIFO缓存模拟三角形列表的顶点变换，统计ACMR/ATVR
+	template<class IndexType>
+	VertexCacheStatistics AnalyzeVertexCache(const std::vector<IndexType>& indices, size_t vertexCount,
+		size_t cacheSize = DefaultCacheSize);
+
+	// 按Forsyth的线性时间算法重排三角形顺序，提高变换后顶点缓存的命中率，三角形集合与环绕方向不变
+	template<class IndexType>
+	void OptimizeVertexCache(std::vector<IndexType>& indices, size_t vertexCount);
+
+	// 在顶点缓存优化的基础上，将三角形划分为若干簇并按与视角无关的遮挡潜力排序，使朝外的簇先绘制，
+	// 以减少通过深度测试后的重复着色；threshold为允许的ACMR放大倍数(如1.05表示最多变差5%)
+	// 需要顶点类型含有pos成员
+	template<class VertexType, class IndexType>
+	void OptimizeOverdraw(const std::vector<VertexType>& vertices, std::vector<IndexType>& indices, float threshold = 1.05f);
+
+	// 从viewCount个均匀分布的方向以正交投影在CPU上光栅化网格(剔除背面，深度测试LESS)，统计平均过度绘制
+	template<class VertexType, class IndexType>
+	OverdrawStatistics AnalyzeOverdraw(const std::vector<VertexType>& vertices, const std::vector<IndexType>& indices,
+		UINT viewCount = 16, UINT resolution = 256);
+
+	// 按索引中首次出现的顺序重排顶点并重映射索引，提高顶点读取的局部性，未被引用的顶点会被移除
+	template<class VertexType, class IndexType>
+	void OptimizeVertexFetch(std::vector<VertexType>& vertices, std::vector<IndexType>& indices);
+
+	// 依次执行顶点缓存、过度绘制(可选)与顶点读取优化，返回优化前后的统计
+	// 有子网格时三角形只在各子网格内部重排，子网格的索引范围不变
+	template<class VertexType, class IndexType>
+	OptimizeReport Optimize(Geometry::MeshData<VertexType, IndexType>& meshData,
+		bool optimizeOverdraw = false, float overdrawThreshold = 1.05f);
+}
+
+namespace MeshOptimizer
+{
+	namespace Internal
+	{
+		//
+		// 以下常量和函数仅供内部实现使用
+		//
+
+		// Forsyth评分所模拟的LRU缓存大小与参数
+		static constexpr size_t ScoreCacheSize = 32;
+		static constexpr float CacheDecayPower = 1.5f;
+		static constexpr float LastTriangleScore = 0.75f;
+		static constexpr float ValenceBoostScale = 2.0f;
+		static constexpr float ValenceBoostPower = 0.5f;
+
+		// 以时间戳模拟的FIFO顶点缓存
+		class FifoCacheSimulator
+		{
+		public:
+			FifoCacheSimulator(size_t vertexCount, size_t cacheSize)
+				: m_Timestamps(vertexCount, 0), m_CacheSize(cacheSize), m_Timestamp(cacheSize + 1) {}
+
+			// 访问一个顶点，未命中时返回true并将其放入缓存
+			bool Access(size_t vertex)
+			{
+				// 进入缓存的时间戳落后超过cacheSize即已被挤出
+				if (m_Timestamp - m_Timestamps[vertex] > m_CacheSize)
+				{
+					m_Timestamps[vertex] = m_Timestamp++;
+					return true;
+				}
+				return false;
+			}
+
+			// 清空缓存
+			void Reset() { m_Timestamp += m_CacheSize + 1; }
+
+		private:
+			std::vector<size_t> m_Timestamps;
+			size_t m_CacheSize;
+			size_t m_Timestamp;
+		};
+
+		// 查表所覆盖的最大剩余三角形数目，超出部分的加分可忽略不计
+		static constexpr UINT MaxValenceTable = 64;
+
+		// 预先计算的缓存位置得分与剩余三角形数目加分
+		struct VertexScoreTable
+		{
+			float cacheScores[ScoreCacheSize];
+			float valenceScores[MaxValenceTable];
+
+			VertexScoreTable()
+			{
+				for (size_t i = 0; i < ScoreCacheSize; ++i)
+				{
+					// 刚输出的三角形的三个顶点得分固定，避免总是沿同一条边推进
+					if (i < 3)
+						cacheScores[i] = LastTriangleScore;
+					else
+						cacheScores[i] = powf(1.0f - (i - 3) / static_cast<float>(ScoreCacheSize - 3), CacheDecayPower);
+				}
+				// 剩余三角形越少的顶点越优先，以尽快处理掉孤立的三角形
+				valenceScores[0] = 0.0f;
+				for (UINT i = 1; i < MaxValenceTable; ++i)
+					valenceScores[i] = ValenceBoostScale * powf(static_cast<float>(i), -ValenceBoostPower);
+			}
+		};
+
+		// 计算顶点评分，cachePosition为-1表示不在缓存中
+		inline float VertexScore(int cachePosition, UINT activeTriangles)
+		{
+			static const VertexScoreTable table;
+
+			// 已没有未输出的三角形引用该顶点
+			if (activeTriangles == 0)
+				return -1.0f;
+
+			float score = cachePosition >= 0 ? table.cacheScores[cachePosition] : 0.0f;
+			score += table.valenceScores[activeTriangles < MaxValenceTable ? activeTriangles : MaxValenceTable - 1];
+			return score;
+		}
+	}
+
+	template<class IndexType>
+	inline VertexCacheStatistics AnalyzeVertexCache(const std::vector<IndexType>& indices, size_t vertexCount,
+		size_t cacheSize)
+	{
+		VertexCacheStatistics stats = {};
+
+		Internal::FifoCacheSimulator cache(vertexCount, cacheSize);
+		std::vector<bool> referenced(vertexCount, false);
+		size_t referencedCount = 0;
+		for (IndexType index : indices)
+		{
+			if (cache.Access(index))
+				++stats.vertexTransforms;
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				++referencedCount;
+			}
+		}
+
+		size_t triangleCount = indices.size() / 3;
+		stats.acmr = triangleCount ? static_cast<float>(stats.vertexTransforms) / triangleCount : 0.0f;
+		stats.atvr = referencedCount ? static_cast<float>(stats.vertexTransforms) / referencedCount : 0.0f;
+		return stats;
+	}
+
+	template<class IndexType>
+	inline void OptimizeVertexCache(std::vector<IndexType>& indices, size_t vertexCount)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		// 建立顶点到三角形的邻接表(CSR)
+		std::vector<UINT> activeTriangles(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++activeTriangles[indices[i]];
+
+		std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < vertexCount; ++i)
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + activeTriangles[i];
+
+		std::vector<UINT> adjacency(adjacencyOffsets[vertexCount]);
+		std::vector<size_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			adjacency[fillOffsets[indices[i]]++] = static_cast<UINT>(i / 3);
+
+		// 初始评分
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+			vertexScores[i] = Internal::VertexScore(-1, activeTriangles[i]);
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		for (size_t i = 0; i < triangleCount; ++i)
+		{
+			triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] +
+				vertexScores[indices[i * 3 + 2]];
+		}
+
+		// 模拟的LRU缓存，多留出3个位置存放新加入的顶点
+		std::vector<IndexType> cache, newCache;
+		cache.reserve(Internal::ScoreCacheSize + 3);
+		newCache.reserve(Internal::ScoreCacheSize + 3);
+
+		std::vector<IndexType> output(triangleCount * 3);
+		size_t nextCandidate = 0;	// 缓存中没有候选三角形时，按原顺序找下一个未输出的三角形
+		int bestTriangle = 0;
+		for (size_t outputTriangle = 0; outputTriangle < triangleCount; ++outputTriangle)
+		{
+			if (bestTriangle < 0)
+			{
+				while (emitted[nextCandidate])
+					++nextCandidate;
+				bestTriangle = static_cast<int>(nextCandidate);
+			}
+
+			// 输出三角形，并从其顶点的邻接表中移除
+			const IndexType* triangle = &indices[bestTriangle * 3];
+			emitted[bestTriangle] = true;
+			for (int k = 0; k < 3; ++k)
+			{
+				IndexType vertex = triangle[k];
+				output[outputTriangle * 3 + k] = vertex;
+
+				UINT* adjBegin = &adjacency[adjacencyOffsets[vertex]];
+				UINT* adjEnd = adjBegin + activeTriangles[vertex];
+				for (UINT* adj = adjBegin; adj < adjEnd; ++adj)
+				{
+					if (*adj == static_cast<UINT>(bestTriangle))
+					{
+						*adj = adjEnd[-1];
+						break;
+					}
+				}
+				--activeTriangles[vertex];
+			}
+
+			// 更新LRU缓存：刚输出的三个顶点位于最前
+			newCache.assign(triangle, triangle + 3);
+			for (IndexType vertex : cache)
+			{
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					newCache.push_back(vertex);
+			}
+			cache.swap(newCache);
+
+			// 重新评分缓存中(包括刚被挤出的)顶点及其相邻三角形
+			for (size_t i = 0; i < cache.size(); ++i)
+			{
+				IndexType vertex = cache[i];
+				cachePositions[vertex] = i < Internal::ScoreCacheSize ? static_cast<int>(i) : -1;
+				float newScore = Internal::VertexScore(cachePositions[vertex], activeTriangles[vertex]);
+				float scoreDelta = newScore - vertexScores[vertex];
+				vertexScores[vertex] = newScore;
+
+				const UINT* adjBegin = &adjacency[adjacencyOffsets[vertex]];
+				const UINT* adjEnd = adjBegin + activeTriangles[vertex];
+				for (const UINT* adj = adjBegin; adj < adjEnd; ++adj)
+					triangleScores[*adj] += scoreDelta;
+			}
+
+			// 在缓存中顶点的相邻三角形里找出得分最高者
+			float bestScore = -1.0f;
+			bestTriangle = -1;
+			for (size_t i = 0; i < cache.size() && i < Internal::ScoreCacheSize; ++i)
+			{
+				IndexType vertex = cache[i];
+				const UINT* adjBegin = &adjacency[adjacencyOffsets[vertex]];
+				const UINT* adjEnd = adjBegin + activeTriangles[vertex];
+				for (const UINT* adj = adjBegin; adj < adjEnd; ++adj)
+				{
+					if (triangleScores[*adj] > bestScore)
+					{
+						bestScore = triangleScores[*adj];
+						bestTriangle = static_cast<int>(*adj);
+					}
+				}
+			}
+			if (cache.size() > Internal::ScoreCacheSize)
+				cache.resize(Internal::ScoreCacheSize);
+		}
+
+		// 余下不足一个三角形的索引保持不变
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	template<class VertexType, class IndexType>
+	inline void OptimizeVertexFetch(std::vector<VertexType>& vertices, std::vector<IndexType>& indices)
+	{
+		static constexpr DWORD unused = ~0u;
+		std::vector<DWORD> remap(vertices.size(), unused);
+		std::vector<VertexType> newVertices;
+		newVertices.reserve(vertices.size());
+
+		for (IndexType& index : indices)
+		{
+			DWORD& newIndex = remap[index];
+			if (newIndex == unused)
+			{
+				newIndex = static_cast<DWORD>(newVertices.size());
+				newVertices.push_back(vertices[index]);
+			}
+			index = static_cast<IndexType>(newIndex);
+		}
+
+		vertices.swap(newVertices);
+	}
+
+	template<class VertexType, class IndexType>
+	inline void OptimizeOverdraw(const std::vector<VertexType>& vertices, std::vector<IndexType>& indices, float threshold)
+	{
+		using namespace DirectX;
+
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		// 硬边界：模拟FIFO缓存，三个顶点都未命中的三角形处开始新簇，在此处切分不会增加顶点变换
+		std::vector<size_t> hardClusters;
+		Internal::FifoCacheSimulator cache(vertices.size(), DefaultCacheSize);
+		for (size_t i = 0; i < triangleCount; ++i)
+		{
+			int misses = cache.Access(indices[i * 3]) + cache.Access(indices[i * 3 + 1]) + cache.Access(indices[i * 3 + 2]);
+			if (i == 0 || misses == 3)
+				hardClusters.push_back(i);
+		}
+		hardClusters.push_back(triangleCount);
+
+		// 软边界：簇内从空缓存开始累计，当累计ACMR不超过该簇ACMR的threshold倍时即可切分
+		std::vector<size_t> clusters;
+		for (size_t c = 0; c + 1 < hardClusters.size(); ++c)
+		{
+			size_t begin = hardClusters[c], end = hardClusters[c + 1];
+
+			cache.Reset();
+			size_t clusterMisses = 0;
+			for (size_t i = begin; i < end; ++i)
+				clusterMisses += cache.Access(indices[i * 3]) + cache.Access(indices[i * 3 + 1]) + cache.Access(indices[i * 3 + 2]);
+			float clusterThreshold = threshold * clusterMisses / (end - begin);
+
+			cache.Reset();
+			clusters.push_back(begin);
+			size_t runningMisses = 0, runningTriangles = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				runningMisses += cache.Access(indices[i * 3]) + cache.Access(indices[i * 3 + 1]) + cache.Access(indices[i * 3 + 2]);
+				++runningTriangles;
+				if (i + 1 < end && runningMisses <= clusterThreshold * runningTriangles)
+				{
+					clusters.push_back(i + 1);
+					cache.Reset();
+					runningMisses = runningTriangles = 0;
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+		size_t clusterCount = clusters.size() - 1;
+
+		// 每个簇按面积加权的质心与法线
+		std::vector<XMFLOAT3> clusterCentroids(clusterCount), clusterNormals(clusterCount);
+		XMVECTOR meshCentroid = XMVectorZero();
+		float meshArea = 0.0f;
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			XMVECTOR centroid = XMVectorZero(), normal = XMVectorZero();
+			float clusterArea = 0.0f;
+			for (size_t i = clusters[c]; i < clusters[c + 1]; ++i)
+			{
+				XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i * 3]].pos);
+				XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i * 3 + 1]].pos);
+				XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i * 3 + 2]].pos);
+				XMVECTOR cross = XMVector3Cross(p1 - p0, p2 - p0);
+				float area = XMVectorGetX(XMVector3Length(cross));
+				centroid += (p0 + p1 + p2) * (area / 3.0f);
+				normal += cross;
+				clusterArea += area;
+			}
+			meshCentroid += centroid;
+			meshArea += clusterArea;
+			XMStoreFloat3(&clusterCentroids[c], clusterArea > 0.0f ? centroid / clusterArea : centroid);
+			XMStoreFloat3(&clusterNormals[c], XMVector3Normalize(normal));
+		}
+		meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+		// 判断网格的环绕方向：叉积法线整体朝外时为正，否则翻转排序键
+		float orientation = 0.0f;
+		for (size_t c = 0; c < clusterCount; ++c)
+			orientation += XMVectorGetX(XMVector3Dot(XMLoadFloat3(&clusterCentroids[c]) - meshCentroid, XMLoadFloat3(&clusterNormals[c])));
+		float sign = orientation < 0.0f ? -1.0f : 1.0f;
+
+		// 离质心越远且越朝外的簇越可能遮挡其他簇，排在前面
+		std::vector<float> sortKeys(clusterCount);
+		std::vector<size_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			sortKeys[c] = sign * XMVectorGetX(XMVector3Dot(XMLoadFloat3(&clusterCentroids[c]) - meshCentroid,
+				XMLoadFloat3(&clusterNormals[c])));
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+		std::vector<IndexType> output;
+		output.reserve(triangleCount * 3);
+		for (size_t c : order)
+			output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	template<class VertexType, class IndexType>
+	inline OverdrawStatistics AnalyzeOverdraw(const std::vector<VertexType>& vertices, const std::vector<IndexType>& indices,
+		UINT viewCount, UINT resolution)
+	{
+		using namespace DirectX;
+
+		OverdrawStatistics stats = {};
+		if (indices.size() < 3 || viewCount == 0 || resolution == 0)
+			return stats;
+
+		std::vector<float> depthBuffer(static_cast<size_t>(resolution) * resolution);
+		std::vector<XMFLOAT3> projected(vertices.size());
+		for (UINT view = 0; view < viewCount; ++view)
+		{
+			// 斐波那契球面上均匀分布的观察方向，按XMMatrixLookToLH的方式构建左手系观察空间
+			float y = 1.0f - 2.0f * (view + 0.5f) / viewCount;
+			float r = sqrtf(1.0f - y * y);
+			float phi = view * XM_PI * (3.0f - sqrtf(5.0f));
+			XMVECTOR eyeDir = XMVectorSet(r * cosf(phi), y, r * sinf(phi), 0.0f);
+			XMVECTOR upDir = fabsf(y) > 0.99f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+			XMVECTOR rightDir = XMVector3Normalize(XMVector3Cross(upDir, eyeDir));
+			upDir = XMVector3Cross(eyeDir, rightDir);
+
+			// 正交投影，并将包围矩形映射到整个视口
+			float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+			for (size_t i = 0; i < vertices.size(); ++i)
+			{
+				XMVECTOR pos = XMLoadFloat3(&vertices[i].pos);
+				XMFLOAT3& p = projected[i];
+				p.x = XMVectorGetX(XMVector3Dot(pos, rightDir));
+				p.y = XMVectorGetX(XMVector3Dot(pos, upDir));
+				p.z = XMVectorGetX(XMVector3Dot(pos, eyeDir));
+				minX = p.x < minX ? p.x : minX;
+				minY = p.y < minY ? p.y : minY;
+				maxX = p.x > maxX ? p.x : maxX;
+				maxY = p.y > maxY ? p.y : maxY;
+			}
+			float extent = (maxX - minX > maxY - minY ? maxX - minX : maxY - minY);
+			float scale = extent > 0.0f ? resolution / extent : 0.0f;
+			for (XMFLOAT3& p : projected)
+			{
+				p.x = (p.x - minX) * scale;
+				p.y = (p.y - minY) * scale;
+			}
+
+			std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				XMFLOAT3 v0 = projected[indices[i]], v1 = projected[indices[i + 1]], v2 = projected[indices[i + 2]];
+
+				// y轴向上时顺时针为正面(与默认光栅化状态一致)，背面剔除
+				float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+				if (area >= 0.0f)
+					continue;
+				std::swap(v1, v2);
+				area = -area;
+
+				// 遍历包围盒内的像素中心
+				int x0 = (std::max)(static_cast<int>(floorf((std::min)((std::min)(v0.x, v1.x), v2.x))), 0);
+				int y0 = (std::max)(static_cast<int>(floorf((std::min)((std::min)(v0.y, v1.y), v2.y))), 0);
+				int x1 = (std::min)(static_cast<int>(ceilf((std::max)((std::max)(v0.x, v1.x), v2.x))), static_cast<int>(resolution) - 1);
+				int y1 = (std::min)(static_cast<int>(ceilf((std::max)((std::max)(v0.y, v1.y), v2.y))), static_cast<int>(resolution) - 1);
+				for (int py = y0; py <= y1; ++py)
+				{
+					for (int px = x0; px <= x1; ++px)
+					{
+						float cx = px + 0.5f, cy = py + 0.5f;
+						float w0 = (v2.x - v1.x) * (cy - v1.y) - (v2.y - v1.y) * (cx - v1.x);
+						float w1 = (v0.x - v2.x) * (cy - v2.y) - (v0.y - v2.y) * (cx - v2.x);
+						float w2 = (v1.x - v0.x) * (cy - v0.y) - (v1.y - v0.y) * (cx - v0.x);
+						if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+							continue;
+
+						float depth = (w0 * v0.z + w1 * v1.z + w2 * v2.z) / area;
+						float& stored = depthBuffer[static_cast<size_t>(py) * resolution + px];
+						if (depth < stored)
+						{
+							if (stored == FLT_MAX)
+								++stats.pixelsCovered;
+							++stats.pixelsShaded;
+							stored = depth;
+						}
+					}
+				}
+			}
+		}
+
+		stats.overdraw = stats.pixelsCovered ? static_cast<float>(stats.pixelsShaded) / stats.pixelsCovered : 0.0f;
+		return stats;
+	}
+
+	template<class VertexType, class IndexType>
+	inline OptimizeReport Optimize(Geometry::MeshData<VertexType, IndexType>& meshData,
+		bool optimizeOverdraw, float overdrawThreshold)
+	{
+		OptimizeReport report = {};
+		report.before = AnalyzeVertexCache(meshData.indexVec, meshData.vertexVec.size());
+		if (optimizeOverdraw)
+			report.overdrawBefore = AnalyzeOverdraw(meshData.vertexVec, meshData.indexVec);
+
+		auto optimizeTriangles = [&](std::vector<IndexType>& indices)
+		{
+			OptimizeVertexCache(indices, meshData.vertexVec.size());
+			if (optimizeOverdraw)
+				OptimizeOverdraw(meshData.vertexVec, indices, overdrawThreshold);
+		};
+		if (meshData.submeshes.empty())
+		{
+			optimizeTriangles(meshData.indexVec);
+		}
+		else
+		{
+			std::vector<IndexType> indices;
+			for (const Geometry::Submesh& submesh : meshData.submeshes)
+			{
+				auto first = meshData.indexVec.begin() + submesh.indexStart;
+				indices.assign(first, first + submesh.indexCount);
+				optimizeTriangles(indices);
+				std::copy(indices.begin(), indices.end(), first);
+			}
+		}
+		OptimizeVertexFetch(meshData.vertexVec, meshData.indexVec);
+
+		report.after = AnalyzeVertexCache(meshData.indexVec, meshData.vertexVec.size());
+		if (optimizeOverdraw)
+			report.overdrawAfter = AnalyzeOverdraw(meshData.vertexVec, meshData.indexVec);
+		return report;
+	}
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include "MeshRegistry.h"
+#include <algorithm>
+#include <filesystem>
+#include "DXTrace.h"
+using namespace DirectX;
+
+MeshResource::MeshResource()
+	: vertexStrides(), vertexBufferCount(), indexCount(), indexFormat(DXGI_FORMAT_R16_UINT)
+{
+	XMStoreFloat4x4(&positionDecode, XMMatrixIdentity());
+}
+
+void MeshResource::CreateVertexBuffer(ID3D11Device* device, UINT slot, const void* data, UINT stride, size_t vertexCount)
+{
+	// 设置顶点缓冲区描述
+	vertexStrides[slot] = stride;
+	D3D11_BUFFER_DESC vbd;
+	ZeroMemory(&vbd, sizeof(vbd));
+	vbd.Usage = D3D11_USAGE_IMMUTABLE;
+	vbd.ByteWidth = (UINT)vertexCount * stride;
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = 0;
+	// 新建顶点缓冲区
+	D3D11_SUBRESOURCE_DATA InitData;
+	ZeroMemory(&InitData, sizeof(InitData));
+	InitData.pSysMem = data;
+	HR_THROW(device->CreateBuffer(&vbd, &InitData, vertexBuffers[slot].GetAddressOf()));
+}
+
+void MeshResource::CreateIndexBuffer(ID3D11Device* device, const void* data, UINT indexSize, UINT count)
+{
+	// 设置索引缓冲区描述
+	indexFormat = indexSize == sizeof(WORD) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	indexCount = count;
+	D3D11_BUFFER_DESC ibd;
+	ZeroMemory(&ibd, sizeof(ibd));
+	ibd.Usage = D3D11_USAGE_IMMUTABLE;
+	ibd.ByteWidth = indexCount * indexSize;
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibd.CPUAccessFlags = 0;
+	// 新建索引缓冲区
+	D3D11_SUBRESOURCE_DATA InitData;
+	ZeroMemory(&InitData, sizeof(InitData));
+	InitData.pSysMem = data;
+	HR_THROW(device->CreateBuffer(&ibd, &InitData, indexBuffer.GetAddressOf()));
+}
+
+void MeshResource::SetDebugObjectName(const std::string& name) const
+{
+#if (defined(DEBUG) || defined(_DEBUG)) && (GRAPHICS_DEBUGGER_OBJECT_NAME)
+	for (UINT i = 0; i < vertexBufferCount; ++i)
+	{
+		if (!vertexBuffers[i])
+			continue;
+		std::string vbName = name + ".VertexBuffer" + std::to_string(i);
+		vertexBuffers[i]->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(vbName.length()), vbName.c_str());
+	}
+	std::string ibName = name + ".IndexBuffer";
+	indexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(ibName.length()), ibName.c_str());
+#else
+	UNREFERENCED_PARAMETER(name);
+#endif
+}
+
+MeshRegistry& MeshRegistry::Get()
+{
+	static MeshRegistry registry;
+	return registry;
+}
+
+std::string MeshRegistry::CanonicalPath(const std::string& path)
+{
+	// 路径按UTF-8解释（项目以/utf-8编译），结果也以UTF-8返回；
+	// string()会经过ANSI代码页转换，非中文系统区域下遇到中文路径会抛异常
+	std::error_code ec;
+	std::filesystem::path input = std::filesystem::u8path(path);
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(std::filesystem::absolute(input, ec), ec);
+	// 文件不存在时weakly_canonical仍会规范化已存在的前缀部分
+	if (ec)
+		canonical = input.lexically_normal();
+	std::string result = canonical.make_preferred().u8string();
+#ifdef _WIN32
+	// 只转换ASCII字母，不影响多字节字符
+	std::transform(result.begin(), result.end(), result.begin(), [](char c) {
+		return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+	});
+#endif
+	return result;
+}
+
+size_t MeshRegistry::GetLoadCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_LoadCount;
+}
+
+size_t MeshRegistry::GetRequestCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_RequestCount;
+}
+
+void MeshRegistry::Purge()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+	{
+		if (!it->second.loading.valid() && it->second.mesh.expired())
+			it = m_Entries.erase(it);
+		else
+			++it;
+	}
+}
+
+MeshHandle MeshRegistry::Acquire(const std::string& key, const Loader& loader)
+{
+	std::promise<MeshHandle> promise;
+	std::shared_future<MeshHandle> loading;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		++m_RequestCount;
+		Entry& entry = m_Entries[key];
+		if (MeshHandle mesh = entry.mesh.lock())
+			return mesh;
+		if (entry.loading.valid())
+		{
+			loading = entry.loading;
+		}
+		else
+		{
+			// 由当前线程负责加载，其它请求等待同一个future
+			entry.loading = promise.get_future().share();
+			++m_LoadCount;
+		}
+	}
+	if (loading.valid())
+		return loading.get();
+
+	// 在锁外加载，不同网格可以并行加载
+	MeshHandle mesh;
+	try
+	{
+		mesh = loader();
+	}
+	catch (...)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Entries[key].loading = std::shared_future<MeshHandle>();
+		}
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Entry& entry = m_Entries[key];
+		entry.mesh = mesh;
+		entry.loading = std::shared_future<MeshHandle>();
+	}
+	promise.set_value(mesh);
+	return mesh;
+}
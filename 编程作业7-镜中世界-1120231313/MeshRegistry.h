@@ -0,0 +1,168 @@
+//***************************************************************************************
+// MeshRegistry.h
+//
+// 按规范化路径与顶点格式共享的网格资源，相同的模型只解析、上传一次
+// Registry of shared, reference-counted GPU meshes keyed by canonical path and vertex format.
+//***************************************************************************************
+
+#ifndef MESHREGISTRY_H
+#define MESHREGISTRY_H
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wrl/client.h>
+#include "Geometry.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+
+// 上传到GPU的网格，创建完成并交给MeshRegistry或GameObject后只读，可被多个物体共享
+struct MeshResource
+{
+	template <class T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	MeshResource();
+
+	// 由交错存放的网格数据创建，只使用输入槽0
+	template<class VertexType, class IndexType>
+	static std::shared_ptr<MeshResource> Create(ID3D11Device* device, const Geometry::MeshData<VertexType, IndexType>& meshData);
+	// 为每个非空的分量创建单独的顶点缓冲区，需配合VertexTraits的streamInputLayout使用
+	template<class IndexType>
+	static std::shared_ptr<MeshResource> Create(ID3D11Device* device, const Geometry::MeshDataSoA<IndexType>& meshData);
+
+	// 设置调试对象名
+	void SetDebugObjectName(const std::string& name) const;
+
+	ComPtr<ID3D11Buffer> vertexBuffers[VertexStreamCount];	// 顶点缓冲区，交错存放时只使用输入槽0
+	UINT vertexStrides[VertexStreamCount];					// 各顶点缓冲区的顶点字节大小
+	UINT vertexBufferCount;									// 需要绑定的输入槽数目
+	ComPtr<ID3D11Buffer> indexBuffer;						// 索引缓冲区
+	UINT indexCount;										// 索引数目
+	DXGI_FORMAT indexFormat;								// 索引格式
+	DirectX::XMFLOAT4X4 positionDecode;						// 顶点位置解码矩阵，未量化时为单位矩阵
+	std::vector<Geometry::Submesh> submeshes;				// 按材质划分的子网格，为空时整个网格只有一个材质
+	std::vector<MeshSimplifier::LodLevel> lodLevels;		// LOD链各级的索引范围，为空时只有一级
+	std::vector<std::vector<MeshletBuilder::Meshlet>> meshlets;	// 各LOD级别的簇
+
+private:
+	// 在输入槽slot上创建顶点缓冲区
+	void CreateVertexBuffer(ID3D11Device* device, UINT slot, const void* data, UINT stride, size_t vertexCount);
+	// 创建索引缓冲区，顶点数目不超过65536时使用16位索引
+	template<class IndexType>
+	void CreateIndexBuffer(ID3D11Device* device, const std::vector<IndexType>& indices, size_t vertexCount);
+	void CreateIndexBuffer(ID3D11Device* device, const void* data, UINT indexSize, UINT indexCount);
+};
+
+// 共享网格的句柄，最后一个句柄释放时网格随之释放
+using MeshHandle = std::shared_ptr<const MeshResource>;
+
+class MeshRegistry
+{
+public:
+	using Loader = std::function<std::shared_ptr<MeshResource>()>;
+
+	MeshRegistry() = default;
+	MeshRegistry(const MeshRegistry&) = delete;
+	MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+	// 获取全局共享的注册表
+	static MeshRegistry& Get();
+
+	// 获取以VertexType格式上传到device的path模型
+	// 该网格仍被引用时直接返回；其它线程正在加载同一网格时等待其完成并返回同一份网格；
+	// 否则在当前线程调用loader()加载，loader抛出的异常会传给当前线程与所有等待者，之后的请求会重新加载
+	template<class VertexType>
+	MeshHandle Acquire(ID3D11Device* device, const std::string& path, const Loader& loader);
+
+	// 规范化路径：转为绝对路径并去掉"."、".."，Windows下统一分隔符并忽略大小写
+	// path与返回值均为UTF-8编码，不依赖系统区域设置
+	static std::string CanonicalPath(const std::string& path);
+
+	// 获取loader被调用的次数
+	size_t GetLoadCount() const;
+	// 获取Acquire被调用的次数
+	size_t GetRequestCount() const;
+	// 移除已不再被引用的条目
+	void Purge();
+
+private:
+	MeshHandle Acquire(const std::string& key, const Loader& loader);
+
+	// 正在加载时loading有效，加载完成后只保留弱引用，注册表本身不延长网格的生命周期
+	struct Entry
+	{
+		std::weak_ptr<const MeshResource> mesh;
+		std::shared_future<MeshHandle> loading;
+	};
+
+	mutable std::mutex m_Mutex;
+	std::unordered_map<std::string, Entry> m_Entries;
+	size_t m_LoadCount = 0;
+	size_t m_RequestCount = 0;
+};
+
+template<class VertexType, class IndexType>
+inline std::shared_ptr<MeshResource> MeshResource::Create(ID3D11Device* device, const Geometry::MeshData<VertexType, IndexType>& meshData)
+{
+	auto mesh = std::make_shared<MeshResource>();
+	mesh->CreateVertexBuffer(device, 0, meshData.vertexVec.data(), sizeof(VertexType), meshData.vertexVec.size());
+	mesh->vertexBufferCount = 1;
+	mesh->CreateIndexBuffer(device, meshData.indexVec, meshData.vertexVec.size());
+	mesh->submeshes = meshData.submeshes;
+	return mesh;
+}
+
+template<class IndexType>
+inline std::shared_ptr<MeshResource> MeshResource::Create(ID3D11Device* device, const Geometry::MeshDataSoA<IndexType>& meshData)
+{
+	auto mesh = std::make_shared<MeshResource>();
+
+	// 输入槽与VertexSemantic的序号一致，缺少的分量留空
+	size_t vertexCount = meshData.VertexCount();
+	auto createStream = [&](VertexSemantic semantic, const auto& stream)
+	{
+		if (!stream.empty())
+			mesh->CreateVertexBuffer(device, static_cast<UINT>(semantic), stream.data(), sizeof(stream[0]), vertexCount);
+	};
+	createStream(VertexSemantic::Position, meshData.positions);
+	createStream(VertexSemantic::Normal, meshData.normals);
+	createStream(VertexSemantic::Tangent, meshData.tangents);
+	createStream(VertexSemantic::Color, meshData.colors);
+	createStream(VertexSemantic::TexCoord, meshData.texCoords);
+	mesh->vertexBufferCount = static_cast<UINT>(VertexSemantic::TexCoord) + 1;
+	mesh->CreateIndexBuffer(device, meshData.indexVec, vertexCount);
+	mesh->submeshes = meshData.submeshes;
+	return mesh;
+}
+
+template<class IndexType>
+inline void MeshResource::CreateIndexBuffer(ID3D11Device* device, const std::vector<IndexType>& indices, size_t vertexCount)
+{
+	// 顶点数目不超过65536时使用16位索引，索引带宽减半
+	if (sizeof(IndexType) == 4 && vertexCount <= 65536)
+	{
+		std::vector<WORD> shortIndices(indices.begin(), indices.end());
+		CreateIndexBuffer(device, shortIndices.data(), sizeof(WORD), static_cast<UINT>(shortIndices.size()));
+	}
+	else
+	{
+		CreateIndexBuffer(device, indices.data(), sizeof(IndexType), static_cast<UINT>(indices.size()));
+	}
+}
+
+template<class VertexType>
+inline MeshHandle MeshRegistry::Acquire(ID3D11Device* device, const std::string& path, const Loader& loader)
+{
+	// 同一路径的不同顶点格式、或上传到不同设备的网格互不共享
+	std::string key = CanonicalPath(path);
+	key += '|' + std::to_string(MeshCache::LayoutHash<VertexType>()) + '|' + std::to_string(reinterpret_cast<uintptr_t>(device));
+	return Acquire(key, loader);
+}
+
+#endif
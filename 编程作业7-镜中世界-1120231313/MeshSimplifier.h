@@ -0,0 +1,589 @@
+//***************************************************************************************
+// MeshSimplifier.h
+//
+// 基于二次误差度量(QEM)的网格简化与LOD链生成
+// Quadric error metric mesh simplification and LOD chain generation.
+//***************************************************************************************
+
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include "Geometry.h"
+#include "MeshOptimizer.h"
+
+namespace MeshSimplifier
+{
+	// LOD链中的一级
+	struct LodLevel
+	{
+		UINT indexStart;	// 在共享索引数组中的起始位置
+		UINT indexCount;	// 索引数目
+		float error;		// 相对原始网格的几何误差上界(模型空间距离)
+		std::vector<Geometry::Submesh> submeshes;	// 各子网格在该级中的索引范围，网格没有子网格时为空
+	};
+
+	// LOD链，所有级别共享同一个顶点缓冲区，各级索引依次存放在同一个索引缓冲区中
+	template<class VertexType, class IndexType>
+	struct MeshLodChain
+	{
+		Geometry::MeshData<VertexType, IndexType> meshData;	// 共享的顶点与依次存放的各级索引
+		std::vector<LodLevel> levels;						// levels[0]为原始网格，越往后越粗糙
+
+		// 物体单位长度投影到屏幕上为pixelsPerUnit个像素时，第level级的屏幕空间误差(像素)
+		float ScreenSpaceError(size_t level, float pixelsPerUnit) const { return levels[level].error * pixelsPerUnit; }
+	};
+
+	// 简化选项
+	struct SimplifyOptions
+	{
+		float normalWeight = 0.5f;	// 法线差异的权重(顶点类型含NORMAL时有效)
+		float colorWeight = 0.1f;	// 颜色差异的权重(顶点类型含COLOR时有效)
+		float maxError = 0.05f;		// 允许的最大几何误差，相对于网格包围盒的最大边长
+	};
+
+	// 将网格简化到不超过targetTriangleCount个三角形(或达到误差上限)，只删除顶点不移动顶点，返回新的索引
+	// pError用于返回简化后的几何误差(模型空间距离)
+	template<class VertexType, class IndexType>
+	std::vector<IndexType> Simplify(const std::vector<VertexType>& vertices, const std::vector<IndexType>& indices,
+		size_t targetTriangleCount, const SimplifyOptions& options = SimplifyOptions(), float* pError = nullptr);
+
+	// 按ratios中的目标三角形比例(相对原网格，递减)逐级简化，生成共享顶点的LOD链
+	// 误差上限使某一级无法继续简化时，后续级别不再生成；除第0级外每级的三角形顺序都经过顶点缓存优化
+	// 有子网格时整个网格一起简化，每级中各子网格剩余的三角形仍连续存放，顶点缓存优化只在子网格内部进行
+	template<class VertexType, class IndexType>
+	MeshLodChain<VertexType, IndexType> BuildLodChain(const Geometry::MeshData<VertexType, IndexType>& meshData,
+		const std::vector<float>& ratios = { 0.5f, 0.25f, 0.125f }, const SimplifyOptions& options = SimplifyOptions());
+
+	// 选出屏幕空间误差不超过maxPixelError的最粗糙的一级
+	size_t SelectLodLevel(const std::vector<LodLevel>& levels, float pixelsPerUnit, float maxPixelError = 1.0f);
+}
+
+namespace MeshSimplifier
+{
+	namespace Internal
+	{
+		//
+		// 以下结构体和函数仅供内部实现使用
+		//
+
+		// 对称的4x4二次误差矩阵，另记录累计的面积权重用于将误差归一化为距离的平方
+		struct Quadric
+		{
+			double a00, a01, a02, a11, a12, a22;
+			double b0, b1, b2;
+			double c;
+			double weight;
+
+			Quadric& operator+=(const Quadric& rhs)
+			{
+				a00 += rhs.a00; a01 += rhs.a01; a02 += rhs.a02;
+				a11 += rhs.a11; a12 += rhs.a12; a22 += rhs.a22;
+				b0 += rhs.b0; b1 += rhs.b1; b2 += rhs.b2;
+				c += rhs.c;
+				weight += rhs.weight;
+				return *this;
+			}
+		};
+
+		// 加入平面n·p + d = 0(n为单位向量)
+		inline void AddPlane(Quadric& q, double nx, double ny, double nz, double d, double weight)
+		{
+			q.a00 += weight * nx * nx; q.a01 += weight * nx * ny; q.a02 += weight * nx * nz;
+			q.a11 += weight * ny * ny; q.a12 += weight * ny * nz; q.a22 += weight * nz * nz;
+			q.b0 += weight * nx * d; q.b1 += weight * ny * d; q.b2 += weight * nz * d;
+			q.c += weight * d * d;
+			q.weight += weight;
+		}
+
+		// 点p到二次误差所表示的各平面距离平方的加权平均
+		inline double EvaluateQuadric(const Quadric& q, const DirectX::XMFLOAT3& p)
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double error = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z +
+				q.a11 * y * y + 2.0 * q.a12 * y * z + q.a22 * z * z +
+				2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+			return q.weight > 0.0 ? (error > 0.0 ? error : 0.0) / q.weight : 0.0;
+		}
+
+		// 查找顶点输入布局中某个语义的字节偏移，不存在时返回-1
+		template<class VertexType>
+		inline int FindSemanticOffset(const char* semanticName)
+		{
+			for (const D3D11_INPUT_ELEMENT_DESC& desc : VertexType::inputLayout)
+			{
+				if (strcmp(desc.SemanticName, semanticName) == 0)
+					return static_cast<int>(desc.AlignedByteOffset);
+			}
+			return -1;
+		}
+
+		// 按位比较的顶点位置哈希，用于查找位置相同的顶点
+		struct PositionHash
+		{
+			size_t operator()(const DirectX::XMFLOAT3& p) const
+			{
+				uint32_t bits[3];
+				memcpy(bits, &p, sizeof(bits));
+				return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+			}
+		};
+
+		struct PositionEqual
+		{
+			bool operator()(const DirectX::XMFLOAT3& lhs, const DirectX::XMFLOAT3& rhs) const
+			{
+				return memcmp(&lhs, &rhs, sizeof(DirectX::XMFLOAT3)) == 0;
+			}
+		};
+
+		// 位置的拓扑类型
+		enum class VertexKind { Manifold, Border, Locked };
+
+		// 逐步简化的状态，使LOD链的各级在同一误差度量下连续简化
+		// 折叠在位置上进行：位置相同的顶点(法线或纹理接缝处的副本)一起折叠，每个副本改为目标位置上属性最接近的副本
+		template<class VertexType, class IndexType>
+		class Simplifier
+		{
+		public:
+			// triangleGroups为每个三角形的分组(如所属的子网格)，简化时随三角形一起保留或移除，可以为空
+			Simplifier(const std::vector<VertexType>& vertices, const std::vector<IndexType>& indices, const SimplifyOptions& options,
+				std::vector<UINT> triangleGroups = {});
+
+			// 继续简化直到三角形数目不超过targetTriangleCount，或已无误差上限内的可折叠边
+			void Simplify(size_t targetTriangleCount);
+
+			const std::vector<IndexType>& GetIndices() const { return m_Indices; }
+			size_t GetTriangleCount() const { return m_Indices.size() / 3; }
+			// 当前各三角形的分组，剩余三角形保持原有的相对顺序
+			const std::vector<UINT>& GetTriangleGroups() const { return m_TriangleGroups; }
+			// 当前的几何误差(模型空间距离)
+			float GetError() const { return static_cast<float>(sqrt(m_MaxErrorSq)) * m_Extent; }
+
+		private:
+			// 一次候选的折叠，将位置u合并到位置v
+			struct Collapse
+			{
+				UINT u, v;
+				double cost;		// 几何误差与属性差异之和，用于排序
+				double errorSq;		// 几何误差，用于检查上限
+			};
+
+			static uint64_t EdgeKey(UINT a, UINT b)
+			{
+				return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+			}
+
+			// 两个顶点属性差异的加权平方和
+			double AttributeError(IndexType a, IndexType b) const;
+			// 位置v上与顶点a属性最接近的副本，pError返回该差异
+			IndexType NearestCopy(IndexType a, UINT v, double* pError) const;
+			// 将位置u移动到位置v是否会使某个三角形翻转
+			bool HasFlip(UINT u, UINT v) const;
+
+		private:
+			std::vector<DirectX::XMFLOAT3> m_Positions;			// 各位置归一化到单位包围盒后的坐标
+			std::vector<Quadric> m_Quadrics;					// 各位置的二次误差
+			std::vector<VertexKind> m_Kinds;					// 各位置的拓扑类型
+			std::vector<UINT> m_PositionIds;					// 顶点所在的位置
+			std::vector<size_t> m_CopyOffsets;					// 位置到顶点副本的邻接表
+			std::vector<IndexType> m_Copies;
+			std::vector<DirectX::XMFLOAT3> m_Normals;			// 参与误差计算的顶点属性
+			std::vector<DirectX::XMFLOAT3> m_Colors;
+			std::vector<IndexType> m_Indices;					// 当前的三角形
+			std::vector<UINT> m_TriangleGroups;					// 当前各三角形的分组，未分组时为空
+			std::vector<size_t> m_AdjacencyOffsets;				// 位置到三角形的邻接表(每趟重建)
+			std::vector<UINT> m_Adjacency;
+			SimplifyOptions m_Options;
+			float m_Extent;										// 包围盒的最大边长
+			double m_MaxErrorSq;
+		};
+
+		template<class VertexType, class IndexType>
+		inline Simplifier<VertexType, IndexType>::Simplifier(const std::vector<VertexType>& vertices,
+			const std::vector<IndexType>& indices, const SimplifyOptions& options, std::vector<UINT> triangleGroups)
+			: m_Indices(indices.begin(), indices.begin() + indices.size() / 3 * 3), m_TriangleGroups(std::move(triangleGroups)),
+			m_Options(options), m_Extent(1.0f), m_MaxErrorSq(0.0)
+		{
+			using namespace DirectX;
+
+			size_t vertexCount = vertices.size();
+
+			// 合并位置相同的顶点
+			std::unordered_map<XMFLOAT3, UINT, PositionHash, PositionEqual> positionMap;
+			positionMap.reserve(vertexCount);
+			m_PositionIds.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				auto result = positionMap.emplace(vertices[i].pos, static_cast<UINT>(m_Positions.size()));
+				if (result.second)
+					m_Positions.push_back(vertices[i].pos);
+				m_PositionIds[i] = result.first->second;
+			}
+			size_t positionCount = m_Positions.size();
+
+			m_CopyOffsets.assign(positionCount + 1, 0);
+			for (UINT id : m_PositionIds)
+				++m_CopyOffsets[id + 1];
+			for (size_t i = 0; i < positionCount; ++i)
+				m_CopyOffsets[i + 1] += m_CopyOffsets[i];
+			m_Copies.resize(vertexCount);
+			std::vector<size_t> fillOffsets(m_CopyOffsets.begin(), m_CopyOffsets.end() - 1);
+			for (size_t i = 0; i < vertexCount; ++i)
+				m_Copies[fillOffsets[m_PositionIds[i]]++] = static_cast<IndexType>(i);
+
+			// 位置归一化到单位包围盒，使误差上限与属性权重不依赖于模型尺寸
+			XMFLOAT3 minPos(FLT_MAX, FLT_MAX, FLT_MAX), maxPos(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			for (const XMFLOAT3& p : m_Positions)
+			{
+				minPos.x = p.x < minPos.x ? p.x : minPos.x;
+				minPos.y = p.y < minPos.y ? p.y : minPos.y;
+				minPos.z = p.z < minPos.z ? p.z : minPos.z;
+				maxPos.x = p.x > maxPos.x ? p.x : maxPos.x;
+				maxPos.y = p.y > maxPos.y ? p.y : maxPos.y;
+				maxPos.z = p.z > maxPos.z ? p.z : maxPos.z;
+			}
+			float extent = (std::max)((std::max)(maxPos.x - minPos.x, maxPos.y - minPos.y), maxPos.z - minPos.z);
+			m_Extent = extent > 0.0f ? extent : 1.0f;
+			for (XMFLOAT3& p : m_Positions)
+				p = XMFLOAT3((p.x - minPos.x) / m_Extent, (p.y - minPos.y) / m_Extent, (p.z - minPos.z) / m_Extent);
+
+			// 读取参与误差计算的属性
+			int normalOffset = FindSemanticOffset<VertexType>("NORMAL");
+			int colorOffset = FindSemanticOffset<VertexType>("COLOR");
+			m_Normals.assign(vertexCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+			m_Colors.assign(vertexCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				const char* pVertex = reinterpret_cast<const char*>(&vertices[i]);
+				if (normalOffset >= 0)
+					memcpy(&m_Normals[i], pVertex + normalOffset, sizeof(XMFLOAT3));
+				if (colorOffset >= 0)
+					memcpy(&m_Colors[i], pVertex + colorOffset, sizeof(XMFLOAT3));
+			}
+
+			// 统计每条边被几个三角形共享
+			std::unordered_map<uint64_t, UINT> edgeCounts;
+			edgeCounts.reserve(m_Indices.size());
+			for (size_t i = 0; i < m_Indices.size(); i += 3)
+			{
+				for (int k = 0; k < 3; ++k)
+					++edgeCounts[EdgeKey(m_PositionIds[m_Indices[i + k]], m_PositionIds[m_Indices[i + (k + 1) % 3]])];
+			}
+
+			// 每个三角形的平面按面积加权加入三个位置的二次误差
+			// 只属于一个三角形的边为边界边，额外加入过该边且垂直于三角形的约束平面；非流形边上的位置锁定不动
+			m_Kinds.assign(positionCount, VertexKind::Manifold);
+			m_Quadrics.assign(positionCount, Quadric());
+			for (size_t i = 0; i < m_Indices.size(); i += 3)
+			{
+				UINT ids[3];
+				XMVECTOR p[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					ids[k] = m_PositionIds[m_Indices[i + k]];
+					p[k] = XMLoadFloat3(&m_Positions[ids[k]]);
+				}
+				XMVECTOR cross = XMVector3Cross(p[1] - p[0], p[2] - p[0]);
+				float area = XMVectorGetX(XMVector3Length(cross)) * 0.5f;
+				if (area <= 0.0f)
+					continue;
+				XMVECTOR normal = XMVector3Normalize(cross);
+				XMFLOAT3 n;
+				XMStoreFloat3(&n, normal);
+				double d = -XMVectorGetX(XMVector3Dot(normal, p[0]));
+				for (int k = 0; k < 3; ++k)
+					AddPlane(m_Quadrics[ids[k]], n.x, n.y, n.z, d, area);
+
+				for (int k = 0; k < 3; ++k)
+				{
+					UINT a = ids[k], b = ids[(k + 1) % 3];
+					UINT count = edgeCounts[EdgeKey(a, b)];
+					if (count == 1)
+					{
+						if (m_Kinds[a] == VertexKind::Manifold)
+							m_Kinds[a] = VertexKind::Border;
+						if (m_Kinds[b] == VertexKind::Manifold)
+							m_Kinds[b] = VertexKind::Border;
+
+						// 边界约束平面的权重取较大值，避免边界向内收缩
+						static constexpr double borderWeight = 10.0;
+						XMVECTOR edge = p[(k + 1) % 3] - p[k];
+						XMVECTOR planeNormal = XMVector3Normalize(XMVector3Cross(edge, normal));
+						XMFLOAT3 m;
+						XMStoreFloat3(&m, planeNormal);
+						double md = -XMVectorGetX(XMVector3Dot(planeNormal, p[k]));
+						double weight = XMVectorGetX(XMVector3Dot(edge, edge)) * borderWeight;
+						AddPlane(m_Quadrics[a], m.x, m.y, m.z, md, weight);
+						AddPlane(m_Quadrics[b], m.x, m.y, m.z, md, weight);
+					}
+					else if (count > 2)
+					{
+						m_Kinds[a] = VertexKind::Locked;
+						m_Kinds[b] = VertexKind::Locked;
+					}
+				}
+			}
+		}
+
+		template<class VertexType, class IndexType>
+		inline double Simplifier<VertexType, IndexType>::AttributeError(IndexType a, IndexType b) const
+		{
+			double dn[3] = { m_Normals[a].x - m_Normals[b].x, m_Normals[a].y - m_Normals[b].y, m_Normals[a].z - m_Normals[b].z };
+			double dc[3] = { m_Colors[a].x - m_Colors[b].x, m_Colors[a].y - m_Colors[b].y, m_Colors[a].z - m_Colors[b].z };
+			double normalWeight = m_Options.normalWeight, colorWeight = m_Options.colorWeight;
+			return normalWeight * normalWeight * (dn[0] * dn[0] + dn[1] * dn[1] + dn[2] * dn[2]) +
+				colorWeight * colorWeight * (dc[0] * dc[0] + dc[1] * dc[1] + dc[2] * dc[2]);
+		}
+
+		template<class VertexType, class IndexType>
+		inline IndexType Simplifier<VertexType, IndexType>::NearestCopy(IndexType a, UINT v, double* pError) const
+		{
+			IndexType nearest = m_Copies[m_CopyOffsets[v]];
+			double nearestError = DBL_MAX;
+			for (size_t c = m_CopyOffsets[v]; c < m_CopyOffsets[v + 1]; ++c)
+			{
+				double error = AttributeError(a, m_Copies[c]);
+				if (error < nearestError)
+				{
+					nearest = m_Copies[c];
+					nearestError = error;
+				}
+			}
+			*pError = nearestError;
+			return nearest;
+		}
+
+		template<class VertexType, class IndexType>
+		inline bool Simplifier<VertexType, IndexType>::HasFlip(UINT u, UINT v) const
+		{
+			using namespace DirectX;
+
+			XMVECTOR target = XMLoadFloat3(&m_Positions[v]);
+			for (size_t a = m_AdjacencyOffsets[u]; a < m_AdjacencyOffsets[u + 1]; ++a)
+			{
+				const IndexType* triangle = &m_Indices[m_Adjacency[a] * 3];
+				UINT ids[3] = { m_PositionIds[triangle[0]], m_PositionIds[triangle[1]], m_PositionIds[triangle[2]] };
+				if (ids[0] == v || ids[1] == v || ids[2] == v)
+					continue;
+
+				// 比较将u移动到v前后三角形的法线方向
+				XMVECTOR p[3], q[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					p[k] = XMLoadFloat3(&m_Positions[ids[k]]);
+					q[k] = ids[k] == u ? target : p[k];
+				}
+				XMVECTOR n0 = XMVector3Cross(p[1] - p[0], p[2] - p[0]);
+				XMVECTOR n1 = XMVector3Cross(q[1] - q[0], q[2] - q[0]);
+				if (XMVectorGetX(XMVector3Dot(n0, n1)) <= 0.0f)
+					return true;
+			}
+			return false;
+		}
+
+		template<class VertexType, class IndexType>
+		inline void Simplifier<VertexType, IndexType>::Simplify(size_t targetTriangleCount)
+		{
+			size_t positionCount = m_Positions.size();
+			double maxErrorSq = static_cast<double>(m_Options.maxError) * m_Options.maxError;
+
+			std::vector<Collapse> collapses;
+			std::vector<bool> touched(positionCount);
+			std::vector<IndexType> remap(m_PositionIds.size());
+			std::unordered_map<uint64_t, UINT> edgeCounts;
+			while (GetTriangleCount() > targetTriangleCount)
+			{
+				// 重建位置到三角形的邻接表
+				size_t triangleCount = GetTriangleCount();
+				m_AdjacencyOffsets.assign(positionCount + 1, 0);
+				for (IndexType index : m_Indices)
+					++m_AdjacencyOffsets[m_PositionIds[index] + 1];
+				for (size_t i = 0; i < positionCount; ++i)
+					m_AdjacencyOffsets[i + 1] += m_AdjacencyOffsets[i];
+				m_Adjacency.resize(m_Indices.size());
+				std::vector<size_t> fillOffsets(m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < m_Indices.size(); ++i)
+					m_Adjacency[fillOffsets[m_PositionIds[m_Indices[i]]]++] = static_cast<UINT>(i / 3);
+
+				edgeCounts.clear();
+				for (size_t i = 0; i < m_Indices.size(); i += 3)
+				{
+					for (int k = 0; k < 3; ++k)
+						++edgeCounts[EdgeKey(m_PositionIds[m_Indices[i + k]], m_PositionIds[m_Indices[i + (k + 1) % 3]])];
+				}
+
+				// 收集候选折叠：内部位置可折叠到任一相邻位置，边界位置只能沿边界边折叠
+				collapses.clear();
+				for (size_t i = 0; i < m_Indices.size(); i += 3)
+				{
+					for (int k = 0; k < 3; ++k)
+					{
+						UINT a = m_PositionIds[m_Indices[i + k]], b = m_PositionIds[m_Indices[i + (k + 1) % 3]];
+						bool borderEdge = edgeCounts[EdgeKey(a, b)] == 1;
+						UINT ends[2][2] = { { a, b }, { b, a } };
+						for (const auto& end : ends)
+						{
+							UINT u = end[0], v = end[1];
+							if (m_Kinds[u] == VertexKind::Locked || (m_Kinds[u] == VertexKind::Border && !borderEdge))
+								continue;
+
+							Quadric q = m_Quadrics[u];
+							q += m_Quadrics[v];
+							double errorSq = EvaluateQuadric(q, m_Positions[v]);
+							double attributeError = 0.0;
+							for (size_t c = m_CopyOffsets[u]; c < m_CopyOffsets[u + 1]; ++c)
+							{
+								double copyError;
+								NearestCopy(m_Copies[c], v, &copyError);
+								attributeError += copyError;
+							}
+							collapses.push_back({ u, v, errorSq + attributeError, errorSq });
+						}
+					}
+				}
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.cost < rhs.cost; });
+
+				// 按代价从小到大折叠，一趟内每个位置的邻域只修改一次，保证邻接表有效
+				std::fill(touched.begin(), touched.end(), false);
+				for (size_t i = 0; i < remap.size(); ++i)
+					remap[i] = static_cast<IndexType>(i);
+				size_t removedTriangles = 0, collapseCount = 0;
+				for (const Collapse& collapse : collapses)
+				{
+					if (removedTriangles >= triangleCount - targetTriangleCount)
+						break;
+					UINT u = collapse.u, v = collapse.v;
+					if (touched[u] || touched[v] || collapse.errorSq > maxErrorSq || HasFlip(u, v))
+						continue;
+
+					double copyError;
+					for (size_t c = m_CopyOffsets[u]; c < m_CopyOffsets[u + 1]; ++c)
+						remap[m_Copies[c]] = NearestCopy(m_Copies[c], v, &copyError);
+					m_Quadrics[v] += m_Quadrics[u];
+					m_MaxErrorSq = (std::max)(m_MaxErrorSq, collapse.errorSq);
+					++collapseCount;
+					for (size_t a = m_AdjacencyOffsets[u]; a < m_AdjacencyOffsets[u + 1]; ++a)
+					{
+						const IndexType* triangle = &m_Indices[m_Adjacency[a] * 3];
+						UINT ids[3] = { m_PositionIds[triangle[0]], m_PositionIds[triangle[1]], m_PositionIds[triangle[2]] };
+						if (ids[0] == v || ids[1] == v || ids[2] == v)
+							++removedTriangles;
+						touched[ids[0]] = touched[ids[1]] = touched[ids[2]] = true;
+					}
+				}
+
+				if (collapseCount == 0)
+					break;
+
+				// 应用折叠并移除位置重合的退化三角形
+				size_t writeIndex = 0;
+				for (size_t i = 0; i < m_Indices.size(); i += 3)
+				{
+					IndexType a = remap[m_Indices[i]], b = remap[m_Indices[i + 1]], c = remap[m_Indices[i + 2]];
+					UINT ia = m_PositionIds[a], ib = m_PositionIds[b], ic = m_PositionIds[c];
+					if (ia == ib || ib == ic || ic == ia)
+						continue;
+					if (!m_TriangleGroups.empty())
+						m_TriangleGroups[writeIndex / 3] = m_TriangleGroups[i / 3];
+					m_Indices[writeIndex++] = a;
+					m_Indices[writeIndex++] = b;
+					m_Indices[writeIndex++] = c;
+				}
+				m_Indices.resize(writeIndex);
+				if (!m_TriangleGroups.empty())
+					m_TriangleGroups.resize(writeIndex / 3);
+			}
+		}
+	}
+
+	template<class VertexType, class IndexType>
+	inline std::vector<IndexType> Simplify(const std::vector<VertexType>& vertices, const std::vector<IndexType>& indices,
+		size_t targetTriangleCount, const SimplifyOptions& options, float* pError)
+	{
+		Internal::Simplifier<VertexType, IndexType> simplifier(vertices, indices, options);
+		simplifier.Simplify(targetTriangleCount);
+		if (pError)
+			*pError = simplifier.GetError();
+		return simplifier.GetIndices();
+	}
+
+	template<class VertexType, class IndexType>
+	inline MeshLodChain<VertexType, IndexType> BuildLodChain(const Geometry::MeshData<VertexType, IndexType>& meshData,
+		const std::vector<float>& ratios, const SimplifyOptions& options)
+	{
+		MeshLodChain<VertexType, IndexType> chain;
+		chain.meshData = meshData;
+		chain.levels.push_back({ 0, static_cast<UINT>(meshData.indexVec.size()), 0.0f, meshData.submeshes });
+
+		// 以子网格的序号作为三角形的分组
+		size_t triangleCount = meshData.indexVec.size() / 3;
+		std::vector<UINT> triangleGroups;
+		if (!meshData.submeshes.empty())
+		{
+			triangleGroups.resize(triangleCount);
+			for (size_t s = 0; s < meshData.submeshes.size(); ++s)
+			{
+				const Geometry::Submesh& submesh = meshData.submeshes[s];
+				size_t first = submesh.indexStart / 3, last = (std::min)(first + submesh.indexCount / 3, triangleCount);
+				for (size_t t = first; t < last; ++t)
+					triangleGroups[t] = static_cast<UINT>(s);
+			}
+		}
+		Internal::Simplifier<VertexType, IndexType> simplifier(meshData.vertexVec, meshData.indexVec, options, std::move(triangleGroups));
+		for (float ratio : ratios)
+		{
+			size_t lastTriangleCount = simplifier.GetTriangleCount();
+			simplifier.Simplify(static_cast<size_t>(triangleCount * ratio));
+			if (simplifier.GetTriangleCount() >= lastTriangleCount)
+				break;
+
+			// 每级单独进行顶点缓存优化，顶点顺序保持不变以便共享
+			std::vector<IndexType> indices = simplifier.GetIndices();
+			LodLevel level = { static_cast<UINT>(chain.meshData.indexVec.size()), static_cast<UINT>(indices.size()),
+				simplifier.GetError() };
+			if (meshData.submeshes.empty())
+			{
+				MeshOptimizer::OptimizeVertexCache(indices, meshData.vertexVec.size());
+			}
+			else
+			{
+				// 剩余三角形按子网格的顺序排列，统计各子网格剩余的数目即得到其索引范围
+				level.submeshes = meshData.submeshes;
+				std::vector<UINT> groupSizes(meshData.submeshes.size(), 0);
+				for (UINT group : simplifier.GetTriangleGroups())
+					++groupSizes[group];
+				std::vector<IndexType> submeshIndices;
+				UINT indexStart = 0;
+				for (size_t s = 0; s < level.submeshes.size(); ++s)
+				{
+					auto first = indices.begin() + indexStart;
+					submeshIndices.assign(first, first + groupSizes[s] * 3);
+					MeshOptimizer::OptimizeVertexCache(submeshIndices, meshData.vertexVec.size());
+					std::copy(submeshIndices.begin(), submeshIndices.end(), first);
+					level.submeshes[s].indexStart = level.indexStart + indexStart;
+					level.submeshes[s].indexCount = groupSizes[s] * 3;
+					indexStart += groupSizes[s] * 3;
+				}
+			}
+			chain.levels.push_back(std::move(level));
+			chain.meshData.indexVec.insert(chain.meshData.indexVec.end(), indices.begin(), indices.end());
+		}
+		return chain;
+	}
+
+	inline size_t SelectLodLevel(const std::vector<LodLevel>& levels, float pixelsPerUnit, float maxPixelError)
+	{
+		size_t level = 0;
+		while (level + 1 < levels.size() && levels[level + 1].error * pixelsPerUnit <= maxPixelError)
+			++level;
+		return level;
+	}
+}
+
+#endif
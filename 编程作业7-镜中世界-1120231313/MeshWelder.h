@@ -0,0 +1,310 @@
+//***************************************************************************************
+// MeshWelder.h
+//
+// 基于空间哈希的顶点焊接：合并重合或近似重合的顶点，重映射索引并移除退化三角形
+// Spatial-hash vertex welding with attribute tolerances and degenerate triangle removal.
+//***************************************************************************************
+
+#ifndef MESHWELDER_H
+#define MESHWELDER_H
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <stdexcept>
+#include "Geometry.h"
+#include "ThreadPool.h"
+
+namespace MeshWelder
+{
+	// 作为属性容差时表示不比较该属性
+	static constexpr float IgnoreAttribute = FLT_MAX;
+
+	// 焊接参数
+	struct WeldOptions
+	{
+		float positionEpsilon = 1e-5f;		// 位置间距离不超过该值时视为重合，为0时只合并坐标完全相同的顶点
+		float normalTolerance = 1e-3f;		// 法线与切线各分量之差的上限
+		float texCoordTolerance = 1e-5f;	// 纹理坐标各分量之差的上限
+		float colorTolerance = 1e-3f;		// 颜色各分量之差的上限
+		bool threaded = true;				// 是否在线程池上并行计算哈希与匹配，结果与单线程逐位相同
+	};
+	// 非浮点格式(量化后的顶点)的属性只在容差为IgnoreAttribute时忽略，否则要求逐字节相同
+
+	// 焊接前后的统计
+	struct WeldReport
+	{
+		size_t vertexCountBefore;
+		size_t vertexCountAfter;
+		size_t triangleCountBefore;
+		size_t triangleCountAfter;		// 不含焊接后变为退化的三角形
+	};
+
+	// 合并位置与各属性都在容差内的顶点：每个顶点并入在它之前、与它匹配的第一个保留顶点，
+	// 保留的顶点保持原有的相对顺序；索引随之重映射，有两个角点相同的三角形被移除
+	// 空间哈希的格子边长为positionEpsilon的数倍，每个顶点只与距离epsilon内的格子(至多8个)中的顶点比较，期望时间为O(n)
+	// pSubmeshes不为nullptr时按移除的三角形更新各子网格的索引范围
+	template<class VertexType, class IndexType>
+	WeldReport WeldVertices(std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+		const WeldOptions& options = WeldOptions(), std::vector<Geometry::Submesh>* pSubmeshes = nullptr);
+
+	// 焊接网格，子网格跨越材质边界共享焊接后的顶点
+	template<class VertexType, class IndexType>
+	WeldReport Weld(Geometry::MeshData<VertexType, IndexType>& meshData, const WeldOptions& options = WeldOptions());
+}
+
+namespace MeshWelder
+{
+	namespace Internal
+	{
+		//
+		// 以下常量和函数仅供内部实现使用
+		//
+
+		// 并行任务的粒度(顶点或三角形数目)
+		static constexpr size_t GrainSize = 4096;
+		static constexpr UINT NoMatch = ~0u;
+
+		// 在线程池上或当前线程上处理[0, count)
+		template<class Func>
+		inline void ForRanges(size_t count, bool threaded, const Func& func)
+		{
+			if (threaded)
+				ThreadPool::Get().ParallelFor(count, GrainSize, func);
+			else if (count > 0)
+				func(size_t(0), count);
+		}
+
+		// 格子边长与positionEpsilon之比：格子越大，靠近格子边界、需要查找相邻格子的顶点越少
+		static constexpr float CellScale = 4.0f;
+
+		// 坐标所在的格子，cellSize为0时直接使用坐标的位模式
+		inline int64_t GetCell(float x, float cellSize)
+		{
+			if (cellSize > 0.0f)
+				return static_cast<int64_t>(floor(x / cellSize));
+			// 加0使-0与+0的位模式相同
+			x += 0.0f;
+			uint32_t bits;
+			memcpy(&bits, &x, sizeof(float));
+			return bits;
+		}
+
+		// 格子所在的桶，bucketBits为桶数目的以2为底的对数
+		inline size_t GetBucket(int64_t x, int64_t y, int64_t z, UINT bucketBits)
+		{
+			uint64_t h = static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull;
+			h ^= static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+			h ^= static_cast<uint64_t>(z) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+			return bucketBits > 0 ? static_cast<size_t>((h * 0x9E3779B97F4A7C15ull) >> (64 - bucketBits)) : 0;
+		}
+
+		// 按格式比较一个元素，浮点格式逐分量比较容差，其余格式逐字节比较
+		inline bool ElementEqual(const BYTE* a, const BYTE* b, DXGI_FORMAT format, size_t size, float tolerance)
+		{
+			if (tolerance == IgnoreAttribute)
+				return true;
+			if (format == DXGI_FORMAT_R32G32B32A32_FLOAT || format == DXGI_FORMAT_R32G32B32_FLOAT ||
+				format == DXGI_FORMAT_R32G32_FLOAT || format == DXGI_FORMAT_R32_FLOAT)
+			{
+				for (size_t i = 0; i < size; i += sizeof(float))
+				{
+					float x, y;
+					memcpy(&x, a + i, sizeof(float));
+					memcpy(&y, b + i, sizeof(float));
+					if (!(fabsf(x - y) <= tolerance))
+						return false;
+				}
+				return true;
+			}
+			return memcmp(a, b, size) == 0;
+		}
+
+		// 两个顶点是否可以合并
+		template<class VertexType>
+		inline bool VertexEqual(const VertexType& a, const VertexType& b, const WeldOptions& options)
+		{
+			float dx = a.pos.x - b.pos.x, dy = a.pos.y - b.pos.y, dz = a.pos.z - b.pos.z;
+			if (!(dx * dx + dy * dy + dz * dz <= options.positionEpsilon * options.positionEpsilon))
+				return false;
+
+			const BYTE* pa = reinterpret_cast<const BYTE*>(&a);
+			const BYTE* pb = reinterpret_cast<const BYTE*>(&b);
+			bool equal = true;
+			VertexTraits<VertexType>::ForEachElement([&](auto element) {
+				using Element = decltype(element);
+				float tolerance = 0.0f;
+				switch (Element::semantic)
+				{
+				case VertexSemantic::Position: return;
+				case VertexSemantic::Normal:
+				case VertexSemantic::Tangent: tolerance = options.normalTolerance; break;
+				case VertexSemantic::Color: tolerance = options.colorTolerance; break;
+				case VertexSemantic::TexCoord: tolerance = options.texCoordTolerance; break;
+				default: break;
+				}
+				equal = equal && ElementEqual(pa + Element::offset, pb + Element::offset, Element::format, Element::size, tolerance);
+			});
+			return equal;
+		}
+	}
+
+	template<class VertexType, class IndexType>
+	inline WeldReport WeldVertices(std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+		const WeldOptions& options, std::vector<Geometry::Submesh>* pSubmeshes)
+	{
+		using namespace DirectX;
+
+		WeldReport report = {};
+		size_t vertexCount = vertices.size();
+		size_t triangleCount = indices.size() / 3;
+		report.vertexCountBefore = report.vertexCountAfter = vertexCount;
+		report.triangleCountBefore = report.triangleCountAfter = triangleCount;
+		if (vertexCount == 0)
+			return report;
+		if (vertexCount > Internal::NoMatch)
+			throw std::runtime_error("Too many vertices to weld.");
+
+		// 桶数目取不小于顶点数的2的幂
+		UINT bucketBits = 0;
+		while ((size_t(1) << bucketBits) < vertexCount)
+			++bucketBits;
+		size_t bucketCount = size_t(1) << bucketBits;
+		float epsilon = options.positionEpsilon;
+		float cellSize = epsilon * Internal::CellScale;
+
+		// 并行计算每个顶点所在的桶，再按桶做计数排序，同一桶内顶点序号升序
+		std::vector<UINT> vertexBuckets(vertexCount);
+		Internal::ForRanges(vertexCount, options.threaded, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+			{
+				const XMFLOAT3& pos = vertices[i].pos;
+				vertexBuckets[i] = static_cast<UINT>(Internal::GetBucket(Internal::GetCell(pos.x, cellSize),
+					Internal::GetCell(pos.y, cellSize), Internal::GetCell(pos.z, cellSize), bucketBits));
+			}
+		});
+		std::vector<UINT> bucketOffsets(bucketCount + 1, 0);
+		for (size_t i = 0; i < vertexCount; ++i)
+			++bucketOffsets[vertexBuckets[i] + 1];
+		for (size_t b = 0; b < bucketCount; ++b)
+			bucketOffsets[b + 1] += bucketOffsets[b];
+		std::vector<UINT> bucketVertices(vertexCount);
+		{
+			std::vector<UINT> cursor(bucketOffsets.begin(), bucketOffsets.end() - 1);
+			for (size_t i = 0; i < vertexCount; ++i)
+				bucketVertices[cursor[vertexBuckets[i]]++] = static_cast<UINT>(i);
+		}
+
+		// 在距离epsilon内可能有顶点的格子中查找序号小于i、与i匹配的顶点；onlyKept为true时只考虑已保留的顶点
+		// 只有与格子边界的距离小于epsilon的坐标轴才需要查找该侧的相邻格子，epsilon为0时只查找自身所在的格子
+		std::vector<UINT> remap(vertexCount);
+		float reach = epsilon * 1.01f;
+		auto findMatch = [&](size_t i, bool onlyKept)
+		{
+			const XMFLOAT3& pos = vertices[i].pos;
+			int64_t lo[3] = { Internal::GetCell(pos.x - reach, cellSize), Internal::GetCell(pos.y - reach, cellSize),
+				Internal::GetCell(pos.z - reach, cellSize) };
+			int64_t hi[3] = { Internal::GetCell(pos.x + reach, cellSize), Internal::GetCell(pos.y + reach, cellSize),
+				Internal::GetCell(pos.z + reach, cellSize) };
+			UINT best = Internal::NoMatch;
+			for (int64_t z = lo[2]; z <= hi[2]; ++z)
+				for (int64_t y = lo[1]; y <= hi[1]; ++y)
+					for (int64_t x = lo[0]; x <= hi[0]; ++x)
+					{
+						size_t bucket = Internal::GetBucket(x, y, z, bucketBits);
+						for (UINT k = bucketOffsets[bucket]; k < bucketOffsets[bucket + 1]; ++k)
+						{
+							UINT j = bucketVertices[k];
+							if (j >= best || j >= i)
+								break;
+							if ((!onlyKept || remap[j] == j) && Internal::VertexEqual(vertices[i], vertices[j], options))
+								best = j;
+						}
+					}
+			return best;
+		};
+
+		// 并行求出每个顶点序号最小的匹配；若它本身被保留，则它也是序号最小的匹配保留顶点，
+		// 否则(匹配链较长时才会出现)再串行查找一次，结果与逐个顶点串行处理相同
+		std::vector<UINT> firstMatch(vertexCount);
+		Internal::ForRanges(vertexCount, options.threaded, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+				firstMatch[i] = static_cast<UINT>(findMatch(i, false));
+		});
+		size_t keptCount = 0;
+		std::vector<UINT> newIndices(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			UINT match = firstMatch[i];
+			if (match != Internal::NoMatch && remap[match] != match)
+				match = findMatch(i, true);
+			if (match == Internal::NoMatch)
+			{
+				remap[i] = static_cast<UINT>(i);
+				newIndices[i] = static_cast<UINT>(keptCount++);
+			}
+			else
+			{
+				remap[i] = match;
+				newIndices[i] = newIndices[match];
+			}
+		}
+		// 查找过程中需要读取原位置的顶点，全部确定后再压缩
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			if (remap[i] == i && newIndices[i] != i)
+				vertices[newIndices[i]] = vertices[i];
+		}
+		vertices.resize(keptCount);
+		report.vertexCountAfter = keptCount;
+
+		// 重映射索引，标记退化三角形后压缩
+		std::vector<BYTE> keepTriangle(triangleCount);
+		Internal::ForRanges(triangleCount, options.threaded, [&](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; ++t)
+			{
+				IndexType* tri = &indices[t * 3];
+				for (int c = 0; c < 3; ++c)
+					tri[c] = static_cast<IndexType>(newIndices[tri[c]]);
+				keepTriangle[t] = tri[0] != tri[1] && tri[1] != tri[2] && tri[2] != tri[0];
+			}
+		});
+		size_t keptTriangles = 0;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			if (!keepTriangle[t])
+				continue;
+			if (keptTriangles != t)
+				memcpy(&indices[keptTriangles * 3], &indices[t * 3], 3 * sizeof(IndexType));
+			++keptTriangles;
+		}
+		indices.resize(keptTriangles * 3);
+
+		// 压缩保持三角形的顺序，子网格的新范围即其中保留下来的三角形
+		if (pSubmeshes)
+		{
+			UINT indexStart = 0;
+			for (Geometry::Submesh& submesh : *pSubmeshes)
+			{
+				size_t first = submesh.indexStart / 3, last = (std::min)(first + submesh.indexCount / 3, triangleCount);
+				UINT kept = 0;
+				for (size_t t = first; t < last; ++t)
+					kept += keepTriangle[t];
+				submesh.indexStart = indexStart;
+				submesh.indexCount = kept * 3;
+				indexStart += kept * 3;
+			}
+		}
+		report.triangleCountAfter = keptTriangles;
+		return report;
+	}
+
+	template<class VertexType, class IndexType>
+	inline WeldReport Weld(Geometry::MeshData<VertexType, IndexType>& meshData, const WeldOptions& options)
+	{
+		return WeldVertices(meshData.vertexVec, meshData.indexVec, options, &meshData.submeshes);
+	}
+}
+
+#endif
@@ -0,0 +1,368 @@
+//***************************************************************************************
+// MeshletBuilder.h
+//
+// 网格簇(meshlet)的划分、包围球与法线锥计算，以及CPU端的簇级剔除
+// Meshlet partitioning with bounding spheres and normal cones, and CPU cluster culling.
+//***************************************************************************************
+
+#ifndef MESHLETBUILDER_H
+#define MESHLETBUILDER_H
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include "Geometry.h"
+
+namespace MeshletBuilder
+{
+	// 一个网格簇，其三角形在索引缓冲区中连续存放
+	struct Meshlet
+	{
+		UINT indexStart;				// 在索引数组中的起始位置
+		UINT indexCount;				// 索引数目
+		UINT vertexCount;				// 引用的不同顶点数目
+		DirectX::XMFLOAT3 center;		// 包围球球心(模型空间)
+		float radius;					// 包围球半径
+		DirectX::XMFLOAT3 coneAxis;		// 法线锥的轴向，簇内三角形法线都在锥内
+		float coneCutoff;				// 法线锥半角的正弦，为1时表示法线过于分散，不做背面剔除
+	};
+
+	// 一段待绘制的索引范围
+	struct DrawRange
+	{
+		UINT indexStart;
+		UINT indexCount;
+	};
+
+	// 剔除统计
+	struct CullStatistics
+	{
+		UINT meshletCount;		// 参与剔除的簇数目
+		UINT frustumCulled;		// 因位于视锥体外被剔除的簇数目
+		UINT backfaceCulled;	// 因整簇背向摄像机被剔除的簇数目
+	};
+
+	// 将索引数组中[indexStart, indexStart + indexCount)范围内的三角形划分为至多maxVertices个顶点、maxTriangles个三角形的簇
+	// 范围内的三角形会被重排为按簇连续存放，簇内保持原有的相对顺序以保留顶点缓存优化的效果
+	// coneWeight越大，簇内的三角形朝向越一致，越容易被背面剔除
+	template<class VertexType, class IndexType>
+	std::vector<Meshlet> BuildMeshlets(const std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+		size_t indexStart, size_t indexCount, UINT maxVertices = 64, UINT maxTriangles = 124, float coneWeight = 2.0f);
+
+	// 对整个网格划分簇
+	template<class VertexType, class IndexType>
+	std::vector<Meshlet> BuildMeshlets(Geometry::MeshData<VertexType, IndexType>& meshData,
+		UINT maxVertices = 64, UINT maxTriangles = 124, float coneWeight = 2.0f);
+
+	// 剔除位于视锥体外或整簇背向摄像机的簇，相邻的可见簇合并为一段索引范围写入ranges
+	// transforms为同一次绘制产生的所有副本(至多8个)的世界变换，例如几何着色器输出的镜像副本，簇在任一副本中可见即保留
+	// 默认光栅化状态(顺时针为正面、剔除背面)下，行列式为负的变换会翻转环绕方向，此时按翻转后的正面判断
+	CullStatistics CullMeshlets(const std::vector<Meshlet>& meshlets, const DirectX::XMMATRIX* transforms, size_t transformCount,
+		const DirectX::XMMATRIX& viewProj, const DirectX::XMFLOAT3& eyePos, std::vector<DrawRange>& ranges);
+}
+
+namespace MeshletBuilder
+{
+	namespace Internal
+	{
+		//
+		// 以下函数仅供内部实现使用
+		//
+
+		// 计算簇的包围球与法线锥
+		template<class VertexType, class IndexType>
+		inline void ComputeMeshletBounds(const std::vector<VertexType>& vertices, const IndexType* indices,
+			const std::vector<IndexType>& meshletVertices, Meshlet& meshlet)
+		{
+			using namespace DirectX;
+
+			// 以包围盒中心为球心
+			XMVECTOR minPos = XMVectorReplicate(FLT_MAX), maxPos = XMVectorReplicate(-FLT_MAX);
+			for (IndexType index : meshletVertices)
+			{
+				XMVECTOR pos = XMLoadFloat3(&vertices[index].pos);
+				minPos = XMVectorMin(minPos, pos);
+				maxPos = XMVectorMax(maxPos, pos);
+			}
+			XMVECTOR center = (minPos + maxPos) * 0.5f;
+			float radius = 0.0f;
+			for (IndexType index : meshletVertices)
+				radius = (std::max)(radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&vertices[index].pos) - center)));
+			XMStoreFloat3(&meshlet.center, center);
+			meshlet.radius = radius;
+
+			// 法线锥的轴取各三角形单位法线的平均，半角由与轴夹角最大的法线决定
+			std::vector<XMFLOAT3> normals;
+			normals.reserve(meshlet.indexCount / 3);
+			XMVECTOR axis = XMVectorZero();
+			for (UINT i = 0; i < meshlet.indexCount; i += 3)
+			{
+				XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i]].pos);
+				XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i + 1]].pos);
+				XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i + 2]].pos);
+				XMVECTOR cross = XMVector3Cross(p1 - p0, p2 - p0);
+				if (XMVectorGetX(XMVector3LengthSq(cross)) <= 0.0f)
+					continue;
+				XMVECTOR normal = XMVector3Normalize(cross);
+				normals.push_back(XMFLOAT3());
+				XMStoreFloat3(&normals.back(), normal);
+				axis += normal;
+			}
+
+			float minDot = 1.0f;
+			if (normals.empty() || XMVectorGetX(XMVector3LengthSq(axis)) <= 0.0f)
+				minDot = 0.0f;
+			else
+			{
+				axis = XMVector3Normalize(axis);
+				for (const XMFLOAT3& normal : normals)
+					minDot = (std::min)(minDot, XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&normal))));
+			}
+
+			// 法线锥接近或超过半球时几乎无法剔除，直接视为不可剔除
+			if (minDot <= 0.1f)
+			{
+				meshlet.coneAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+				meshlet.coneCutoff = 1.0f;
+			}
+			else
+			{
+				XMStoreFloat3(&meshlet.coneAxis, axis);
+				meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+			}
+		}
+	}
+
+	template<class VertexType, class IndexType>
+	inline std::vector<Meshlet> BuildMeshlets(const std::vector<VertexType>& vertices, std::vector<IndexType>& indices,
+		size_t indexStart, size_t indexCount, UINT maxVertices, UINT maxTriangles, float coneWeight)
+	{
+		using namespace DirectX;
+
+		std::vector<Meshlet> meshlets;
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0)
+			return meshlets;
+		const IndexType* triangles = indices.data() + indexStart;
+		size_t vertexCount = vertices.size();
+
+		// 位置相同的顶点(法线接缝处的副本)视为相邻，使按面分开法线的网格也能形成连通的簇
+		std::vector<UINT> positionIds(vertexCount);
+		{
+			std::vector<UINT> order(vertexCount);
+			for (size_t i = 0; i < vertexCount; ++i)
+				order[i] = static_cast<UINT>(i);
+			auto lessPos = [&](UINT lhs, UINT rhs)
+			{
+				const XMFLOAT3& a = vertices[lhs].pos;
+				const XMFLOAT3& b = vertices[rhs].pos;
+				return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+			};
+			std::sort(order.begin(), order.end(), lessPos);
+			for (size_t i = 0; i < vertexCount; ++i)
+				positionIds[order[i]] = i > 0 && !lessPos(order[i - 1], order[i]) ? positionIds[order[i - 1]] : static_cast<UINT>(i);
+		}
+
+		// 位置到三角形的邻接表
+		std::vector<UINT> adjacencyOffsets(vertexCount + 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++adjacencyOffsets[positionIds[triangles[i]] + 1];
+		for (size_t i = 0; i < vertexCount; ++i)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		std::vector<UINT> adjacency(triangleCount * 3);
+		{
+			std::vector<UINT> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < triangleCount * 3; ++i)
+				adjacency[fillOffsets[positionIds[triangles[i]]]++] = static_cast<UINT>(i / 3);
+		}
+
+		// 三角形的质心与单位法线，距离以平均三角形尺寸为单位
+		std::vector<XMFLOAT3> centroids(triangleCount), normals(triangleCount);
+		float totalArea = 0.0f;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&vertices[triangles[t * 3]].pos);
+			XMVECTOR p1 = XMLoadFloat3(&vertices[triangles[t * 3 + 1]].pos);
+			XMVECTOR p2 = XMLoadFloat3(&vertices[triangles[t * 3 + 2]].pos);
+			XMVECTOR cross = XMVector3Cross(p1 - p0, p2 - p0);
+			float length = XMVectorGetX(XMVector3Length(cross));
+			totalArea += length * 0.5f;
+			XMStoreFloat3(&centroids[t], (p0 + p1 + p2) / 3.0f);
+			XMStoreFloat3(&normals[t], length > 0.0f ? cross / length : XMVectorZero());
+		}
+		float triangleSize = sqrtf(totalArea / triangleCount);
+		float distanceScale = triangleSize > 0.0f ? 1.0f / triangleSize : 0.0f;
+
+		std::vector<bool> emitted(triangleCount);
+		std::vector<UINT> vertexMeshlet(vertexCount, UINT_MAX);	// 顶点当前所属的簇
+		std::vector<IndexType> meshletVertices;
+		std::vector<UINT> meshletTriangles;
+		std::vector<IndexType> output;
+		output.reserve(triangleCount * 3);
+
+		size_t seed = 0;
+		while (output.size() < triangleCount * 3)
+		{
+			// 以扫描顺序中的下一个未输出三角形为种子开始新簇
+			while (emitted[seed])
+				++seed;
+			UINT meshletId = static_cast<UINT>(meshlets.size());
+			meshletVertices.clear();
+			meshletTriangles.clear();
+			XMVECTOR centroidSum = XMVectorZero(), normalSum = XMVectorZero();
+
+			size_t next = seed;
+			while (next != SIZE_MAX)
+			{
+				emitted[next] = true;
+				meshletTriangles.push_back(static_cast<UINT>(next));
+				for (int k = 0; k < 3; ++k)
+				{
+					IndexType index = triangles[next * 3 + k];
+					if (vertexMeshlet[index] != meshletId)
+					{
+						vertexMeshlet[index] = meshletId;
+						meshletVertices.push_back(index);
+					}
+				}
+				centroidSum += XMLoadFloat3(&centroids[next]);
+				normalSum += XMLoadFloat3(&normals[next]);
+				if (meshletTriangles.size() >= maxTriangles)
+					break;
+
+				// 在与簇相邻的三角形中，优先选新增顶点最少的，其次选离簇中心近且朝向一致的
+				XMVECTOR meshletCentroid = centroidSum / static_cast<float>(meshletTriangles.size());
+				XMVECTOR meshletNormal = XMVector3Normalize(normalSum);
+				next = SIZE_MAX;
+				int bestNewVertices = 4;
+				float bestSpread = FLT_MAX;
+				for (IndexType vertex : meshletVertices)
+				{
+					UINT position = positionIds[vertex];
+					for (UINT a = adjacencyOffsets[position]; a < adjacencyOffsets[position + 1]; ++a)
+					{
+						UINT t = adjacency[a];
+						if (emitted[t])
+							continue;
+						int newVertices = (vertexMeshlet[triangles[t * 3]] != meshletId) +
+							(vertexMeshlet[triangles[t * 3 + 1]] != meshletId) + (vertexMeshlet[triangles[t * 3 + 2]] != meshletId);
+						if (meshletVertices.size() + newVertices > maxVertices || newVertices > bestNewVertices)
+							continue;
+						float spread = XMVectorGetX(XMVector3Length(XMLoadFloat3(&centroids[t]) - meshletCentroid)) * distanceScale +
+							coneWeight * (1.0f - XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normals[t]), meshletNormal)));
+						if (newVertices < bestNewVertices || spread < bestSpread)
+						{
+							next = t;
+							bestNewVertices = newVertices;
+							bestSpread = spread;
+						}
+					}
+				}
+			}
+
+			// 簇内三角形保持原有的相对顺序
+			std::sort(meshletTriangles.begin(), meshletTriangles.end());
+			Meshlet meshlet = {};
+			meshlet.indexStart = static_cast<UINT>(indexStart + output.size());
+			meshlet.indexCount = static_cast<UINT>(meshletTriangles.size() * 3);
+			meshlet.vertexCount = static_cast<UINT>(meshletVertices.size());
+			size_t outputStart = output.size();
+			for (UINT t : meshletTriangles)
+				output.insert(output.end(), triangles + t * 3, triangles + t * 3 + 3);
+			Internal::ComputeMeshletBounds(vertices, output.data() + outputStart, meshletVertices, meshlet);
+			meshlets.push_back(meshlet);
+		}
+
+		std::copy(output.begin(), output.end(), indices.begin() + indexStart);
+		return meshlets;
+	}
+
+	template<class VertexType, class IndexType>
+	inline std::vector<Meshlet> BuildMeshlets(Geometry::MeshData<VertexType, IndexType>& meshData,
+		UINT maxVertices, UINT maxTriangles, float coneWeight)
+	{
+		return BuildMeshlets(meshData.vertexVec, meshData.indexVec, 0, meshData.indexVec.size(), maxVertices, maxTriangles, coneWeight);
+	}
+
+	inline CullStatistics CullMeshlets(const std::vector<Meshlet>& meshlets, const DirectX::XMMATRIX* transforms, size_t transformCount,
+		const DirectX::XMMATRIX& viewProj, const DirectX::XMFLOAT3& eyePos, std::vector<DrawRange>& ranges)
+	{
+		using namespace DirectX;
+
+		// 每个副本在模型空间中的视锥体平面与摄像机位置
+		struct CopyView
+		{
+			XMFLOAT4 planes[6];
+			XMFLOAT3 eyePos;
+			float facing;	// 翻转环绕方向时为-1
+		};
+		static constexpr size_t maxCopies = 8;
+		CopyView views[maxCopies];
+		size_t viewCount = (std::min)(transformCount, maxCopies);
+		XMVECTOR eye = XMLoadFloat3(&eyePos);
+		for (size_t c = 0; c < viewCount; ++c)
+		{
+			// 从裁剪矩阵的列提取平面(z范围为[0, 1])，平面在模型空间中，与包围球直接比较
+			XMFLOAT4X4 m;
+			XMStoreFloat4x4(&m, transforms[c] * viewProj);
+			XMVECTOR col0 = XMVectorSet(m._11, m._21, m._31, m._41);
+			XMVECTOR col1 = XMVectorSet(m._12, m._22, m._32, m._42);
+			XMVECTOR col2 = XMVectorSet(m._13, m._23, m._33, m._43);
+			XMVECTOR col3 = XMVectorSet(m._14, m._24, m._34, m._44);
+			XMVECTOR planes[6] = { col3 + col0, col3 - col0, col3 + col1, col3 - col1, col2, col3 - col2 };
+			for (int p = 0; p < 6; ++p)
+				XMStoreFloat4(&views[c].planes[p], planes[p] / XMVector3Length(planes[p]));
+
+			XMVECTOR det;
+			XMMATRIX invTransform = XMMatrixInverse(&det, transforms[c]);
+			XMStoreFloat3(&views[c].eyePos, XMVector3TransformCoord(eye, invTransform));
+			views[c].facing = XMVectorGetX(XMMatrixDeterminant(transforms[c])) < 0.0f ? -1.0f : 1.0f;
+		}
+
+		CullStatistics stats = {};
+		stats.meshletCount = static_cast<UINT>(meshlets.size());
+		ranges.clear();
+		for (const Meshlet& meshlet : meshlets)
+		{
+			XMVECTOR center = XMLoadFloat3(&meshlet.center);
+			bool visible = false, inFrustum = false;
+			for (size_t c = 0; c < viewCount && !visible; ++c)
+			{
+				const CopyView& view = views[c];
+				bool outside = false;
+				for (int p = 0; p < 6 && !outside; ++p)
+					outside = XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&view.planes[p]), center)) < -meshlet.radius;
+				if (outside)
+					continue;
+				inFrustum = true;
+
+				// 从摄像机指向簇中心的方向与法线锥轴的夹角足够小时，簇内所有三角形都背向摄像机
+				XMVECTOR toCenter = center - XMLoadFloat3(&view.eyePos);
+				float distance = XMVectorGetX(XMVector3Length(toCenter));
+				float coneDot = view.facing * XMVectorGetX(XMVector3Dot(toCenter, XMLoadFloat3(&meshlet.coneAxis)));
+				visible = coneDot < meshlet.coneCutoff * distance + meshlet.radius;
+			}
+
+			if (!visible)
+			{
+				if (inFrustum)
+					++stats.backfaceCulled;
+				else
+					++stats.frustumCulled;
+				continue;
+			}
+
+			// 与上一段索引范围相邻时合并，减少绘制调用
+			if (!ranges.empty() && ranges.back().indexStart + ranges.back().indexCount == meshlet.indexStart)
+				ranges.back().indexCount += meshlet.indexCount;
+			else
+				ranges.push_back({ meshlet.indexStart, meshlet.indexCount });
+		}
+		return stats;
+	}
+}
+
+#endif
@@ -0,0 +1,344 @@
+#include "ObjReader.h"
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	m_hFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_hFile, &fileSize))
+	{
+		Close();
+		return false;
+	}
+
+	// 空文件无法创建映射，视为打开成功的空区域
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+	if (m_Size == 0)
+		return true;
+
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_hMapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const char*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+	m_pData = nullptr;
+	m_Size = 0;
+}
+
+TempFile::~TempFile()
+{
+	Close();
+}
+
+bool TempFile::Create()
+{
+	Close();
+
+	WCHAR tempDir[MAX_PATH + 1];
+	WCHAR tempPath[MAX_PATH];
+	DWORD length = GetTempPathW(MAX_PATH + 1, tempDir);
+	if (length == 0 || length > MAX_PATH || !GetTempFileNameW(tempDir, L"obj", 0, tempPath))
+		return false;
+
+	// GetTempFileName已创建了同名的空文件，以关闭时删除的方式重新打开
+	m_hFile = CreateFileW(tempPath, GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		DeleteFileW(tempPath);
+		return false;
+	}
+	return true;
+}
+
+void TempFile::Close()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+	m_pData = nullptr;
+}
+
+bool TempFile::Write(uint64_t offset, const void* data, size_t size)
+{
+	LARGE_INTEGER distance;
+	distance.QuadPart = static_cast<LONGLONG>(offset);
+	if (m_hFile == INVALID_HANDLE_VALUE || m_hMapping || !SetFilePointerEx(m_hFile, distance, nullptr, FILE_BEGIN))
+		return false;
+
+	const char* p = static_cast<const char*>(data);
+	while (size > 0)
+	{
+		DWORD chunk = size > 0x40000000u ? 0x40000000u : static_cast<DWORD>(size);
+		DWORD written = 0;
+		if (!WriteFile(m_hFile, p, chunk, &written, nullptr) || written != chunk)
+			return false;
+		p += chunk;
+		size -= chunk;
+	}
+	return true;
+}
+
+const char* TempFile::Map()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	m_pData = nullptr;
+
+	// 空文件无法创建映射
+	LARGE_INTEGER fileSize;
+	if (m_hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_hFile, &fileSize))
+		throw std::runtime_error("Failed to map temporary file.");
+	if (fileSize.QuadPart == 0)
+		return nullptr;
+
+	if (!m_hMapping)
+		m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping)
+		m_pData = static_cast<const char*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+		throw std::runtime_error("Failed to map temporary file.");
+	return m_pData;
+}
+
+WindowedFile::WindowedFile(size_t windowSize)
+	: m_Buffer(windowSize ? windowSize : 1)
+{
+}
+
+WindowedFile::~WindowedFile()
+{
+	Close();
+}
+
+bool WindowedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	m_hFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	return m_hFile != INVALID_HANDLE_VALUE;
+}
+
+void WindowedFile::Close()
+{
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_DataSize = 0;
+	m_Consumed = 0;
+	m_EndOfFile = false;
+}
+
+void WindowedFile::Rewind()
+{
+	LARGE_INTEGER distance;
+	distance.QuadPart = 0;
+	if (m_hFile == INVALID_HANDLE_VALUE || !SetFilePointerEx(m_hFile, distance, nullptr, FILE_BEGIN))
+		throw std::runtime_error("Failed to rewind file.");
+
+	m_DataSize = 0;
+	m_Consumed = 0;
+	m_EndOfFile = false;
+}
+
+bool WindowedFile::Next(const char*& begin, const char*& end)
+{
+	// 将上个窗口之后剩下的不完整行移到缓冲区开头
+	size_t remain = m_DataSize - m_Consumed;
+	memmove(m_Buffer.data(), m_Buffer.data() + m_Consumed, remain);
+	m_DataSize = remain;
+	m_Consumed = 0;
+
+	for (;;)
+	{
+		// 填满缓冲区
+		while (!m_EndOfFile && m_DataSize < m_Buffer.size())
+		{
+			size_t size = m_Buffer.size() - m_DataSize;
+			DWORD toRead = size > 0x40000000u ? 0x40000000u : static_cast<DWORD>(size);
+			DWORD read = 0;
+			if (m_hFile == INVALID_HANDLE_VALUE || !ReadFile(m_hFile, m_Buffer.data() + m_DataSize, toRead, &read, nullptr))
+				throw std::runtime_error("Failed to read file.");
+			m_EndOfFile = read == 0;
+			m_DataSize += read;
+		}
+
+		if (m_DataSize == 0)
+			return false;
+
+		// 文件末尾的最后一行可以没有换行符
+		if (m_EndOfFile)
+		{
+			m_Consumed = m_DataSize;
+			break;
+		}
+
+		// 窗口在最后一个换行符之后截断
+		size_t lineEnd = m_DataSize;
+		while (lineEnd > 0 && m_Buffer[lineEnd - 1] != '\n')
+			--lineEnd;
+		if (lineEnd > 0)
+		{
+			m_Consumed = lineEnd;
+			break;
+		}
+
+		// 整个窗口都在同一行内，扩大窗口
+		m_Buffer.resize(m_Buffer.size() * 2);
+	}
+
+	begin = m_Buffer.data();
+	end = begin + m_Consumed;
+	return true;
+}
+
+ObjReader::RecordCounts ObjReader::CountRecords(const char* begin, const char* end)
+{
+	RecordCounts counts = {};
+	const char* content = nullptr;
+	for (const char* p = begin; p < end; )
+	{
+		const char* lineEnd = LineEnd(p, end);
+		switch (ReadRecordType(p, lineEnd, content))
+		{
+		case RecordType::Position: ++counts.positionCount; break;
+		case RecordType::TexCoord: ++counts.texCoordCount; break;
+		case RecordType::Normal: ++counts.normalCount; break;
+		case RecordType::Face:
+		{
+			size_t faceVertexCount = CountFaceVertices(content, lineEnd);
+			++counts.faceCount;
+			counts.triangleCount += faceVertexCount > 2 ? faceVertexCount - 2 : 0;
+			break;
+		}
+		default: break;
+		}
+		p = lineEnd + 1;
+	}
+	return counts;
+}
+
+std::vector<const char*> ObjReader::SplitLines(const char* begin, const char* end, size_t maxChunks, size_t minChunkSize)
+{
+	size_t size = static_cast<size_t>(end - begin);
+	size_t chunkCount = minChunkSize ? size / minChunkSize : maxChunks;
+	if (chunkCount > maxChunks)
+		chunkCount = maxChunks;
+	if (chunkCount < 1)
+		chunkCount = 1;
+
+	std::vector<const char*> bounds;
+	bounds.reserve(chunkCount + 1);
+	bounds.push_back(begin);
+	for (size_t i = 1; i < chunkCount; ++i)
+	{
+		// 从等分点向后找到下一个行首
+		const char* p = begin + size * i / chunkCount;
+		if (p < bounds.back())
+			p = bounds.back();
+		p = LineEnd(p, end);
+		if (p < end)
+			++p;
+		if (p > bounds.back() && p < end)
+			bounds.push_back(p);
+	}
+	bounds.push_back(end);
+	return bounds;
+}
+
+bool ObjReader::ReadMaterialLibrary(const std::string& filePath, std::vector<MtlMaterial>& materials)
+{
+	MappedFile file;
+	if (!file.Open(filePath))
+		return false;
+
+	// newmtl之前的参数没有所属的材质，忽略
+	MtlMaterial* pMaterial = nullptr;
+	auto parseColor = [](const char* p, const char* lineEnd, DirectX::XMFLOAT3& color)
+	{
+		p = ParseFloat(p, lineEnd, color.x);
+		// 只给出一个分量时表示灰度
+		if (SkipSpaces(p, lineEnd) >= lineEnd)
+		{
+			color.y = color.z = color.x;
+			return;
+		}
+		p = ParseFloat(p, lineEnd, color.y);
+		p = ParseFloat(p, lineEnd, color.z);
+	};
+	const char* end = file.End();
+	for (const char* p = file.Begin(); p < end; )
+	{
+		const char* lineEnd = LineEnd(p, end);
+		const char* q = SkipSpaces(p, lineEnd);
+		const char* content = nullptr;
+		if ((content = MatchKeyword(q, lineEnd, "newmtl")))
+		{
+			materials.emplace_back();
+			pMaterial = &materials.back();
+			pMaterial->name = ReadName(content, lineEnd);
+		}
+		else if (pMaterial)
+		{
+			if ((content = MatchKeyword(q, lineEnd, "Ka")))
+				parseColor(content, lineEnd, pMaterial->ambient);
+			else if ((content = MatchKeyword(q, lineEnd, "Kd")))
+				parseColor(content, lineEnd, pMaterial->diffuse);
+			else if ((content = MatchKeyword(q, lineEnd, "Ks")))
+				parseColor(content, lineEnd, pMaterial->specular);
+			else if ((content = MatchKeyword(q, lineEnd, "Ns")))
+				ParseFloat(content, lineEnd, pMaterial->shininess);
+			else if ((content = MatchKeyword(q, lineEnd, "d")))
+				ParseFloat(content, lineEnd, pMaterial->opacity);
+			else if ((content = MatchKeyword(q, lineEnd, "Tr")))
+			{
+				float transparency = 0.0f;
+				ParseFloat(content, lineEnd, transparency);
+				pMaterial->opacity = 1.0f - transparency;
+			}
+		}
+		p = lineEnd + 1;
+	}
+	return true;
+}
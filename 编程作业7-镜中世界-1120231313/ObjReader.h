@@ -0,0 +1,299 @@
+//***************************************************************************************
+// ObjReader.h
+//
+// 基于内存映射或固定窗口顺序读取的OBJ模型文件读取
+// Memory-mapped and windowed OBJ model file reader.
+//***************************************************************************************
+
+#ifndef OBJREADER_H
+#define OBJREADER_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// 只读的内存映射文件
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// 打开并映射整个文件，失败返回false
+	bool Open(const std::string& filePath);
+	// 解除映射并关闭文件
+	void Close();
+
+	// 获取映射区域
+	const char* Begin() const { return m_pData; }
+	const char* End() const { return m_pData + m_Size; }
+	size_t Size() const { return m_Size; }
+
+private:
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;	// 文件句柄
+	HANDLE m_hMapping = nullptr;			// 文件映射句柄
+	const char* m_pData = nullptr;			// 映射视图首地址
+	size_t m_Size = 0;						// 文件字节数
+};
+
+// 按固定大小的窗口顺序读取的文件，每个窗口只包含完整的行
+class WindowedFile
+{
+public:
+	explicit WindowedFile(size_t windowSize);
+	~WindowedFile();
+
+	WindowedFile(const WindowedFile&) = delete;
+	WindowedFile& operator=(const WindowedFile&) = delete;
+
+	// 打开文件，失败返回false
+	bool Open(const std::string& filePath);
+	// 关闭文件
+	void Close();
+	// 回到文件开头重新读取
+	void Rewind();
+
+	// 读取下一个窗口，[begin, end)由若干完整的行组成，文件读完时返回false
+	// 单行超过窗口大小时窗口会扩大到能容纳该行
+	bool Next(const char*& begin, const char*& end);
+
+private:
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;	// 文件句柄
+	std::vector<char> m_Buffer;				// 窗口缓冲区
+	size_t m_DataSize = 0;					// 缓冲区中已读入的字节数
+	size_t m_Consumed = 0;					// 缓冲区中已交出的字节数
+	bool m_EndOfFile = false;				// 是否已读到文件末尾
+};
+
+// 系统临时目录中名字唯一的临时文件，先写入再以只读方式映射
+// 文件以关闭时删除的方式打开，句柄关闭(包括进程异常退出)后由系统删除
+class TempFile
+{
+public:
+	TempFile() = default;
+	~TempFile();
+
+	TempFile(const TempFile&) = delete;
+	TempFile& operator=(const TempFile&) = delete;
+
+	// 在临时目录中创建文件，失败返回false
+	bool Create();
+	// 关闭文件，文件随之删除
+	void Close();
+
+	// 在offset处写入size字节，失败返回false；映射后不应再写入
+	bool Write(uint64_t offset, const void* data, size_t size);
+	// 映射整个文件并返回首地址，已有的视图先解除映射；文件为空时返回nullptr，失败时抛出异常
+	// 解除映射会释放视图中已访问的页，反复映射可以限制驻留内存
+	const char* Map();
+
+private:
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;	// 文件句柄
+	HANDLE m_hMapping = nullptr;			// 文件映射句柄
+	const char* m_pData = nullptr;			// 映射视图首地址
+};
+
+namespace ObjReader
+{
+	// 文件中各类记录的数目
+	struct RecordCounts
+	{
+		size_t positionCount;	// v
+		size_t texCoordCount;	// vt
+		size_t normalCount;		// vn
+		size_t faceCount;		// f
+		size_t triangleCount;	// 多边形面按扇形三角化后的三角形数目
+	};
+
+	// 记录类型
+	enum class RecordType { Other, Position, TexCoord, Normal, Face, UseMaterial, MaterialLibrary };
+
+	// 面记录中的一个顶点"v/vt/vn"，按文件中的原值保存(从1开始，负数为相对索引，0表示缺省)
+	struct FaceVertex
+	{
+		int position;
+		int texCoord;
+		int normal;
+	};
+
+	// 是否为行内空白
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// 跳过行内空白
+	inline const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	// 跳过当前词
+	inline const char* SkipToken(const char* p, const char* end)
+	{
+		while (p < end && !IsSpace(*p) && *p != '\n')
+			++p;
+		return p;
+	}
+
+	// 返回当前行的行尾(指向'\n'或end)
+	inline const char* LineEnd(const char* p, const char* end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+		return lineEnd ? lineEnd : end;
+	}
+
+	// 一行是否以关键字keyword开头且其后为空白，是则返回关键字之后的位置，否则返回nullptr
+	inline const char* MatchKeyword(const char* p, const char* lineEnd, const char* keyword)
+	{
+		size_t length = strlen(keyword);
+		if (static_cast<size_t>(lineEnd - p) <= length || memcmp(p, keyword, length) != 0 || !IsSpace(p[length]))
+			return nullptr;
+		return p + length + 1;
+	}
+
+	// 判断一行的记录类型，并返回记录内容的起始位置
+	inline RecordType ReadRecordType(const char* p, const char* lineEnd, const char*& content)
+	{
+		p = SkipSpaces(p, lineEnd);
+		if (lineEnd - p < 2)
+			return RecordType::Other;
+
+		if (p[0] == 'v' && IsSpace(p[1]))
+		{
+			content = p + 2;
+			return RecordType::Position;
+		}
+		if (p[0] == 'v' && p[1] == 't' && lineEnd - p > 2 && IsSpace(p[2]))
+		{
+			content = p + 3;
+			return RecordType::TexCoord;
+		}
+		if (p[0] == 'v' && p[1] == 'n' && lineEnd - p > 2 && IsSpace(p[2]))
+		{
+			content = p + 3;
+			return RecordType::Normal;
+		}
+		if (p[0] == 'f' && IsSpace(p[1]))
+		{
+			content = p + 2;
+			return RecordType::Face;
+		}
+		if (p[0] == 'u' && (content = MatchKeyword(p, lineEnd, "usemtl")))
+			return RecordType::UseMaterial;
+		if (p[0] == 'm' && (content = MatchKeyword(p, lineEnd, "mtllib")))
+			return RecordType::MaterialLibrary;
+		return RecordType::Other;
+	}
+
+	// 读取记录中的名字(材质名、文件名)，即去掉首尾空白后的剩余部分，名字中可以含有空格
+	inline std::string ReadName(const char* p, const char* lineEnd)
+	{
+		p = SkipSpaces(p, lineEnd);
+		while (lineEnd > p && IsSpace(lineEnd[-1]))
+			--lineEnd;
+		return std::string(p, lineEnd);
+	}
+
+	// 原地解析一个浮点数，失败时置0并跳过该词
+	inline const char* ParseFloat(const char* p, const char* end, float& value)
+	{
+		p = SkipSpaces(p, end);
+		if (p < end && *p == '+')
+			++p;
+		auto result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+		{
+			value = 0.0f;
+			return SkipToken(p, end);
+		}
+		return result.ptr;
+	}
+
+	// 原地解析面记录中的一个顶点，支持"v"、"v/vt"、"v//vn"与"v/vt/vn"四种写法
+	inline const char* ParseFaceVertex(const char* p, const char* end, FaceVertex& vertex)
+	{
+		vertex = {};
+		p = SkipSpaces(p, end);
+		p = std::from_chars(p, end, vertex.position).ptr;
+		if (p < end && *p == '/')
+		{
+			++p;
+			if (p < end && *p != '/')
+				p = std::from_chars(p, end, vertex.texCoord).ptr;
+			if (p < end && *p == '/')
+				p = std::from_chars(p + 1, end, vertex.normal).ptr;
+		}
+		return SkipToken(p, end);
+	}
+
+	// 统计一条面记录中的顶点数目
+	inline size_t CountFaceVertices(const char* p, const char* end)
+	{
+		size_t count = 0;
+		for (p = SkipSpaces(p, end); p < end && *p != '\n'; p = SkipSpaces(p, end))
+		{
+			p = SkipToken(p, end);
+			++count;
+		}
+		return count;
+	}
+
+	// 将文件中的索引转换为从0开始的索引，count为此前已出现的同类记录数目，total为整个文件中的数目
+	// 相对索引(负数)只能引用此前的记录；正数索引可以引用文件中后出现的记录，按total检查
+	// 缺省或越界时返回-1
+	inline int ResolveIndex(int index, size_t count, size_t total)
+	{
+		long long resolved = index > 0 ? index - 1LL : static_cast<long long>(count) + index;
+		long long limit = static_cast<long long>(index > 0 ? total : count);
+		return index != 0 && resolved >= 0 && resolved < limit ? static_cast<int>(resolved) : -1;
+	}
+
+	// 统计[begin, end)内各类记录的数目
+	RecordCounts CountRecords(const char* begin, const char* end);
+
+	// 将[begin, end)按行切分为至多maxChunks块，每块不小于minChunkSize字节(最后一块除外)
+	// 返回各块的边界，第i块为[bounds[i], bounds[i + 1])，且每个边界都位于行首
+	std::vector<const char*> SplitLines(const char* begin, const char* end, size_t maxChunks, size_t minChunkSize);
+
+	// MTL材质库中的一个材质，未出现的参数取默认值
+	struct MtlMaterial
+	{
+		std::string name;									// newmtl
+		DirectX::XMFLOAT3 ambient = { 0.2f, 0.2f, 0.2f };	// Ka
+		DirectX::XMFLOAT3 diffuse = { 0.8f, 0.8f, 0.8f };	// Kd
+		DirectX::XMFLOAT3 specular = { 0.0f, 0.0f, 0.0f };	// Ks
+		float shininess = 1.0f;								// Ns
+		float opacity = 1.0f;								// d，或1 - Tr
+	};
+
+	// 读取MTL材质库，追加到materials中；文件无法打开时返回false
+	bool ReadMaterialLibrary(const std::string& filePath, std::vector<MtlMaterial>& materials);
+
+	// 使用同一材质的一段连续三角形
+	struct MaterialGroup
+	{
+		std::string materialName;	// usemtl给出的材质名，第一条usemtl之前的面为空
+		uint32_t indexStart;		// 在索引数组中的起始位置
+		uint32_t indexCount;		// 索引数目
+	};
+
+	// 模型的材质分组，只记录名字与索引范围，材质参数由材质库给出
+	struct MaterialGroups
+	{
+		std::vector<std::string> libraries;		// mtllib引用的材质库，相对于OBJ文件所在目录
+		std::vector<MaterialGroup> groups;		// 按索引顺序排列，文件中没有usemtl时为空
+	};
+}
+
+#endif
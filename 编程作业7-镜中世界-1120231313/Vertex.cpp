@@ -1,39 +1,21 @@
 #include "Vertex.h"
 
-const D3D11_INPUT_ELEMENT_DESC VertexPos::inputLayout[1] = {
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
-
-const D3D11_INPUT_ELEMENT_DESC VertexPosColor::inputLayout[2] = {
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
-
-const D3D11_INPUT_ELEMENT_DESC VertexPosTex::inputLayout[2] = {
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
-
-const D3D11_INPUT_ELEMENT_DESC VertexPosSize::inputLayout[2] = {
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "SIZE", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
-
-const D3D11_INPUT_ELEMENT_DESC VertexPosNormalColor::inputLayout[3] = {
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
-
-const D3D11_INPUT_ELEMENT_DESC VertexPosNormalTex::inputLayout[3] = {
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
-
-const D3D11_INPUT_ELEMENT_DESC VertexPosNormalTangentTex::inputLayout[4] = {
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 40, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
\ No newline at end of file
+// 输入布局由Vertex.h中的VertexTraits生成
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPos::inputLayout)[1] = VertexTraits<VertexPos>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosColor::inputLayout)[2] = VertexTraits<VertexPosColor>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosTex::inputLayout)[2] = VertexTraits<VertexPosTex>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosSize::inputLayout)[2] = VertexTraits<VertexPosSize>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosNormalColor::inputLayout)[3] = VertexTraits<VertexPosNormalColor>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosNormalTex::inputLayout)[3] = VertexTraits<VertexPosNormalTex>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosNormalTangentTex::inputLayout)[4] = VertexTraits<VertexPosNormalTangentTex>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosNormalColorPacked::inputLayout)[3] = VertexTraits<VertexPosNormalColorPacked>::inputLayout;
+
+const D3D11_INPUT_ELEMENT_DESC (&VertexPosNormalTexPacked::inputLayout)[3] = VertexTraits<VertexPosNormalTexPacked>::inputLayout;
@@ -9,8 +9,123 @@
 #ifndef VERTEX_H
 #define VERTEX_H
 
+#include <cstddef>
 #include <d3d11_1.h>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+//
+// 顶点布局描述
+// 每种顶点结构体在文件末尾以VertexTraits特化描述一次各元素的语义、格式与位置，
+// 输入布局数组与Geometry中由VertexData到顶点的转换均在编译期由该描述生成
+//
+
+// 顶点元素的语义，顶点数据按分量分流存放时，语义的序号即所在顶点缓冲区的输入槽
+enum class VertexSemantic
+{
+	Position,
+	Normal,
+	Tangent,
+	Color,
+	TexCoord,
+	Size
+};
+
+// 分流存放时的顶点缓冲区数目
+static constexpr UINT VertexStreamCount = static_cast<UINT>(VertexSemantic::Size) + 1;
+
+// 语义对应的HLSL语义名
+constexpr const char* GetSemanticName(VertexSemantic semantic)
+{
+	switch (semantic)
+	{
+	case VertexSemantic::Position: return "POSITION";
+	case VertexSemantic::Normal: return "NORMAL";
+	case VertexSemantic::Tangent: return "TANGENT";
+	case VertexSemantic::Color: return "COLOR";
+	case VertexSemantic::TexCoord: return "TEXCOORD";
+	default: return "SIZE";
+	}
+}
+
+// 顶点格式的字节大小，仅包含本项目用到的格式，其余返回0
+constexpr size_t GetFormatSize(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+	case DXGI_FORMAT_R32G32B32_FLOAT: return 12;
+	case DXGI_FORMAT_R32G32_FLOAT: return 8;
+	case DXGI_FORMAT_R16G16B16A16_UNORM: return 8;
+	case DXGI_FORMAT_R16G16_SNORM: return 4;
+	case DXGI_FORMAT_R16G16_FLOAT: return 4;
+	case DXGI_FORMAT_R8G8B8A8_UNORM: return 4;
+	default: return 0;
+	}
+}
+
+// 顶点中的一个元素，Offset与Size取自结构体成员
+template<VertexSemantic Semantic, DXGI_FORMAT Format, size_t Offset, size_t Size>
+struct VertexElement
+{
+	static_assert(GetFormatSize(Format) == Size, "Vertex element format does not match the member size!");
+
+	static constexpr VertexSemantic semantic = Semantic;
+	static constexpr DXGI_FORMAT format = Format;
+	static constexpr size_t offset = Offset;
+	static constexpr size_t size = Size;
+
+	static constexpr D3D11_INPUT_ELEMENT_DESC GetDesc()
+	{
+		return { GetSemanticName(Semantic), 0, Format, 0, static_cast<UINT>(Offset), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	}
+
+	// 每种语义单独占用一个输入槽时的描述
+	static constexpr D3D11_INPUT_ELEMENT_DESC GetStreamDesc()
+	{
+		return { GetSemanticName(Semantic), 0, Format, static_cast<UINT>(Semantic), 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	}
+};
+
+// 检查各元素依次紧密排列且恰好覆盖整个顶点结构体
+template<class VertexType, class... Elements>
+constexpr bool IsVertexElementListPacked()
+{
+	constexpr size_t offsets[] = { Elements::offset... };
+	constexpr size_t sizes[] = { Elements::size... };
+	size_t end = 0;
+	for (size_t i = 0; i < sizeof...(Elements); ++i)
+	{
+		if (offsets[i] != end)
+			return false;
+		end += sizes[i];
+	}
+	return end == sizeof(VertexType);
+}
+
+// 按成员声明顺序列出顶点的全部元素，要求元素紧密排列、覆盖整个结构体
+template<class VertexType, class... Elements>
+struct VertexElementList
+{
+	static constexpr size_t elementCount = sizeof...(Elements);
+	static constexpr D3D11_INPUT_ELEMENT_DESC inputLayout[sizeof...(Elements)] = { Elements::GetDesc()... };
+	// 顶点数据按分量分流存放(Geometry::MeshDataSoA)时使用的输入布局
+	static constexpr D3D11_INPUT_ELEMENT_DESC streamInputLayout[sizeof...(Elements)] = { Elements::GetStreamDesc()... };
+
+	// 对每个元素调用func(Element{})
+	template<class Func>
+	static void ForEachElement(Func&& func)
+	{
+		(func(Elements{}), ...);
+	}
+
+	static_assert(IsVertexElementListPacked<VertexType, Elements...>(),
+		"Vertex elements must be listed in order and cover the whole vertex!");
+};
+
+// 顶点结构体的布局描述，由各顶点结构体特化
+template<class VertexType>
+struct VertexTraits;
 
 struct VertexPos
 {
@@ -25,7 +140,7 @@ struct VertexPos
 	constexpr VertexPos(const DirectX::XMFLOAT3& _pos) : pos(_pos) {}
 
 	DirectX::XMFLOAT3 pos;
-	static const D3D11_INPUT_ELEMENT_DESC inputLayout[1];
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[1];
 };
 
 struct VertexPosColor
@@ -43,7 +158,7 @@ struct VertexPosColor
 
 	DirectX::XMFLOAT3 pos;
 	DirectX::XMFLOAT4 color;
-	static const D3D11_INPUT_ELEMENT_DESC inputLayout[2];
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[2];
 };
 
 struct VertexPosTex
@@ -61,7 +176,7 @@ struct VertexPosTex
 
 	DirectX::XMFLOAT3 pos;
 	DirectX::XMFLOAT2 tex;
-	static const D3D11_INPUT_ELEMENT_DESC inputLayout[2];
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[2];
 };
 
 struct VertexPosSize
@@ -79,7 +194,7 @@ struct VertexPosSize
 
 	DirectX::XMFLOAT3 pos;
 	DirectX::XMFLOAT2 size;
-	static const D3D11_INPUT_ELEMENT_DESC inputLayout[2];
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[2];
 };
 
 struct VertexPosNormalColor
@@ -99,7 +214,7 @@ struct VertexPosNormalColor
 	DirectX::XMFLOAT3 pos;
 	DirectX::XMFLOAT3 normal;
 	DirectX::XMFLOAT4 color;
-	static const D3D11_INPUT_ELEMENT_DESC inputLayout[3];
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[3];
 };
 
 
@@ -120,7 +235,7 @@ struct VertexPosNormalTex
 	DirectX::XMFLOAT3 pos;
 	DirectX::XMFLOAT3 normal;
 	DirectX::XMFLOAT2 tex;
-	static const D3D11_INPUT_ELEMENT_DESC inputLayout[3];
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[3];
 };
 
 struct VertexPosNormalTangentTex
@@ -141,7 +256,123 @@ struct VertexPosNormalTangentTex
 	DirectX::XMFLOAT3 normal;
 	DirectX::XMFLOAT4 tangent;
 	DirectX::XMFLOAT2 tex;
-	static const D3D11_INPUT_ELEMENT_DESC inputLayout[4];
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[4];
 };
 
+//
+// 压缩顶点格式，编解码见VertexCompression.h
+// 位置为按网格包围盒归一化的16位UNORM(w分量不使用)，需配合解码矩阵还原到模型空间
+// 法线为八面体编码的2x16位SNORM，由着色器解码
+//
+
+struct VertexPosNormalColorPacked
+{
+	VertexPosNormalColorPacked() = default;
+
+	VertexPosNormalColorPacked(const VertexPosNormalColorPacked&) = default;
+	VertexPosNormalColorPacked& operator=(const VertexPosNormalColorPacked&) = default;
+
+	VertexPosNormalColorPacked(VertexPosNormalColorPacked&&) = default;
+	VertexPosNormalColorPacked& operator=(VertexPosNormalColorPacked&&) = default;
+
+	DirectX::PackedVector::XMUSHORTN4 pos;
+	DirectX::PackedVector::XMSHORTN2 normal;
+	DirectX::PackedVector::XMUBYTEN4 color;
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[3];
+};
+
+struct VertexPosNormalTexPacked
+{
+	VertexPosNormalTexPacked() = default;
+
+	VertexPosNormalTexPacked(const VertexPosNormalTexPacked&) = default;
+	VertexPosNormalTexPacked& operator=(const VertexPosNormalTexPacked&) = default;
+
+	VertexPosNormalTexPacked(VertexPosNormalTexPacked&&) = default;
+	VertexPosNormalTexPacked& operator=(VertexPosNormalTexPacked&&) = default;
+
+	DirectX::PackedVector::XMUSHORTN4 pos;
+	DirectX::PackedVector::XMSHORTN2 normal;
+	DirectX::PackedVector::XMHALF2 tex;
+	static const D3D11_INPUT_ELEMENT_DESC (&inputLayout)[3];
+};
+
+
+//
+// 各顶点结构体的布局描述
+//
+
+#define VERTEX_ELEMENT(VertexType, member, semantic, format) \
+	VertexElement<VertexSemantic::semantic, format, offsetof(VertexType, member), sizeof(VertexType::member)>
+
+template<>
+struct VertexTraits<VertexPos> : VertexElementList<VertexPos,
+	VERTEX_ELEMENT(VertexPos, pos, Position, DXGI_FORMAT_R32G32B32_FLOAT)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosColor> : VertexElementList<VertexPosColor,
+	VERTEX_ELEMENT(VertexPosColor, pos, Position, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosColor, color, Color, DXGI_FORMAT_R32G32B32A32_FLOAT)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosTex> : VertexElementList<VertexPosTex,
+	VERTEX_ELEMENT(VertexPosTex, pos, Position, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosTex, tex, TexCoord, DXGI_FORMAT_R32G32_FLOAT)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosSize> : VertexElementList<VertexPosSize,
+	VERTEX_ELEMENT(VertexPosSize, pos, Position, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosSize, size, Size, DXGI_FORMAT_R32G32_FLOAT)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosNormalColor> : VertexElementList<VertexPosNormalColor,
+	VERTEX_ELEMENT(VertexPosNormalColor, pos, Position, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosNormalColor, normal, Normal, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosNormalColor, color, Color, DXGI_FORMAT_R32G32B32A32_FLOAT)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosNormalTex> : VertexElementList<VertexPosNormalTex,
+	VERTEX_ELEMENT(VertexPosNormalTex, pos, Position, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosNormalTex, normal, Normal, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosNormalTex, tex, TexCoord, DXGI_FORMAT_R32G32_FLOAT)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosNormalTangentTex> : VertexElementList<VertexPosNormalTangentTex,
+	VERTEX_ELEMENT(VertexPosNormalTangentTex, pos, Position, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosNormalTangentTex, normal, Normal, DXGI_FORMAT_R32G32B32_FLOAT),
+	VERTEX_ELEMENT(VertexPosNormalTangentTex, tangent, Tangent, DXGI_FORMAT_R32G32B32A32_FLOAT),
+	VERTEX_ELEMENT(VertexPosNormalTangentTex, tex, TexCoord, DXGI_FORMAT_R32G32_FLOAT)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosNormalColorPacked> : VertexElementList<VertexPosNormalColorPacked,
+	VERTEX_ELEMENT(VertexPosNormalColorPacked, pos, Position, DXGI_FORMAT_R16G16B16A16_UNORM),
+	VERTEX_ELEMENT(VertexPosNormalColorPacked, normal, Normal, DXGI_FORMAT_R16G16_SNORM),
+	VERTEX_ELEMENT(VertexPosNormalColorPacked, color, Color, DXGI_FORMAT_R8G8B8A8_UNORM)>
+{
+};
+
+template<>
+struct VertexTraits<VertexPosNormalTexPacked> : VertexElementList<VertexPosNormalTexPacked,
+	VERTEX_ELEMENT(VertexPosNormalTexPacked, pos, Position, DXGI_FORMAT_R16G16B16A16_UNORM),
+	VERTEX_ELEMENT(VertexPosNormalTexPacked, normal, Normal, DXGI_FORMAT_R16G16_SNORM),
+	VERTEX_ELEMENT(VertexPosNormalTexPacked, tex, TexCoord, DXGI_FORMAT_R16G16_FLOAT)>
+{
+};
+
+#undef VERTEX_ELEMENT
+
 #endif
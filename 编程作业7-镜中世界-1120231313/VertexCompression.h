@@ -0,0 +1,316 @@
+//***************************************************************************************
+// VertexCompression.h
+//
+// 顶点属性的量化压缩：16位位置、八面体编码法线、RGBA8颜色与半精度纹理坐标
+// Vertex attribute quantization: 16-bit positions, octahedral normals, RGBA8 colors and half-float texcoords.
+//***************************************************************************************
+
+#ifndef VERTEXCOMPRESSION_H
+#define VERTEXCOMPRESSION_H
+
+#include <vector>
+#include <cfloat>
+#include <type_traits>
+#include <DirectXPackedVector.h>
+#include "Geometry.h"
+#include "MeshNormals.h"
+#include "ThreadPool.h"
+
+namespace VertexCompression
+{
+	// 位置的量化范围，模型空间位置 = 量化位置([0, 1]^3) * scale + offset
+	struct PositionBounds
+	{
+		DirectX::XMFLOAT3 offset;		// 包围盒最小点
+		DirectX::XMFLOAT3 scale;		// 包围盒各轴的边长
+
+		// 将量化位置还原到模型空间的矩阵，绘制时左乘世界矩阵
+		DirectX::XMMATRIX XM_CALLCONV GetDecodeMatrix() const;
+		// 量化带来的最大位置误差(各轴半个量化步长构成的向量长度)
+		float GetMaxError() const;
+	};
+
+	// 编码误差上界，由编码方式决定
+	// 八面体法线：2x16位SNORM的最大角度误差(弧度)
+	static constexpr float MaxNormalError = 1.0e-4f;
+	// RGBA8颜色：各分量的最大误差
+	static constexpr float MaxColorError = 0.5f / 255.0f;
+	// 半精度纹理坐标：[0, 1]内的最大相对误差
+	static constexpr float MaxTexCoordRelativeError = 1.0f / 2048.0f;
+
+	// 计算网格所有顶点位置的量化范围
+	template<class VertexType>
+	PositionBounds ComputePositionBounds(const std::vector<VertexType>& vertices);
+	// 计算连续存放的位置数组(如MeshDataSoA::positions)的量化范围
+	PositionBounds ComputePositionBounds(const DirectX::XMFLOAT3* positions, size_t count);
+
+	// 单个属性的编码与解码，整数格式均按最近值舍入
+	DirectX::PackedVector::XMUSHORTN4 XM_CALLCONV EncodePosition(DirectX::FXMVECTOR position, const PositionBounds& bounds);
+	DirectX::XMVECTOR XM_CALLCONV DecodePosition(const DirectX::PackedVector::XMUSHORTN4& packed, const PositionBounds& bounds);
+	DirectX::PackedVector::XMSHORTN2 XM_CALLCONV EncodeNormal(DirectX::FXMVECTOR normal);
+	DirectX::XMVECTOR XM_CALLCONV DecodeNormal(const DirectX::PackedVector::XMSHORTN2& packed);
+	DirectX::PackedVector::XMUBYTEN4 XM_CALLCONV EncodeColor(DirectX::FXMVECTOR color);
+	DirectX::XMVECTOR XM_CALLCONV DecodeColor(const DirectX::PackedVector::XMUBYTEN4& packed);
+	DirectX::PackedVector::XMHALF2 XM_CALLCONV EncodeTexCoord(DirectX::FXMVECTOR tex);
+	DirectX::XMVECTOR XM_CALLCONV DecodeTexCoord(const DirectX::PackedVector::XMHALF2& packed);
+
+	// 将网格转换为压缩顶点格式，目标顶点类型中的每个属性都由源顶点的同名成员编码得到
+	// 索引保持不变，位置的量化范围写入pBounds(可为nullptr)
+	template<class PackedVertexType, class VertexType, class IndexType>
+	Geometry::MeshData<PackedVertexType, IndexType> CompressMesh(const Geometry::MeshData<VertexType, IndexType>& meshData,
+		PositionBounds* pBounds = nullptr);
+
+	// 将压缩格式的网格还原为浮点顶点格式，目标顶点类型中的每个属性都由压缩顶点的同名成员解码得到
+	template<class VertexType, class PackedVertexType, class IndexType>
+	Geometry::MeshData<VertexType, IndexType> DecompressMesh(const Geometry::MeshData<PackedVertexType, IndexType>& meshData,
+		const PositionBounds& bounds);
+}
+
+namespace VertexCompression
+{
+	namespace Internal
+	{
+		//
+		// 以下结构体和函数仅供内部实现使用
+		//
+
+		// 并行编码的粒度(顶点数目)
+		static constexpr size_t GrainSize = 4096;
+
+		// 顶点类型是否含有对应的成员，normal成员使用MeshNormals::HasNormal
+		template<class VertexType, class = void>
+		struct HasColor : std::false_type {};
+		template<class VertexType>
+		struct HasColor<VertexType, decltype(void(std::declval<VertexType&>().color))> : std::true_type {};
+
+		template<class VertexType, class = void>
+		struct HasTex : std::false_type {};
+		template<class VertexType>
+		struct HasTex<VertexType, decltype(void(std::declval<VertexType&>().tex))> : std::true_type {};
+
+		// 分量符号，0视为正
+		inline DirectX::XMVECTOR XM_CALLCONV SignNotZero(DirectX::FXMVECTOR v)
+		{
+			using namespace DirectX;
+			return XMVectorSelect(g_XMNegativeOne, g_XMOne, XMVectorGreaterOrEqual(v, XMVectorZero()));
+		}
+	}
+
+	inline DirectX::XMMATRIX XM_CALLCONV PositionBounds::GetDecodeMatrix() const
+	{
+		using namespace DirectX;
+		return XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixTranslation(offset.x, offset.y, offset.z);
+	}
+
+	inline float PositionBounds::GetMaxError() const
+	{
+		using namespace DirectX;
+		XMVECTOR halfStep = XMLoadFloat3(&scale) * (0.5f / 65535.0f);
+		return XMVectorGetX(XMVector3Length(halfStep));
+	}
+
+	template<class VertexType>
+	inline PositionBounds ComputePositionBounds(const std::vector<VertexType>& vertices)
+	{
+		using namespace DirectX;
+
+		PositionBounds bounds = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f) };
+		if (vertices.empty())
+			return bounds;
+
+		XMVECTOR minPos = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maxPos = XMVectorReplicate(-FLT_MAX);
+		for (const VertexType& vertex : vertices)
+		{
+			XMVECTOR pos = XMLoadFloat3(&vertex.pos);
+			minPos = XMVectorMin(minPos, pos);
+			maxPos = XMVectorMax(maxPos, pos);
+		}
+		XMStoreFloat3(&bounds.offset, minPos);
+		XMStoreFloat3(&bounds.scale, maxPos - minPos);
+		return bounds;
+	}
+
+	inline PositionBounds ComputePositionBounds(const DirectX::XMFLOAT3* positions, size_t count)
+	{
+		using namespace DirectX;
+
+		PositionBounds bounds = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f) };
+		if (count == 0)
+			return bounds;
+
+		XMVECTOR minPos = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maxPos = XMVectorReplicate(-FLT_MAX);
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR pos = XMLoadFloat3(positions + i);
+			minPos = XMVectorMin(minPos, pos);
+			maxPos = XMVectorMax(maxPos, pos);
+		}
+		XMStoreFloat3(&bounds.offset, minPos);
+		XMStoreFloat3(&bounds.scale, maxPos - minPos);
+		return bounds;
+	}
+
+	inline DirectX::PackedVector::XMUSHORTN4 XM_CALLCONV EncodePosition(DirectX::FXMVECTOR position, const PositionBounds& bounds)
+	{
+		using namespace DirectX;
+		using namespace DirectX::PackedVector;
+
+		// 边长为0的轴上所有位置都量化为0
+		XMVECTOR scale = XMLoadFloat3(&bounds.scale);
+		XMVECTOR invScale = XMVectorSelect(XMVectorReciprocal(scale), XMVectorZero(), XMVectorEqual(scale, XMVectorZero()));
+		XMVECTOR unorm = XMVectorSaturate((position - XMLoadFloat3(&bounds.offset)) * invScale);
+
+		XMUSHORT4 quantized;
+		XMStoreUShort4(&quantized, XMVectorRound(XMVectorSetW(unorm, 1.0f) * 65535.0f));
+		XMUSHORTN4 packed;
+		packed.v = quantized.v;
+		return packed;
+	}
+
+	inline DirectX::XMVECTOR XM_CALLCONV DecodePosition(const DirectX::PackedVector::XMUSHORTN4& packed, const PositionBounds& bounds)
+	{
+		using namespace DirectX;
+		using namespace DirectX::PackedVector;
+		XMVECTOR unorm = XMLoadUShortN4(&packed);
+		return XMVectorSetW(XMVectorMultiplyAdd(unorm, XMLoadFloat3(&bounds.scale), XMLoadFloat3(&bounds.offset)), 1.0f);
+	}
+
+	inline DirectX::PackedVector::XMSHORTN2 XM_CALLCONV EncodeNormal(DirectX::FXMVECTOR normal)
+	{
+		using namespace DirectX;
+		using namespace DirectX::PackedVector;
+
+		// 投影到八面体|x| + |y| + |z| = 1上，下半球沿对角线折叠到上半球的外侧
+		XMVECTOR absNormal = XMVectorAbs(normal);
+		XMVECTOR l1 = XMVectorSplatX(absNormal) + XMVectorSplatY(absNormal) + XMVectorSplatZ(absNormal);
+		XMVECTOR oct = XMVectorSelect(XMVectorZero(), normal / l1, XMVectorGreater(l1, XMVectorZero()));
+		if (XMVectorGetZ(oct) < 0.0f)
+		{
+			XMVECTOR swapped = XMVectorSwizzle<1, 0, 2, 3>(XMVectorAbs(oct));
+			oct = (g_XMOne - swapped) * Internal::SignNotZero(oct);
+		}
+
+		XMSHORT2 quantized;
+		XMStoreShort2(&quantized, XMVectorRound(XMVectorClamp(oct, g_XMNegativeOne, g_XMOne) * 32767.0f));
+		XMSHORTN2 packed;
+		packed.v = quantized.v;
+		return packed;
+	}
+
+	inline DirectX::XMVECTOR XM_CALLCONV DecodeNormal(const DirectX::PackedVector::XMSHORTN2& packed)
+	{
+		using namespace DirectX;
+		using namespace DirectX::PackedVector;
+
+		XMVECTOR oct = XMLoadShortN2(&packed);
+		XMVECTOR absOct = XMVectorAbs(oct);
+		float z = 1.0f - XMVectorGetX(absOct) - XMVectorGetY(absOct);
+		// z < 0时还原折叠：xy各自向原点移回-z
+		XMVECTOR fold = XMVectorReplicate((std::max)(-z, 0.0f));
+		oct -= fold * Internal::SignNotZero(oct);
+		return XMVector3Normalize(XMVectorSetZ(oct, z));
+	}
+
+	inline DirectX::PackedVector::XMUBYTEN4 XM_CALLCONV EncodeColor(DirectX::FXMVECTOR color)
+	{
+		using namespace DirectX;
+		using namespace DirectX::PackedVector;
+		XMUBYTE4 quantized;
+		XMStoreUByte4(&quantized, XMVectorRound(XMVectorSaturate(color) * 255.0f));
+		XMUBYTEN4 packed;
+		packed.v = quantized.v;
+		return packed;
+	}
+
+	inline DirectX::XMVECTOR XM_CALLCONV DecodeColor(const DirectX::PackedVector::XMUBYTEN4& packed)
+	{
+		return DirectX::PackedVector::XMLoadUByteN4(&packed);
+	}
+
+	inline DirectX::PackedVector::XMHALF2 XM_CALLCONV EncodeTexCoord(DirectX::FXMVECTOR tex)
+	{
+		using namespace DirectX::PackedVector;
+		XMHALF2 packed;
+		XMStoreHalf2(&packed, tex);
+		return packed;
+	}
+
+	inline DirectX::XMVECTOR XM_CALLCONV DecodeTexCoord(const DirectX::PackedVector::XMHALF2& packed)
+	{
+		return DirectX::PackedVector::XMLoadHalf2(&packed);
+	}
+
+	template<class PackedVertexType, class VertexType, class IndexType>
+	inline Geometry::MeshData<PackedVertexType, IndexType> CompressMesh(const Geometry::MeshData<VertexType, IndexType>& meshData,
+		PositionBounds* pBounds)
+	{
+		using namespace DirectX;
+		static_assert(!MeshNormals::HasNormal<PackedVertexType>::value || MeshNormals::HasNormal<VertexType>::value,
+			"The source vertex type has no normal!");
+		static_assert(!Internal::HasColor<PackedVertexType>::value || Internal::HasColor<VertexType>::value,
+			"The source vertex type has no color!");
+		static_assert(!Internal::HasTex<PackedVertexType>::value || Internal::HasTex<VertexType>::value,
+			"The source vertex type has no texcoord!");
+
+		PositionBounds bounds = ComputePositionBounds(meshData.vertexVec);
+		if (pBounds)
+			*pBounds = bounds;
+
+		Geometry::MeshData<PackedVertexType, IndexType> packedData;
+		packedData.indexVec = meshData.indexVec;
+		packedData.submeshes = meshData.submeshes;
+		packedData.vertexVec.resize(meshData.vertexVec.size());
+		ThreadPool::Get().ParallelFor(meshData.vertexVec.size(), Internal::GrainSize, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+			{
+				const VertexType& src = meshData.vertexVec[i];
+				PackedVertexType& dst = packedData.vertexVec[i];
+				dst.pos = EncodePosition(XMLoadFloat3(&src.pos), bounds);
+				if constexpr (MeshNormals::HasNormal<PackedVertexType>::value)
+					dst.normal = EncodeNormal(XMLoadFloat3(&src.normal));
+				if constexpr (Internal::HasColor<PackedVertexType>::value)
+					dst.color = EncodeColor(XMLoadFloat4(&src.color));
+				if constexpr (Internal::HasTex<PackedVertexType>::value)
+					dst.tex = EncodeTexCoord(XMLoadFloat2(&src.tex));
+			}
+		});
+		return packedData;
+	}
+
+	template<class VertexType, class PackedVertexType, class IndexType>
+	inline Geometry::MeshData<VertexType, IndexType> DecompressMesh(const Geometry::MeshData<PackedVertexType, IndexType>& meshData,
+		const PositionBounds& bounds)
+	{
+		using namespace DirectX;
+		static_assert(!MeshNormals::HasNormal<VertexType>::value || MeshNormals::HasNormal<PackedVertexType>::value,
+			"The packed vertex type has no normal!");
+		static_assert(!Internal::HasColor<VertexType>::value || Internal::HasColor<PackedVertexType>::value,
+			"The packed vertex type has no color!");
+		static_assert(!Internal::HasTex<VertexType>::value || Internal::HasTex<PackedVertexType>::value,
+			"The packed vertex type has no texcoord!");
+
+		Geometry::MeshData<VertexType, IndexType> result;
+		result.indexVec = meshData.indexVec;
+		result.submeshes = meshData.submeshes;
+		result.vertexVec.resize(meshData.vertexVec.size());
+		ThreadPool::Get().ParallelFor(meshData.vertexVec.size(), Internal::GrainSize, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+			{
+				const PackedVertexType& src = meshData.vertexVec[i];
+				VertexType& dst = result.vertexVec[i];
+				XMStoreFloat3(&dst.pos, DecodePosition(src.pos, bounds));
+				if constexpr (MeshNormals::HasNormal<VertexType>::value)
+					XMStoreFloat3(&dst.normal, DecodeNormal(src.normal));
+				if constexpr (Internal::HasColor<VertexType>::value)
+					XMStoreFloat4(&dst.color, DecodeColor(src.color));
+				if constexpr (Internal::HasTex<VertexType>::value)
+					XMStoreFloat2(&dst.tex, DecodeTexCoord(src.tex));
+			}
+		});
+		return result;
+	}
+}
+
+#endif